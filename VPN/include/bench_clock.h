@@ -0,0 +1,22 @@
+// include/bench_clock.h
+
+#ifndef BENCH_CLOCK_H
+#define BENCH_CLOCK_H
+
+#include <stdint.h>
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 벤치마크용 시계 (bench_dataplane / bench_crypto 공용)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// CLOCK_MONOTONIC (나노초)
+uint64_t bench_now_ns(void);
+
+// CPU 사이클 (x86 은 TSC, 그 밖에는 나노초로 대신)
+uint64_t bench_cycles(void);
+
+// 사이클 ↔ 시간 환산 비율 측정 (100ms 동안 바쁘게 대기)
+// 반환값: 마이크로초당 사이클 수
+double bench_calibrate(void);
+
+#endif // BENCH_CLOCK_H
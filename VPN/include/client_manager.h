@@ -5,37 +5,109 @@
 
 #include <stdint.h>
 #include <time.h>
+#include <pthread.h>
 #include <netinet/in.h>
+#include "hash_index.h"
+#include "id_bitmap.h"
+#include "timer_wheel.h"
+#include "ipc_protocol.h"
+#include "server_stats.h"
 
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 // 클라이언트 관리
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 
-#define MAX_CLIENTS 254
 #define CLIENT_TIMEOUT 300  // 5분 (초)
 
-// 클라이언트 정보
+// 클라이언트 타이머 (테이블의 타이머 휠, 1틱 = 1초)
+// - 만료: 마지막 통신 + CLIENT_TIMEOUT 에 걸어두고, 울렸을 때 그 사이 통신이 있었으면 다시 건다
+//   (패킷마다 타이머를 옮기지 않고 last_seen 만 갱신)
+// - RTT 측정: 연결 후 STATS_RTT_PROBE_SEC 마다 (클라이언트마다 시점이 달라 PING이 몰리지 않음)
+
+// VPN IP 풀 (--pool 로 변경)
+// 네트워크 주소, 첫 주소(서버 TUN), 브로드캐스트 주소는 할당하지 않는다.
+// /16 이면 65533명. 통계 세그먼트가 주소마다 슬롯을 잡으므로 /16 보다 크게는 받지 않음.
+#define CLIENT_POOL_DEFAULT "10.8.0.0/24"
+#define CLIENT_POOL_MIN_PREFIX 16
+#define CLIENT_POOL_MAX_PREFIX 30
+
+// 엔트리 저장소는 청크 단위로 필요할 때 할당 (청크는 테이블 제거 전까지 해제하지 않음)
+#define CLIENT_CHUNK_BITS 8
+#define CLIENT_CHUNK_SIZE (1u << CLIENT_CHUNK_BITS)
+
+// 클라이언트 정보 (패킷마다 접근하는 hot 필드)
 typedef struct {
-    uint32_t vpn_ip;              // VPN IP (네트워크 바이트 오더)
+    time_t last_seen;             // 마지막 통신 시간 (테이블 시계, 단조 초)
     struct sockaddr_in real_addr; // 실제 주소 (IP:포트)
-    time_t last_seen;             // 마지막 통신 시간
-    uint32_t session_id;          // 세션 ID
+    uint32_t vpn_ip;              // VPN IP (네트워크 바이트 오더)
+    key_handle_t key_handle;      // Enclave 세션키 핸들 (핸드셰이크 후 설정)
     int active;                   // 활성 상태 (1=활성, 0=비활성)
 } client_entry_t;
 
+// 클라이언트 경로 (TUN 워커가 읽기 lock 안에서 값으로 복사해 가는 필드)
+// 복사한 뒤 메인 스레드가 슬롯을 반납/재사용해도 이미 읽은 값은 찢어지지 않는다.
+typedef struct {
+    struct sockaddr_in real_addr; // 보낼 주소
+    uint32_t vpn_ip;              // VPN IP (네트워크 바이트 오더)
+    key_handle_t key_handle;      // 세션키 핸들
+    int slot;                     // 슬롯 번호 (클라이언트 통계 인덱스)
+} client_route_t;
+
+// 클라이언트 부가 정보 (연결/출력 때만 쓰는 cold 필드)
+typedef struct {
+    uint32_t session_id;          // 세션 ID
+    time_t connected_at;          // 연결 시각 (벽시계)
+    timer_node_t expiry;          // 세션 만료 타이머 (id = 슬롯)
+    timer_node_t probe;           // RTT 측정 타이머 (id = 슬롯)
+} client_info_t;
+
+// 엔트리 청크 (clients[i] 와 info[i] 는 같은 클라이언트)
+typedef struct {
+    client_entry_t clients[CLIENT_CHUNK_SIZE];
+    client_info_t info[CLIENT_CHUNK_SIZE];
+} client_chunk_t;
+
 // 클라이언트 테이블
+// TUN 워커 스레드는 조회만, 추가/제거는 메인 스레드가 하므로 rwlock 사용.
+// 슬롯 번호 = 풀 안에서의 VPN IP 오프셋이라 VPN IP 조회는 인덱스 계산만 하면 된다.
+// 청크는 한 번 할당하면 그대로 두므로 조회로 얻은 포인터는 제거 후에도 유효한 메모리다.
+// 시계와 타이머 휠은 메인 스레드만 갱신한다 (워커는 now 만 읽음).
 typedef struct {
-    client_entry_t clients[MAX_CLIENTS];
+    client_chunk_t **chunks;      // [capacity / CLIENT_CHUNK_SIZE], 비어 있으면 NULL
+    uint32_t chunk_count;         // 할당된 청크 수
+    uint32_t base;                // 풀 네트워크 주소 (호스트 바이트 오더)
+    int prefix;                   // 풀 프리픽스 길이
+    uint32_t capacity;            // 풀 주소 수 = 슬롯 수 (예약 주소 포함)
+    id_bitmap_t ips;              // 빈 VPN IP (오프셋)
+    hash_index_t by_addr;         // (IP, 포트) → 슬롯
     int count;                    // 현재 활성 클라이언트 수
-    uint32_t next_ip;             // 다음 할당할 VPN IP (호스트 바이트 오더)
+    pthread_rwlock_t lock;        // 테이블 구조 보호 (추가/제거 ↔ 조회)
+    server_stats_t *stats;        // 추가/제거를 통계 세그먼트에 알림 (NULL = 안 함)
+    time_t now;                   // 거친 단조 시계 (초, client_table_tick 으로 갱신)
+    timer_wheel_t timers;         // 클라이언트 타이머
 } client_table_t;
 
+// 타이머 콜백 (메인 스레드, 테이블 lock 없이 호출)
+typedef void (*client_probe_fn)(client_entry_t *client, void *arg);
+typedef void (*client_expired_fn)(uint32_t vpn_ip, void *arg);
+
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 // 함수 선언
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 
+// VPN IP 풀 해석 ("10.8.0.0/16")
+// network: 네트워크 주소 (네트워크 바이트 오더)
+// 반환값: 0 (성공), -1 (형식 오류 / 프리픽스 범위 밖 / 호스트 비트가 0이 아님)
+int parse_client_pool(const char *cidr, uint32_t *network, int *prefix);
+
+// 풀에서 클라이언트에게 줄 수 있는 주소 수
+static inline uint32_t client_pool_hosts(int prefix) {
+    return (1u << (32 - prefix)) - 3;
+}
+
 // 클라이언트 테이블 생성
-client_table_t* init_client_table(void);
+// network/prefix: parse_client_pool 결과
+client_table_t* init_client_table(uint32_t network, int prefix);
 
 // 클라이언트 테이블 제거
 void destroy_client_table(client_table_t *table);
@@ -45,25 +117,63 @@ void destroy_client_table(client_table_t *table);
 uint32_t add_client(client_table_t *table, struct sockaddr_in *addr);
 
 // VPN IP로 클라이언트 찾기
+// 반환한 엔트리는 메인 스레드가 언제든 반납/재사용할 수 있으므로 메인 스레드에서만 쓸 것
 client_entry_t* find_client_by_vpn_ip(client_table_t *table, uint32_t vpn_ip);
 
-// 실제 주소로 클라이언트 찾기
+// 실제 주소로 클라이언트 찾기 (메인 스레드 전용, 위와 같음)
 client_entry_t* find_client_by_addr(client_table_t *table, struct sockaddr_in *addr);
 
+// VPN IP로 경로 복사 (TUN 워커용, 읽기 lock 안에서 복사)
+// 반환값: 0 (찾음), -1 (없음)
+int client_table_route(client_table_t *table, uint32_t vpn_ip, client_route_t *route);
+
 // 클라이언트 제거
 void remove_client(client_table_t *table, uint32_t vpn_ip);
 
-// 타임아웃된 클라이언트 제거
-void check_client_timeouts(client_table_t *table);
-
-// 클라이언트 마지막 통신 시간 갱신
-void update_client_activity(client_entry_t *client);
+// 테이블 시계 갱신 (메인 이벤트 루프의 하우스키핑 타이머마다)
+void client_table_tick(client_table_t *table);
+
+// 시계까지 타이머 진행 (메인 스레드)
+// probe: RTT 측정 시점이 된 클라이언트마다
+// expired: 타임아웃으로 제거된 클라이언트마다 (슬롯은 이미 반납됨, Enclave 키 정리용)
+// 반환값: 타임아웃으로 제거된 클라이언트 수
+int run_client_timers(client_table_t *table, client_probe_fn probe,
+                      client_expired_fn expired, void *arg);
+
+// 클라이언트 마지막 통신 시간 갱신 (테이블 시계 값을 기록, 같으면 쓰지 않음)
+static inline void update_client_activity(const client_table_t *table, client_entry_t *client) {
+    // 여러 워커가 동시에 갱신할 수 있음
+    time_t now = __atomic_load_n(&table->now, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&client->last_seen, __ATOMIC_RELAXED) != now) {
+        __atomic_store_n(&client->last_seen, now, __ATOMIC_RELAXED);
+    }
+}
+
+// 세션키 핸들 설정 (워커가 동시에 읽을 수 있음)
+void set_client_key_handle(client_entry_t *client, key_handle_t key_handle);
+
+// 클라이언트 부가 정보 (세션 ID 등)
+client_info_t* get_client_info(client_table_t *table, const client_entry_t *client);
+
+// 클라이언트 슬롯 번호 (풀 오프셋 = 통계 세그먼트 인덱스)
+static inline int client_slot(const client_table_t *table, const client_entry_t *client) {
+    return (int)(ntohl(client->vpn_ip) - table->base);
+}
+
+// 엔트리에서 경로 복사 (메인 스레드 또는 lock 보유 시)
+static inline void client_route_fill(const client_table_t *table, const client_entry_t *client,
+                                     client_route_t *route) {
+    route->real_addr = client->real_addr;
+    route->vpn_ip = client->vpn_ip;
+    route->key_handle = __atomic_load_n(&client->key_handle, __ATOMIC_ACQUIRE);
+    route->slot = client_slot(table, client);
+}
 
 // 세션 ID 생성
 uint32_t generate_session_id(void);
 
 // 클라이언트 정보 출력
-void print_client_info(const client_entry_t *client);
+void print_client_info(const client_table_t *table, const client_entry_t *client);
 
 // 클라이언트 테이블 출력 (디버깅용)
 void print_client_table(const client_table_t *table);
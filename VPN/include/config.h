@@ -14,6 +14,9 @@ typedef struct {
     int keepalive_interval;
     int pong_timeout;
     int log_level;  // 0=ERROR, 1=WARN, 2=INFO, 3=DEBUG
+    char pcap_replay[256];   // 비어 있지 않으면 TUN 대신 pcap 백엔드
+    char pcap_record[256];
+    int pcap_max_rate;       // 1 = replay 타임스탬프 무시
 } vpn_config_t;
 
 // 기본 설정
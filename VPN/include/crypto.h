@@ -11,9 +11,28 @@
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 
 #define CRYPTO_KEY_SIZE 32
-#define CRYPTO_NONCE_SIZE 12
+#define CRYPTO_NONCE_SIZE 12       // AEAD nonce = 방향(4) + 카운터(8)
+#define CRYPTO_COUNTER_SIZE 8      // 와이어에 실리는 부분 (카운터만)
 #define CRYPTO_MAC_SIZE 16
 
+// nonce 방향 (두 방향이 같은 세션키를 쓰므로 nonce 공간을 나눔)
+#define CRYPTO_DIR_CLIENT_TO_SERVER 0
+#define CRYPTO_DIR_SERVER_TO_CLIENT 1
+
+// 암호 스위트 (핸드셰이크에서 협상, 제안은 비트마스크로 OR)
+#define CRYPTO_SUITE_CHACHA20_POLY1305 0x01
+#define CRYPTO_SUITE_AES256_GCM        0x02
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 세션 암호 상태 (협상된 스위트 + 미리 계산한 키 스케줄)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+typedef struct {
+    crypto_aead_aes256gcm_state aes_state;  // AES-256-GCM 확장 키 (beforenm 결과)
+    uint8_t key[CRYPTO_KEY_SIZE];           // 세션키 (ChaCha20-Poly1305용)
+    uint8_t suite;                          // CRYPTO_SUITE_*
+} crypto_session_t;
+
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 // ChaCha20-Poly1305 암호화/복호화
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
@@ -40,6 +59,59 @@ int crypto_decrypt(const uint8_t *ciphertext, size_t ciphertext_len,
                    uint8_t *plaintext, const uint8_t *key,
                    const uint8_t *nonce);
 
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 스위트 선택 / 세션 암호화 (데이터 경로)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 이 CPU에서 쓸 수 있는 스위트 (비트마스크, AES는 AES-NI/ARMv8 Crypto 필요)
+uint8_t crypto_supported_suites(void);
+
+// 시작 시 1회: 쓸 수 있는 스위트를 MTU 크기 패킷으로 짧게 벤치마크해서 선호 스위트 결정
+// 반환값: 선택된 스위트
+uint8_t crypto_select_suite(void);
+
+// 선호 스위트 (crypto_select_suite 전에는 ChaCha20-Poly1305)
+uint8_t crypto_preferred_suite(void);
+
+// 상대가 제안한 비트마스크에서 스위트 선택 (선호 스위트 → ChaCha20-Poly1305 순)
+// offered가 0이면 스위트 필드가 없는 구버전으로 보고 ChaCha20-Poly1305
+// 반환값: 스위트, 0 (공통 스위트 없음)
+uint8_t crypto_negotiate_suite(uint8_t offered);
+
+// 스위트 이름
+const char* crypto_suite_name(uint8_t suite);
+
+// 세션 상태 준비 (AES는 여기서 키 스케줄을 한 번만 계산)
+// 반환값: 0 (성공), -1 (알 수 없거나 이 CPU에서 못 쓰는 스위트)
+int crypto_session_init(crypto_session_t *session, uint8_t suite, const uint8_t *key);
+
+// 세션 상태 제거 (키와 키 스케줄 모두 0으로)
+void crypto_session_clear(crypto_session_t *session);
+
+// 세션 암호화: out = 암호문 + MAC (len + CRYPTO_MAC_SIZE)
+// 반환값: 0 (성공), -1 (실패)
+int crypto_session_encrypt(const crypto_session_t *session,
+                           const uint8_t *in, size_t len,
+                           uint8_t *out, const uint8_t *nonce);
+
+// 세션 복호화: in = 암호문 + MAC
+// 반환값: 평문 길이, -1 (인증 실패)
+int crypto_session_decrypt(const crypto_session_t *session,
+                           const uint8_t *in, size_t len,
+                           uint8_t *out, const uint8_t *nonce);
+
+// 세션 in-place 암호화 (data + len 뒤에 MAC 기록)
+// 반환값: 0 (성공), -1 (실패)
+int crypto_session_encrypt_inplace(const crypto_session_t *session,
+                                   uint8_t *data, size_t len,
+                                   const uint8_t *nonce);
+
+// 세션 in-place 복호화 (len = 암호문 + MAC)
+// 반환값: 평문 길이, -1 (인증 실패)
+int crypto_session_decrypt_inplace(const crypto_session_t *session,
+                                   uint8_t *data, size_t len,
+                                   const uint8_t *nonce);
+
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 // Curve25519 ECDH (키 교환)
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
@@ -71,8 +143,13 @@ void crypto_derive_session_key(uint8_t *session_key,
 // 유틸리티
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 
-// 랜덤 nonce 생성
-void crypto_random_nonce(uint8_t *nonce);
+// 카운터 nonce 생성: [방향(4, BE)][카운터(8, BE)]
+// 세션마다 방향별 카운터를 0부터 증가시키므로 같은 키로 nonce가 반복되지 않음
+void crypto_counter_nonce(uint8_t *nonce, uint32_t direction, uint64_t counter);
+
+// 와이어 카운터 기록/읽기 (CRYPTO_COUNTER_SIZE 바이트, 빅엔디안)
+void crypto_put_counter(uint8_t *wire, uint64_t counter);
+uint64_t crypto_get_counter(const uint8_t *wire);
 
 // 랜덤 키 생성
 void crypto_random_key(uint8_t *key);
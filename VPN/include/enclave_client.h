@@ -5,6 +5,8 @@
 
 #include <stdint.h>
 #include <sys/types.h>
+#include "ipc_protocol.h"
+#include "packet_buf.h"
 
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 // Enclave IPC 클라이언트
@@ -21,23 +23,32 @@ void enclave_disconnect(int enclave_fd);
 int enclave_ping(int enclave_fd);
 
 // 키 추가 (VPN IP → 세션키)
-int enclave_add_key(int enclave_fd, uint32_t vpn_ip, const uint8_t *session_key);
+// cipher_suite: 세션 암호 스위트 (CRYPTO_SUITE_*)
+// key_handle: 등록된 키의 핸들 출력 (NULL 가능)
+int enclave_add_key(int enclave_fd, uint32_t vpn_ip, const uint8_t *session_key,
+                    uint8_t cipher_suite, key_handle_t *key_handle);
 
 // 키 제거
 int enclave_remove_key(int enclave_fd, uint32_t vpn_ip);
 
 // ECDH 핸드셰이크 (클라이언트 공개키 → 세션키)
+// offered_suites: 클라이언트가 제안한 암호 스위트 (비트마스크, 0=구버전 클라이언트)
 // server_public_key: 서버 공개키 출력 (32 bytes)
 // session_key: 생성된 세션키 출력 (32 bytes)
+// cipher_suite: Enclave가 고른 스위트 출력
+// key_handle: 세션키 핸들 출력 (데이터 경로 요청에 사용, NULL 가능)
 int enclave_handshake(int enclave_fd, uint32_t vpn_ip,
                       const uint8_t *client_public_key,
+                      uint8_t offered_suites,
                       uint8_t *server_public_key,
-                      uint8_t *session_key);
+                      uint8_t *session_key,
+                      uint8_t *cipher_suite,
+                      key_handle_t *key_handle);
 
 // 암호화 (평문 → 암호문)
 // plaintext: 평문 데이터
 // plaintext_len: 평문 길이
-// ciphertext: 암호문 출력 버퍼 (최소 plaintext_len + 28)
+// ciphertext: 암호문 출력 버퍼 (최소 plaintext_len + 24)
 // ciphertext_len: 암호문 길이 출력
 // 반환값: 0 (성공), -1 (실패)
 int enclave_encrypt(int enclave_fd, uint32_t vpn_ip,
@@ -45,7 +56,7 @@ int enclave_encrypt(int enclave_fd, uint32_t vpn_ip,
                     uint8_t *ciphertext, size_t *ciphertext_len);
 
 // 복호화 (암호문 → 평문)
-// ciphertext: 암호문 데이터 (nonce + encrypted + mac)
+// ciphertext: 암호문 데이터 (counter + encrypted + mac)
 // ciphertext_len: 암호문 길이
 // plaintext: 평문 출력 버퍼
 // plaintext_len: 평문 길이 출력
@@ -57,4 +68,150 @@ int enclave_decrypt(int enclave_fd, uint32_t vpn_ip,
 // Enclave 종료 요청
 int enclave_shutdown(int enclave_fd);
 
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 배치 암호화/복호화
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 배치 엔트리 (패킷 1개)
+typedef struct {
+    uint32_t vpn_ip;           // 키 식별 (네트워크 바이트 오더)
+    key_handle_t key_handle;   // 키 핸들 (KEY_HANDLE_INVALID면 vpn_ip로 조회)
+    const uint8_t *input;      // 입력 데이터
+    size_t input_len;          // 입력 길이
+    uint8_t *output;           // 출력 버퍼 (암호화: input_len + 24, 복호화: input_len 이상)
+    size_t output_len;         // 출력 길이 (결과)
+    int status;                // 0=성공, -1=실패 (결과)
+} enclave_batch_entry_t;
+
+// 여러 패킷을 한 번의 IPC로 암호화 (IPC_MAX_BATCH개 / IPC_MAX_BATCH_DATA 단위로 분할)
+// 버퍼는 호출마다 할당하므로 스레드마다 자기 연결로 부르면 동시에 써도 된다.
+// 같은 enclave_fd를 여러 스레드가 동시에 쓰면 응답이 섞이므로 호출자가 직렬화할 것.
+// 반환값: 성공한 엔트리 수, -1 (IPC 실패)
+int enclave_encrypt_batch(int enclave_fd, enclave_batch_entry_t *entries, int count);
+
+// 여러 패킷을 한 번의 IPC로 복호화 (분할 / 스레드 조건은 암호화와 같음)
+// 반환값: 성공한 엔트리 수, -1 (IPC 실패)
+int enclave_decrypt_batch(int enclave_fd, enclave_batch_entry_t *entries, int count);
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 공유 메모리 링 (데이터 경로)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// ENCRYPT/DECRYPT 전용. 요청당 소켓 시스템콜 없이 공유 메모리로 전달되며
+// eventfd 알림은 상대방이 잠들어 있을 때만 발생한다.
+
+typedef struct enclave_ring enclave_ring_t;
+
+// 링 생성 후 Enclave에 등록 (IPC_RING_SETUP)
+// 반환값: 링 핸들 (성공), NULL (실패)
+enclave_ring_t* enclave_ring_attach(int enclave_fd);
+
+// 링 해제
+void enclave_ring_detach(enclave_ring_t *ring);
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 제로카피 링 (슬롯 = 패킷 버퍼)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// 링 슬롯을 packet_buf_t로 빌려 TUN read / recvmmsg가 바로 채우고,
+// Enclave가 제자리에서 암호화/복호화한 결과를 그대로 write / sendmmsg 한다.
+//
+//   1. enclave_ring_reserve: 다음 슬롯 n개 예약 (아직 제출 안 됨)
+//   2. 호출자가 pkt을 채우고 command / vpn_ip / key_handle 지정
+//   3. enclave_ring_process: 예약 순서대로 앞에서부터 제출 (여러 번 나눠도 됨)
+//   4. 결과 pkt은 같은 링에 다음 reserve를 하기 전까지 유효
+//
+// 같은 링에서 예약한 슬롯이 남아 있는 동안 다른 링 함수를 섞어 쓰지 말 것.
+
+// 예약 슬롯 1개
+typedef struct {
+    packet_buf_t pkt;          // 슬롯 데이터 (입력 → in-place 결과)
+    uint8_t command;           // IPC_ENCRYPT / IPC_DECRYPT / 0 (건너뜀)
+    uint32_t vpn_ip;           // 키 식별 (네트워크 바이트 오더)
+    key_handle_t key_handle;   // 키 핸들
+    int status;                // 0=성공, -1=실패 (결과)
+} enclave_ring_packet_t;
+
+// 슬롯 예약
+// headroom: 입력 앞에 남길 공간 (ENCRYPT는 카운터 자리 8바이트 이상 필요)
+// 반환값: 예약한 슬롯 수 (≤ count), -1 (링 실패)
+int enclave_ring_reserve(enclave_ring_t *ring, enclave_ring_packet_t *pkts,
+                         int count, size_t headroom);
+
+// 예약한 슬롯 중 앞에서 count개 처리 (제출 1회 + 완료 대기)
+// ENCRYPT: pkt = 평문 → [카운터][암호문 + MAC] (pkt.data가 8바이트 앞으로 이동)
+// DECRYPT: pkt = [카운터][암호문 + MAC] → 평문
+// 반환값: 성공한 슬롯 수, -1 (링 실패)
+int enclave_ring_process(enclave_ring_t *ring, enclave_ring_packet_t *pkts, int count);
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 비동기 IPC (파이프라인)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// 소켓 요청을 응답을 기다리지 않고 여러 개 보내 두고, 응답은 request_id로
+// 맞춰 콜백으로 돌려준다. 핸드셰이크(ECDH)처럼 오래 걸리는 제어 명령 동안에도
+// 호출자는 UDP/TUN 처리를 계속할 수 있다.
+//
+//   1. enclave_async_submit: 요청 전송 → 토큰(request_id) 반환
+//   2. enclave_async_fd를 epoll에 등록, 읽을 수 있으면 enclave_async_poll(ctx, 0)
+//   3. 응답이 도착한 요청마다 콜백 호출 (순서는 응답 도착 순)
+//
+// 동기 함수(enclave_handshake 등)와 같은 소켓을 섞어 쓰면 응답을 가로채므로
+// 비동기 컨텍스트에는 전용 연결을 넘길 것. 스레드 안전하지 않음.
+// 콜백 안에서도 submit 할 수 있지만 응답은 회수하지 않으므로(창이 가득 차면 실패)
+// 콜백 안에서 enclave_async_wait로 기다리지 말 것.
+
+#define ENCLAVE_ASYNC_MAX_WINDOW  64     // 동시에 보낼 수 있는 요청 수 상한
+#define ENCLAVE_ASYNC_WAIT_MS     1000   // 창이 가득 찼을 때 응답 대기 최대 시간
+
+typedef struct enclave_async enclave_async_t;
+
+// 완료 콜백
+// status: Enclave 응답 상태 (0=성공), 연결이 끊기면 -1 (data = NULL)
+// data/len: 응답 데이터 (콜백 안에서만 유효)
+typedef void (*enclave_async_cb_t)(void *user, uint32_t token, int status,
+                                   const uint8_t *data, size_t len);
+
+// 비동기 컨텍스트 생성 (enclave_fd는 논블로킹으로 바뀌고 컨텍스트가 소유)
+// window: 동시에 응답을 기다릴 수 있는 요청 수 (1 ~ ENCLAVE_ASYNC_MAX_WINDOW)
+// 반환값: 컨텍스트 (성공), NULL (실패)
+enclave_async_t* enclave_async_create(int enclave_fd, int window);
+
+// 컨텍스트 해제 (남은 요청은 status=-1로 콜백, 소켓도 닫음)
+void enclave_async_destroy(enclave_async_t *ctx);
+
+// epoll 등록용 소켓 fd
+int enclave_async_fd(const enclave_async_t *ctx);
+
+// 응답을 기다리는 요청 수
+int enclave_async_in_flight(const enclave_async_t *ctx);
+
+// 요청 전송 (창이 가득 차면 응답 하나가 올 때까지 먼저 회수)
+// 반환값: 토큰 (0이 아닌 request_id), 0 (실패)
+uint32_t enclave_async_submit(enclave_async_t *ctx, uint8_t command, uint32_t vpn_ip,
+                              const uint8_t *data, size_t data_len,
+                              enclave_async_cb_t cb, void *user);
+
+// 도착한 응답 회수 (timeout_ms: 0=기다리지 않음, -1=하나 이상 올 때까지)
+// 반환값: 완료된 요청 수, -1 (연결 끊김)
+int enclave_async_poll(enclave_async_t *ctx, int timeout_ms);
+
+// 특정 요청이 완료될 때까지 대기 (그 사이 다른 응답도 콜백 처리)
+// 반환값: 0 (완료), -1 (실패 또는 ENCLAVE_ASYNC_WAIT_MS 초과)
+int enclave_async_wait(enclave_async_t *ctx, uint32_t token);
+
+// ECDH 핸드셰이크 (응답 데이터 = ipc_handshake_response_t)
+uint32_t enclave_async_handshake(enclave_async_t *ctx, uint32_t vpn_ip,
+                                 const uint8_t *client_public_key,
+                                 uint8_t offered_suites,
+                                 enclave_async_cb_t cb, void *user);
+
+// 키 제거 (cb는 NULL 가능)
+uint32_t enclave_async_remove_key(enclave_async_t *ctx, uint32_t vpn_ip,
+                                  enclave_async_cb_t cb, void *user);
+
+// 여러 키 제거 (count ≤ IPC_MAX_REMOVE_KEYS, 응답 데이터 = 제거된 수의 ipc_batch_header_t)
+uint32_t enclave_async_remove_keys(enclave_async_t *ctx, const uint32_t *vpn_ips, int count,
+                                   enclave_async_cb_t cb, void *user);
+
 #endif // ENCLAVE_CLIENT_H
@@ -0,0 +1,41 @@
+// include/event_loop.h
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// epoll / timerfd 헬퍼 (서버·클라이언트 이벤트 루프 공용)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// 등록은 edge-triggered(EPOLLET) 기준이므로 호출자는 준비된 fd를
+// EAGAIN이 나올 때까지 읽어야 한다.
+
+#define EVENT_LOOP_MAX_EVENTS 16
+
+// epoll 인스턴스 생성
+// 반환값: epoll fd (성공), -1 (실패)
+int event_loop_create(void);
+
+// fd 등록
+// events: EPOLLIN 등 (EPOLLET은 호출자가 지정)
+// tag: 이벤트 발생 시 epoll_event.data.u32 로 돌려받을 값
+// 반환값: 0 (성공), -1 (실패)
+int event_loop_add(int epoll_fd, int fd, uint32_t events, uint32_t tag);
+
+// 논블로킹 모드 설정
+// 반환값: 0 (성공), -1 (실패)
+int set_nonblocking(int fd);
+
+// 주기 타이머 생성 (timerfd, 논블로킹)
+// interval_ms: 주기 (밀리초)
+// 반환값: timer fd (성공), -1 (실패)
+int timer_fd_create(unsigned int interval_ms);
+
+// 타이머 만료 횟수 읽기 (알림 소비)
+// 반환값: 마지막 확인 이후 만료된 횟수 (0 = 없음)
+uint64_t timer_fd_ack(int timer_fd);
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,58 @@
+// include/hash_index.h
+
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <stdint.h>
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 오픈 어드레싱 해시 인덱스 (키 → 슬롯 번호)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// 엔트리 배열(클라이언트 테이블, 키 테이블)을 O(1)로 찾기 위한 보조 인덱스.
+// - 버킷은 16바이트(키 + 값)라 캐시 라인 하나에 4개, 선형 탐사는 대부분 한 줄 안에서 끝남
+// - 버킷 수 = 최대 엔트리 수의 2배 이상인 2의 거듭제곱 (부하율 ≤ 50%)
+// - 삭제는 backward shift 방식이라 tombstone이 쌓이지 않음
+//
+// 잠금은 하지 않는다. 호출자가 원본 테이블과 같은 잠금으로 보호할 것.
+
+#define HASH_INDEX_EMPTY (-1)
+
+typedef struct {
+    uint64_t key;
+    int32_t value;                // 슬롯 번호, HASH_INDEX_EMPTY = 빈 버킷
+    uint32_t reserved;
+} hash_bucket_t;
+
+typedef struct {
+    hash_bucket_t *buckets;       // 캐시 라인 정렬
+    uint32_t mask;                // 버킷 수 - 1
+    uint32_t count;               // 저장된 키 수
+} hash_index_t;
+
+// 인덱스 생성
+// max_entries: 저장할 최대 키 수
+// 반환값: 0 (성공), -1 (실패)
+int hash_index_init(hash_index_t *index, uint32_t max_entries);
+
+// 인덱스 해제
+void hash_index_destroy(hash_index_t *index);
+
+// 최대 엔트리 수 늘리기 (부하율을 넘으면 버킷 배열을 키워서 다시 넣음)
+// 원본 테이블이 커질 때 호출. 조회와 같은 잠금의 쓰기 쪽을 잡고 부를 것.
+// 반환값: 0 (성공), -1 (메모리 부족, 기존 인덱스는 그대로)
+int hash_index_reserve(hash_index_t *index, uint32_t max_entries);
+
+// 키 조회
+// 반환값: 슬롯 번호, HASH_INDEX_EMPTY (없음)
+int32_t hash_index_get(const hash_index_t *index, uint64_t key);
+
+// 키 추가 (이미 있으면 값 교체)
+// 반환값: 0 (성공), -1 (가득 참)
+int hash_index_put(hash_index_t *index, uint64_t key, int32_t value);
+
+// 키 제거
+// 반환값: 0 (제거), -1 (없음)
+int hash_index_remove(hash_index_t *index, uint64_t key);
+
+#endif // HASH_INDEX_H
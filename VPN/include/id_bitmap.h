@@ -0,0 +1,49 @@
+// include/id_bitmap.h
+
+#ifndef ID_BITMAP_H
+#define ID_BITMAP_H
+
+#include <stdint.h>
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 계층형 비트맵 번호 할당기 (0 ~ size-1)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// VPN IP 풀과 Enclave 키 슬롯처럼 "비어 있는 번호 하나"를 자주 찾는 곳에 쓴다.
+// - 맨 아래 단계: 번호마다 1비트 (1 = 비어 있음)
+// - 위 단계: 아래 단계 워드(64비트)마다 1비트 (1 = 그 워드에 빈 번호가 있음)
+// - 할당은 위에서부터 ctz 한 번씩 (단계 수만큼), 해제는 비트 하나 + 워드가 비었을 때만 위로 전파
+//   → 64^4 = 16M 번호까지 최대 4단계라 사실상 O(1)
+// - 항상 가장 작은 빈 번호를 돌려주므로 사용 중인 번호가 앞쪽에 모인다
+//
+// 잠금은 하지 않는다. 호출자가 잠글 것.
+
+#define ID_BITMAP_MAX_LEVELS 4
+#define ID_BITMAP_MAX_SIZE (1u << 24)
+
+typedef struct {
+    uint64_t *words[ID_BITMAP_MAX_LEVELS];   // [0] = 번호별 비트, [levels-1] = 워드 1개
+    uint32_t size;                           // 전체 번호 수
+    uint32_t used;                           // 할당된 번호 수
+    int levels;
+} id_bitmap_t;
+
+// 비트맵 생성 (모든 번호가 비어 있는 상태)
+// 반환값: 0 (성공), -1 (실패)
+int id_bitmap_init(id_bitmap_t *bm, uint32_t size);
+
+// 비트맵 해제
+void id_bitmap_destroy(id_bitmap_t *bm);
+
+// 가장 작은 빈 번호 할당
+// 반환값: 번호, -1 (가득 참)
+int32_t id_bitmap_alloc(id_bitmap_t *bm);
+
+// 특정 번호 할당 (예약 주소 등)
+// 반환값: 0 (성공), -1 (범위 밖 / 이미 사용 중)
+int id_bitmap_take(id_bitmap_t *bm, uint32_t id);
+
+// 번호 반납 (비어 있던 번호면 무시)
+void id_bitmap_release(id_bitmap_t *bm, uint32_t id);
+
+#endif // ID_BITMAP_H
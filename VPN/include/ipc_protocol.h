@@ -10,8 +10,27 @@
 // Enclave IPC 프로토콜
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 
+// 소켓은 SOCK_SEQPACKET: 요청/응답 1개 = 메시지 1개 (방향마다 시스템콜 1회)
+
 #define IPC_SOCKET_PATH "/tmp/vpn-enclave.sock"
 #define IPC_MAX_DATA_SIZE 4096
+#define IPC_CRYPTO_OVERHEAD 24     // counter(8) + MAC(16)
+#define IPC_RING_FD_COUNT 3        // memfd, sq_eventfd, cq_eventfd
+#define IPC_MAX_RINGS 8            // 연결당 최대 링 수 (서버 TUN 워커 수 상한)
+#define IPC_MAX_BATCH 64           // 배치 요청당 최대 패킷 수
+#define IPC_MAX_BATCH_DATA 65535   // 배치 요청/응답 데이터 최대 크기 (data_len 한계)
+#define IPC_MAX_REMOVE_KEYS 1024   // REMOVE_KEYS 요청당 최대 키 수
+
+// 키 핸들 (Enclave 키 테이블 슬롯 번호 + 세대)
+// ADD_KEY / HANDSHAKE 응답으로 받아 데이터 경로 요청에 실어 보낸다.
+// 슬롯이 제거/재사용되면 세대가 바뀌므로 오래된 핸들은 조회에 실패한다.
+typedef uint32_t key_handle_t;
+
+#define KEY_HANDLE_INVALID 0       // 핸들 없음 (vpn_ip로 조회)
+#define KEY_HANDLE_SLOT_BITS 16
+#define KEY_HANDLE_MAKE(slot, gen) (((uint32_t)(gen) << KEY_HANDLE_SLOT_BITS) | (uint32_t)(slot))
+#define KEY_HANDLE_SLOT(handle) ((handle) & ((1u << KEY_HANDLE_SLOT_BITS) - 1))
+#define KEY_HANDLE_GEN(handle) ((handle) >> KEY_HANDLE_SLOT_BITS)
 
 // IPC 명령 타입
 typedef enum {
@@ -21,6 +40,10 @@ typedef enum {
     IPC_ADD_KEY = 0x04,        // 키 추가 (VPN IP → 세션키)
     IPC_REMOVE_KEY = 0x05,     // 키 제거
     IPC_HANDSHAKE = 0x06,      // ECDH 핸드셰이크
+    IPC_RING_SETUP = 0x07,     // 공유 메모리 링 등록 (fd는 SCM_RIGHTS로 전달)
+    IPC_ENCRYPT_BATCH = 0x08,  // 여러 패킷 암호화 (ipc_batch_entry_t 배열)
+    IPC_DECRYPT_BATCH = 0x09,  // 여러 패킷 복호화 (ipc_batch_entry_t 배열)
+    IPC_REMOVE_KEYS = 0x0A,    // 여러 키 제거 (만료된 세션 정리)
     IPC_SHUTDOWN = 0xFF,       // Enclave 종료
 } ipc_command_t;
 
@@ -48,14 +71,23 @@ typedef struct {
 // ADD_KEY 요청 데이터
 #pragma pack(push, 1)
 typedef struct {
-    uint8_t session_key[32];   // ChaCha20-Poly1305 키
+    uint8_t session_key[32];   // 세션키
+    uint8_t cipher_suite;      // CRYPTO_SUITE_*
 } ipc_add_key_data_t;
 #pragma pack(pop)
 
+// ADD_KEY 응답 데이터
+#pragma pack(push, 1)
+typedef struct {
+    uint32_t key_handle;       // 키 핸들 (네트워크 바이트 오더)
+} ipc_key_handle_data_t;
+#pragma pack(pop)
+
 // HANDSHAKE 요청 데이터
 #pragma pack(push, 1)
 typedef struct {
     uint8_t client_public_key[32];  // 클라이언트 공개키
+    uint8_t cipher_suites;          // 클라이언트가 제안한 스위트 (비트마스크)
 } ipc_handshake_data_t;
 #pragma pack(pop)
 
@@ -64,9 +96,34 @@ typedef struct {
 typedef struct {
     uint8_t server_public_key[32];  // 서버 공개키
     uint8_t session_key[32];         // 생성된 세션키
+    uint32_t key_handle;             // 키 핸들 (네트워크 바이트 오더)
+    uint8_t cipher_suite;            // Enclave가 고른 스위트
 } ipc_handshake_response_t;
 #pragma pack(pop)
 
+// ENCRYPT_BATCH / DECRYPT_BATCH 데이터
+//   요청: ipc_batch_header_t + (ipc_batch_entry_t + 입력) × count
+//   응답: ipc_batch_header_t + (ipc_batch_entry_t + 출력) × count
+#pragma pack(push, 1)
+typedef struct {
+    uint16_t count;            // 엔트리 수
+} ipc_batch_header_t;
+#pragma pack(pop)
+
+#pragma pack(push, 1)
+typedef struct {
+    uint32_t vpn_ip;           // 키 식별 (네트워크 바이트 오더)
+    uint32_t key_handle;       // 키 핸들 (네트워크 바이트 오더, 0이면 vpn_ip로 조회)
+    int8_t status;             // 응답: 0=성공, -1=실패 (요청에서는 0)
+    uint16_t data_len;         // 뒤따르는 데이터 길이
+    uint8_t data[];
+} ipc_batch_entry_t;
+#pragma pack(pop)
+
+// REMOVE_KEYS 데이터
+//   요청: ipc_batch_header_t + uint32_t vpn_ip[count] (네트워크 바이트 오더)
+//   응답: ipc_batch_header_t (실제로 제거된 키 수)
+
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 // 헬퍼 함수
 // ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
@@ -82,4 +139,23 @@ void init_ipc_request(ipc_request_t *req, uint8_t command,
 void init_ipc_response(ipc_response_t *resp, uint32_t request_id,
                        int8_t status, const uint8_t *data, uint16_t data_len);
 
+// 헤더 + 데이터를 메시지 1개로 전송 (sendmsg 1회, 데이터를 헤더 뒤로 복사하지 않음)
+// fds: 첨부할 fd (SCM_RIGHTS, 최대 IPC_RING_FD_COUNT개, 없으면 fd_count=0)
+// 반환값: 전송한 바이트 수, -1 (실패)
+ssize_t ipc_send_msg(int sock_fd, const void *hdr, size_t hdr_len,
+                     const void *data, size_t data_len,
+                     const int *fds, int fd_count);
+
+// fd를 첨부하여 전송 (SCM_RIGHTS)
+// 반환값: 전송한 바이트 수, -1 (실패)
+ssize_t ipc_send_fds(int sock_fd, const void *buf, size_t len,
+                     const int *fds, int fd_count);
+
+// 메시지 1개 수신 + 첨부된 fd 회수 (recvmsg 1회)
+// fds: fd 출력 배열 (최대 IPC_RING_FD_COUNT개, NULL이면 받은 fd는 닫음)
+// fd_count: 받은 fd 개수 출력 (NULL 가능)
+// 반환값: 메시지 크기, 0 (연결 종료), -1 (실패, len보다 큰 메시지는 EMSGSIZE)
+ssize_t ipc_recv_fds(int sock_fd, void *buf, size_t len,
+                     int *fds, int *fd_count);
+
 #endif // IPC_PROTOCOL_H
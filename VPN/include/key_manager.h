@@ -4,22 +4,45 @@
 #define KEY_MANAGER_H
 
 #include <stdint.h>
+#include <pthread.h>
+#include "hash_index.h"
+#include "id_bitmap.h"
+#include "ipc_protocol.h"
+#include "replay_window.h"
+#include "crypto.h"
 
-#define MAX_KEYS 256
+// 키 테이블 최대 크기 (핸들 슬롯이 KEY_HANDLE_SLOT_BITS(16) 비트이므로 65536)
+// 엔트리는 KEY_CHUNK_SIZE 단위로 필요할 때 할당하고, 청크는 키 관리자 제거 전까지 그대로 둔다.
+#define MAX_KEYS (1 << KEY_HANDLE_SLOT_BITS)
+#define KEY_CHUNK_BITS 8
+#define KEY_CHUNK_SIZE (1 << KEY_CHUNK_BITS)
+#define KEY_CHUNK_COUNT (MAX_KEYS / KEY_CHUNK_SIZE)
+
+// 동시성 (멀티스레드 Enclave)
+//   쓰기 (add_key / remove_key): 제어 스레드에서만, 내부에서 쓰기 잠금
+//   읽기 (데이터 경로 워커): key_manager_read_lock 구간 안에서 조회/사용
+//     → 링 배치 단위로 한 번만 잡으므로 패킷당 비용 없음
+//   엔트리 안의 가변 상태: tx_counter는 원자 증가, rx_window는 엔트리별 스핀락
 
 // 키 엔트리
 typedef struct {
     uint32_t vpn_ip;           // VPN IP (네트워크 바이트 오더)
-    uint8_t session_key[32];   // 세션키
+    crypto_session_t session;  // 세션키 + 협상된 스위트 (AES 키 스케줄 미리 계산)
     int active;                // 활성 여부
+    uint16_t generation;       // 슬롯 세대 (키가 바뀔 때마다 증가, 0은 사용 안 함)
+    uint64_t tx_counter;       // 서버 → 클라이언트 nonce 카운터 (키가 바뀌면 0)
+    replay_window_t rx_window; // 클라이언트 → 서버 재전송 방지 창
+    uint32_t rx_lock;          // rx_window 스핀락 (같은 세션을 여러 워커가 복호화할 때)
 } key_entry_t;
 
 // 키 관리자
 typedef struct {
-    key_entry_t keys[MAX_KEYS];
+    key_entry_t *chunks[KEY_CHUNK_COUNT];   // 슬롯 >> KEY_CHUNK_BITS, 비어 있으면 NULL
+    int chunk_count;           // 할당된 청크 수
+    id_bitmap_t slots;         // 빈 슬롯
+    hash_index_t by_vpn_ip;    // VPN IP → 슬롯 (핸들 없는 요청용)
+    pthread_rwlock_t lock;     // 키 테이블 잠금 (쓰기 우선)
     int count;
-    uint8_t server_private_key[32];  // 서버 비밀키
-    uint8_t server_public_key[32];   // 서버 공개키
 } key_manager_t;
 
 // 키 관리자 초기화
@@ -28,21 +51,51 @@ key_manager_t* init_key_manager(void);
 // 키 관리자 제거
 void destroy_key_manager(key_manager_t *km);
 
-// 키 추가
-int add_key(key_manager_t *km, uint32_t vpn_ip, const uint8_t *session_key);
+// 데이터 경로 읽기 구간 (get_key_entry*가 돌려준 포인터는 이 구간 안에서만 유효)
+// 유일한 쓰기 주체인 제어 스레드는 잠그지 않고 조회해도 됨
+void key_manager_read_lock(key_manager_t *km);
+void key_manager_read_unlock(key_manager_t *km);
+
+// 재전송 창 확인/갱신 (엔트리 스핀락 사용, 의미는 replay_window_check/update와 동일)
+int key_entry_replay_check(key_entry_t *entry, uint64_t counter);
+int key_entry_replay_update(key_entry_t *entry, uint64_t counter);
+
+// 키 추가 (같은 VPN IP가 이미 있으면 그 슬롯의 키를 교체)
+// suite: CRYPTO_SUITE_*
+// 반환값: 키 핸들 (성공), KEY_HANDLE_INVALID (실패)
+key_handle_t add_key(key_manager_t *km, uint32_t vpn_ip, const uint8_t *session_key,
+                     uint8_t suite);
 
-// 키 조회
+// 키 조회 (VPN IP)
 const uint8_t* get_key(key_manager_t *km, uint32_t vpn_ip);
 
+// 키 조회 (핸들: 범위 + 세대 확인만, 탐색 없음)
+// 반환값: 세션키, NULL (오래된/잘못된 핸들)
+const uint8_t* get_key_by_handle(key_manager_t *km, key_handle_t handle);
+
+// 엔트리 조회 (nonce 카운터/재전송 창이 필요한 데이터 경로용)
+key_entry_t* get_key_entry(key_manager_t *km, uint32_t vpn_ip);
+key_entry_t* get_key_entry_by_handle(key_manager_t *km, key_handle_t handle);
+
 // 키 제거
 void remove_key(key_manager_t *km, uint32_t vpn_ip);
 
-// 서버 공개키 가져오기
-void get_server_public_key(key_manager_t *km, uint8_t *public_key);
+// 여러 키 제거 (만료된 세션 정리용, 데이터 경로는 쓰기 잠금을 한 번만 기다림)
+// vpn_ips: 네트워크 바이트 오더
+// 반환값: 실제로 제거된 키 수 (없는 키는 건너뜀)
+int remove_keys(key_manager_t *km, const uint32_t *vpn_ips, int count);
 
-// ECDH 핸드셰이크 수행
+// ECDH 핸드셰이크 수행 (핸드셰이크마다 서버 키 쌍을 새로 만들어 세션키가 매번 다름)
+// offered_suites: 클라이언트가 제안한 스위트 (비트마스크)
+// server_public_key_out: 이번 핸드셰이크의 서버 공개키 출력 (32 bytes)
+// suite_out: 협상된 스위트 출력
+// handle_out: 등록된 세션키의 핸들 출력
 int perform_handshake(key_manager_t *km, uint32_t vpn_ip,
                       const uint8_t *client_public_key,
-                      uint8_t *session_key_out);
+                      uint8_t offered_suites,
+                      uint8_t *server_public_key_out,
+                      uint8_t *session_key_out,
+                      uint8_t *suite_out,
+                      key_handle_t *handle_out);
 
 #endif // KEY_MANAGER_H
@@ -0,0 +1,90 @@
+// include/packet_buf.h
+
+#ifndef PACKET_BUF_H
+#define PACKET_BUF_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 패킷 버퍼 (headroom / tailroom)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// 와이어 패킷을 한 버퍼 안에서 완성하기 위한 레이아웃:
+//
+//   head                data           data+len          end
+//    │ vpn_header │ 카운터 │  IP 패킷 (평문/암호문)  │  MAC  │
+//    └──── PKT_HEADROOM ───┘                       └ TAILROOM ┘
+//
+// TUN은 data 위치로 바로 읽고, 암호화는 제자리에서 하며,
+// 카운터/헤더는 push로 앞에 붙이고 MAC은 put으로 뒤에 붙인다.
+// 수신은 반대로 pull로 헤더/카운터를 벗긴다. 어느 단계에서도 payload 복사 없음.
+
+#define PKT_BUF_SIZE 2048
+#define PKT_HEADROOM 24            // vpn_header_t(16) + counter(8)
+#define PKT_TAILROOM 16            // Poly1305 MAC
+
+typedef struct {
+    uint8_t *head;                 // 버퍼 시작
+    uint8_t *data;                 // 현재 패킷 시작
+    size_t len;                    // 현재 패킷 길이
+    uint8_t *end;                  // 버퍼 끝
+} packet_buf_t;
+
+// 버퍼 연결 (data = head + headroom, 빈 패킷)
+static inline void pkt_buf_init(packet_buf_t *pkt, uint8_t *mem, size_t size, size_t headroom) {
+    pkt->head = mem;
+    pkt->data = mem + headroom;
+    pkt->len = 0;
+    pkt->end = mem + size;
+}
+
+// 앞쪽 여유 공간
+static inline size_t pkt_headroom(const packet_buf_t *pkt) {
+    return (size_t)(pkt->data - pkt->head);
+}
+
+// 뒤쪽 여유 공간 (data + len 이후)
+static inline size_t pkt_tailroom(const packet_buf_t *pkt) {
+    return (size_t)(pkt->end - (pkt->data + pkt->len));
+}
+
+// 앞에 n 바이트 붙이기 (반환값: 새 data, 공간 부족 시 NULL)
+static inline uint8_t* pkt_push(packet_buf_t *pkt, size_t n) {
+    if (pkt_headroom(pkt) < n) {
+        return NULL;
+    }
+    pkt->data -= n;
+    pkt->len += n;
+    return pkt->data;
+}
+
+// 앞에서 n 바이트 떼기 (반환값: 떼어낸 부분의 시작, 길이 부족 시 NULL)
+static inline uint8_t* pkt_pull(packet_buf_t *pkt, size_t n) {
+    if (pkt->len < n) {
+        return NULL;
+    }
+    uint8_t *old = pkt->data;
+    pkt->data += n;
+    pkt->len -= n;
+    return old;
+}
+
+// 뒤에 n 바이트 붙이기 (반환값: 붙인 부분의 시작, 공간 부족 시 NULL)
+static inline uint8_t* pkt_put(packet_buf_t *pkt, size_t n) {
+    if (pkt_tailroom(pkt) < n) {
+        return NULL;
+    }
+    uint8_t *tail = pkt->data + pkt->len;
+    pkt->len += n;
+    return tail;
+}
+
+// 길이를 len으로 줄이기 (MAC 제거 등)
+static inline void pkt_trim(packet_buf_t *pkt, size_t len) {
+    if (len < pkt->len) {
+        pkt->len = len;
+    }
+}
+
+#endif // PACKET_BUF_H
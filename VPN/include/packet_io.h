@@ -0,0 +1,78 @@
+// include/packet_io.h
+
+#ifndef PACKET_IO_H
+#define PACKET_IO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 패킷 I/O 백엔드 (TUN 자리)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// 데이터 경로는 TUN fd에 패킷 1개 = read/write 1회로 접근한다.
+// pcap 백엔드는 TUN 대신 AF_UNIX SOCK_SEQPACKET 소켓쌍의 한쪽을 돌려주고,
+// 반대쪽은 백엔드 스레드가 맡는다 (데이터 경로 코드는 그대로):
+//
+//   replay: pcap 파일의 IP 패킷을 원래 간격 또는 최대 속도로 써 넣음
+//           → 데이터 경로에는 TUN에서 읽은 패킷으로 보임
+//   record: 데이터 경로가 TUN에 쓰려던 패킷을 pcap 파일로 기록
+//           (파일이 없으면 읽어서 버림)
+//
+// 루트 권한이나 커널 장치 없이 캡처한 트래픽을 똑같이 흘려 넣을 수 있다.
+// 오프로드(virtio_net_hdr)는 TUN 백엔드에서만 쓰인다.
+
+#define PACKET_IO_MTU        1500     // replay 최대 패킷 (TUN 기본 MTU, 넘으면 건너뜀)
+#define PACKET_IO_SNAPLEN    65535    // record 파일 snaplen
+#define PACKET_IO_SOCK_BUF   (4 * 1024 * 1024)
+
+typedef enum {
+    PACKET_IO_TUN = 0,
+    PACKET_IO_PCAP
+} packet_io_type_t;
+
+typedef struct {
+    packet_io_type_t type;
+    const char *dev_name;      // TUN: 장치 이름
+    int tun_flags;             // TUN: TUN_OFFLOAD 등
+    const char *replay_path;   // PCAP: 주입할 캡처 (NULL = 없음)
+    const char *record_path;   // PCAP: 기록할 파일 (NULL = 버림)
+    int replay_max_rate;       // PCAP: 1 = 타임스탬프 무시하고 최대 속도
+} packet_io_config_t;
+
+// 백엔드 상태 (0으로 초기화된 상태에서 packet_io_close 호출 가능)
+typedef struct {
+    packet_io_type_t type;
+    int peer_fd;               // PCAP: 백엔드 스레드 쪽 소켓
+
+    pthread_t replay_thread;
+    pthread_t record_thread;
+    int replay_started;
+    int record_started;
+
+    FILE *replay_file;
+    FILE *record_file;
+    int replay_swapped;        // 파일 바이트 오더가 반대
+    int replay_nsec;           // 타임스탬프 단위가 나노초
+    uint32_t replay_linktype;
+    int replay_max_rate;
+
+    uint64_t replayed;         // 주입한 패킷
+    uint64_t skipped;          // 건너뛴 레코드 (IP 아님, 잘림, MTU 초과)
+    uint64_t recorded;         // 기록(또는 버린) 패킷
+} packet_io_t;
+
+// 백엔드 열기
+// fds: 데이터 경로 fd (출력, count개). TUN fd처럼 호출자가 close 한다.
+// count: TUN 큐 수 (PCAP은 1만 지원)
+// 반환값: 0 (성공), -1 (실패, 연 자원은 모두 정리됨)
+int packet_io_open(packet_io_t *io, const packet_io_config_t *config, int *fds, int count);
+
+// 백엔드 스레드 정리 + 통계 출력 (데이터 경로 fd는 닫지 않음)
+void packet_io_close(packet_io_t *io);
+
+// 백엔드 이름 ("tun" / "pcap")
+const char* packet_io_name(packet_io_type_t type);
+
+#endif // PACKET_IO_H
@@ -38,6 +38,7 @@ typedef struct {
     vpn_header_t header;
     char username[32];       // 사용자 이름
     uint8_t auth_token[32];  // 인증 토큰
+    uint8_t cipher_suites;   // 제안하는 암호 스위트 (CRYPTO_SUITE_* 비트마스크, 0=구버전)
 } connect_request_t;
 #pragma pack(pop)
 
@@ -49,6 +50,8 @@ typedef struct {
     uint32_t vpn_ip;         // 할당된 VPN IP (네트워크 바이트 오더)
     uint32_t session_id;     // 세션 ID
     uint8_t server_public_key[32];
+    uint8_t cipher_suite;    // 서버가 고른 암호 스위트 (CRYPTO_SUITE_*)
+    uint8_t pool_prefix;     // VPN IP 풀 프리픽스 (클라이언트 TUN 넷마스크, 0=구버전 → /24)
 } __attribute__((packed)) connect_response_t;
 #pragma pack(pop)
 
@@ -0,0 +1,41 @@
+// include/replay_window.h
+
+#ifndef REPLAY_WINDOW_H
+#define REPLAY_WINDOW_H
+
+#include <stdint.h>
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 재전송 방지 슬라이딩 창 (카운터 nonce 수신 측)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// 지금까지 본 가장 큰 카운터(last) 아래 REPLAY_WINDOW_SIZE개를 비트맵으로 기억한다.
+// 비트맵은 64비트 워드의 링이라 창이 앞으로 움직일 때 비트 시프트 없이
+// 지나간 워드만 0으로 지운다 (RFC 6479). 검사/갱신 모두 O(1).
+//
+//   replay_window_check:  복호화 전에 중복/너무 오래된 패킷을 거름 (상태 변경 없음)
+//   replay_window_update: 인증(MAC) 성공 후에만 호출 → 위조 패킷은 창을 못 움직임
+//
+// 잠금은 하지 않는다. 여러 스레드가 한 창을 쓰면 호출자가 감쌀 것 (key_entry_replay_*).
+
+#define REPLAY_WINDOW_BITS  2048                            // 비트맵 크기 (2의 거듭제곱)
+#define REPLAY_WINDOW_WORDS (REPLAY_WINDOW_BITS / 64)
+#define REPLAY_WINDOW_SIZE  (REPLAY_WINDOW_BITS - 64)      // 받아주는 과거 범위
+
+typedef struct {
+    uint64_t last;                                  // 지금까지 받은 가장 큰 카운터
+    uint64_t bitmap[REPLAY_WINDOW_WORDS];
+} replay_window_t;
+
+// 창 초기화 (새 세션)
+void replay_window_init(replay_window_t *win);
+
+// 받아도 되는 카운터인지 확인
+// 반환값: 0 (새 카운터), -1 (중복 또는 창보다 오래됨)
+int replay_window_check(const replay_window_t *win, uint64_t counter);
+
+// 카운터를 받은 것으로 기록 (창 이동)
+// 반환값: 0 (기록), -1 (그 사이 중복이 되었음)
+int replay_window_update(replay_window_t *win, uint64_t counter);
+
+#endif // REPLAY_WINDOW_H
@@ -0,0 +1,295 @@
+// include/server_stats.h
+
+#ifndef SERVER_STATS_H
+#define SERVER_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <netinet/in.h>
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 서버 통계 (공유 메모리 카운터)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// 데이터 경로 카운터를 이름 있는 공유 메모리(/dev/shm/vpn_server_stats)에 두고,
+// vpn_stat 같은 외부 도구가 읽기 전용으로 mmap 해서 읽는다.
+// 읽는 쪽은 서버에 아무 요청(소켓/시그널)도 보내지 않으므로 수집이 패킷 처리를 늦추지 않는다.
+//
+//   [헤더][워커 카운터 × W][클라이언트 카운터 × W × C][클라이언트 메타 × C]
+//
+// 카운터 블록은 워커(스레드)마다 따로 있고 캐시 라인 단위로 정렬되어 있어
+// 블록마다 쓰는 스레드가 하나뿐이다 → 락이나 원자적 RMW 없이 relaxed store로 증가.
+// 읽는 쪽은 워커 블록을 더해서 본다 (정렬된 64비트 load는 찢어지지 않음).
+// 클라이언트 메타(주소, 세션 ID, RTT)는 메인 스레드만 쓰고 seqlock으로 묶어서 읽는다.
+//
+// 단계별 지연 히스토그램 (워커마다, 읽는 쪽에서 합침):
+//   [... 클라이언트 메타][지연 히스토그램 × W]
+// 켜져 있을 때만 단계 앞뒤로 TSC를 읽어 기록한다 (꺼져 있으면 플래그 확인 1번).
+// 값은 CPU 사이클 그대로 저장하고, 읽는 쪽이 헤더의 cycles_per_ms로 시간으로 바꾼다.
+
+#define STATS_SHM_NAME       "/vpn_server_stats"
+#define STATS_MAGIC          0x56504e53   // "VPNS"
+#define STATS_VERSION        2
+#define STATS_CACHE_LINE     64
+#define STATS_BATCH_BUCKETS  8            // 배치 크기 분포: 1, 2-3, 4-7, ..., 128 이상
+#define STATS_RTT_PROBE_SEC  10           // RTT 측정 PING 주기 (초)
+#define STATS_RTT_MAX_NS     (10ULL * 1000000000ULL)   // 이보다 늦은 PONG은 무시
+
+// 지연 히스토그램 (HDR 방식 로그-선형 칸)
+// 2^SUB_BITS 미만은 1사이클 단위, 그 위는 2배 구간마다 2^SUB_BITS 칸 (상대 오차 ~3%)
+#define STATS_HIST_SUB_BITS  5
+#define STATS_HIST_MAX_BITS  40           // 2^40 사이클 (3GHz에서 약 6분) 이상은 마지막 칸
+#define STATS_HIST_BUCKETS   ((STATS_HIST_MAX_BITS - STATS_HIST_SUB_BITS + 1) << STATS_HIST_SUB_BITS)
+
+// 클라이언트별 드롭 사유
+typedef enum {
+    CLIENT_DROP_ENCRYPT = 0,      // Enclave 암호화 실패 (키 없음 등)
+    CLIENT_DROP_TUN_WRITE,        // 복호화 후 TUN 쓰기 실패
+    CLIENT_DROP_UDP_SEND,         // 송신 버퍼 가득 / sendmmsg 실패
+    CLIENT_DROP_MAX
+} client_drop_t;
+
+// 클라이언트를 특정할 수 없는 드롭 (워커 전역)
+typedef enum {
+    STATS_DROP_SHORT = 0,         // 헤더보다 짧은 패킷
+    STATS_DROP_UNKNOWN_CLIENT,    // 등록되지 않은 주소에서 온 DATA
+    STATS_DROP_NO_ROUTE,          // 목적지 VPN IP의 클라이언트 없음
+    STATS_DROP_IPV6,              // IPv6 (미지원)
+    STATS_DROP_OVERSIZE,          // 슬롯보다 큰 GRO 세그먼트
+    STATS_DROP_BAD_OFFLOAD,       // 체크섬 오프셋 / GSO 타입 오류
+    STATS_DROP_IPC,               // Enclave 링 제출 실패로 버린 패킷
+    STATS_DROP_MAX
+} stats_drop_t;
+
+// 지연 측정 단계
+typedef enum {
+    STATS_STAGE_UDP_RECV = 0,     // recvmmsg 1회 (UDP → TUN)
+    STATS_STAGE_DECRYPT,          // Enclave 복호화 왕복 (링 제출 ~ 완료)
+    STATS_STAGE_TUN_WRITE,        // 복호화된 배치 TUN 쓰기 (GRO flush 포함)
+    STATS_STAGE_RX_TOTAL,         // handle_udp_to_tun 1회 전체
+    STATS_STAGE_TUN_READ,         // TUN read 1회 (TUN → UDP, TSO 묶음 포함)
+    STATS_STAGE_ENCRYPT,          // Enclave 암호화 왕복
+    STATS_STAGE_UDP_SEND,         // sendmmsg (udp_send_batch 1회)
+    STATS_STAGE_TX_TOTAL,         // handle_tun_to_udp 1회 전체
+    STATS_STAGE_SCHED,            // epoll 깨어남 ~ 해당 fd 처리 시작 (루프 안 대기)
+    STATS_STAGE_MAX
+} stats_stage_t;
+
+// 클라이언트 카운터 (워커 × 슬롯, 캐시 라인 1개)
+typedef struct {
+    uint64_t rx_packets;          // UDP → TUN (복호화 성공)
+    uint64_t rx_bytes;            // 평문 바이트
+    uint64_t tx_packets;          // TUN → UDP (전송 성공)
+    uint64_t tx_bytes;            // UDP 페이로드 바이트
+    uint64_t decrypt_failures;    // 키 불일치 / 변조 / 재전송
+    uint64_t drops[CLIENT_DROP_MAX];
+} __attribute__((aligned(STATS_CACHE_LINE))) stats_client_t;
+
+// 워커 전역 카운터
+typedef struct {
+    // UDP
+    uint64_t udp_rx_calls;        // recvmmsg 호출
+    uint64_t udp_rx_packets;      // 받은 데이터그램 (GRO 묶음은 세그먼트 단위)
+    uint64_t udp_rx_eagain;       // 빈 소켓에서 돌아온 호출
+    uint64_t udp_tx_calls;        // udp_send_batch 호출
+    uint64_t udp_tx_messages;     // 보낸 메시지 (GSO 메시지는 패킷 여러 개)
+    uint64_t udp_tx_eagain;       // 보내지 못한 메시지 (송신 버퍼 가득 등)
+
+    // TUN
+    uint64_t tun_rx_packets;      // read 1회 = 1 (TSO 묶음도 1)
+    uint64_t tun_rx_eagain;       // 큐가 비어 읽기를 끝낸 횟수
+    uint64_t tun_tx_packets;
+    uint64_t tun_tx_errors;
+
+    // Enclave IPC (enclave_ring_process 1회 = 배치 1개)
+    uint64_t ipc_batches;
+    uint64_t ipc_packets;
+    uint64_t ipc_ns_total;        // 제출 ~ 완료 대기 시간 합
+    uint64_t ipc_ns_max;
+    uint64_t ipc_failures;        // 링 예약/제출 실패
+
+    uint64_t rx_batch_hist[STATS_BATCH_BUCKETS];   // 복호화 배치 크기 분포
+    uint64_t tx_batch_hist[STATS_BATCH_BUCKETS];   // 암호화 배치 크기 분포
+    uint64_t drops[STATS_DROP_MAX];
+} __attribute__((aligned(STATS_CACHE_LINE))) stats_worker_t;
+
+// 지연 히스토그램 1개 (값 단위: 사이클)
+typedef struct {
+    uint64_t count;
+    uint64_t total;
+    uint64_t max;
+    uint64_t buckets[STATS_HIST_BUCKETS];
+} __attribute__((aligned(STATS_CACHE_LINE))) stats_hist_t;
+
+// 워커 1개의 단계별 히스토그램
+typedef struct {
+    stats_hist_t stages[STATS_STAGE_MAX];
+} stats_latency_t;
+
+// 클라이언트 메타 (메인 스레드만 씀, seqlock)
+typedef struct {
+    uint32_t seq;                 // 홀수 = 쓰는 중
+    uint32_t active;
+    uint32_t vpn_ip;              // 네트워크 바이트 오더
+    uint32_t real_ip;             // 네트워크 바이트 오더
+    uint16_t real_port;           // 네트워크 바이트 오더
+    uint16_t reserved;
+    uint32_t session_id;
+    int64_t connected_at;         // time_t
+    uint64_t last_rtt_ns;         // 마지막 PING/PONG 왕복 (0 = 측정 전)
+    int64_t rtt_measured_at;      // time_t
+} stats_client_meta_t;
+
+// 세그먼트 헤더 (magic은 나머지를 다 채운 뒤 마지막에 씀)
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t worker_count;
+    uint32_t client_capacity;
+    uint64_t size;                // 세그먼트 전체 크기
+    uint64_t workers_offset;      // stats_worker_t[worker_count]
+    uint64_t clients_offset;      // stats_client_t[worker_count][client_capacity]
+    uint64_t meta_offset;         // stats_client_meta_t[client_capacity]
+    uint64_t latency_offset;      // stats_latency_t[worker_count]
+    uint64_t cycles_per_ms;       // 히스토그램 값 → 시간 환산
+    int64_t started_at;           // 서버 시작 시각 (time_t)
+    int32_t pid;                  // 서버 PID
+    uint32_t batch_size;          // 배치 최대 크기 (BATCH_SIZE)
+    uint32_t latency_enabled;     // 지연 측정 중 (서버가 상태를 옮겨 적음)
+} __attribute__((aligned(STATS_CACHE_LINE))) stats_header_t;
+
+// 세그먼트 핸들 (서버: 읽기/쓰기, 도구: 읽기 전용)
+typedef struct {
+    stats_header_t *header;
+    size_t size;
+    char name[64];                // shm 이름 (익명 메모리면 빈 문자열)
+    int owner;                    // 1 = 만든 쪽 (닫을 때 shm_unlink)
+} server_stats_t;
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 함수 선언
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 세그먼트 생성 (서버)
+// name: shm 이름 (NULL = 프로세스 전용 익명 메모리, 카운터는 그대로 동작)
+// 반환값: 0 (성공), -1 (실패)
+int server_stats_create(server_stats_t *stats, const char *name,
+                        int worker_count, int client_capacity, int batch_size);
+
+// 세그먼트 읽기 전용 연결 (vpn_stat)
+// 반환값: 0 (성공), -1 (없음 / 버전 불일치)
+int server_stats_attach(server_stats_t *stats, const char *name);
+
+// 매핑 해제 (만든 쪽이면 이름도 제거)
+void server_stats_close(server_stats_t *stats);
+
+// 클라이언트 등록 / 해제 (메인 스레드, 슬롯 카운터를 0으로 되돌림)
+void server_stats_client_up(server_stats_t *stats, int slot, uint32_t vpn_ip,
+                            const struct sockaddr_in *addr, uint32_t session_id,
+                            time_t connected_at);
+void server_stats_client_down(server_stats_t *stats, int slot);
+
+// 클라이언트 RTT 기록 (메인 스레드)
+void server_stats_client_rtt(server_stats_t *stats, int slot, uint64_t rtt_ns);
+
+// 클라이언트 메타 일관된 복사본 읽기
+void server_stats_read_meta(const server_stats_t *stats, int slot, stats_client_meta_t *out);
+
+// 워커 블록 합산
+void server_stats_sum_workers(const server_stats_t *stats, stats_worker_t *out);
+void server_stats_sum_client(const server_stats_t *stats, int slot, stats_client_t *out);
+
+// 지연 측정 상태를 세그먼트에 표시 (서버)
+void server_stats_set_latency(server_stats_t *stats, int enabled);
+
+// 단계 히스토그램을 모든 워커에서 합침
+void server_stats_merge_latency(const server_stats_t *stats, int stage, stats_hist_t *out);
+
+// 히스토그램 백분위 (q = 0..1, 칸의 중간값, 사이클)
+uint64_t stats_hist_percentile(const stats_hist_t *hist, double q);
+
+// 사이클 → 마이크로초
+double server_stats_cycles_to_us(const server_stats_t *stats, uint64_t cycles);
+
+// 단계 이름 ("udp_recv" 등)
+const char* stats_stage_name(int stage);
+
+// 워커 w의 전역 카운터
+static inline stats_worker_t* server_stats_worker(const server_stats_t *stats, int w) {
+    return (stats_worker_t*)((uint8_t*)stats->header + stats->header->workers_offset) + w;
+}
+
+// 워커 w의 클라이언트 카운터 배열 (슬롯 번호로 인덱스)
+static inline stats_client_t* server_stats_clients(const server_stats_t *stats, int w) {
+    return (stats_client_t*)((uint8_t*)stats->header + stats->header->clients_offset) +
+           (size_t)w * stats->header->client_capacity;
+}
+
+// 슬롯의 클라이언트 메타
+static inline stats_client_meta_t* server_stats_meta(const server_stats_t *stats, int slot) {
+    return (stats_client_meta_t*)((uint8_t*)stats->header + stats->header->meta_offset) + slot;
+}
+
+// 워커 w의 지연 히스토그램
+static inline stats_latency_t* server_stats_latency(const server_stats_t *stats, int w) {
+    return (stats_latency_t*)((uint8_t*)stats->header + stats->header->latency_offset) + w;
+}
+
+// 카운터 증가 (블록 주인 스레드만 호출, 읽는 쪽이 찢어진 값을 보지 않도록 원자적 store)
+static inline void stats_add(uint64_t *counter, uint64_t n) {
+    __atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+static inline void stats_max(uint64_t *counter, uint64_t value) {
+    if (value > *counter) {
+        __atomic_store_n(counter, value, __ATOMIC_RELAXED);
+    }
+}
+
+// 배치 크기 → 분포 버킷 (floor(log2(n)), 마지막 버킷에 모음)
+static inline int stats_batch_bucket(int n) {
+    int bucket = n > 1 ? 31 - __builtin_clz((unsigned)n) : 0;
+    return bucket < STATS_BATCH_BUCKETS ? bucket : STATS_BATCH_BUCKETS - 1;
+}
+
+// 값 → 히스토그램 칸
+static inline int stats_hist_index(uint64_t value) {
+    if (value < (1ULL << STATS_HIST_SUB_BITS)) {
+        return (int)value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    if (msb >= STATS_HIST_MAX_BITS) {
+        return STATS_HIST_BUCKETS - 1;
+    }
+    int shift = msb - STATS_HIST_SUB_BITS;
+    return ((shift + 1) << STATS_HIST_SUB_BITS) + (int)(value >> shift) - (1 << STATS_HIST_SUB_BITS);
+}
+
+// 히스토그램 기록 (주인 워커만 호출)
+static inline void stats_hist_record(stats_hist_t *hist, uint64_t value) {
+    stats_add(&hist->count, 1);
+    stats_add(&hist->total, value);
+    stats_max(&hist->max, value);
+    stats_add(&hist->buckets[stats_hist_index(value)], 1);
+}
+
+// CPU 사이클 (x86은 TSC, 그 밖에는 나노초로 대신)
+static inline uint64_t stats_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// 단조 시계 (나노초, vDSO라 시스템 콜 없음)
+static inline uint64_t stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+#endif // SERVER_STATS_H
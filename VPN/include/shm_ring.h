@@ -0,0 +1,129 @@
+// include/shm_ring.h
+
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 공유 메모리 링 (vpn_server ↔ vpn_enclave 데이터 경로)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// ENCRYPT/DECRYPT 는 Unix 소켓 대신 이 링으로 전달된다.
+// (HANDSHAKE, ADD_KEY 같은 제어 명령은 계속 소켓 사용)
+//
+//   서버:    슬롯 작성 → sq_tail 증가 → (Enclave가 자고 있으면) sq_eventfd 깨움
+//   Enclave: sq_tail까지 처리 → cq_tail 증가 → (서버가 자고 있으면) cq_eventfd 깨움
+//   서버:    cq_tail까지 결과 회수 → cq_head 증가 (슬롯 반환)
+//
+// Enclave는 요청을 순서대로 처리하므로 완료 순서 = 제출 순서.
+// eventfd 는 상대방이 idle 플래그를 세운 경우에만 write 한다.
+
+#define SHM_RING_ENTRIES   256          // 2의 거듭제곱
+#define SHM_RING_MASK      (SHM_RING_ENTRIES - 1)
+#define SHM_RING_SLOT_SIZE 2048         // 슬롯당 데이터 버퍼 (MTU 패킷 + 암호화 오버헤드)
+#define SHM_RING_HEADROOM  8            // ENCRYPT 입력 앞에 비워둘 공간 (카운터 자리)
+#define SHM_RING_SPIN      2000         // 잠들기 전 busy-poll 횟수
+#define SHM_RING_WAIT_MS   1000         // 완료 대기 최대 시간
+#define SHM_CACHE_LINE     64
+
+// 링 슬롯 (요청과 결과를 같은 슬롯에 기록, Enclave는 in-place 처리)
+//   ENCRYPT: [headroom(8)][평문]       → [카운터][암호문 + MAC]
+//   DECRYPT: [카운터][암호문 + MAC]    → [카운터 자리][평문]
+typedef struct {
+    uint8_t  command;          // IPC_ENCRYPT / IPC_DECRYPT
+    int8_t   status;           // 0=성공, -1=실패 (Enclave가 기록)
+    uint16_t data_off;         // 요청: 입력 시작 오프셋 / 완료: 출력 시작 오프셋
+    uint16_t data_len;         // 요청: 입력 길이 / 완료: 출력 길이
+    uint16_t reserved;
+    uint32_t request_id;       // 요청 ID
+    uint32_t vpn_ip;           // 클라이언트 VPN IP (네트워크 바이트 오더)
+    uint32_t key_handle;       // 키 핸들 (0이면 vpn_ip로 조회)
+    uint8_t  data[SHM_RING_SLOT_SIZE];
+} shm_ring_slot_t;
+
+// 공유 메모리 레이아웃 (생산자/소비자 인덱스는 캐시 라인 분리)
+typedef struct {
+    // 서버가 쓰는 값
+    uint32_t sq_tail __attribute__((aligned(SHM_CACHE_LINE)));
+    uint32_t cq_head;
+    uint32_t server_waiting;   // 1 = 서버가 cq_eventfd에서 대기 중
+
+    // Enclave가 쓰는 값
+    uint32_t cq_tail __attribute__((aligned(SHM_CACHE_LINE)));
+    uint32_t enclave_idle;     // 1 = Enclave가 sq_eventfd에서 대기 중
+
+    shm_ring_slot_t slots[SHM_RING_ENTRIES] __attribute__((aligned(SHM_CACHE_LINE)));
+} shm_ring_shared_t;
+
+// 프로세스 로컬 핸들
+typedef struct {
+    shm_ring_shared_t *shared; // mmap된 공유 영역
+    int mem_fd;                // memfd (공유 메모리)
+    int sq_event_fd;           // 서버 → Enclave 알림
+    int cq_event_fd;           // Enclave → 서버 알림
+} shm_ring_t;
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 생성 / 매핑
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 링 생성 (서버 측): memfd + eventfd 2개 생성 후 매핑
+// 반환값: 0 (성공), -1 (실패)
+int shm_ring_create(shm_ring_t *ring);
+
+// 전달받은 fd로 링 매핑 (Enclave 측)
+// 반환값: 0 (성공), -1 (실패)
+int shm_ring_map(shm_ring_t *ring, int mem_fd, int sq_event_fd, int cq_event_fd);
+
+// 링 해제 (매핑 해제 + fd 닫기)
+void shm_ring_destroy(shm_ring_t *ring);
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 서버 측 (생산자)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 사용 가능한 슬롯 수
+uint32_t shm_ring_free_slots(const shm_ring_t *ring);
+
+// 제출했지만 아직 반환하지 않은 슬롯 수
+uint32_t shm_ring_in_flight(const shm_ring_t *ring);
+
+// 현재 sq_tail (절대 인덱스)
+uint32_t shm_ring_tail(const shm_ring_t *ring);
+
+// sq_tail 위치의 슬롯 (index번째 다음 슬롯)
+shm_ring_slot_t* shm_ring_next_slot(shm_ring_t *ring, uint32_t index);
+
+// count개 슬롯 제출 (필요할 때만 Enclave 깨움)
+void shm_ring_submit(shm_ring_t *ring, uint32_t count);
+
+// target(절대 인덱스)까지 완료될 때까지 대기 (spin → eventfd)
+// 반환값: 0 (성공), -1 (실패 또는 SHM_RING_WAIT_MS 초과)
+int shm_ring_wait(shm_ring_t *ring, uint32_t target);
+
+// 완료된 슬롯 반환
+void shm_ring_release(shm_ring_t *ring, uint32_t count);
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// Enclave 측 (소비자)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 처리 대기 중인 요청 수
+uint32_t shm_ring_pending(const shm_ring_t *ring);
+
+// cq_tail 위치의 슬롯 (index번째 다음 슬롯)
+shm_ring_slot_t* shm_ring_pending_slot(shm_ring_t *ring, uint32_t index);
+
+// count개 요청 완료 (필요할 때만 서버 깨움)
+void shm_ring_complete(shm_ring_t *ring, uint32_t count);
+
+// 잠들기 준비: idle 플래그를 세운 뒤에도 요청이 없으면 1 반환
+// (0이면 그 사이 요청이 들어온 것이므로 계속 처리)
+int shm_ring_prepare_sleep(shm_ring_t *ring);
+
+// sq_eventfd 알림 소비 + idle 해제
+void shm_ring_wakeup_ack(shm_ring_t *ring);
+
+#endif // SHM_RING_H
@@ -0,0 +1,61 @@
+// include/timer_wheel.h
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 계층형 타이머 휠
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// 클라이언트 세션 만료 / keepalive 처럼 "대부분 취소되거나 다시 걸리는" 타이머용.
+// - 단계마다 64칸, 칸은 이중 연결 리스트 → 걸기 / 다시 걸기 / 취소 모두 O(1)
+// - 0단계 1칸 = 1틱, 위 단계로 갈수록 64배 (4단계 = 64^4 틱, 1틱 = 1초면 약 194일)
+// - 0단계가 한 바퀴 돌 때마다 위 단계 칸 하나를 아래로 다시 나눠 담음 (cascade)
+// - 노드는 호출자 구조체 안에 두고, id로 주인을 찾는다 (할당 없음)
+//
+// 잠금은 하지 않는다. 한 스레드(메인 이벤트 루프)에서만 쓸 것.
+
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+
+typedef struct timer_node {
+    struct timer_node *next;
+    struct timer_node *prev;      // NULL = 걸려 있지 않음
+    uint64_t expires;             // 만료 틱
+    uint32_t id;                  // 호출자 식별용 (클라이언트 슬롯 등)
+} timer_node_t;
+
+typedef struct {
+    timer_node_t slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];   // 칸마다 리스트 머리
+    uint64_t now;                 // 처리가 끝난 마지막 틱
+    uint32_t count;               // 걸려 있는 타이머 수
+} timer_wheel_t;
+
+// 만료 콜백 (노드는 이미 빠진 상태라 콜백 안에서 다시 걸어도 됨)
+typedef void (*timer_fn_t)(timer_node_t *node, void *arg);
+
+// 휠 초기화 (now = 현재 틱)
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t now);
+
+// 노드 초기화 (걸려 있지 않은 상태)
+void timer_node_init(timer_node_t *node, uint32_t id);
+
+// 타이머 걸기 (이미 걸려 있으면 옮김, 지난 틱이면 다음 틱에 만료)
+void timer_wheel_arm(timer_wheel_t *wheel, timer_node_t *node, uint64_t expires);
+
+// 타이머 취소 (걸려 있지 않으면 무시)
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_node_t *node);
+
+// now 틱까지 진행하며 만료된 타이머마다 fn 호출
+// 반환값: 만료된 타이머 수
+int timer_wheel_advance(timer_wheel_t *wheel, uint64_t now, timer_fn_t fn, void *arg);
+
+static inline int timer_armed(const timer_node_t *node) {
+    return node->prev != NULL;
+}
+
+#endif // TIMER_WHEEL_H
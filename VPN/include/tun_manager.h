@@ -4,11 +4,112 @@
 #define TUN_MANAGER_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <linux/virtio_net.h>
+
+// TUN flags
+#define TUN_OFFLOAD 0x01   // IFF_VNET_HDR + TUNSETOFFLOAD (CSUM, TSO4, TSO6)
+
+// Offload mode buffers
+#define TUN_VNET_HDR_LEN     sizeof(struct virtio_net_hdr)
+#define TUN_GSO_BUF_SIZE     65536   // one GSO super-packet
+#define TUN_GRO_MAX_SEGMENTS 64      // max packets per coalesced write
 
 // Create TUN Interface
 int create_tun_interface(const char *dev_name);
 
+// Create TUN Interface with flags (TUN_OFFLOAD)
+// return fd, -1(fail)
+// With TUN_OFFLOAD every read/write carries a struct virtio_net_hdr in front.
+// If the kernel refuses the offloads the fd is still returned, without them:
+// check with tun_offload_enabled().
+int create_tun_interface_flags(const char *dev_name, int flags);
+
+// Create multi-queue TUN Interface (IFF_MULTI_QUEUE)
+// dev_name: device name
+// fds: queue fds (output, count entries)
+// count: number of queues to open
+// flags: TUN_OFFLOAD or 0
+// return 0, -1(fail, every opened queue is closed)
+int create_tun_queues(const char *dev_name, int *fds, int count, int flags);
+
+// Whether fd was opened with IFF_VNET_HDR and offloads accepted
+// return 1, 0
+int tun_offload_enabled(int tun_fd);
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// Offload mode: read side (TSO super-packets → MTU segments)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// Read one packet with its virtio_net_hdr
+// buf/buf_len: preferred destination (e.g. ring slot)
+// stage: TUN_GSO_BUF_SIZE bytes, used when the packet is a GSO super-packet
+//        or does not fit buf
+// packet: (output) buf or stage, whichever holds the whole packet
+// return packet length, -1(fail, errno kept; EAGAIN = empty)
+ssize_t tun_read_offload(int tun_fd, struct virtio_net_hdr *vh,
+                         uint8_t *buf, size_t buf_len, uint8_t *stage,
+                         uint8_t **packet);
+
+// Complete a partial checksum (VIRTIO_NET_HDR_F_NEEDS_CSUM) in place
+// return 0, -1(bad csum_start/csum_offset)
+int tun_finish_checksum(const struct virtio_net_hdr *vh, uint8_t *pkt, size_t len);
+
+// TCP segmentation iterator
+typedef struct {
+    const uint8_t *pkt;   // super-packet
+    size_t len;
+    size_t l4_off;        // TCP header offset
+    size_t hdr_len;       // IP + TCP headers
+    size_t mss;           // payload bytes per segment
+    size_t off;           // payload consumed
+    uint16_t index;       // segment number
+    int ipv6;
+} tun_gso_iter_t;
+
+// Start segmenting (gso_type TCPV4 / TCPV6)
+// return 0, -1(unsupported or malformed)
+int tun_gso_begin(tun_gso_iter_t *it, const struct virtio_net_hdr *vh,
+                  const uint8_t *pkt, size_t len);
+
+// Write next segment to out (headers fixed, IP/TCP checksums complete)
+// return segment length, 0(done), -1(segment larger than out_size)
+ssize_t tun_gso_next(tun_gso_iter_t *it, uint8_t *out, size_t out_size);
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// Offload mode: write side (consecutive TCP segments → one GSO write)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// Packets are referenced, not copied: they must stay valid until
+// tun_gro_flush(). The first packet's IP/TCP headers are rewritten on flush.
+
+typedef struct {
+    struct virtio_net_hdr vh;
+    struct iovec iov[TUN_GRO_MAX_SEGMENTS + 1];   // [0] = vh, [1] = first packet, then payloads
+    int segments;         // 0 = empty
+    uint8_t *first;
+    size_t l4_off;
+    size_t hdr_len;
+    size_t mss;
+    size_t total;         // coalesced packet length
+    uint32_t next_seq;
+    uint8_t push;         // PSH seen (closes the run)
+    int closed;           // short segment or PSH: no more appends
+    int ipv6;
+} tun_gro_t;
+
+void tun_gro_init(tun_gro_t *gro);
+
+// Add one decrypted IP packet (coalesce or write)
+// return 0, -1(write fail)
+int tun_gro_add(tun_gro_t *gro, int tun_fd, uint8_t *pkt, size_t len);
+
+// Write out pending coalesced packet
+// return 0, -1(write fail)
+int tun_gro_flush(tun_gro_t *gro, int tun_fd);
+
 // TUN Interface IP Configuration
 // dev: device name
 // ip: IP
@@ -5,12 +5,40 @@
 
 #include <stdint.h>
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+// UDP 오프로드 (커널이 지원할 때만 켜짐)
+#define UDP_OFFLOAD_GSO      0x01   // UDP_SEGMENT: 같은 크기 데이터그램 묶음 전송
+#define UDP_OFFLOAD_GRO      0x02   // UDP_GRO: 수신 데이터그램을 묶어서 전달
+
+#define UDP_GSO_MAX_BYTES    65507  // 묶음 1개 최대 페이로드 (65535 - IP 20 - UDP 8)
+#define UDP_GSO_MAX_SEGMENTS 64     // 묶음 1개 최대 세그먼트 수 (커널 UDP_MAX_SEGMENTS)
+#define UDP_GRO_BUF_SIZE     65535  // GRO 수신 버퍼 크기
+
+// sendmsg/recvmsg 제어 메시지 버퍼 (세그먼트 크기 uint16 하나)
+typedef union {
+    char buf[CMSG_SPACE(sizeof(uint16_t))];
+    struct cmsghdr align;
+} udp_cmsg_t;
+
+// 배치 API는 struct mmsghdr (recvmmsg/sendmmsg)를 사용하므로
+// 이 헤더를 포함하는 .c 파일은 _GNU_SOURCE를 먼저 정의해야 한다.
 
 // UDP 서버 생성
 // port: 바인딩할 포트 번호
 // 반환값: UDP 소켓 파일 디스크립터 (성공), -1 (실패)
+// GSO/GRO는 가능하면 자동으로 켜짐 (udp_offload_flags로 확인)
 int create_udp_server(uint16_t port);
 
+// UDP_GRO 켜기 + UDP_SEGMENT 지원 확인
+// 반환값: UDP_OFFLOAD_* 비트 (지원 안 하면 0)
+int udp_enable_offload(int udp_fd);
+
+// 현재 켜진 오프로드 조회
+// 반환값: UDP_OFFLOAD_* 비트
+int udp_offload_flags(int udp_fd);
+
 // UDP 패킷 수신
 // udp_fd: UDP 소켓 파일 디스크립터
 // buffer: 수신 버퍼
@@ -29,4 +57,46 @@ ssize_t udp_recv(int udp_fd, uint8_t *buffer, size_t buffer_size,
 ssize_t udp_send(int udp_fd, const uint8_t *buffer, size_t length,
                  const struct sockaddr_in *dest_addr);
 
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 배치 송수신 (recvmmsg / sendmmsg)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// mmsghdr / iovec / sockaddr_in 배열은 호출자 소유.
+// 메시지 i 는 iovs[i] 하나와 addrs[i] 하나를 사용한다.
+
+// 배치 메시지 1개 준비 (msg → iov → buffer, msg_name → addr)
+// buffer / length: 수신 시 버퍼 크기, 전송 시 보낼 데이터
+void udp_batch_prepare(struct mmsghdr *msg, struct iovec *iov,
+                       struct sockaddr_in *addr, uint8_t *buffer, size_t length);
+
+// GSO 메시지 준비: iov[0..iov_count)를 이어 붙여 segment_size 단위로 잘라 전송
+// 마지막 세그먼트만 segment_size보다 짧을 수 있다. ctrl은 전송 완료까지 유지.
+void udp_batch_prepare_gso(struct mmsghdr *msg, struct iovec *iov, size_t iov_count,
+                           struct sockaddr_in *addr, udp_cmsg_t *ctrl,
+                           uint16_t segment_size);
+
+// GRO 수신 메시지 준비 (udp_batch_prepare + 세그먼트 크기를 받을 ctrl)
+// buffer는 UDP_GRO_BUF_SIZE 권장
+void udp_batch_prepare_gro(struct mmsghdr *msg, struct iovec *iov,
+                           struct sockaddr_in *addr, uint8_t *buffer, size_t length,
+                           udp_cmsg_t *ctrl);
+
+// 수신한 메시지의 GRO 세그먼트 크기
+// 반환값: 세그먼트 크기 (여러 데이터그램이 묶여 있음), 0 (단일 데이터그램)
+size_t udp_gro_segment_size(const struct mmsghdr *msg);
+
+// 여러 패킷 한 번에 수신 (논블로킹)
+// msgs: udp_batch_prepare로 준비된 메시지 배열
+// count: 최대 수신 개수
+// 반환값: 수신한 패킷 수 (msgs[i].msg_len = 길이), 0 (없음), -1 (실패)
+int udp_recv_batch(int udp_fd, struct mmsghdr *msgs, unsigned int count);
+
+// 여러 패킷 한 번에 전송 (목적지가 달라도 한 번에)
+// msgs: udp_batch_prepare / udp_batch_prepare_gso로 준비된 메시지 배열
+// GSO 메시지가 거부되면(EIO, EMSGSIZE) 세그먼트별로 나눠서 다시 보낸다.
+// 중간 메시지 하나가 실패해도 나머지는 계속 보내므로 보낸 메시지가 앞쪽에 모여 있지 않을 수 있다.
+// 메시지별 결과: msgs[i].msg_len > 0 이면 전송됨, 0 이면 드롭
+// 반환값: 전송한 메시지 수, -1 (전부 실패)
+int udp_send_batch(int udp_fd, struct mmsghdr *msgs, unsigned int count);
+
 #endif // UDP_SERVER_H
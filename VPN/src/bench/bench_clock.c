@@ -0,0 +1,32 @@
+// src/bench/bench_clock.c
+
+#include "bench_clock.h"
+#include <time.h>
+
+#define BENCH_CALIBRATE_NS 100000000ull
+
+uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+uint64_t bench_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return bench_now_ns();
+#endif
+}
+
+double bench_calibrate(void) {
+    uint64_t ns0 = bench_now_ns();
+    uint64_t c0 = bench_cycles();
+    
+    while (bench_now_ns() - ns0 < BENCH_CALIBRATE_NS) {
+    }
+    
+    uint64_t ns = bench_now_ns() - ns0;
+    uint64_t cycles = bench_cycles() - c0;
+    return (double)cycles * 1000.0 / (double)ns;
+}
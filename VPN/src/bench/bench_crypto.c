@@ -0,0 +1,540 @@
+// src/bench/bench_crypto.c
+//
+// 암호 계층 마이크로벤치마크 (crypto.c / key_manager.c, I/O 없음)
+//
+//   1. AEAD: crypto_encrypt/crypto_decrypt + 스위트별 세션 API, 64 B ~ 64 KB
+//   2. 핸드셰이크: perform_handshake (서버 키 생성 + ECDH + KDF + add_key) 초당 횟수
+//   3. 키 조회: get_key / get_key_by_handle, 키 254 / 4k / 64k 개
+//
+// 사람이 읽는 표 뒤에 JSON 요약을 출력한다 (--json 이면 JSON만).
+// 키 테이블은 청크 단위로 늘어나므로 MAX_KEYS(65536)까지 그대로 채운다.
+
+#define _GNU_SOURCE
+#include "crypto.h"
+#include "key_manager.h"
+#include "bench_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sodium.h>
+
+#define BENCH_DEFAULT_SIZES      "64,256,1024,1400,4096,16384,65536"
+#define BENCH_DEFAULT_MB         64          // 측정 1회당 처리할 데이터 (MB)
+#define BENCH_DEFAULT_HANDSHAKES 2000
+#define BENCH_DEFAULT_LOOKUPS    1000000
+#define BENCH_MIN_ITERATIONS     16
+#define BENCH_MAX_SIZES          16
+#define BENCH_MAX_PAYLOAD        65536
+#define BENCH_HANDSHAKE_CLIENTS  254
+#define BENCH_KEY_BASE_IP        0x0a000000u  // 10.0.0.0 부터 키마다 1씩
+
+// 키 개수별 조회 측정 (MAX_KEYS를 넘으면 건너뜀)
+static const int key_counts[] = { 254, 4096, 65536 };
+#define KEY_COUNT_CASES (int)(sizeof(key_counts) / sizeof(key_counts[0]))
+
+// AEAD 측정 결과 1개
+typedef struct {
+    const char *suite;
+    const char *api;              // "crypto_encrypt" (ChaCha 원시 API) / "session"
+    const char *op;               // "encrypt" / "decrypt"
+    int size;
+    double ns_per_op;
+    double cycles_per_byte;
+} aead_result_t;
+
+// 키 조회 측정 결과 1개
+typedef struct {
+    int keys;
+    int skipped;                  // MAX_KEYS 초과
+    double get_key_ns;
+    double by_handle_ns;
+} lookup_result_t;
+
+static double cycles_per_us = 1000.0;
+static int saved_stdout = -1;
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 출력 잠시 끄기 (add_key / perform_handshake 는 호출마다 로그를 남김)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+static void stdout_mute(void) {
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (saved_stdout < 0 || null_fd < 0) {
+        perror("stdout_mute");
+        if (null_fd >= 0) close(null_fd);
+        return;
+    }
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+}
+
+static void stdout_unmute(void) {
+    if (saved_stdout < 0) {
+        return;
+    }
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    saved_stdout = -1;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 1. AEAD
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 크기 하나에 대해 ChaCha20-Poly1305 원시 API (crypto_encrypt / crypto_decrypt)
+static void bench_raw_api(int size, int iterations, uint8_t *plain, uint8_t *cipher,
+                          aead_result_t *out) {
+    uint8_t key[CRYPTO_KEY_SIZE];
+    uint8_t nonce[CRYPTO_NONCE_SIZE];
+    crypto_random_key(key);
+    
+    uint64_t start = bench_cycles();
+    for (int i = 0; i < iterations; i++) {
+        crypto_counter_nonce(nonce, CRYPTO_DIR_SERVER_TO_CLIENT, i);
+        crypto_encrypt(plain, size, cipher, key, nonce);
+    }
+    uint64_t enc_cycles = bench_cycles() - start;
+    
+    // 마지막으로 만든 암호문을 반복 복호화 (인증 성공 경로)
+    start = bench_cycles();
+    for (int i = 0; i < iterations; i++) {
+        crypto_decrypt(cipher, size + CRYPTO_MAC_SIZE, plain, key, nonce);
+    }
+    uint64_t dec_cycles = bench_cycles() - start;
+    
+    sodium_memzero(key, sizeof(key));
+    
+    const char *suite = crypto_suite_name(CRYPTO_SUITE_CHACHA20_POLY1305);
+    out[0] = (aead_result_t){ suite, "crypto_encrypt", "encrypt", size,
+                              enc_cycles / cycles_per_us * 1000.0 / iterations,
+                              (double)enc_cycles / iterations / size };
+    out[1] = (aead_result_t){ suite, "crypto_encrypt", "decrypt", size,
+                              dec_cycles / cycles_per_us * 1000.0 / iterations,
+                              (double)dec_cycles / iterations / size };
+}
+
+// 크기 하나에 대해 세션 API (키 스케줄을 미리 계산한 데이터 경로)
+static void bench_session_api(uint8_t suite, int size, int iterations,
+                              uint8_t *plain, uint8_t *cipher, aead_result_t *out) {
+    uint8_t key[CRYPTO_KEY_SIZE];
+    uint8_t nonce[CRYPTO_NONCE_SIZE];
+    crypto_session_t session;
+    
+    crypto_random_key(key);
+    crypto_session_init(&session, suite, key);
+    sodium_memzero(key, sizeof(key));
+    
+    uint64_t start = bench_cycles();
+    for (int i = 0; i < iterations; i++) {
+        crypto_counter_nonce(nonce, CRYPTO_DIR_SERVER_TO_CLIENT, i);
+        crypto_session_encrypt(&session, plain, size, cipher, nonce);
+    }
+    uint64_t enc_cycles = bench_cycles() - start;
+    
+    start = bench_cycles();
+    for (int i = 0; i < iterations; i++) {
+        crypto_session_decrypt(&session, cipher, size + CRYPTO_MAC_SIZE, plain, nonce);
+    }
+    uint64_t dec_cycles = bench_cycles() - start;
+    
+    crypto_session_clear(&session);
+    
+    out[0] = (aead_result_t){ crypto_suite_name(suite), "session", "encrypt", size,
+                              enc_cycles / cycles_per_us * 1000.0 / iterations,
+                              (double)enc_cycles / iterations / size };
+    out[1] = (aead_result_t){ crypto_suite_name(suite), "session", "decrypt", size,
+                              dec_cycles / cycles_per_us * 1000.0 / iterations,
+                              (double)dec_cycles / iterations / size };
+}
+
+// 반환값: 채운 결과 수, -1 (메모리 부족)
+static int bench_aead(const int *sizes, int size_count, int mb, aead_result_t *results) {
+    uint8_t *plain = (uint8_t*)malloc(BENCH_MAX_PAYLOAD);
+    uint8_t *cipher = (uint8_t*)malloc(BENCH_MAX_PAYLOAD + CRYPTO_MAC_SIZE);
+    uint8_t suites = crypto_supported_suites();
+    int count = 0;
+    
+    if (!plain || !cipher) {
+        perror("malloc");
+        free(plain);
+        free(cipher);
+        return -1;
+    }
+    randombytes_buf(plain, BENCH_MAX_PAYLOAD);
+    
+    for (int s = 0; s < size_count; s++) {
+        int size = sizes[s];
+        long iterations = (long)mb * 1024 * 1024 / size;
+        if (iterations < BENCH_MIN_ITERATIONS) {
+            iterations = BENCH_MIN_ITERATIONS;
+        }
+    
+        bench_raw_api(size, iterations, plain, cipher, &results[count]);
+        count += 2;
+    
+        if (suites & CRYPTO_SUITE_CHACHA20_POLY1305) {
+            bench_session_api(CRYPTO_SUITE_CHACHA20_POLY1305, size, iterations,
+                              plain, cipher, &results[count]);
+            count += 2;
+        }
+        if (suites & CRYPTO_SUITE_AES256_GCM) {
+            bench_session_api(CRYPTO_SUITE_AES256_GCM, size, iterations,
+                              plain, cipher, &results[count]);
+            count += 2;
+        }
+    }
+    
+    free(plain);
+    free(cipher);
+    return count;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 2. 핸드셰이크
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// perform_handshake 를 count번 (클라이언트 키 생성은 측정 밖, VPN IP 254개를 돌려가며 재핸드셰이크)
+// 반환값: 핸드셰이크 1회당 나노초, -1 (실패)
+static double bench_handshake(int count, uint8_t *suite_out) {
+    uint8_t (*client_keys)[32] = malloc((size_t)count * 32);
+    uint8_t private_key[32];
+    uint8_t server_public_key[32];
+    uint8_t session_key[32];
+    key_handle_t handle;
+    int failed = 0;
+    
+    if (!client_keys) {
+        perror("malloc");
+        return -1;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        crypto_generate_keypair(client_keys[i], private_key);
+    }
+    sodium_memzero(private_key, sizeof(private_key));
+    
+    stdout_mute();
+    key_manager_t *km = init_key_manager();
+    
+    uint64_t start = bench_cycles();
+    for (int i = 0; km && i < count; i++) {
+        uint32_t vpn_ip = htonl(BENCH_KEY_BASE_IP + 1 + i % BENCH_HANDSHAKE_CLIENTS);
+        if (perform_handshake(km, vpn_ip, client_keys[i], crypto_supported_suites(),
+                              server_public_key, session_key, suite_out, &handle) != 0) {
+            failed = 1;
+            break;
+        }
+    }
+    uint64_t elapsed = bench_cycles() - start;
+    
+    destroy_key_manager(km);
+    stdout_unmute();
+    
+    sodium_memzero(session_key, sizeof(session_key));
+    free(client_keys);
+    
+    if (!km || failed) {
+        fprintf(stderr, "❌ Handshake benchmark failed\n");
+        return -1;
+    }
+    return elapsed / cycles_per_us * 1000.0 / count;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 3. 키 조회
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// keys개를 채운 테이블에서 무작위 조회 lookups번
+static int bench_lookup(int keys, int lookups, lookup_result_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->keys = keys;
+    
+    if (keys > MAX_KEYS) {
+        out->skipped = 1;
+        return 0;
+    }
+    
+    key_handle_t *handles = (key_handle_t*)malloc(keys * sizeof(key_handle_t));
+    uint32_t *seq_ip = (uint32_t*)malloc(lookups * sizeof(uint32_t));
+    key_handle_t *seq_handle = (key_handle_t*)malloc(lookups * sizeof(key_handle_t));
+    uint8_t key[CRYPTO_KEY_SIZE];
+    int ret = 0;
+    
+    if (!handles || !seq_ip || !seq_handle) {
+        perror("malloc");
+        free(handles);
+        free(seq_ip);
+        free(seq_handle);
+        return -1;
+    }
+    
+    stdout_mute();
+    key_manager_t *km = init_key_manager();
+    
+    for (int i = 0; km && i < keys; i++) {
+        crypto_random_key(key);
+        handles[i] = add_key(km, htonl(BENCH_KEY_BASE_IP + 1 + i), key,
+                             CRYPTO_SUITE_CHACHA20_POLY1305);
+        if (handles[i] == KEY_HANDLE_INVALID) {
+            ret = -1;
+            break;
+        }
+    }
+    stdout_unmute();
+    sodium_memzero(key, sizeof(key));
+    
+    if (!km || ret != 0) {
+        fprintf(stderr, "❌ Failed to fill key table (%d keys)\n", keys);
+        destroy_key_manager(km);
+        free(handles);
+        free(seq_ip);
+        free(seq_handle);
+        return -1;
+    }
+    
+    // 조회 순서는 미리 무작위로 (순서 생성 비용은 측정 밖)
+    for (int i = 0; i < lookups; i++) {
+        uint32_t index = randombytes_uniform(keys);
+        seq_ip[i] = htonl(BENCH_KEY_BASE_IP + 1 + index);
+        seq_handle[i] = handles[index];
+    }
+    
+    uintptr_t sink = 0;
+    
+    uint64_t start = bench_cycles();
+    for (int i = 0; i < lookups; i++) {
+        sink += (uintptr_t)get_key(km, seq_ip[i]);
+    }
+    uint64_t by_ip = bench_cycles() - start;
+    
+    start = bench_cycles();
+    for (int i = 0; i < lookups; i++) {
+        sink += (uintptr_t)get_key_by_handle(km, seq_handle[i]);
+    }
+    uint64_t by_handle = bench_cycles() - start;
+    
+    if (sink == 0) {
+        fprintf(stderr, "⚠️  No keys found during lookup benchmark\n");
+    }
+    
+    out->get_key_ns = by_ip / cycles_per_us * 1000.0 / lookups;
+    out->by_handle_ns = by_handle / cycles_per_us * 1000.0 / lookups;
+    
+    stdout_mute();
+    destroy_key_manager(km);
+    stdout_unmute();
+    
+    free(handles);
+    free(seq_ip);
+    free(seq_handle);
+    return 0;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 출력
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+static double mb_per_s(const aead_result_t *r) {
+    return r->ns_per_op > 0 ? r->size * 1000.0 / r->ns_per_op : 0.0;
+}
+
+static void print_table(const aead_result_t *aead, int aead_count,
+                        double handshake_ns, uint8_t handshake_suite,
+                        const lookup_result_t *lookups) {
+    printf("━━━ AEAD ━━━\n");
+    printf("  %-18s %-15s %-8s %6s %11s %10s %10s\n",
+           "suite", "api", "op", "size", "ns/op", "MB/s", "cycles/B");
+    for (int i = 0; i < aead_count; i++) {
+        const aead_result_t *r = &aead[i];
+        printf("  %-18s %-15s %-8s %6d %11.1f %10.1f %10.2f\n",
+               r->suite, r->api, r->op, r->size, r->ns_per_op, mb_per_s(r), r->cycles_per_byte);
+    }
+    printf("\n");
+    
+    printf("━━━ Handshake (perform_handshake) ━━━\n");
+    if (handshake_ns > 0) {
+        printf("  %.1f us/handshake, %.0f handshakes/s (%s)\n\n",
+               handshake_ns / 1000.0, 1e9 / handshake_ns, crypto_suite_name(handshake_suite));
+    } else {
+        printf("  failed\n\n");
+    }
+    
+    printf("━━━ Key lookup (MAX_KEYS=%d) ━━━\n", MAX_KEYS);
+    printf("  %6s %14s %20s\n", "keys", "get_key ns", "get_key_by_handle ns");
+    for (int i = 0; i < KEY_COUNT_CASES; i++) {
+        if (lookups[i].skipped) {
+            printf("  %6d %14s %20s\n", lookups[i].keys, "skipped", "skipped");
+        } else {
+            printf("  %6d %14.1f %20.1f\n",
+                   lookups[i].keys, lookups[i].get_key_ns, lookups[i].by_handle_ns);
+        }
+    }
+    printf("\n");
+}
+
+static void print_json(const aead_result_t *aead, int aead_count,
+                       double handshake_ns, uint8_t handshake_suite,
+                       const lookup_result_t *lookups) {
+    printf("{\n");
+    printf("  \"cycles_per_us\": %.1f,\n", cycles_per_us);
+    printf("  \"supported_suites\": [");
+    const char *sep = "";
+    if (crypto_supported_suites() & CRYPTO_SUITE_CHACHA20_POLY1305) {
+        printf("\"%s\"", crypto_suite_name(CRYPTO_SUITE_CHACHA20_POLY1305));
+        sep = ", ";
+    }
+    if (crypto_supported_suites() & CRYPTO_SUITE_AES256_GCM) {
+        printf("%s\"%s\"", sep, crypto_suite_name(CRYPTO_SUITE_AES256_GCM));
+    }
+    printf("],\n");
+    
+    printf("  \"aead\": [\n");
+    for (int i = 0; i < aead_count; i++) {
+        const aead_result_t *r = &aead[i];
+        printf("    {\"suite\": \"%s\", \"api\": \"%s\", \"op\": \"%s\", \"size\": %d, "
+               "\"ns_per_op\": %.1f, \"mb_per_s\": %.1f, \"cycles_per_byte\": %.3f}%s\n",
+               r->suite, r->api, r->op, r->size, r->ns_per_op, mb_per_s(r),
+               r->cycles_per_byte, i + 1 < aead_count ? "," : "");
+    }
+    printf("  ],\n");
+    
+    printf("  \"handshake\": {\"suite\": \"%s\", \"ns_per_handshake\": %.1f, "
+           "\"handshakes_per_s\": %.1f},\n",
+           crypto_suite_name(handshake_suite), handshake_ns > 0 ? handshake_ns : 0.0,
+           handshake_ns > 0 ? 1e9 / handshake_ns : 0.0);
+    
+    printf("  \"key_lookup\": [\n");
+    for (int i = 0; i < KEY_COUNT_CASES; i++) {
+        const lookup_result_t *l = &lookups[i];
+        if (l->skipped) {
+            printf("    {\"keys\": %d, \"skipped\": true}", l->keys);
+        } else {
+            printf("    {\"keys\": %d, \"get_key_ns\": %.2f, \"get_key_by_handle_ns\": %.2f}",
+                   l->keys, l->get_key_ns, l->by_handle_ns);
+        }
+        printf("%s\n", i + 1 < KEY_COUNT_CASES ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// main
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --sizes <a,b,...>   payload sizes in bytes (default %s, 1..%d)\n",
+           BENCH_DEFAULT_SIZES, BENCH_MAX_PAYLOAD);
+    printf("  --mb <N>            data processed per AEAD measurement (default %d MB)\n",
+           BENCH_DEFAULT_MB);
+    printf("  --handshakes <N>    perform_handshake calls (default %d)\n",
+           BENCH_DEFAULT_HANDSHAKES);
+    printf("  --lookups <N>       key lookups per table size (default %d)\n",
+           BENCH_DEFAULT_LOOKUPS);
+    printf("  --json              print only the JSON summary\n");
+}
+
+int main(int argc, char *argv[]) {
+    char sizes_arg[128] = BENCH_DEFAULT_SIZES;
+    int sizes[BENCH_MAX_SIZES];
+    int size_count = 0;
+    int mb = BENCH_DEFAULT_MB;
+    int handshakes = BENCH_DEFAULT_HANDSHAKES;
+    int lookups = BENCH_DEFAULT_LOOKUPS;
+    int json_only = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            strncpy(sizes_arg, argv[++i], sizeof(sizes_arg) - 1);
+        } else if (strcmp(argv[i], "--mb") == 0 && i + 1 < argc) {
+            mb = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--handshakes") == 0 && i + 1 < argc) {
+            handshakes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lookups") == 0 && i + 1 < argc) {
+            lookups = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json_only = 1;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    for (char *tok = strtok(sizes_arg, ","); tok && size_count < BENCH_MAX_SIZES;
+         tok = strtok(NULL, ",")) {
+        sizes[size_count] = atoi(tok);
+        if (sizes[size_count] < 1 || sizes[size_count] > BENCH_MAX_PAYLOAD) {
+            fprintf(stderr, "❌ Invalid payload size: %s (1..%d)\n", tok, BENCH_MAX_PAYLOAD);
+            return 1;
+        }
+        size_count++;
+    }
+    
+    if (size_count == 0 || mb < 1 || handshakes < 1 || lookups < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    
+    // 초기화 로그 / 스위트 선택 결과는 표에 포함되므로 숨김
+    stdout_mute();
+    int init_ok = crypto_init() == 0;
+    if (init_ok) {
+        crypto_select_suite();    // 핸드셰이크 협상이 Enclave와 같은 스위트를 고르도록
+    }
+    stdout_unmute();
+    if (!init_ok) {
+        return 1;
+    }
+    
+    if (!json_only) {
+        printf("📊 Crypto Benchmark\n");
+        printf("═══════════════════════════════════════\n");
+        printf("   Calibrating clock...\n");
+    }
+    cycles_per_us = bench_calibrate();
+    
+    if (!json_only) {
+        printf("   %.0f cycles/us, %d MB per AEAD measurement\n\n", cycles_per_us, mb);
+    }
+    
+    aead_result_t *aead = (aead_result_t*)calloc(size_count * 6, sizeof(aead_result_t));
+    if (!aead) {
+        perror("calloc");
+        return 1;
+    }
+    
+    int aead_count = bench_aead(sizes, size_count, mb, aead);
+    
+    uint8_t handshake_suite = 0;
+    double handshake_ns = bench_handshake(handshakes, &handshake_suite);
+    
+    lookup_result_t lookup_results[KEY_COUNT_CASES];
+    int ret = (aead_count < 0 || handshake_ns < 0) ? 1 : 0;
+    
+    for (int i = 0; i < KEY_COUNT_CASES; i++) {
+        if (bench_lookup(key_counts[i], lookups, &lookup_results[i]) != 0) {
+            lookup_results[i].skipped = 1;
+            ret = 1;
+        }
+    }
+    
+    if (aead_count < 0) {
+        aead_count = 0;
+    }
+    
+    if (!json_only) {
+        print_table(aead, aead_count, handshake_ns, handshake_suite, lookup_results);
+        printf("━━━ JSON ━━━\n");
+    }
+    print_json(aead, aead_count, handshake_ns, handshake_suite, lookup_results);
+    
+    free(aead);
+    return ret;
+}
@@ -0,0 +1,661 @@
+// src/bench/bench_dataplane.c
+//
+// 서버 데이터 경로 벤치마크 (root, 실제 TUN, 두 번째 호스트 없이 실행)
+//
+//   UDP: 127.0.0.1 루프백 소켓 (서버 1개 + 클라이언트 N개)
+//   TUN: AF_UNIX SOCK_DGRAM socketpair (패킷 경계 유지)
+//   암호화: 실제 vpn_enclave 프로세스 + 공유 메모리 링
+//
+// vpn_server.c 의 handle_udp_to_tun / handle_tun_to_udp 를 그대로 호출하기 위해
+// 소스째 포함한다 (VPN_SERVER_NO_MAIN 으로 main 제외).
+
+#define VPN_SERVER_NO_MAIN
+#include "../server/vpn_server.c"
+
+#include "crypto.h"
+#include "bench_clock.h"
+#include <netinet/udp.h>
+#include <sodium.h>
+
+#define BENCH_DEFAULT_SIZES   "64,512,1400"
+#define BENCH_DEFAULT_CLIENTS 8
+#define BENCH_DEFAULT_PACKETS 20000
+#define BENCH_MAX_SIZES       16
+#define BENCH_MIN_SIZE        (int)(sizeof(struct iphdr) + sizeof(struct udphdr))
+#define BENCH_MAX_SIZE        1500
+#define BENCH_SOCK_BUF        (4 << 20)
+#define BENCH_SERVER_IP       "10.8.0.1"
+
+// 벤치마크 클라이언트 (서버 테이블에 등록된 가짜 피어)
+typedef struct {
+    int sock_fd;                  // 127.0.0.1:임의 포트
+    struct sockaddr_in addr;
+    uint32_t vpn_ip;
+    crypto_session_t crypto;      // 서버와 같은 세션키 (DATA 패킷 생성용)
+    uint64_t tx_counter;          // 클라이언트 → 서버 nonce 카운터
+} bench_client_t;
+
+// 처리 1회(버스트 하나를 비울 때까지) 측정값
+typedef struct {
+    uint64_t cycles;
+    int packets;
+} bench_sample_t;
+
+// 방향 하나의 결과
+typedef struct {
+    uint64_t packets;             // 상대편에 도착한 패킷 수
+    uint64_t bytes;               // 도착한 IP 패킷 바이트 (평문 기준)
+    uint64_t cycles;              // 데이터 경로 함수 안에서 보낸 시간
+    double p50_us;
+    double p99_us;
+} bench_result_t;
+
+static bench_client_t *bench_clients = NULL;
+static int bench_client_count = 0;
+static double cycles_per_us = 1000.0;   // bench_calibrate() 로 측정
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 지연 백분위
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+static int compare_samples(const void *a, const void *b) {
+    const bench_sample_t *x = (const bench_sample_t*)a;
+    const bench_sample_t *y = (const bench_sample_t*)b;
+    return (x->cycles > y->cycles) - (x->cycles < y->cycles);
+}
+
+// 패킷 가중 백분위 (패킷 하나의 지연 = 그 패킷이 속한 버스트 처리 시간)
+static double sample_percentile(bench_sample_t *samples, int count, uint64_t packets,
+                                double percentile) {
+    if (count == 0 || packets == 0) {
+        return 0.0;
+    }
+    
+    uint64_t target = (uint64_t)(packets * percentile / 100.0);
+    uint64_t seen = 0;
+    
+    for (int i = 0; i < count; i++) {
+        seen += samples[i].packets;
+        if (seen > target) {
+            return samples[i].cycles / cycles_per_us;
+        }
+    }
+    return samples[count - 1].cycles / cycles_per_us;
+}
+
+static void finish_result(bench_result_t *result, bench_sample_t *samples, int count) {
+    qsort(samples, count, sizeof(bench_sample_t), compare_samples);
+    result->p50_us = sample_percentile(samples, count, result->packets, 50.0);
+    result->p99_us = sample_percentile(samples, count, result->packets, 99.0);
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 합성 패킷
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+static uint16_t ip_checksum(const void *data, size_t len) {
+    const uint16_t *words = (const uint16_t*)data;
+    uint32_t sum = 0;
+    
+    for (size_t i = 0; i < len / 2; i++) {
+        sum += words[i];
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
+
+// size 바이트짜리 IPv4/UDP 패킷 생성
+static void build_ip_packet(uint8_t *buffer, int size, uint32_t saddr, uint32_t daddr,
+                            uint32_t sequence) {
+    struct iphdr *ip = (struct iphdr*)buffer;
+    struct udphdr *udp = (struct udphdr*)(buffer + sizeof(struct iphdr));
+    
+    memset(buffer, 0, size);
+    ip->version = 4;
+    ip->ihl = 5;
+    ip->ttl = 64;
+    ip->protocol = IPPROTO_UDP;
+    ip->tot_len = htons(size);
+    ip->id = htons(sequence & 0xffff);
+    ip->saddr = saddr;
+    ip->daddr = daddr;
+    ip->check = ip_checksum(ip, sizeof(struct iphdr));
+    
+    udp->source = htons(40000);
+    udp->dest = htons(9);
+    udp->len = htons(size - sizeof(struct iphdr));
+    
+    // 페이로드에 순번 (체크섬은 생략: 서버는 검사하지 않음)
+    if (size >= BENCH_MIN_SIZE + 4) {
+        uint32_t seq = htonl(sequence);
+        memcpy(buffer + BENCH_MIN_SIZE, &seq, sizeof(seq));
+    }
+}
+
+// 클라이언트가 보내는 DATA 패킷 생성 ([헤더][카운터][암호문 + MAC])
+// 반환값: 패킷 길이, -1 (실패)
+static int build_data_packet(bench_client_t *client, uint8_t *out, int size, uint32_t sequence) {
+    uint8_t plaintext[BENCH_MAX_SIZE];
+    uint8_t nonce[CRYPTO_NONCE_SIZE];
+    
+    build_ip_packet(plaintext, size, client->vpn_ip, inet_addr(BENCH_SERVER_IP), sequence);
+    
+    uint64_t counter = client->tx_counter++;
+    crypto_counter_nonce(nonce, CRYPTO_DIR_CLIENT_TO_SERVER, counter);
+    
+    uint8_t *payload = out + sizeof(vpn_header_t);
+    crypto_put_counter(payload, counter);
+    if (crypto_session_encrypt(&client->crypto, plaintext, size,
+                               payload + CRYPTO_COUNTER_SIZE, nonce) != 0) {
+        return -1;
+    }
+    
+    size_t payload_len = CRYPTO_COUNTER_SIZE + size + CRYPTO_MAC_SIZE;
+    init_vpn_header((vpn_header_t*)out, PKT_DATA, payload_len);
+    return sizeof(vpn_header_t) + payload_len;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 준비 / 정리
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+static int set_socket_buffers(int fd) {
+    int size = BENCH_SOCK_BUF;
+    if (setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size)) < 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) < 0) {
+        perror("setsockopt SO_SNDBUF/SO_RCVBUF");
+        return -1;
+    }
+    return 0;
+}
+
+// 127.0.0.1:임의 포트에 바인딩된 논블로킹 UDP 소켓
+static int bench_udp_socket(struct sockaddr_in *addr) {
+    socklen_t addr_len = sizeof(*addr);
+    
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    
+    if (bind(fd, (struct sockaddr*)addr, sizeof(*addr)) < 0 ||
+        getsockname(fd, (struct sockaddr*)addr, &addr_len) < 0 ||
+        set_nonblocking(fd) < 0 || set_socket_buffers(fd) < 0) {
+        perror("bench socket");
+        close(fd);
+        return -1;
+    }
+    
+    return fd;
+}
+
+// 클라이언트 N개 등록 + Enclave 핸드셰이크 (서버와 같은 세션키를 받아둠)
+static int setup_clients(client_table_t *table, int count) {
+    bench_clients = (bench_client_t*)calloc(count, sizeof(bench_client_t));
+    if (!bench_clients) {
+        perror("calloc");
+        return -1;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        bench_client_t *bc = &bench_clients[i];
+        uint8_t client_public_key[32];
+        uint8_t client_private_key[32];
+        uint8_t server_public_key[32];
+        uint8_t session_key[32];
+        uint8_t suite;
+        key_handle_t handle;
+    
+        bc->sock_fd = bench_udp_socket(&bc->addr);
+        if (bc->sock_fd < 0) {
+            return -1;
+        }
+        bench_client_count++;
+    
+        bc->vpn_ip = add_client(table, &bc->addr);
+        client_entry_t *entry = find_client_by_addr(table, &bc->addr);
+        if (bc->vpn_ip == 0 || !entry) {
+            fprintf(stderr, "❌ Failed to add bench client %d\n", i);
+            return -1;
+        }
+    
+        crypto_generate_keypair(client_public_key, client_private_key);
+        if (enclave_handshake(enclave_fd, bc->vpn_ip, client_public_key,
+                              crypto_supported_suites(), server_public_key,
+                              session_key, &suite, &handle) != 0 ||
+            crypto_session_init(&bc->crypto, suite, session_key) != 0) {
+            fprintf(stderr, "❌ Handshake failed for bench client %d\n", i);
+            return -1;
+        }
+        sodium_memzero(session_key, sizeof(session_key));
+        sodium_memzero(client_private_key, sizeof(client_private_key));
+        set_client_key_handle(entry, handle);
+    }
+    
+    printf("✅ %d bench client(s) registered (%s)\n", count,
+           crypto_suite_name(bench_clients[0].crypto.suite));
+    return 0;
+}
+
+static void cleanup_clients(void) {
+    for (int i = 0; i < bench_client_count; i++) {
+        close(bench_clients[i].sock_fd);
+        crypto_session_clear(&bench_clients[i].crypto);
+    }
+    free(bench_clients);
+    bench_clients = NULL;
+    bench_client_count = 0;
+}
+
+// 소켓에 쌓인 데이터그램 모두 버리기 (개수 / 바이트 반환)
+static int drain_socket(int fd, uint8_t *buffer, size_t size, uint64_t *bytes) {
+    int count = 0;
+    
+    for (;;) {
+        ssize_t n = recv(fd, buffer, size, MSG_DONTWAIT);
+        if (n < 0) {
+            break;
+        }
+        count++;
+        if (bytes) {
+            *bytes += n;
+        }
+    }
+    return count;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 방향별 측정
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// UDP → 복호화 → TUN
+// 암호화된 DATA 패킷을 미리 만들어 두고, burst개씩 클라이언트 소켓으로 보낸 뒤
+// handle_udp_to_tun 이 소켓을 비울 때까지의 시간을 잰다.
+static int bench_udp_to_tun(int udp_fd, int tun_fd, int app_fd, client_table_t *table,
+                            int size, int packets, int burst, bench_result_t *result) {
+    int wire_size = sizeof(vpn_header_t) + CRYPTO_COUNTER_SIZE + size + CRYPTO_MAC_SIZE;
+    uint8_t *wire = (uint8_t*)malloc((size_t)packets * wire_size);
+    int *wire_len = (int*)malloc(packets * sizeof(int));
+    bench_sample_t *samples = (bench_sample_t*)malloc((packets / burst + 1) * sizeof(bench_sample_t));
+    uint8_t buffer[PKT_BUF_SIZE];
+    struct sockaddr_in server_addr;
+    socklen_t addr_len = sizeof(server_addr);
+    int sample_count = 0;
+    
+    memset(result, 0, sizeof(*result));
+    
+    if (!wire || !wire_len || !samples ||
+        getsockname(udp_fd, (struct sockaddr*)&server_addr, &addr_len) < 0) {
+        perror("bench_udp_to_tun");
+        free(wire);
+        free(wire_len);
+        free(samples);
+        return -1;
+    }
+    
+    // 측정 밖에서 암호화 (클라이언트 몫)
+    for (int i = 0; i < packets; i++) {
+        bench_client_t *bc = &bench_clients[i % bench_client_count];
+        wire_len[i] = build_data_packet(bc, wire + (size_t)i * wire_size, size, i);
+        if (wire_len[i] < 0) {
+            fprintf(stderr, "❌ Failed to build DATA packet\n");
+            free(wire);
+            free(wire_len);
+            free(samples);
+            return -1;
+        }
+    }
+    
+    for (int first = 0; first < packets; first += burst) {
+        int last = first + burst < packets ? first + burst : packets;
+    
+        for (int i = first; i < last; i++) {
+            bench_client_t *bc = &bench_clients[i % bench_client_count];
+            sendto(bc->sock_fd, wire + (size_t)i * wire_size, wire_len[i], 0,
+                   (struct sockaddr*)&server_addr, sizeof(server_addr));
+        }
+    
+        uint64_t start = bench_cycles();
+        while (handle_udp_to_tun(udp_fd, tun_fd, table) == BATCH_SIZE) {
+        }
+        uint64_t elapsed = bench_cycles() - start;
+    
+        int delivered = drain_socket(app_fd, buffer, sizeof(buffer), &result->bytes);
+        result->packets += delivered;
+        result->cycles += elapsed;
+        samples[sample_count].cycles = elapsed;
+        samples[sample_count].packets = delivered;
+        sample_count++;
+    }
+    
+    finish_result(result, samples, sample_count);
+    
+    free(wire);
+    free(wire_len);
+    free(samples);
+    return 0;
+}
+
+// TUN → 암호화 → UDP
+// 평문 IP 패킷을 burst개씩 TUN 자리에 쓰고, handle_tun_to_udp 가 비울 때까지의 시간을 잰다.
+static int bench_tun_to_udp(tun_worker_t *worker, int app_fd,
+                            int size, int packets, int burst, bench_result_t *result) {
+    bench_sample_t *samples = (bench_sample_t*)malloc((packets / burst + 1) * sizeof(bench_sample_t));
+    uint8_t *plain = (uint8_t*)malloc((size_t)bench_client_count * size);
+    uint8_t buffer[PKT_BUF_SIZE];
+    int sample_count = 0;
+    
+    memset(result, 0, sizeof(*result));
+    
+    if (!samples || !plain) {
+        perror("malloc");
+        free(samples);
+        free(plain);
+        return -1;
+    }
+    
+    // 클라이언트마다 패킷 하나씩 (평문 생성 비용은 측정에서 뺌)
+    for (int c = 0; c < bench_client_count; c++) {
+        build_ip_packet(plain + (size_t)c * size, size, inet_addr(BENCH_SERVER_IP),
+                        bench_clients[c].vpn_ip, c);
+    }
+    
+    for (int first = 0; first < packets; first += burst) {
+        int last = first + burst < packets ? first + burst : packets;
+    
+        for (int i = first; i < last; i++) {
+            int c = i % bench_client_count;
+            if (send(app_fd, plain + (size_t)c * size, size, 0) < 0) {
+                perror("send (TUN stand-in)");
+                break;
+            }
+        }
+    
+        uint64_t start = bench_cycles();
+        while (handle_tun_to_udp(worker) == BATCH_SIZE) {
+        }
+        uint64_t elapsed = bench_cycles() - start;
+    
+        int delivered = 0;
+        for (int c = 0; c < bench_client_count; c++) {
+            delivered += drain_socket(bench_clients[c].sock_fd, buffer, sizeof(buffer), NULL);
+        }
+        result->packets += delivered;
+        result->bytes += (uint64_t)delivered * size;
+        result->cycles += elapsed;
+        samples[sample_count].cycles = elapsed;
+        samples[sample_count].packets = delivered;
+        sample_count++;
+    }
+    
+    finish_result(result, samples, sample_count);
+    
+    free(samples);
+    free(plain);
+    return 0;
+}
+
+static void print_result(const char *direction, int size, int packets,
+                         const bench_result_t *result) {
+    double seconds = result->cycles / cycles_per_us / 1e6;
+    double pps = seconds > 0 ? result->packets / seconds : 0.0;
+    double gbps = seconds > 0 ? result->bytes * 8.0 / seconds / 1e9 : 0.0;
+    double cycles_per_packet = result->packets ? (double)result->cycles / result->packets : 0.0;
+    
+    printf("  %-8s %6d %9llu/%-9d %10.0f %8.3f %11.0f %9.1f %9.1f\n",
+           direction, size, (unsigned long long)result->packets, packets,
+           pps, gbps, cycles_per_packet, result->p50_us, result->p99_us);
+}
+
+// 단계별 지연 (--latency, 모든 크기 합산)
+static void print_stage_latency(void) {
+    printf("\n━━━ Stage Latency (all sizes) ━━━\n");
+    printf("  %-10s %10s %9s %9s %9s %9s\n",
+           "stage", "samples", "p50(us)", "p99(us)", "p999(us)", "max(us)");
+    
+    for (int st = 0; st < STATS_STAGE_MAX; st++) {
+        stats_hist_t hist;
+        server_stats_merge_latency(&server_stats, st, &hist);
+        if (hist.count == 0) {
+            continue;
+        }
+        
+        printf("  %-10s %10llu %9.2f %9.2f %9.2f %9.2f\n",
+               stats_stage_name(st), (unsigned long long)hist.count,
+               server_stats_cycles_to_us(&server_stats, stats_hist_percentile(&hist, 0.50)),
+               server_stats_cycles_to_us(&server_stats, stats_hist_percentile(&hist, 0.99)),
+               server_stats_cycles_to_us(&server_stats, stats_hist_percentile(&hist, 0.999)),
+               server_stats_cycles_to_us(&server_stats, hist.max));
+    }
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// main
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 벤치마크 환경 (서버 main 과 같은 순서로 준비)
+typedef struct {
+    int udp_fd;
+    int tun_pair[2];              // [0] = 서버 쪽 (TUN fd 자리), [1] = 커널 쪽
+    client_table_t *table;
+    struct sockaddr_in server_addr;
+} bench_env_t;
+
+// 반환값: 0 (성공), -1 (실패, 만든 것은 cleanup_env 로 정리)
+static int setup_env(bench_env_t *env, int clients, int use_udp_offload,
+                     uint32_t pool_network, int pool_prefix) {
+    printf("━━━ Enclave Process ━━━\n");
+    enclave_pid = start_enclave_process();
+    if (enclave_pid < 0) {
+        return -1;
+    }
+    
+    enclave_fd = enclave_connect();
+    if (enclave_fd < 0) {
+        return -1;
+    }
+    
+    enclave_ring = enclave_ring_attach(enclave_fd);
+    if (!enclave_ring) {
+        fprintf(stderr, "❌ Enclave ring setup failed\n");
+        return -1;
+    }
+    printf("\n");
+    
+    printf("━━━ Bench Setup ━━━\n");
+    
+    // TUN 자리: 패킷 경계가 유지되는 socketpair
+    if (socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, env->tun_pair) < 0) {
+        perror("socketpair");
+        return -1;
+    }
+    if (set_nonblocking(env->tun_pair[0]) < 0 || set_nonblocking(env->tun_pair[1]) < 0 ||
+        set_socket_buffers(env->tun_pair[0]) < 0 || set_socket_buffers(env->tun_pair[1]) < 0) {
+        return -1;
+    }
+    
+    env->udp_fd = bench_udp_socket(&env->server_addr);
+    if (env->udp_fd < 0) {
+        return -1;
+    }
+    udp_offload = use_udp_offload ? (udp_enable_offload(env->udp_fd) & UDP_OFFLOAD_GSO) : 0;
+    tun_offload = 0;
+    
+    env->table = init_client_table(pool_network, pool_prefix);
+    if (!env->table || setup_clients(env->table, clients) != 0) {
+        return -1;
+    }
+    
+    // 워커 0 (서버에서는 메인 스레드 몫)
+    tun_worker_t *worker = &workers[0];
+    worker->queue = 0;
+    worker->tun_fd = env->tun_pair[0];
+    worker->ring = enclave_ring;
+    worker->batch = &tx_batch;
+    worker->udp_fd = env->udp_fd;
+    worker->table = env->table;
+    worker_count = 1;
+    
+    // 카운터도 서버와 똑같이 증가 (공유 메모리 대신 익명 메모리)
+    if (server_stats_create(&server_stats, NULL, 1, env->table->capacity, BATCH_SIZE) < 0) {
+        return -1;
+    }
+    worker->stats = server_stats_worker(&server_stats, 0);
+    worker->client_stats = server_stats_clients(&server_stats, 0);
+    worker->latency = server_stats_latency(&server_stats, 0);
+    env->table->stats = &server_stats;
+    
+    return 0;
+}
+
+static void cleanup_env(bench_env_t *env) {
+    cleanup_clients();
+    if (env->table) destroy_client_table(env->table);
+    server_stats_close(&server_stats);
+    if (env->udp_fd >= 0) close(env->udp_fd);
+    if (env->tun_pair[0] >= 0) close(env->tun_pair[0]);
+    if (env->tun_pair[1] >= 0) close(env->tun_pair[1]);
+    if (enclave_ring) enclave_ring_detach(enclave_ring);
+    if (enclave_fd >= 0) {
+        enclave_shutdown(enclave_fd);
+        enclave_disconnect(enclave_fd);
+    }
+    stop_enclave_process(enclave_pid);
+}
+
+// 크기마다 두 방향 측정
+static int run_benchmarks(bench_env_t *env, const int *sizes, int size_count,
+                          int packets, int burst) {
+    cycles_per_us = bench_calibrate();
+    printf("   UDP:      127.0.0.1:%u (GSO %s)\n", ntohs(env->server_addr.sin_port),
+           (udp_offload & UDP_OFFLOAD_GSO) ? "on" : "off");
+    printf("   TUN:      socketpair (fd=%d/%d)\n", env->tun_pair[0], env->tun_pair[1]);
+    printf("   Clock:    %.0f cycles/us\n", cycles_per_us);
+    printf("   Workload: %d packets per size, burst %d\n\n", packets, burst);
+    
+    printf("━━━ Results ━━━\n");
+    printf("  %-8s %6s %19s %10s %8s %11s %9s %9s\n",
+           "dir", "size", "delivered/sent", "pps", "Gbit/s", "cycles/pkt", "p50(us)", "p99(us)");
+    
+    for (int s = 0; s < size_count; s++) {
+        bench_result_t result;
+        
+        if (bench_udp_to_tun(env->udp_fd, env->tun_pair[0], env->tun_pair[1], env->table,
+                             sizes[s], packets, burst, &result) != 0) {
+            return -1;
+        }
+        print_result("udp→tun", sizes[s], packets, &result);
+        
+        if (bench_tun_to_udp(&workers[0], env->tun_pair[1],
+                             sizes[s], packets, burst, &result) != 0) {
+            return -1;
+        }
+        print_result("tun→udp", sizes[s], packets, &result);
+    }
+    
+    printf("\n   (latency = time to drain one burst, weighted per packet)\n");
+    
+    if (latency_sampling) {
+        print_stage_latency();
+    }
+    return 0;
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --sizes <a,b,...>   IPv4 packet sizes in bytes (default %s, %d..%d)\n",
+           BENCH_DEFAULT_SIZES, BENCH_MIN_SIZE, BENCH_MAX_SIZE);
+    printf("  --clients <N>       simulated clients (default %d, up to the pool size)\n",
+           BENCH_DEFAULT_CLIENTS);
+    printf("  --packets <N>       packets per size and direction (default %d)\n",
+           BENCH_DEFAULT_PACKETS);
+    printf("  --burst <N>         packets queued before each drain (default %d)\n", BATCH_SIZE);
+    printf("  --udp-offload       enable UDP GSO on the server socket\n");
+    printf("  --latency           also report per-stage latency histograms\n");
+    printf("  --pool <cidr>       client VPN IP pool (default %s)\n", CLIENT_POOL_DEFAULT);
+}
+
+int main(int argc, char *argv[]) {
+    char sizes_arg[128] = BENCH_DEFAULT_SIZES;
+    int sizes[BENCH_MAX_SIZES];
+    int size_count = 0;
+    int clients = BENCH_DEFAULT_CLIENTS;
+    int packets = BENCH_DEFAULT_PACKETS;
+    int burst = BATCH_SIZE;
+    int use_udp_offload = 0;
+    const char *pool = CLIENT_POOL_DEFAULT;
+    uint32_t pool_network;
+    int pool_prefix;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            strncpy(sizes_arg, argv[++i], sizeof(sizes_arg) - 1);
+        } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            clients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--packets") == 0 && i + 1 < argc) {
+            packets = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--burst") == 0 && i + 1 < argc) {
+            burst = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--udp-offload") == 0) {
+            use_udp_offload = 1;
+        } else if (strcmp(argv[i], "--latency") == 0) {
+            latency_sampling = 1;
+        } else if (strcmp(argv[i], "--pool") == 0 && i + 1 < argc) {
+            pool = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    for (char *tok = strtok(sizes_arg, ","); tok && size_count < BENCH_MAX_SIZES;
+         tok = strtok(NULL, ",")) {
+        sizes[size_count] = atoi(tok);
+        if (sizes[size_count] < BENCH_MIN_SIZE || sizes[size_count] > BENCH_MAX_SIZE) {
+            fprintf(stderr, "❌ Invalid packet size: %s (%d..%d)\n",
+                    tok, BENCH_MIN_SIZE, BENCH_MAX_SIZE);
+            return 1;
+        }
+        size_count++;
+    }
+    
+    if (parse_client_pool(pool, &pool_network, &pool_prefix) < 0) {
+        return 1;
+    }
+    
+    if (size_count == 0 || clients < 1 || (uint32_t)clients > client_pool_hosts(pool_prefix) ||
+        packets < 1 || burst < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    
+    printf("📊 Data Plane Benchmark\n");
+    printf("═══════════════════════════════════════\n\n");
+    
+    // 패킷마다 출력하지 않도록
+    log_set_level(LOG_WARN);
+    
+    if (crypto_init() != 0) {
+        return 1;
+    }
+    
+    bench_env_t env = { .udp_fd = -1, .tun_pair = { -1, -1 } };
+    int ret = 1;
+    
+    if (setup_env(&env, clients, use_udp_offload, pool_network, pool_prefix) == 0 &&
+        run_benchmarks(&env, sizes, size_count, packets, burst) == 0) {
+        ret = 0;
+    }
+    
+    printf("\n");
+    cleanup_env(&env);
+    
+    return ret;
+}
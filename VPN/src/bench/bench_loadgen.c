@@ -0,0 +1,1019 @@
+// src/bench/bench_loadgen.c
+//
+// 다중 세션 부하 발생기 (udp_test_client 확장판, 단일 프로세스 / 단일 스레드)
+//
+//   1. 핸드셰이크: 세션마다 Curve25519 키쌍 → CONNECT_REQ → CONNECT_RESP → ECDH + KDF
+//   2. 데이터: 세션마다 ICMP echo request를 DATA 패킷으로 일정 속도 전송 (크기 분포 지정)
+//   3. 응답: 목적지가 서버 TUN 주소(10.8.0.1)면 커널이 echo reply 로 답하므로
+//            서버 → 클라이언트 방향까지 왕복 → 세션별 RTT / 손실 / goodput
+//
+// 서버는 주소로 클라이언트를 구분하므로 세션마다 UDP 소켓 1개를 쓰고,
+// epoll 하나로 받으면서 소켓별로 sendmmsg / recvmmsg 배치 처리한다.
+// 응답은 서버를 TUN 백엔드로 실행했을 때만 온다 (pcap 백엔드면 전송량만 의미 있음).
+
+#define _GNU_SOURCE
+#include "protocol.h"
+#include "crypto.h"
+#include "replay_window.h"
+#include "udp_server.h"
+#include "event_loop.h"
+#include "bench_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sodium.h>
+
+#define LOADGEN_DEFAULT_SERVER   "127.0.0.1"
+#define LOADGEN_DEFAULT_PORT     51820
+#define LOADGEN_DEFAULT_TARGET   "10.8.0.1"      // 서버 TUN 주소 (커널이 ping에 응답)
+#define LOADGEN_DEFAULT_SESSIONS 100
+#define LOADGEN_DEFAULT_RATE     100             // 세션당 초당 패킷
+#define LOADGEN_DEFAULT_DURATION 10              // 초
+#define LOADGEN_DEFAULT_SIZES    "64:7,576:4,1400:1"   // IMIX 비슷하게 (크기:가중치)
+#define LOADGEN_DEFAULT_WINDOW   64              // 동시에 진행할 핸드셰이크 수
+#define LOADGEN_MAX_SESSIONS     65535           // ICMP id 16비트
+#define LOADGEN_MAX_SIZES        16
+#define LOADGEN_MIN_PACKET       (20 + 8 + (int)sizeof(probe_t))
+#define LOADGEN_MAX_PACKET       1472
+#define LOADGEN_BATCH            32              // 소켓 1개당 sendmmsg / recvmmsg 최대 개수
+#define LOADGEN_BUF_SIZE         2048
+#define LOADGEN_TICK_MS          1               // 전송 스케줄 주기
+#define LOADGEN_HANDSHAKE_MS     5000            // 핸드셰이크 응답 대기
+#define LOADGEN_DRAIN_MS         1000            // 전송 종료 후 늦은 응답 대기
+#define LOADGEN_RTT_EXACT_US     1024            // RTT 히스토그램: 이 아래는 1us 단위
+#define LOADGEN_RTT_SUB_BITS     6               // 그 위는 2배 구간마다 64칸 (오차 ~1.6%)
+#define LOADGEN_RTT_MAX_EXP      36              // 2^36 us 까지
+#define LOADGEN_RTT_BUCKETS      (LOADGEN_RTT_EXACT_US + \
+                                  (LOADGEN_RTT_MAX_EXP - 10) * (1 << LOADGEN_RTT_SUB_BITS))
+#define LOADGEN_PROBE_MAGIC      0x4c47454eu     // "LGEN"
+
+// ICMP echo 페이로드 앞부분 (echo reply가 그대로 돌려줌)
+#pragma pack(push, 1)
+typedef struct {
+    uint32_t magic;
+    uint32_t session;
+    uint32_t seq;
+    uint64_t sent_ns;
+} probe_t;
+#pragma pack(pop)
+
+typedef enum {
+    SESSION_IDLE = 0,
+    SESSION_HANDSHAKE,
+    SESSION_CONNECTED,
+    SESSION_FAILED
+} session_state_t;
+
+typedef struct {
+    int fd;
+    session_state_t state;
+    uint8_t public_key[32];
+    uint8_t private_key[32];
+    crypto_session_t crypto;
+    uint32_t vpn_ip;               // 네트워크 바이트 오더
+    uint64_t hs_start_ns;
+    uint64_t hs_ns;                // 핸드셰이크 지연 (CONNECT_REQ → 세션키 준비)
+    
+    uint64_t tx_counter;           // 클라이언트 → 서버 nonce 카운터
+    replay_window_t window;        // 서버 → 클라이언트
+    uint64_t start_ns;             // 첫 패킷 시각 (세션마다 위상을 나눔)
+    uint32_t seq;
+    
+    uint64_t sent;
+    uint64_t sent_bytes;
+    uint64_t send_drops;           // 소켓 송신 버퍼가 차서 못 보낸 패킷
+    uint64_t recv;
+    uint64_t recv_bytes;
+    uint64_t bad;                  // 인증 실패 / 알 수 없는 응답
+    uint64_t rtt_sum_ns;
+    uint64_t rtt_min_ns;
+    uint64_t rtt_max_ns;
+} session_t;
+
+// 크기 분포 (가중치 누적)
+typedef struct {
+    int size[LOADGEN_MAX_SIZES];
+    int cumulative[LOADGEN_MAX_SIZES];
+    int count;
+    int total;
+} size_mix_t;
+
+typedef struct {
+    struct sockaddr_in server_addr;
+    uint32_t target_ip;
+    int sessions;
+    int rate;
+    int duration;
+    int connect_rate;              // 초당 핸드셰이크 시작 수 (0 = 창만큼 최대한)
+    int window;
+    uint8_t suites;
+    int per_session;
+    int json_only;
+    size_mix_t mix;
+} loadgen_config_t;
+
+static volatile sig_atomic_t running = 1;
+static session_t *sessions;
+static int epoll_fd = -1;
+static uint32_t rtt_hist[LOADGEN_RTT_BUCKETS];
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+// 배치 버퍼 (모든 소켓이 번갈아 사용)
+static uint8_t tx_bufs[LOADGEN_BATCH][LOADGEN_BUF_SIZE];
+static uint8_t rx_bufs[LOADGEN_BATCH][LOADGEN_BUF_SIZE];
+static struct mmsghdr tx_msgs[LOADGEN_BATCH];
+static struct mmsghdr rx_msgs[LOADGEN_BATCH];
+static struct iovec tx_iovs[LOADGEN_BATCH];
+static struct iovec rx_iovs[LOADGEN_BATCH];
+static struct sockaddr_in tx_addrs[LOADGEN_BATCH];
+static struct sockaddr_in rx_addrs[LOADGEN_BATCH];
+
+static void signal_handler(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static int pick_size(const size_mix_t *mix) {
+    int r = (int)(next_random() % (uint64_t)mix->total);
+    for (int i = 0; i < mix->count; i++) {
+        if (r < mix->cumulative[i]) {
+            return mix->size[i];
+        }
+    }
+    return mix->size[mix->count - 1];
+}
+
+// "64:7,576:4,1400" → 크기 분포 (가중치 생략 시 1)
+static int parse_sizes(char *arg, size_mix_t *mix) {
+    memset(mix, 0, sizeof(*mix));
+    
+    for (char *tok = strtok(arg, ","); tok; tok = strtok(NULL, ",")) {
+        if (mix->count == LOADGEN_MAX_SIZES) {
+            fprintf(stderr, "❌ Too many packet sizes (max %d)\n", LOADGEN_MAX_SIZES);
+            return -1;
+        }
+    
+        char *colon = strchr(tok, ':');
+        int size = atoi(tok);
+        int weight = colon ? atoi(colon + 1) : 1;
+    
+        if (size < LOADGEN_MIN_PACKET || size > LOADGEN_MAX_PACKET || weight < 1) {
+            fprintf(stderr, "❌ Invalid size entry: %s (size %d..%d, weight >= 1)\n",
+                    tok, LOADGEN_MIN_PACKET, LOADGEN_MAX_PACKET);
+            return -1;
+        }
+    
+        mix->total += weight;
+        mix->size[mix->count] = size;
+        mix->cumulative[mix->count] = mix->total;
+        mix->count++;
+    }
+    
+    return mix->count > 0 ? 0 : -1;
+}
+
+// RTT(us) → 히스토그램 칸 (1024us 미만은 그대로, 그 위는 로그-선형)
+static int rtt_bucket(uint64_t us) {
+    if (us < LOADGEN_RTT_EXACT_US) {
+        return (int)us;
+    }
+    int exp = 63 - __builtin_clzll(us);
+    if (exp >= LOADGEN_RTT_MAX_EXP) {
+        return LOADGEN_RTT_BUCKETS - 1;
+    }
+    int sub = (int)(us >> (exp - LOADGEN_RTT_SUB_BITS)) & ((1 << LOADGEN_RTT_SUB_BITS) - 1);
+    return LOADGEN_RTT_EXACT_US + (exp - 10) * (1 << LOADGEN_RTT_SUB_BITS) + sub;
+}
+
+// 칸 → 그 칸의 하한 (us)
+static double rtt_bucket_us(int bucket) {
+    if (bucket < LOADGEN_RTT_EXACT_US) {
+        return bucket;
+    }
+    int exp = 10 + (bucket - LOADGEN_RTT_EXACT_US) / (1 << LOADGEN_RTT_SUB_BITS);
+    int sub = (bucket - LOADGEN_RTT_EXACT_US) % (1 << LOADGEN_RTT_SUB_BITS);
+    return (double)(((uint64_t)(1 << LOADGEN_RTT_SUB_BITS) + sub) << (exp - LOADGEN_RTT_SUB_BITS));
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 내부 IP 패킷 (ICMP echo request)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+static uint16_t ip_checksum(const uint8_t *data, size_t len) {
+    uint32_t sum = 0;
+    
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        sum += (uint32_t)(data[i] << 8 | data[i + 1]);
+    }
+    if (len & 1) {
+        sum += (uint32_t)(data[len - 1] << 8);
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return htons((uint16_t)~sum);
+}
+
+// size 바이트짜리 ICMP echo request 작성 (src = 세션 VPN IP)
+static void build_echo(uint8_t *pkt, int size, const session_t *s, uint32_t index,
+                       uint32_t target_ip, uint64_t now) {
+    memset(pkt, 0, 28);
+    
+    // IPv4 헤더
+    pkt[0] = 0x45;
+    pkt[2] = (uint8_t)(size >> 8);
+    pkt[3] = (uint8_t)size;
+    pkt[4] = (uint8_t)(s->seq >> 8);
+    pkt[5] = (uint8_t)s->seq;
+    pkt[8] = 64;                  // TTL
+    pkt[9] = 1;                   // ICMP
+    memcpy(pkt + 12, &s->vpn_ip, 4);
+    memcpy(pkt + 16, &target_ip, 4);
+    uint16_t ip_sum = ip_checksum(pkt, 20);
+    memcpy(pkt + 10, &ip_sum, 2);
+    
+    // ICMP echo (id = 세션 번호, seq = 하위 16비트)
+    uint8_t *icmp = pkt + 20;
+    icmp[0] = 8;
+    icmp[4] = (uint8_t)(index >> 8);
+    icmp[5] = (uint8_t)index;
+    icmp[6] = (uint8_t)(s->seq >> 8);
+    icmp[7] = (uint8_t)s->seq;
+    
+    probe_t probe = {
+        .magic = LOADGEN_PROBE_MAGIC,
+        .session = index,
+        .seq = s->seq,
+        .sent_ns = now,
+    };
+    memcpy(icmp + 8, &probe, sizeof(probe));
+    memset(icmp + 8 + sizeof(probe), 0xA5, size - 28 - sizeof(probe));
+    
+    uint16_t icmp_sum = ip_checksum(icmp, size - 20);
+    memcpy(icmp + 2, &icmp_sum, 2);
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 세션 소켓 / 핸드셰이크
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 세션 수만큼 fd를 쓸 수 있도록 soft limit 올리기
+static int raise_fd_limit(int sessions) {
+    struct rlimit rl;
+    rlim_t need = (rlim_t)sessions + 64;
+    
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) {
+        perror("getrlimit");
+        return -1;
+    }
+    if (rl.rlim_cur >= need) {
+        return 0;
+    }
+    
+    rl.rlim_cur = (rl.rlim_max == RLIM_INFINITY || rl.rlim_max >= need) ? need : rl.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur < need) {
+        fprintf(stderr, "❌ Need %lu file descriptors, limit is %lu (ulimit -n)\n",
+                (unsigned long)need, (unsigned long)rl.rlim_cur);
+        return -1;
+    }
+    return 0;
+}
+
+// 세션 소켓 열기 (서버에 connect → 세션마다 고유한 출발 포트)
+static int open_sessions(const loadgen_config_t *config) {
+    for (int i = 0; i < config->sessions; i++) {
+        session_t *s = &sessions[i];
+    
+        s->fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (s->fd < 0) {
+            perror("socket");
+            return -1;
+        }
+    
+        if (connect(s->fd, (const struct sockaddr*)&config->server_addr,
+                    sizeof(config->server_addr)) < 0 ||
+            set_nonblocking(s->fd) < 0 ||
+            event_loop_add(epoll_fd, s->fd, EPOLLIN | EPOLLET, (uint32_t)i) < 0) {
+            perror("session socket");
+            return -1;
+        }
+    
+        crypto_generate_keypair(s->public_key, s->private_key);
+        s->rtt_min_ns = UINT64_MAX;
+    }
+    return 0;
+}
+
+static void send_connect_request(session_t *s, int index, uint8_t suites) {
+    connect_request_t req;
+    
+    memset(&req, 0, sizeof(req));
+    init_vpn_header(&req.header, PKT_CONNECT_REQ, sizeof(req) - sizeof(vpn_header_t));
+    snprintf(req.username, sizeof(req.username), "load%05d", index);
+    memcpy(req.auth_token, s->public_key, 32);
+    req.cipher_suites = suites;
+    
+    s->hs_start_ns = bench_now_ns();
+    s->state = SESSION_HANDSHAKE;
+    
+    if (send(s->fd, &req, sizeof(req), 0) < 0) {
+        perror("send CONNECT_REQ");
+        s->state = SESSION_FAILED;
+    }
+}
+
+// CONNECT_RESP → ECDH + KDF (vpn_client 와 같은 유도)
+static void handle_connect_response(session_t *s, const uint8_t *data, size_t n) {
+    const connect_response_t *resp = (const connect_response_t*)data;
+    
+    if (s->state != SESSION_HANDSHAKE) {
+        return;   // 타임아웃 뒤에 온 응답
+    }
+    
+    if (n < sizeof(connect_response_t) || resp->status != 0) {
+        s->state = SESSION_FAILED;
+        return;
+    }
+    
+    uint8_t shared_secret[32];
+    uint8_t session_key[32];
+    
+    if (crypto_ecdh(shared_secret, s->private_key, resp->server_public_key) != 0) {
+        s->state = SESSION_FAILED;
+        return;
+    }
+    crypto_kdf_derive_from_key(session_key, 32, 1, "VPN_SESS", shared_secret);
+    sodium_memzero(shared_secret, sizeof(shared_secret));
+    
+    int ret = crypto_session_init(&s->crypto, resp->cipher_suite, session_key);
+    sodium_memzero(session_key, sizeof(session_key));
+    if (ret != 0) {
+        s->state = SESSION_FAILED;
+        return;
+    }
+    
+    s->vpn_ip = resp->vpn_ip;
+    replay_window_init(&s->window);
+    s->hs_ns = bench_now_ns() - s->hs_start_ns;
+    s->state = SESSION_CONNECTED;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 데이터 송수신
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 서버 → 클라이언트 DATA: 복호화 후 echo reply 면 RTT 기록
+static void handle_data(session_t *s, uint32_t index, uint8_t *data, size_t n) {
+    if (n < sizeof(vpn_header_t) + CRYPTO_COUNTER_SIZE + CRYPTO_MAC_SIZE) {
+        s->bad++;
+        return;
+    }
+    
+    uint8_t *wire_counter = data + sizeof(vpn_header_t);
+    uint8_t *ciphertext = wire_counter + CRYPTO_COUNTER_SIZE;
+    size_t ciphertext_len = n - sizeof(vpn_header_t) - CRYPTO_COUNTER_SIZE;
+    
+    uint64_t counter = crypto_get_counter(wire_counter);
+    if (replay_window_check(&s->window, counter) != 0) {
+        s->bad++;
+        return;
+    }
+    
+    uint8_t nonce[CRYPTO_NONCE_SIZE];
+    crypto_counter_nonce(nonce, CRYPTO_DIR_SERVER_TO_CLIENT, counter);
+    
+    int len = crypto_session_decrypt_inplace(&s->crypto, ciphertext, ciphertext_len, nonce);
+    if (len < 0) {
+        s->bad++;
+        return;
+    }
+    replay_window_update(&s->window, counter);
+    
+    // IPv4 + ICMP echo reply + 우리가 보낸 probe
+    probe_t probe;
+    if (len < LOADGEN_MIN_PACKET || (ciphertext[0] >> 4) != 4 || ciphertext[9] != 1 ||
+        ciphertext[20] != 0) {
+        s->bad++;
+        return;
+    }
+    memcpy(&probe, ciphertext + 28, sizeof(probe));
+    if (probe.magic != LOADGEN_PROBE_MAGIC || probe.session != index) {
+        s->bad++;
+        return;
+    }
+    
+    uint64_t rtt = bench_now_ns() - probe.sent_ns;
+    
+    s->recv++;
+    s->recv_bytes += (uint64_t)len;
+    s->rtt_sum_ns += rtt;
+    if (rtt < s->rtt_min_ns) s->rtt_min_ns = rtt;
+    if (rtt > s->rtt_max_ns) s->rtt_max_ns = rtt;
+    rtt_hist[rtt_bucket(rtt / 1000)]++;
+}
+
+// 소켓 1개 비우기 (recvmmsg 배치, edge-triggered 이므로 EAGAIN까지)
+static void drain_session(uint32_t index) {
+    session_t *s = &sessions[index];
+    int count;
+    
+    do {
+        for (int i = 0; i < LOADGEN_BATCH; i++) {
+            udp_batch_prepare(&rx_msgs[i], &rx_iovs[i], &rx_addrs[i],
+                              rx_bufs[i], LOADGEN_BUF_SIZE);
+        }
+    
+        count = udp_recv_batch(s->fd, rx_msgs, LOADGEN_BATCH);
+    
+        for (int i = 0; i < count; i++) {
+            size_t n = rx_msgs[i].msg_len;
+            const vpn_header_t *header = (const vpn_header_t*)rx_bufs[i];
+    
+            if (n < sizeof(vpn_header_t)) {
+                continue;
+            }
+            if (header->type == PKT_CONNECT_RESP) {
+                handle_connect_response(s, rx_bufs[i], n);
+            } else if (header->type == PKT_DATA && s->state == SESSION_CONNECTED) {
+                handle_data(s, index, rx_bufs[i], n);
+            }
+        }
+    } while (count == LOADGEN_BATCH);
+}
+
+// 이벤트 처리 (timeout_ms 동안 대기)
+static void poll_sessions(int timeout_ms) {
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+    
+    int n = epoll_wait(epoll_fd, events, EVENT_LOOP_MAX_EVENTS, timeout_ms);
+    if (n < 0) {
+        if (errno != EINTR) {
+            perror("epoll_wait");
+            running = 0;
+        }
+        return;
+    }
+    
+    for (int i = 0; i < n; i++) {
+        drain_session(events[i].data.u32);
+    }
+}
+
+// 세션 1개의 밀린 패킷을 한 번의 sendmmsg로 (최대 LOADGEN_BATCH개)
+static void send_due(const loadgen_config_t *config, uint32_t index, uint64_t now) {
+    session_t *s = &sessions[index];
+    
+    if (now < s->start_ns) {
+        return;
+    }
+    
+    uint64_t due = (now - s->start_ns) * (uint64_t)config->rate / 1000000000ull + 1;
+    uint64_t done = s->sent + s->send_drops;
+    if (due <= done) {
+        return;
+    }
+    
+    int count = due - done > LOADGEN_BATCH ? LOADGEN_BATCH : (int)(due - done);
+    size_t bytes[LOADGEN_BATCH];
+    
+    for (int i = 0; i < count; i++) {
+        uint8_t *buf = tx_bufs[i];
+        int size = pick_size(&config->mix);
+    
+        // [헤더][카운터][ICMP echo 암호문 + MAC]
+        uint8_t *plaintext = buf + sizeof(vpn_header_t) + CRYPTO_COUNTER_SIZE;
+        build_echo(plaintext, size, s, index, config->target_ip, now);
+        s->seq++;
+    
+        uint64_t counter = s->tx_counter++;
+        uint8_t nonce[CRYPTO_NONCE_SIZE];
+        crypto_counter_nonce(nonce, CRYPTO_DIR_CLIENT_TO_SERVER, counter);
+        crypto_put_counter(buf + sizeof(vpn_header_t), counter);
+        crypto_session_encrypt_inplace(&s->crypto, plaintext, size, nonce);
+    
+        size_t ciphertext_len = CRYPTO_COUNTER_SIZE + size + CRYPTO_MAC_SIZE;
+        init_vpn_header((vpn_header_t*)buf, PKT_DATA, ciphertext_len);
+    
+        bytes[i] = size;
+        udp_batch_prepare(&tx_msgs[i], &tx_iovs[i], &tx_addrs[i], buf,
+                          sizeof(vpn_header_t) + ciphertext_len);
+        tx_msgs[i].msg_hdr.msg_name = NULL;   // connect()된 소켓
+        tx_msgs[i].msg_hdr.msg_namelen = 0;
+    }
+    
+    int sent = udp_send_batch(s->fd, tx_msgs, count);
+    if (sent < 0) {
+        sent = 0;
+    }
+    
+    for (int i = 0; i < sent; i++) {
+        s->sent_bytes += bytes[i];
+    }
+    s->sent += sent;
+    s->send_drops += count - sent;
+}
+
+static void send_disconnects(int count) {
+    vpn_header_t disconnect;
+    
+    for (int i = 0; i < count; i++) {
+        if (sessions[i].state == SESSION_CONNECTED || sessions[i].state == SESSION_HANDSHAKE) {
+            init_vpn_header(&disconnect, PKT_DISCONNECT, 0);
+            send(sessions[i].fd, &disconnect, sizeof(disconnect), 0);
+        }
+    }
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 단계별 실행
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 핸드셰이크 단계 (창 + 선택적 속도 제한)
+// 반환값: 첫 요청 ~ 마지막 완료까지 걸린 시간 (ns)
+static uint64_t run_handshakes(const loadgen_config_t *config) {
+    uint64_t start = bench_now_ns();
+    uint64_t last_done = start;
+    int next = 0;
+    
+    while (running) {
+        uint64_t now = bench_now_ns();
+        int outstanding = 0;
+        int finished = 0;
+    
+        // 타임아웃 + 진행 상황
+        for (int i = 0; i < next; i++) {
+            session_t *s = &sessions[i];
+            if (s->state == SESSION_HANDSHAKE &&
+                now - s->hs_start_ns > LOADGEN_HANDSHAKE_MS * 1000000ull) {
+                s->state = SESSION_FAILED;
+            }
+            if (s->state == SESSION_HANDSHAKE) {
+                outstanding++;
+            } else {
+                finished++;
+                if (s->state == SESSION_CONNECTED && s->hs_start_ns + s->hs_ns > last_done) {
+                    last_done = s->hs_start_ns + s->hs_ns;
+                }
+            }
+        }
+    
+        if (finished == config->sessions) {
+            break;
+        }
+    
+        // 새 핸드셰이크 시작
+        int allowed = config->sessions;
+        if (config->connect_rate > 0) {
+            uint64_t budget = (now - start) * (uint64_t)config->connect_rate / 1000000000ull + 1;
+            if (budget < (uint64_t)allowed) {
+                allowed = (int)budget;
+            }
+        }
+        while (next < allowed && outstanding < config->window) {
+            send_connect_request(&sessions[next], next, config->suites);
+            next++;
+            outstanding++;
+        }
+    
+        poll_sessions(LOADGEN_TICK_MS);
+    }
+    
+    return last_done - start;
+}
+
+// 데이터 단계: duration 동안 전송 + 늦은 응답 대기
+// 반환값: 전송 시간 (ns)
+static uint64_t run_traffic(const loadgen_config_t *config, int connected) {
+    uint64_t interval = 1000000000ull / (uint64_t)config->rate;
+    uint64_t start = bench_now_ns();
+    uint64_t end = start + (uint64_t)config->duration * 1000000000ull;
+    int k = 0;
+    
+    // 세션마다 첫 패킷 시각을 한 주기 안에 고르게 나눔 (동시에 몰리지 않게)
+    for (int i = 0; i < config->sessions; i++) {
+        if (sessions[i].state == SESSION_CONNECTED) {
+            sessions[i].start_ns = start + interval * (uint64_t)k++ / (uint64_t)connected;
+        }
+    }
+    
+    uint64_t now = start;
+    while (running && now < end) {
+        for (int i = 0; i < config->sessions; i++) {
+            if (sessions[i].state == SESSION_CONNECTED) {
+                send_due(config, (uint32_t)i, now);
+            }
+        }
+        poll_sessions(LOADGEN_TICK_MS);
+        now = bench_now_ns();
+    }
+    
+    uint64_t elapsed = now - start;
+    
+    uint64_t drain_end = bench_now_ns() + LOADGEN_DRAIN_MS * 1000000ull;
+    while (running && bench_now_ns() < drain_end) {
+        poll_sessions(LOADGEN_TICK_MS * 10);
+    }
+    
+    return elapsed;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 결과
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+typedef struct {
+    int attempted;
+    int connected;
+    double hs_per_s;
+    double hs_p50_ms;
+    double hs_p99_ms;
+    double hs_max_ms;
+    
+    double seconds;
+    uint64_t sent;
+    uint64_t recv;
+    uint64_t send_drops;
+    uint64_t bad;
+    uint64_t sent_bytes;
+    uint64_t recv_bytes;
+    double loss_pct;
+    double offered_mbps;
+    double goodput_mbps;
+    double rtt_us[6];              // min, p50, p90, p99, p99.9, max
+    double session_goodput[3];     // 세션별 goodput 최소 / 중앙값 / 최대 (Mbit/s)
+    double session_loss[3];        // 세션별 손실 최소 / 중앙값 / 최대 (%)
+} loadgen_result_t;
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double session_loss_pct(const session_t *s) {
+    return s->sent ? 100.0 * (double)(s->sent - (s->recv < s->sent ? s->recv : s->sent)) / (double)s->sent : 0.0;
+}
+
+static double percentile_us(uint64_t total, double pct) {
+    uint64_t rank = (uint64_t)((double)total * pct / 100.0);
+    uint64_t seen = 0;
+    
+    if (rank >= total) {
+        rank = total - 1;
+    }
+    for (int b = 0; b < LOADGEN_RTT_BUCKETS; b++) {
+        seen += rtt_hist[b];
+        if (seen > rank) {
+            return rtt_bucket_us(b);
+        }
+    }
+    return rtt_bucket_us(LOADGEN_RTT_BUCKETS - 1);
+}
+
+static void summarize(const loadgen_config_t *config, uint64_t hs_elapsed, uint64_t data_elapsed,
+                      loadgen_result_t *r) {
+    int n = config->sessions;
+    double *values = (double*)calloc(n, sizeof(double));
+    double *losses = (double*)calloc(n, sizeof(double));
+    
+    memset(r, 0, sizeof(*r));
+    r->attempted = n;
+    r->seconds = (double)data_elapsed / 1e9;
+    
+    int k = 0;
+    uint64_t rtt_min = UINT64_MAX, rtt_max = 0;
+    
+    for (int i = 0; i < n; i++) {
+        const session_t *s = &sessions[i];
+        if (s->state != SESSION_CONNECTED) {
+            continue;
+        }
+        if (values) {
+            values[r->connected] = (double)s->hs_ns / 1e6;
+        }
+        r->connected++;
+        r->sent += s->sent;
+        r->recv += s->recv;
+        r->send_drops += s->send_drops;
+        r->bad += s->bad;
+        r->sent_bytes += s->sent_bytes;
+        r->recv_bytes += s->recv_bytes;
+        if (s->recv) {
+            if (s->rtt_min_ns < rtt_min) rtt_min = s->rtt_min_ns;
+            if (s->rtt_max_ns > rtt_max) rtt_max = s->rtt_max_ns;
+        }
+    }
+    
+    if (r->connected > 0 && values && losses) {
+        qsort(values, r->connected, sizeof(double), compare_double);
+        r->hs_p50_ms = values[r->connected / 2];
+        r->hs_p99_ms = values[(int)((r->connected - 1) * 0.99)];
+        r->hs_max_ms = values[r->connected - 1];
+        r->hs_per_s = hs_elapsed ? (double)r->connected * 1e9 / (double)hs_elapsed : 0.0;
+    
+        // 세션별 goodput / 손실 분포
+        for (int i = 0; i < n; i++) {
+            const session_t *s = &sessions[i];
+            if (s->state == SESSION_CONNECTED) {
+                values[k] = r->seconds > 0 ? (double)s->recv_bytes * 8 / r->seconds / 1e6 : 0.0;
+                losses[k] = session_loss_pct(s);
+                k++;
+            }
+        }
+        qsort(values, k, sizeof(double), compare_double);
+        qsort(losses, k, sizeof(double), compare_double);
+        r->session_goodput[0] = values[0];
+        r->session_goodput[1] = values[k / 2];
+        r->session_goodput[2] = values[k - 1];
+        r->session_loss[0] = losses[0];
+        r->session_loss[1] = losses[k / 2];
+        r->session_loss[2] = losses[k - 1];
+    }
+    
+    uint64_t answered = r->recv < r->sent ? r->recv : r->sent;
+    r->loss_pct = r->sent ? 100.0 * (double)(r->sent - answered) / (double)r->sent : 0.0;
+    r->offered_mbps = r->seconds > 0 ? (double)r->sent_bytes * 8 / r->seconds / 1e6 : 0.0;
+    r->goodput_mbps = r->seconds > 0 ? (double)r->recv_bytes * 8 / r->seconds / 1e6 : 0.0;
+    
+    if (r->recv > 0) {
+        r->rtt_us[0] = (double)rtt_min / 1e3;
+        r->rtt_us[1] = percentile_us(r->recv, 50.0);
+        r->rtt_us[2] = percentile_us(r->recv, 90.0);
+        r->rtt_us[3] = percentile_us(r->recv, 99.0);
+        r->rtt_us[4] = percentile_us(r->recv, 99.9);
+        r->rtt_us[5] = (double)rtt_max / 1e3;
+    }
+    
+    free(values);
+    free(losses);
+}
+
+static void print_table(const loadgen_config_t *config, const loadgen_result_t *r) {
+    printf("━━━ Handshakes ━━━\n");
+    printf("   Connected:   %d / %d (%d failed or timed out)\n",
+           r->connected, r->attempted, r->attempted - r->connected);
+    printf("   Rate:        %.1f handshakes/s\n", r->hs_per_s);
+    printf("   Latency:     p50 %.2f ms, p99 %.2f ms, max %.2f ms\n\n",
+           r->hs_p50_ms, r->hs_p99_ms, r->hs_max_ms);
+    
+    printf("━━━ Traffic (%.1f s, %d pps/session) ━━━\n", r->seconds, config->rate);
+    printf("   Sent:        %llu packets, %.1f Mbit/s offered (%llu send drops)\n",
+           (unsigned long long)r->sent, r->offered_mbps, (unsigned long long)r->send_drops);
+    printf("   Echoed:      %llu packets, %.1f Mbit/s goodput\n",
+           (unsigned long long)r->recv, r->goodput_mbps);
+    printf("   Loss:        %.3f %%   (%llu bad / unauthenticated replies)\n",
+           r->loss_pct, (unsigned long long)r->bad);
+    if (r->recv > 0) {
+        printf("   RTT (us):    min %.0f  p50 %.0f  p90 %.0f  p99 %.0f  p99.9 %.0f  max %.0f\n",
+               r->rtt_us[0], r->rtt_us[1], r->rtt_us[2], r->rtt_us[3], r->rtt_us[4], r->rtt_us[5]);
+    } else {
+        printf("   RTT:         no echo replies (is the server on a TUN backend?)\n");
+    }
+    printf("   Per session: goodput min/median/max %.3f / %.3f / %.3f Mbit/s\n",
+           r->session_goodput[0], r->session_goodput[1], r->session_goodput[2]);
+    printf("                loss    min/median/max %.2f / %.2f / %.2f %%\n\n",
+           r->session_loss[0], r->session_loss[1], r->session_loss[2]);
+    
+    if (config->per_session) {
+        printf("━━━ Sessions ━━━\n");
+        printf("   %-6s %-15s %9s %9s %9s %8s %10s %10s\n",
+               "#", "VPN IP", "hs ms", "sent", "echoed", "loss %", "rtt avg us", "rtt max us");
+        for (int i = 0; i < config->sessions; i++) {
+            const session_t *s = &sessions[i];
+            if (s->state != SESSION_CONNECTED) {
+                printf("   %-6d %-15s %9s\n", i, "-", "failed");
+                continue;
+            }
+            struct in_addr addr = { .s_addr = s->vpn_ip };
+            printf("   %-6d %-15s %9.2f %9llu %9llu %8.2f %10.0f %10.0f\n",
+                   i, inet_ntoa(addr), (double)s->hs_ns / 1e6,
+                   (unsigned long long)s->sent, (unsigned long long)s->recv,
+                   session_loss_pct(s),
+                   s->recv ? (double)s->rtt_sum_ns / (double)s->recv / 1e3 : 0.0,
+                   (double)s->rtt_max_ns / 1e3);
+        }
+        printf("\n");
+    }
+}
+
+static void print_json(const loadgen_config_t *config, const loadgen_result_t *r) {
+    printf("{\n");
+    printf("  \"sessions\": %d,\n", r->attempted);
+    printf("  \"rate_pps_per_session\": %d,\n", config->rate);
+    printf("  \"handshake\": {\"connected\": %d, \"failed\": %d, \"per_s\": %.1f, "
+           "\"p50_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f},\n",
+           r->connected, r->attempted - r->connected, r->hs_per_s,
+           r->hs_p50_ms, r->hs_p99_ms, r->hs_max_ms);
+    printf("  \"traffic\": {\"seconds\": %.3f, \"sent\": %llu, \"echoed\": %llu, "
+           "\"send_drops\": %llu, \"bad\": %llu, \"loss_pct\": %.4f, "
+           "\"offered_mbps\": %.3f, \"goodput_mbps\": %.3f},\n",
+           r->seconds, (unsigned long long)r->sent, (unsigned long long)r->recv,
+           (unsigned long long)r->send_drops, (unsigned long long)r->bad, r->loss_pct,
+           r->offered_mbps, r->goodput_mbps);
+    printf("  \"rtt_us\": {\"min\": %.1f, \"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, "
+           "\"p999\": %.0f, \"max\": %.1f}%s\n",
+           r->rtt_us[0], r->rtt_us[1], r->rtt_us[2], r->rtt_us[3], r->rtt_us[4], r->rtt_us[5],
+           config->per_session ? "," : "");
+    
+    if (config->per_session) {
+        printf("  \"per_session\": [\n");
+        for (int i = 0; i < config->sessions; i++) {
+            const session_t *s = &sessions[i];
+            printf("    {\"index\": %d, \"connected\": %s, \"handshake_ms\": %.3f, "
+                   "\"sent\": %llu, \"echoed\": %llu, \"loss_pct\": %.4f, "
+                   "\"goodput_mbps\": %.4f, \"rtt_avg_us\": %.1f, \"rtt_max_us\": %.1f}%s\n",
+                   i, s->state == SESSION_CONNECTED ? "true" : "false",
+                   (double)s->hs_ns / 1e6,
+                   (unsigned long long)s->sent, (unsigned long long)s->recv,
+                   session_loss_pct(s),
+                   r->seconds > 0 ? (double)s->recv_bytes * 8 / r->seconds / 1e6 : 0.0,
+                   s->recv ? (double)s->rtt_sum_ns / (double)s->recv / 1e3 : 0.0,
+                   (double)s->rtt_max_ns / 1e3,
+                   i + 1 < config->sessions ? "," : "");
+        }
+        printf("  ]\n");
+    }
+    printf("}\n");
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// main
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --server <ip>        VPN server (default %s)\n", LOADGEN_DEFAULT_SERVER);
+    printf("  --port <N>           server port (default %d)\n", LOADGEN_DEFAULT_PORT);
+    printf("  --sessions <N>       concurrent clients (default %d, 1..%d)\n",
+           LOADGEN_DEFAULT_SESSIONS, LOADGEN_MAX_SESSIONS);
+    printf("  --connect-rate <N>   handshakes started per second (default: as fast as the window allows)\n");
+    printf("  --window <N>         handshakes in flight (default %d)\n", LOADGEN_DEFAULT_WINDOW);
+    printf("  --rate <N>           packets per second per session (default %d)\n",
+           LOADGEN_DEFAULT_RATE);
+    printf("  --duration <S>       traffic phase in seconds (default %d)\n",
+           LOADGEN_DEFAULT_DURATION);
+    printf("  --sizes <s:w,...>    inner IP packet sizes with weights (default %s, %d..%d)\n",
+           LOADGEN_DEFAULT_SIZES, LOADGEN_MIN_PACKET, LOADGEN_MAX_PACKET);
+    printf("  --target <ip>        echo target inside the tunnel (default %s)\n",
+           LOADGEN_DEFAULT_TARGET);
+    printf("  --suite chacha|aes   cipher suite to offer (default chacha)\n");
+    printf("  --per-session        print one row per session (and include them in JSON)\n");
+    printf("  --json               print only the JSON summary\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *server = LOADGEN_DEFAULT_SERVER;
+    const char *target = LOADGEN_DEFAULT_TARGET;
+    char sizes_arg[256] = LOADGEN_DEFAULT_SIZES;
+    int port = LOADGEN_DEFAULT_PORT;
+    loadgen_config_t config = {
+        .sessions = LOADGEN_DEFAULT_SESSIONS,
+        .rate = LOADGEN_DEFAULT_RATE,
+        .duration = LOADGEN_DEFAULT_DURATION,
+        .window = LOADGEN_DEFAULT_WINDOW,
+        .suites = CRYPTO_SUITE_CHACHA20_POLY1305,
+    };
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+            server = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) {
+            config.sessions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--connect-rate") == 0 && i + 1 < argc) {
+            config.connect_rate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            config.window = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            config.rate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            config.duration = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            strncpy(sizes_arg, argv[++i], sizeof(sizes_arg) - 1);
+        } else if (strcmp(argv[i], "--target") == 0 && i + 1 < argc) {
+            target = argv[++i];
+        } else if (strcmp(argv[i], "--suite") == 0 && i + 1 < argc) {
+            i++;
+            config.suites = strcmp(argv[i], "aes") == 0 ? CRYPTO_SUITE_AES256_GCM
+                                                         : CRYPTO_SUITE_CHACHA20_POLY1305;
+        } else if (strcmp(argv[i], "--per-session") == 0) {
+            config.per_session = 1;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            config.json_only = 1;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (config.sessions < 1 || config.sessions > LOADGEN_MAX_SESSIONS ||
+        config.rate < 1 || config.duration < 1 || config.window < 1 ||
+        config.connect_rate < 0 || port < 1 || port > 65535 ||
+        parse_sizes(sizes_arg, &config.mix) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    
+    config.server_addr.sin_family = AF_INET;
+    config.server_addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, server, &config.server_addr.sin_addr) <= 0 ||
+        inet_pton(AF_INET, target, &config.target_ip) <= 0) {
+        fprintf(stderr, "❌ Invalid server or target address\n");
+        return 1;
+    }
+    
+    // crypto_init 은 성공 메시지를 stdout에 남기므로 (--json 출력 보호) 직접 초기화
+    if (sodium_init() < 0) {
+        fprintf(stderr, "❌ libsodium initialization failed\n");
+        return 1;
+    }
+    if (!(crypto_supported_suites() & config.suites)) {
+        fprintf(stderr, "❌ %s is not available on this CPU\n", crypto_suite_name(config.suites));
+        return 1;
+    }
+    if (raise_fd_limit(config.sessions) != 0) {
+        return 1;
+    }
+    
+    sessions = (session_t*)calloc(config.sessions, sizeof(session_t));
+    epoll_fd = event_loop_create();
+    if (!sessions || epoll_fd < 0) {
+        perror("setup");
+        return 1;
+    }
+    
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    
+    if (!config.json_only) {
+        printf("🚀 VPN Load Generator\n");
+        printf("═══════════════════════════════════════\n");
+        printf("   Server:   %s:%d (inner echo target %s)\n", server, port, target);
+        printf("   Sessions: %d, %d pps each, %d s\n",
+               config.sessions, config.rate, config.duration);
+        printf("   Sizes:    ");
+        for (int i = 0; i < config.mix.count; i++) {
+            int weight = config.mix.cumulative[i] - (i ? config.mix.cumulative[i - 1] : 0);
+            printf("%s%d B x%d", i ? ", " : "", config.mix.size[i], weight);
+        }
+        printf("\n");
+        printf("   Suite:    %s\n\n", crypto_suite_name(config.suites));
+    }
+    
+    int ret = 0;
+    
+    if (open_sessions(&config) != 0) {
+        ret = 1;
+    } else {
+        uint64_t hs_elapsed = run_handshakes(&config);
+    
+        int connected = 0;
+        for (int i = 0; i < config.sessions; i++) {
+            connected += (sessions[i].state == SESSION_CONNECTED);
+        }
+    
+        uint64_t data_elapsed = 0;
+        if (connected > 0) {
+            data_elapsed = run_traffic(&config, connected);
+        } else {
+            fprintf(stderr, "❌ No session completed the handshake\n");
+            ret = 1;
+        }
+    
+        loadgen_result_t result;
+        summarize(&config, hs_elapsed, data_elapsed, &result);
+        if (!config.json_only) {
+            print_table(&config, &result);
+            printf("━━━ JSON ━━━\n");
+        }
+        print_json(&config, &result);
+    }
+    
+    send_disconnects(config.sessions);
+    
+    for (int i = 0; i < config.sessions; i++) {
+        if (sessions[i].fd > 0) {
+            close(sessions[i].fd);
+        }
+        crypto_session_clear(&sessions[i].crypto);
+    }
+    sodium_memzero(sessions, sizeof(session_t) * config.sessions);
+    free(sessions);
+    close(epoll_fd);
+    
+    return ret;
+}
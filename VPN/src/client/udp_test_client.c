@@ -54,6 +54,7 @@ int main(int argc, char *argv[]) {
     
     strncpy(conn_req.username, "test_user", sizeof(conn_req.username) - 1);
     memset(conn_req.auth_token, 0xAB, sizeof(conn_req.auth_token)); // 가짜 토큰
+    conn_req.cipher_suites = 0;   // 스위트 제안 없음 → 서버가 ChaCha20-Poly1305 선택
     
     printf("Sending CONNECT_REQ...\n");
     print_vpn_packet(&conn_req.header);
@@ -1,40 +1,87 @@
 // src/client/vpn_client.c
 
+#define _GNU_SOURCE
 #include "protocol.h"
 #include "crypto.h"
 #include "tun_manager.h"
+#include "udp_server.h"
 #include "config.h"
 #include "logger.h"
+#include "packet_buf.h"
+#include "replay_window.h"
+#include "event_loop.h"
+#include "packet_io.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <unistd.h>
+#include <errno.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
-#include <sys/select.h>
 #include <signal.h>
 #include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
 #include <sodium.h>
 
 #define INITIAL_BACKOFF 1
 #define MAX_BACKOFF 60
 
+#define CLIENT_BATCH_SIZE 64        // recvmmsg / sendmmsg 1회당 최대 패킷 수
+#define CLIENT_DRAIN_BUDGET 16      // epoll 깨어남 1회당 최대 배치 수 (타이머 굶주림 방지)
+#define KEEPALIVE_TICK_MS 1000      // keepalive / PONG 타임아웃 확인 주기 (timerfd)
+#define DATA_THREAD_WAIT_MS 500     // 데이터 스레드가 종료 플래그 / 세션 교체를 확인하는 주기
+#define SESSION_SWAP_WAIT_MS 2000   // 세션 교체 시 두 스레드가 넘겨받기를 기다리는 최대 시간
+
+// epoll 이벤트 태그
+enum {
+    EV_UDP = 1,
+    EV_TUN,
+    EV_WAKE
+};
+
+// 연결 1회분 세션 (발행한 뒤에는 바뀌지 않음)
+// RX/TX 스레드가 공유하는 것은 이 구조체뿐이고, 재연결하면 새 세션을 만들어 포인터째 교체한다.
+// 카운터와 재전송 창은 방향별 스레드가 각자 가진다.
+typedef struct client_session {
+    uint32_t generation;           // 교체할 때마다 1씩 증가
+    int sock_fd;                   // 세션 전용 UDP 소켓 (재연결마다 새로 생성)
+    int udp_offload;               // UDP_OFFLOAD_* (GSO 묶음 전송 / GRO 묶음 수신)
+    crypto_session_t crypto;       // 협상된 스위트 + 미리 계산한 키 스케줄
+    struct client_session *retired_next;  // 해제 대기 목록 (메인 스레드 전용)
+} client_session_t;
+
+// 방향별 데이터 스레드 (RX: UDP → 복호화 → TUN, TX: TUN → 암호화 → UDP)
+typedef struct {
+    pthread_t thread;
+    int started;                   // 스레드 생성 여부
+    int wake_fd;                   // eventfd (세션 교체 / 종료 알림)
+    uint32_t generation;           // 이 스레드가 넘겨받은 세션 세대 (__atomic)
+} data_thread_t;
+
 typedef struct {
-    int sock_fd;
     int tun_fd;
+    packet_io_t io;                // TUN 또는 pcap replay/record
     struct sockaddr_in server_addr;
     
     uint8_t client_private_key[32];
     uint8_t client_public_key[32];
     uint8_t server_public_key[32];
-    uint8_t session_key[32];
+    client_session_t *session;     // 현재 세션 (__atomic 교체, 데이터 스레드는 읽기만)
+    client_session_t *retired;     // 교체됐지만 아직 해제하지 못한 이전 세션들
     
     uint32_t vpn_ip;
+    int pool_prefix;               // 서버 VPN IP 풀 프리픽스 (TUN 넷마스크)
     uint32_t session_id;
     int connected;
     
     time_t last_ping_sent;
-    time_t last_pong_received;
+    time_t last_pong_received;     // RX 스레드가 기록 (__atomic)
+    
+    data_thread_t rx;
+    data_thread_t tx;
     
     int reconnect_attempts;
     int backoff_seconds;
@@ -43,6 +90,39 @@ typedef struct {
     vpn_config_t *config;
 } vpn_client_t;
 
+// RX 스레드 상태 (서버 → 클라이언트)
+typedef struct {
+    const client_session_t *session;
+    replay_window_t window;        // 서버 → 클라이언트 재전송 방지 창
+} rx_state_t;
+
+// TX 스레드 상태 (클라이언트 → 서버)
+typedef struct {
+    const client_session_t *session;
+    uint64_t counter;              // 클라이언트 → 서버 nonce 카운터
+} tx_state_t;
+
+// 배치 버퍼 (rx_* 는 RX 스레드 전용, tx_* 는 TX 스레드 전용)
+typedef struct {
+    // UDP → TUN (GRO 묶음 수신)
+    struct mmsghdr rx_msgs[CLIENT_BATCH_SIZE];
+    struct iovec rx_iovs[CLIENT_BATCH_SIZE];
+    struct sockaddr_in rx_addrs[CLIENT_BATCH_SIZE];
+    udp_cmsg_t rx_ctrls[CLIENT_BATCH_SIZE];
+    
+    // TUN → UDP (메시지 i ↔ tx_ctrls[i], GSO 묶음은 연속된 tx_iovs 여러 개 사용)
+    uint8_t tx_bufs[CLIENT_BATCH_SIZE][PKT_BUF_SIZE];
+    packet_buf_t tx_pkts[CLIENT_BATCH_SIZE];
+    struct mmsghdr tx_msgs[CLIENT_BATCH_SIZE];
+    struct iovec tx_iovs[CLIENT_BATCH_SIZE];
+    udp_cmsg_t tx_ctrls[CLIENT_BATCH_SIZE];
+} client_batch_t;
+
+static client_batch_t batch;
+
+// GRO 수신 버퍼 (RX 스레드 전용, 묶음 1개 = 최대 64KB, 실제로 쓰인 페이지만 메모리 차지)
+static uint8_t gro_buffers[CLIENT_BATCH_SIZE][UDP_GRO_BUF_SIZE];
+
 volatile sig_atomic_t client_running = 1;
 
 void client_signal_handler(int sig) {
@@ -61,7 +141,8 @@ vpn_client_t* init_vpn_client(const char *server_ip, uint16_t server_port) {
     
     memset(client, 0, sizeof(vpn_client_t));
     client->tun_fd = -1;
-    client->sock_fd = -1;
+    client->rx.wake_fd = -1;
+    client->tx.wake_fd = -1;
     client->backoff_seconds = INITIAL_BACKOFF;
     
     if (crypto_init() != 0) {
@@ -69,62 +150,163 @@ vpn_client_t* init_vpn_client(const char *server_ip, uint16_t server_port) {
         return NULL;
     }
     
-    crypto_generate_keypair(client->client_public_key, client->client_private_key);
-    
     LOG_INFO("✅ VPN Client initialized");
     LOG_INFO("   Server: %s:%u", server_ip, server_port);
     
     return client;
 }
 
+// 세션 해제 (소켓 닫기 + 키 스케줄 지우기)
+static void free_session(client_session_t *session) {
+    if (session) {
+        if (session->sock_fd >= 0) {
+            close(session->sock_fd);
+        }
+        crypto_session_clear(&session->crypto);
+        sodium_memzero(session, sizeof(client_session_t));
+        free(session);
+    }
+}
+
+// 해제 대기 중인 이전 세션 모두 해제
+// (두 스레드가 최신 세대를 넘겨받았거나 멈춘 뒤에만 호출)
+static void free_retired_sessions(vpn_client_t *client) {
+    while (client->retired) {
+        client_session_t *next = client->retired->retired_next;
+        free_session(client->retired);
+        client->retired = next;
+    }
+}
+
+// 데이터 스레드가 멈춘 뒤에 호출
 void destroy_vpn_client(vpn_client_t *client) {
     if (client) {
-        if (client->connected && client->sock_fd >= 0) {
+        client_session_t *session = client->session;
+        
+        if (client->connected && session) {
             uint8_t buffer[sizeof(vpn_header_t)];
             vpn_header_t *disconnect = (vpn_header_t*)buffer;
             init_vpn_header(disconnect, PKT_DISCONNECT, 0);
             
-            sendto(client->sock_fd, buffer, sizeof(vpn_header_t), 0,
+            sendto(session->sock_fd, buffer, sizeof(vpn_header_t), 0,
                    (struct sockaddr*)&client->server_addr,
                    sizeof(client->server_addr));
             
             LOG_DEBUG("📤 DISCONNECT sent");
         }
         
-        if (client->sock_fd >= 0) {
-            close(client->sock_fd);
+        free_session(session);
+        free_retired_sessions(client);
+        if (client->rx.wake_fd >= 0) {
+            close(client->rx.wake_fd);
+        }
+        if (client->tx.wake_fd >= 0) {
+            close(client->tx.wake_fd);
         }
         if (client->tun_fd >= 0) {
             close(client->tun_fd);
         }
+        packet_io_close(&client->io);
         sodium_memzero(client, sizeof(vpn_client_t));
         free(client);
         LOG_INFO("🧹 VPN Client destroyed");
     }
 }
 
-int recreate_socket(vpn_client_t *client) {
-    if (client->sock_fd >= 0) {
-        close(client->sock_fd);
+// 새 세션용 소켓 생성 (기존 세션 소켓은 데이터 스레드가 계속 사용)
+// 반환값: 소켓 fd, -1 (실패)
+static int open_session_socket(vpn_client_t *client, int *udp_offload) {
+    client->server_addr.sin_family = AF_INET;
+    client->server_addr.sin_port = htons(client->config->server_port);
+    
+    if (inet_pton(AF_INET, client->config->server_address, &client->server_addr.sin_addr) <= 0) {
+        LOG_ERROR("Invalid server IP");
+        return -1;
     }
     
-    client->sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (client->sock_fd < 0) {
+    int sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock_fd < 0) {
         perror("socket");
         return -1;
     }
     
-    client->server_addr.sin_family = AF_INET;
-    client->server_addr.sin_port = htons(client->config->server_port);
+    // GRO: 서버가 GSO로 묶어 보낸 데이터그램을 묶음으로 수신
+    // GSO: TUN에서 읽은 같은 크기 패킷을 메시지 하나로 묶어 전송
+    *udp_offload = udp_enable_offload(sock_fd);
+    LOG_DEBUG("   UDP offload: GSO %s, GRO %s",
+              (*udp_offload & UDP_OFFLOAD_GSO) ? "on" : "off",
+              (*udp_offload & UDP_OFFLOAD_GRO) ? "on" : "off");
     
-    if (inet_pton(AF_INET, client->config->server_address, &client->server_addr.sin_addr) <= 0) {
-        LOG_ERROR("Invalid server IP");
-        close(client->sock_fd);
-        client->sock_fd = -1;
-        return -1;
+    return sock_fd;
+}
+
+// 데이터 스레드가 모두 새 세대를 넘겨받았는지
+static int session_acked(vpn_client_t *client, uint32_t generation) {
+    data_thread_t *threads[2] = { &client->rx, &client->tx };
+    
+    for (int i = 0; i < 2; i++) {
+        if (threads[i]->started &&
+            __atomic_load_n(&threads[i]->generation, __ATOMIC_ACQUIRE) != generation) {
+            return 0;
+        }
     }
+    return 1;
+}
+
+// 데이터 스레드 깨우기 (세션 교체 / 종료)
+static void wake_data_thread(data_thread_t *thread) {
+    uint64_t one = 1;
+    if (thread->wake_fd >= 0 &&
+        write(thread->wake_fd, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN) {
+        perror("eventfd write");
+    }
+}
+
+// 깨우기 알림 소비 (논블로킹 eventfd: 값이 없으면 EAGAIN)
+static void drain_wake_fd(data_thread_t *thread) {
+    uint64_t value;
+    if (read(thread->wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        perror("eventfd read");
+    }
+}
+
+// 새 세션 발행: 포인터를 원자적으로 교체하고, 두 스레드가 넘겨받은 뒤 이전 세션 해제
+// (스레드는 배치 사이에서만 세션을 바꾸므로 넘겨받은 뒤에는 이전 키/소켓을 쓰지 않음)
+static void publish_session(vpn_client_t *client, client_session_t *session) {
+    client_session_t *old = client->session;
     
-    return 0;
+    session->generation = old ? old->generation + 1 : 1;
+    __atomic_store_n(&client->session, session, __ATOMIC_RELEASE);
+    
+    if (!old) {
+        return;
+    }
+    
+    wake_data_thread(&client->rx);
+    wake_data_thread(&client->tx);
+    
+    for (int waited = 0; !session_acked(client, session->generation); waited++) {
+        if (waited >= SESSION_SWAP_WAIT_MS) {
+            // 아직 이전 세션을 쓰는 스레드가 있으면 대기 목록에 넣고 다음 확인 때 해제
+            old->retired_next = client->retired;
+            client->retired = old;
+            LOG_WARN("⚠️  Data threads did not pick up session %u, retiring the old one",
+                     session->generation);
+            return;
+        }
+        usleep(1000);
+    }
+    
+    // 스레드는 항상 최신 세션으로만 옮겨가므로 대기 중인 더 오래된 세션도 함께 해제
+    free_session(old);
+    free_retired_sessions(client);
+}
+
+// 교체가 늦어 남겨둔 세션 정리 (keepalive 타이머마다 확인)
+static void reap_retired_sessions(vpn_client_t *client) {
+    if (client->retired && session_acked(client, client->session->generation)) {
+        free_retired_sessions(client);
+    }
 }
 
 int vpn_connect(vpn_client_t *client, const char *username) {
@@ -132,7 +314,15 @@ int vpn_connect(vpn_client_t *client, const char *username) {
     
     LOG_INFO("🔐 Connecting to VPN server...");
     
-    if (recreate_socket(client) != 0) {
+    client_session_t *session = (client_session_t*)calloc(1, sizeof(client_session_t));
+    if (!session) {
+        perror("calloc");
+        return -1;
+    }
+    
+    session->sock_fd = open_session_socket(client, &session->udp_offload);
+    if (session->sock_fd < 0) {
+        free(session);
         return -1;
     }
     
@@ -140,33 +330,39 @@ int vpn_connect(vpn_client_t *client, const char *username) {
     init_vpn_header(&req->header, PKT_CONNECT_REQ,
                     sizeof(connect_request_t) - sizeof(vpn_header_t));
     
+    // 연결(재연결)마다 새 키 쌍 → 서버 키 쌍과 함께 세션키가 매번 바뀜
+    crypto_generate_keypair(client->client_public_key, client->client_private_key);
+    
     strncpy(req->username, username, sizeof(req->username) - 1);
     memcpy(req->auth_token, client->client_public_key, 32);
+    req->cipher_suites = crypto_supported_suites();   // 서버가 이 중에서 고름
     
     LOG_DEBUG("   Sending CONNECT_REQ...");
     
-    ssize_t sent = sendto(client->sock_fd, buffer, sizeof(connect_request_t), 0,
+    ssize_t sent = sendto(session->sock_fd, buffer, sizeof(connect_request_t), 0,
                           (struct sockaddr*)&client->server_addr,
                           sizeof(client->server_addr));
     
     if (sent < 0) {
         perror("sendto");
+        free_session(session);
         return -1;
     }
     
     LOG_DEBUG("   Waiting for CONNECT_RESP...");
     
     struct timeval tv = {5, 0};
-    setsockopt(client->sock_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(session->sock_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
     
     struct sockaddr_in recv_addr;
     socklen_t recv_len = sizeof(recv_addr);
     
-    ssize_t n = recvfrom(client->sock_fd, buffer, sizeof(buffer), 0,
+    ssize_t n = recvfrom(session->sock_fd, buffer, sizeof(buffer), 0,
                          (struct sockaddr*)&recv_addr, &recv_len);
     
     if (n < 0) {
         perror("recvfrom");
+        free_session(session);
         return -1;
     }
     
@@ -174,11 +370,13 @@ int vpn_connect(vpn_client_t *client, const char *username) {
     
     if (resp->header.type != PKT_CONNECT_RESP) {
         LOG_ERROR("   ❌ Unexpected response type");
+        free_session(session);
         return -1;
     }
     
     if (resp->status != 0) {
         LOG_ERROR("   ❌ Connection failed");
+        free_session(session);
         return -1;
     }
     
@@ -186,6 +384,14 @@ int vpn_connect(vpn_client_t *client, const char *username) {
     client->session_id = ntohl(resp->session_id);
     memcpy(client->server_public_key, resp->server_public_key, 32);
     
+    // cipher_suite 필드가 없는 구버전 서버는 ChaCha20-Poly1305
+    uint8_t suite = n > (ssize_t)offsetof(connect_response_t, cipher_suite)
+                  ? resp->cipher_suite : CRYPTO_SUITE_CHACHA20_POLY1305;
+    
+    // pool_prefix 필드가 없는 구버전 서버는 /24
+    client->pool_prefix = (n >= (ssize_t)sizeof(connect_response_t) && resp->pool_prefix)
+                        ? resp->pool_prefix : 24;
+    
     struct in_addr vpn_addr;
     vpn_addr.s_addr = client->vpn_ip;
     
@@ -196,15 +402,19 @@ int vpn_connect(vpn_client_t *client, const char *username) {
     LOG_DEBUG("   🔑 Generating session key (ECDH)...");
     
     uint8_t shared_secret[32];
+    uint8_t session_key[32];
     
-    if (crypto_ecdh(shared_secret, client->client_private_key,
-                   client->server_public_key) != 0) {
+    int ret = crypto_ecdh(shared_secret, client->client_private_key,
+                          client->server_public_key);
+    sodium_memzero(client->client_private_key, sizeof(client->client_private_key));
+    if (ret != 0) {
         LOG_ERROR("   ❌ ECDH failed");
+        free_session(session);
         return -1;
     }
     
     crypto_kdf_derive_from_key(
-        client->session_key,
+        session_key,
         32,
         1,
         "VPN_SESS",
@@ -213,13 +423,26 @@ int vpn_connect(vpn_client_t *client, const char *username) {
     
     sodium_memzero(shared_secret, 32);
     
+    ret = crypto_session_init(&session->crypto, suite, session_key);
+    sodium_memzero(session_key, sizeof(session_key));
+    if (ret != 0) {
+        LOG_ERROR("   ❌ Unsupported cipher suite: 0x%02x", suite);
+        free_session(session);
+        return -1;
+    }
+    LOG_INFO("   Cipher: %s", crypto_suite_name(suite));
+    
     LOG_DEBUG("   ✅ Session key generated");
     
+    // 양쪽 모두 핸드셰이크마다 새 키 쌍을 쓰므로 세션키도 매번 새 키
+    // → 카운터와 재전송 창은 각 스레드가 넘겨받을 때 처음부터 (서버 쪽 add_key와 동일)
+    publish_session(client, session);
+    
     client->connected = 1;
     client->reconnect_attempts = 0;
     client->backoff_seconds = INITIAL_BACKOFF;
     
-    client->last_pong_received = time(NULL);
+    __atomic_store_n(&client->last_pong_received, time(NULL), __ATOMIC_RELAXED);
     client->last_ping_sent = time(NULL);
     
     return 0;
@@ -231,19 +454,34 @@ int setup_client_tun(vpn_client_t *client) {
         return 0;
     }
     
-    LOG_INFO("━━━ Client TUN Interface ━━━");
+    const vpn_config_t *config = client->config;
+    packet_io_config_t io_config = { .type = PACKET_IO_TUN, .dev_name = "tun1" };
+    
+    // 설정에 pcap 파일이 있으면 TUN 장치 없이 replay/record
+    if (config && (config->pcap_replay[0] || config->pcap_record[0])) {
+        io_config.type = PACKET_IO_PCAP;
+        io_config.replay_path = config->pcap_replay[0] ? config->pcap_replay : NULL;
+        io_config.record_path = config->pcap_record[0] ? config->pcap_record : NULL;
+        io_config.replay_max_rate = config->pcap_max_rate;
+    }
+    
+    LOG_INFO(io_config.type == PACKET_IO_TUN ? "━━━ Client TUN Interface ━━━" : "━━━ Client Packet I/O (pcap) ━━━");
     
-    client->tun_fd = create_tun_interface("tun1");
-    if (client->tun_fd < 0) {
+    if (packet_io_open(&client->io, &io_config, &client->tun_fd, 1) < 0) {
+        client->tun_fd = -1;
         return -1;
     }
     
+    if (io_config.type != PACKET_IO_TUN) {
+        return 0;
+    }
+    
     struct in_addr vpn_addr;
     vpn_addr.s_addr = client->vpn_ip;
     char ip_str[INET_ADDRSTRLEN];
     inet_ntop(AF_INET, &vpn_addr, ip_str, sizeof(ip_str));
     
-    if (configure_tun_ip("tun1", ip_str, 24) < 0) {
+    if (configure_tun_ip("tun1", ip_str, client->pool_prefix) < 0) {
         close(client->tun_fd);
         client->tun_fd = -1;
         return -1;
@@ -264,7 +502,7 @@ void send_ping(vpn_client_t *client) {
     vpn_header_t *ping = (vpn_header_t*)buffer;
     init_vpn_header(ping, PKT_PING, 0);
     
-    ssize_t sent = sendto(client->sock_fd, buffer, sizeof(vpn_header_t), 0,
+    ssize_t sent = sendto(client->session->sock_fd, buffer, sizeof(vpn_header_t), 0,
                           (struct sockaddr*)&client->server_addr,
                           sizeof(client->server_addr));
     
@@ -277,7 +515,8 @@ void send_ping(vpn_client_t *client) {
 int check_keepalive(vpn_client_t *client) {
     time_t now = time(NULL);
     
-    if (now - client->last_pong_received > client->config->pong_timeout) {
+    time_t last_pong = __atomic_load_n(&client->last_pong_received, __ATOMIC_RELAXED);
+    if (now - last_pong > client->config->pong_timeout) {
         LOG_ERROR("❌ No PONG received for %d seconds", client->config->pong_timeout);
         LOG_ERROR("   Connection lost!");
         return -1;
@@ -326,52 +565,74 @@ int attempt_reconnect(vpn_client_t *client) {
     return 0;
 }
 
-void handle_udp_to_tun(vpn_client_t *client) {
-    uint8_t buffer[2048];
-    uint8_t plaintext[2048];
-    struct sockaddr_in recv_addr;
-    socklen_t recv_len = sizeof(recv_addr);
-    
-    ssize_t n = recvfrom(client->sock_fd, buffer, sizeof(buffer), 0,
-                         (struct sockaddr*)&recv_addr, &recv_len);
-    
-    if (n < 0) return;
+// 수신한 데이터그램 1개 처리 (DATA는 제자리에서 복호화하여 TUN에 쓰기)
+static void handle_udp_packet(vpn_client_t *client, rx_state_t *rx, uint8_t *data, size_t n) {
+    packet_buf_t pkt;
     
-    if (n < (ssize_t)sizeof(vpn_header_t)) {
+    if (n < sizeof(vpn_header_t)) {
         return;
     }
     
-    vpn_header_t *header = (vpn_header_t*)buffer;
+    pkt_buf_init(&pkt, data, n, 0);
+    pkt_put(&pkt, n);
+    vpn_header_t *header = (vpn_header_t*)pkt.data;
     
     switch (header->type) {
         case PKT_PONG: {
-            client->last_pong_received = time(NULL);
+            __atomic_store_n(&client->last_pong_received, time(NULL), __ATOMIC_RELAXED);
             LOG_DEBUG("🏓 PONG received");
             break;
         }
         
+        case PKT_PING: {
+            // 서버의 RTT 측정: 타임스탬프를 그대로 돌려줌
+            vpn_header_t pong;
+            init_vpn_header(&pong, PKT_PONG, 0);
+            pong.timestamp = header->timestamp;
+            sendto(rx->session->sock_fd, &pong, sizeof(pong), 0,
+                   (struct sockaddr*)&client->server_addr, sizeof(client->server_addr));
+            LOG_DEBUG("🏓 PING from server, PONG sent");
+            break;
+        }
+        
         case PKT_DATA: {
-            LOG_DEBUG("📥 Encrypted packet received (%zd bytes)", n);
+            LOG_DEBUG("📥 Encrypted packet received (%zu bytes)", n);
             
-            uint8_t *ciphertext = buffer + sizeof(vpn_header_t);
-            size_t ciphertext_len = n - sizeof(vpn_header_t);
+            // [헤더][카운터][암호문 + MAC] → 헤더/카운터를 벗기고 제자리에서 복호화
+            pkt_pull(&pkt, sizeof(vpn_header_t));
+            uint8_t *wire_counter = pkt_pull(&pkt, CRYPTO_COUNTER_SIZE);
+            if (!wire_counter || pkt.len < CRYPTO_MAC_SIZE) {
+                LOG_DEBUG("   ⚠️  DATA packet too short");
+                return;
+            }
+            
+            // 중복/오래된 패킷은 복호화 전에 버림
+            uint64_t counter = crypto_get_counter(wire_counter);
+            if (replay_window_check(&rx->window, counter) != 0) {
+                LOG_DEBUG("   ⚠️  Replayed packet dropped (counter=%llu)",
+                          (unsigned long long)counter);
+                return;
+            }
             
-            LOG_DEBUG("   🔓 Decrypting %zu bytes...", ciphertext_len);
+            LOG_DEBUG("   🔓 Decrypting %zu bytes...", pkt.len);
             
-            uint8_t *nonce = ciphertext;
-            uint8_t *encrypted = ciphertext + CRYPTO_NONCE_SIZE;
-            size_t encrypted_len = ciphertext_len - CRYPTO_NONCE_SIZE;
+            uint8_t nonce[CRYPTO_NONCE_SIZE];
+            crypto_counter_nonce(nonce, CRYPTO_DIR_SERVER_TO_CLIENT, counter);
             
-            if (crypto_decrypt(encrypted, encrypted_len, plaintext,
-                             client->session_key, nonce) != 0) {
+            int plaintext_len = crypto_session_decrypt_inplace(&rx->session->crypto,
+                                                               pkt.data, pkt.len, nonce);
+            if (plaintext_len < 0) {
                 LOG_ERROR("   ❌ Decryption failed");
                 return;
             }
             
-            size_t plaintext_len = encrypted_len - CRYPTO_MAC_SIZE;
-            LOG_DEBUG("   ✅ Decrypted to %zu bytes", plaintext_len);
+            // 인증된 패킷만 창을 움직임
+            replay_window_update(&rx->window, counter);
+            
+            pkt_trim(&pkt, plaintext_len);
+            LOG_DEBUG("   ✅ Decrypted to %zu bytes", pkt.len);
             
-            ssize_t written = write(client->tun_fd, plaintext, plaintext_len);
+            ssize_t written = write(client->tun_fd, pkt.data, pkt.len);
             if (written > 0) {
                 LOG_DEBUG("   → TUN: Written %zd bytes", written);
             }
@@ -383,47 +644,322 @@ void handle_udp_to_tun(vpn_client_t *client) {
     }
 }
 
-void handle_tun_to_udp(vpn_client_t *client) {
-    uint8_t buffer[2048];
-    uint8_t ciphertext[2048];
-    uint8_t packet_buffer[2048];
-    
-    ssize_t n = read(client->tun_fd, buffer, sizeof(buffer));
+// UDP → TUN: recvmmsg 한 번으로 최대 CLIENT_BATCH_SIZE개 수신
+// (GRO로 묶여 온 메시지는 세그먼트 크기 단위로 잘라서 처리)
+// 반환값: 받은 메시지 수 (CLIENT_BATCH_SIZE 미만이면 소켓이 비었음)
+int handle_udp_to_tun(vpn_client_t *client, rx_state_t *rx) {
+    for (int i = 0; i < CLIENT_BATCH_SIZE; i++) {
+        udp_batch_prepare_gro(&batch.rx_msgs[i], &batch.rx_iovs[i], &batch.rx_addrs[i],
+                              gro_buffers[i], UDP_GRO_BUF_SIZE, &batch.rx_ctrls[i]);
+    }
     
-    if (n < 0) {
-        perror("TUN read");
-        return;
+    // 소켓은 블로킹(전송 backpressure)이지만 recvmmsg는 MSG_DONTWAIT
+    int count = udp_recv_batch(rx->session->sock_fd, batch.rx_msgs, CLIENT_BATCH_SIZE);
+    if (count <= 0) {
+        return 0;
     }
     
-    LOG_DEBUG("📤 TUN packet captured (%zd bytes)", n);
-    LOG_DEBUG("   🔒 Encrypting...");
+    for (int i = 0; i < count; i++) {
+        size_t len = batch.rx_msgs[i].msg_len;
+        size_t segment_size = udp_gro_segment_size(&batch.rx_msgs[i]);
+        if (segment_size == 0) {
+            segment_size = len;
+        }
+        
+        for (size_t off = 0; off < len; off += segment_size) {
+            size_t seg_len = len - off < segment_size ? len - off : segment_size;
+            handle_udp_packet(client, rx, gro_buffers[i] + off, seg_len);
+        }
+    }
     
+    return count;
+}
+
+// TUN에서 읽은 평문 1개를 DATA 패킷으로 (제자리 암호화)
+// pkt: [headroom][평문] → [헤더][카운터][암호문 + MAC]
+// 반환값: 0 (성공), -1 (실패)
+static int seal_packet(tx_state_t *tx, packet_buf_t *pkt) {
+    size_t plaintext_len = pkt->len;
+    
+    // 평문 앞에 카운터, 제자리 암호화 후 뒤에 MAC
+    uint64_t counter = tx->counter++;
     uint8_t nonce[CRYPTO_NONCE_SIZE];
-    crypto_random_nonce(nonce);
+    crypto_counter_nonce(nonce, CRYPTO_DIR_CLIENT_TO_SERVER, counter);
+    crypto_put_counter(pkt_push(pkt, CRYPTO_COUNTER_SIZE), counter);
     
-    if (crypto_encrypt(buffer, n, ciphertext + CRYPTO_NONCE_SIZE,
-                      client->session_key, nonce) != 0) {
-        LOG_ERROR("   ❌ Encryption failed");
-        return;
+    if (crypto_session_encrypt_inplace(&tx->session->crypto,
+                                       pkt->data + CRYPTO_COUNTER_SIZE,
+                                       plaintext_len, nonce) != 0) {
+        return -1;
     }
     
-    memcpy(ciphertext, nonce, CRYPTO_NONCE_SIZE);
-    size_t ciphertext_len = CRYPTO_NONCE_SIZE + n + CRYPTO_MAC_SIZE;
+    pkt_put(pkt, CRYPTO_MAC_SIZE);
     
-    LOG_DEBUG("   ✅ Encrypted to %zu bytes", ciphertext_len);
+    size_t ciphertext_len = pkt->len;
+    vpn_header_t *header = (vpn_header_t*)pkt_push(pkt, sizeof(vpn_header_t));
+    init_vpn_header(header, PKT_DATA, ciphertext_len);
     
-    data_packet_t *pkt = (data_packet_t*)packet_buffer;
-    init_vpn_header(&pkt->header, PKT_DATA, ciphertext_len);
-    memcpy(pkt->data, ciphertext, ciphertext_len);
+    return 0;
+}
+
+// TUN → UDP: EAGAIN이 나올 때까지 최대 CLIENT_BATCH_SIZE개 읽어 암호화 후 sendmmsg 한 번
+// GSO가 켜져 있으면 연속된 같은 크기 패킷을 메시지 하나로 묶는다.
+// (마지막 세그먼트만 짧을 수 있으므로 짧은 패킷이 오면 묶음을 닫음)
+// 반환값: 읽은 패킷 수 (CLIENT_BATCH_SIZE 미만이면 TUN이 비었음)
+int handle_tun_to_udp(vpn_client_t *client, tx_state_t *tx) {
+    int reads = 0;
+    int ready = 0;
+    
+    while (reads < CLIENT_BATCH_SIZE) {
+        packet_buf_t *pkt = &batch.tx_pkts[ready];
+        
+        // 헤더 + 카운터 자리를 비우고 읽기 (MAC 자리는 뒤에 남김)
+        pkt_buf_init(pkt, batch.tx_bufs[ready], PKT_BUF_SIZE, PKT_HEADROOM);
+        
+        ssize_t n = read(client->tun_fd, pkt->data, pkt_tailroom(pkt) - PKT_TAILROOM);
+        if (n <= 0) {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("TUN read");
+            }
+            break;
+        }
+        reads++;
+        
+        pkt_put(pkt, n);
+        LOG_DEBUG("📤 TUN packet captured (%zd bytes)", n);
+        
+        if (seal_packet(tx, pkt) != 0) {
+            LOG_ERROR("   ❌ Encryption failed");
+            continue;   // 같은 버퍼를 다음 읽기에 재사용
+        }
+        ready++;
+    }
     
-    size_t total_len = sizeof(vpn_header_t) + ciphertext_len;
+    if (ready == 0) {
+        return reads;
+    }
     
-    ssize_t sent = sendto(client->sock_fd, packet_buffer, total_len, 0,
-                          (struct sockaddr*)&client->server_addr,
-                          sizeof(client->server_addr));
+    int msgs = 0;
+    int run_first = 0;            // 현재 메시지의 첫 iov
+    size_t run_seg = 0;           // 현재 메시지의 세그먼트 크기
+    size_t run_bytes = 0;
+    int run_open = 0;             // 같은 크기 세그먼트를 더 붙일 수 있는지
     
-    if (sent > 0) {
-        LOG_DEBUG("   → UDP: Sent %zd bytes to server", sent);
+    for (int i = 0; i < ready; i++) {
+        packet_buf_t *pkt = &batch.tx_pkts[i];
+        
+        batch.tx_iovs[i].iov_base = pkt->data;
+        batch.tx_iovs[i].iov_len = pkt->len;
+        
+        int segments = i - run_first;
+        if ((tx->session->udp_offload & UDP_OFFLOAD_GSO) && run_open &&
+            pkt->len <= run_seg &&
+            segments < UDP_GSO_MAX_SEGMENTS &&
+            run_bytes + pkt->len <= UDP_GSO_MAX_BYTES) {
+            // 현재 묶음에 세그먼트 추가
+            run_bytes += pkt->len;
+            run_open = (pkt->len == run_seg);
+            udp_batch_prepare_gso(&batch.tx_msgs[msgs - 1], &batch.tx_iovs[run_first],
+                                  segments + 1, &client->server_addr,
+                                  &batch.tx_ctrls[msgs - 1], run_seg);
+        } else {
+            // 새 메시지 시작
+            run_first = i;
+            run_seg = pkt->len;
+            run_bytes = pkt->len;
+            run_open = 1;
+            udp_batch_prepare_gso(&batch.tx_msgs[msgs], &batch.tx_iovs[i], 1,
+                                  &client->server_addr, &batch.tx_ctrls[msgs], run_seg);
+            msgs++;
+        }
+    }
+    
+    int sent = udp_send_batch(tx->session->sock_fd, batch.tx_msgs, msgs);
+    
+    LOG_DEBUG("   → UDP: Sent %d/%d messages (%d packets)", sent, msgs, ready);
+    
+    return reads;
+}
+
+// 데이터 스레드 epoll 준비 (wake eventfd 는 level-triggered)
+// 반환값: epoll fd, -1 (실패)
+static int data_thread_loop(data_thread_t *thread) {
+    int epoll_fd = event_loop_create();
+    if (epoll_fd < 0 || event_loop_add(epoll_fd, thread->wake_fd, EPOLLIN, EV_WAKE) < 0) {
+        if (epoll_fd >= 0) close(epoll_fd);
+        return -1;
+    }
+    return epoll_fd;
+}
+
+// 새 세션이 발행됐으면 넘겨받을 세션 반환 (아니면 NULL)
+static const client_session_t* session_changed(vpn_client_t *client,
+                                               const client_session_t *current) {
+    const client_session_t *latest = __atomic_load_n(&client->session, __ATOMIC_ACQUIRE);
+    return latest != current ? latest : NULL;
+}
+
+// RX 스레드: UDP → 복호화 → TUN
+static void* rx_thread_main(void *arg) {
+    vpn_client_t *client = (vpn_client_t*)arg;
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+    rx_state_t rx;
+    int pending = 0;
+    
+    memset(&rx, 0, sizeof(rx));
+    
+    int epoll_fd = data_thread_loop(&client->rx);
+    if (epoll_fd < 0) {
+        LOG_ERROR("❌ RX thread: event loop setup failed");
+        client_running = 0;
+        return NULL;
+    }
+    
+    while (client_running) {
+        const client_session_t *latest = session_changed(client, rx.session);
+        if (latest) {
+            // 새 소켓 등록 (이전 소켓은 메인 스레드가 close 하면서 epoll에서 빠짐)
+            if (event_loop_add(epoll_fd, latest->sock_fd, EPOLLIN | EPOLLET, EV_UDP) < 0) {
+                client_running = 0;
+                break;
+            }
+            rx.session = latest;
+            replay_window_init(&rx.window);
+            pending = 1;    // 등록 전에 도착한 것도 처리
+            __atomic_store_n(&client->rx.generation, latest->generation, __ATOMIC_RELEASE);
+            LOG_DEBUG("🔁 RX thread switched to session %u", latest->generation);
+        }
+        
+        // 덜 비운 소켓이 있으면 기다리지 않고 세션 교체만 확인
+        int nfds = epoll_wait(epoll_fd, events, EVENT_LOOP_MAX_EVENTS,
+                              pending ? 0 : DATA_THREAD_WAIT_MS);
+        if (nfds < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait (RX)");
+            break;
+        }
+        
+        for (int i = 0; i < nfds; i++) {
+            if (events[i].data.u32 == EV_WAKE) {
+                drain_wake_fd(&client->rx);
+            } else {
+                pending = 1;
+            }
+        }
+        
+        // 예산을 다 쓰면 pending으로 남겨 다음 반복에서 이어서 처리
+        for (int round = 0; pending && round < CLIENT_DRAIN_BUDGET && client_running; round++) {
+            pending = (handle_udp_to_tun(client, &rx) == CLIENT_BATCH_SIZE);
+        }
+    }
+    
+    close(epoll_fd);
+    return NULL;
+}
+
+// TX 스레드: TUN → 암호화 → UDP
+static void* tx_thread_main(void *arg) {
+    vpn_client_t *client = (vpn_client_t*)arg;
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+    tx_state_t tx;
+    int pending = 1;    // 등록 전에 도착한 것도 처리
+    
+    memset(&tx, 0, sizeof(tx));
+    
+    int epoll_fd = data_thread_loop(&client->tx);
+    if (epoll_fd < 0 || event_loop_add(epoll_fd, client->tun_fd, EPOLLIN | EPOLLET, EV_TUN) < 0) {
+        LOG_ERROR("❌ TX thread: event loop setup failed");
+        if (epoll_fd >= 0) close(epoll_fd);
+        client_running = 0;
+        return NULL;
+    }
+    
+    while (client_running) {
+        const client_session_t *latest = session_changed(client, tx.session);
+        if (latest) {
+            tx.session = latest;
+            tx.counter = 0;
+            __atomic_store_n(&client->tx.generation, latest->generation, __ATOMIC_RELEASE);
+            LOG_DEBUG("🔁 TX thread switched to session %u", latest->generation);
+        }
+        
+        int nfds = epoll_wait(epoll_fd, events, EVENT_LOOP_MAX_EVENTS,
+                              pending ? 0 : DATA_THREAD_WAIT_MS);
+        if (nfds < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait (TX)");
+            break;
+        }
+        
+        for (int i = 0; i < nfds; i++) {
+            if (events[i].data.u32 == EV_WAKE) {
+                drain_wake_fd(&client->tx);
+            } else {
+                pending = 1;
+            }
+        }
+        
+        for (int round = 0; pending && round < CLIENT_DRAIN_BUDGET && client_running; round++) {
+            pending = (handle_tun_to_udp(client, &tx) == CLIENT_BATCH_SIZE);
+        }
+    }
+    
+    close(epoll_fd);
+    return NULL;
+}
+
+// 데이터 스레드 시작 (시그널은 메인 스레드만 받도록 막아둔 상태로 생성)
+// 반환값: 0 (성공), -1 (실패, 시작된 스레드는 stop_data_threads로 정리)
+static int start_data_threads(vpn_client_t *client) {
+    sigset_t block, old;
+    int ret = 0;
+    
+    client->rx.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    client->tx.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (client->rx.wake_fd < 0 || client->tx.wake_fd < 0) {
+        perror("eventfd");
+        return -1;
+    }
+    
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    
+    if (pthread_create(&client->rx.thread, NULL, rx_thread_main, client) != 0) {
+        LOG_ERROR("❌ Failed to start RX thread");
+        ret = -1;
+    } else {
+        client->rx.started = 1;
+        
+        if (pthread_create(&client->tx.thread, NULL, tx_thread_main, client) != 0) {
+            LOG_ERROR("❌ Failed to start TX thread");
+            ret = -1;
+        } else {
+            client->tx.started = 1;
+        }
+    }
+    
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    return ret;
+}
+
+// 데이터 스레드 종료
+static void stop_data_threads(vpn_client_t *client) {
+    data_thread_t *threads[2] = { &client->rx, &client->tx };
+    
+    client_running = 0;
+    
+    for (int i = 0; i < 2; i++) {
+        if (threads[i]->started) {
+            wake_data_thread(threads[i]);
+            pthread_join(threads[i]->thread, NULL);
+            threads[i]->started = 0;
+        }
     }
 }
 
@@ -500,11 +1036,24 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
-    LOG_INFO("✅ VPN Client is running!");
+    // 데이터 경로는 방향별 전용 스레드 (논블로킹 TUN, UDP 소켓은 전송 backpressure를 위해 블로킹 유지)
+    // 메인 스레드는 keepalive 타이머와 재연결만 담당
+    int timer_fd = timer_fd_create(KEEPALIVE_TICK_MS);
+    if (timer_fd < 0 || set_nonblocking(client->tun_fd) < 0 ||
+        start_data_threads(client) < 0) {
+        stop_data_threads(client);
+        if (timer_fd >= 0) close(timer_fd);
+        destroy_vpn_client(client);
+        config_destroy(config);
+        return 1;
+    }
+    
+    LOG_INFO("✅ VPN Client is running! (RX/TX threads)");
     LOG_INFO("⏳ Press Ctrl+C to disconnect...");
     
     while (client_running) {
         if (!client->connected) {
+            // 재연결하는 동안에도 데이터 스레드는 이전 세션으로 계속 동작
             if (config->auto_reconnect) {
                 if (attempt_reconnect(client) != 0) {
                     LOG_ERROR("💔 Reconnection failed, exiting...");
@@ -516,43 +1065,29 @@ int main(int argc, char *argv[]) {
             }
         }
         
-        int max_fd = (client->tun_fd > client->sock_fd) ? client->tun_fd : client->sock_fd;
-        
-        fd_set read_fds;
-        struct timeval timeout = {1, 0};
-        
-        FD_ZERO(&read_fds);
-        FD_SET(client->tun_fd, &read_fds);
-        FD_SET(client->sock_fd, &read_fds);
-        
-        int activity = select(max_fd + 1, &read_fds, NULL, NULL, &timeout);
-        
-        if (activity < 0) {
-            if (client_running) {
-                perror("select");
+        struct pollfd pfd = { .fd = timer_fd, .events = POLLIN };
+        int ret = poll(&pfd, 1, -1);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            perror("poll");
             break;
         }
         
-        if (check_keepalive(client) != 0) {
-            LOG_ERROR("💔 Connection lost");
-            client->connected = 0;
-            continue;
-        }
-        
-        if (activity == 0) {
-            continue;
-        }
-        
-        if (FD_ISSET(client->sock_fd, &read_fds)) {
-            handle_udp_to_tun(client);
-        }
-        
-        if (FD_ISSET(client->tun_fd, &read_fds)) {
-            handle_tun_to_udp(client);
+        // keepalive 는 타이머가 울릴 때만 확인 (패킷마다 time() 호출하지 않음)
+        if (timer_fd_ack(timer_fd) > 0) {
+            reap_retired_sessions(client);
+            if (check_keepalive(client) != 0) {
+                LOG_ERROR("💔 Connection lost");
+                client->connected = 0;
+            }
         }
     }
     
+    stop_data_threads(client);
+    close(timer_fd);
+    
     LOG_INFO("🧹 Cleaning up...");
     destroy_vpn_client(client);
     config_destroy(config);
@@ -21,6 +21,9 @@ vpn_config_t* config_create_default(void) {
     config->keepalive_interval = 30;
     config->pong_timeout = 60;
     config->log_level = 2;  // INFO
+    config->pcap_replay[0] = '\0';
+    config->pcap_record[0] = '\0';
+    config->pcap_max_rate = 0;
     
     return config;
 }
@@ -116,6 +119,12 @@ int config_load_from_file(vpn_config_t *config, const char *filename) {
             else if (strcmp(value, "INFO") == 0) config->log_level = 2;
             else if (strcmp(value, "DEBUG") == 0) config->log_level = 3;
             else config->log_level = atoi(value);
+        } else if (strcmp(key, "pcap_replay") == 0) {
+            strncpy(config->pcap_replay, value, sizeof(config->pcap_replay) - 1);
+        } else if (strcmp(key, "pcap_record") == 0) {
+            strncpy(config->pcap_record, value, sizeof(config->pcap_record) - 1);
+        } else if (strcmp(key, "pcap_rate") == 0) {
+            config->pcap_max_rate = (strcmp(value, "max") == 0);
         } else {
             fprintf(stderr, "Warning: Unknown key '%s' at line %d\n", key, line_num);
         }
@@ -141,5 +150,11 @@ void config_print(const vpn_config_t *config) {
         case 3: printf("DEBUG\n"); break;
         default: printf("%d\n", config->log_level);
     }
+    if (config->pcap_replay[0] || config->pcap_record[0]) {
+        printf("  Packet I/O:          pcap (replay %s at %s rate, record %s)\n",
+               config->pcap_replay[0] ? config->pcap_replay : "none",
+               config->pcap_max_rate ? "max" : "original",
+               config->pcap_record[0] ? config->pcap_record : "none");
+    }
     printf("═══════════════════════════════════════\n");
 }
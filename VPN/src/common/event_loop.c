@@ -0,0 +1,80 @@
+// src/common/event_loop.c
+
+#include "event_loop.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+// epoll 인스턴스 생성
+int event_loop_create(void) {
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        perror("❌ epoll_create1 failed");
+        return -1;
+    }
+    return epoll_fd;
+}
+
+// fd 등록
+int event_loop_add(int epoll_fd, int fd, uint32_t events, uint32_t tag) {
+    struct epoll_event ev;
+    
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.u32 = tag;
+    
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        perror("❌ epoll_ctl ADD failed");
+        return -1;
+    }
+    return 0;
+}
+
+// 논블로킹 모드 설정
+int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        perror("❌ fcntl O_NONBLOCK failed");
+        return -1;
+    }
+    return 0;
+}
+
+// 주기 타이머 생성
+int timer_fd_create(unsigned int interval_ms) {
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0) {
+        perror("❌ timerfd_create failed");
+        return -1;
+    }
+    
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = interval_ms / 1000;
+    spec.it_interval.tv_nsec = (long)(interval_ms % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;   // 첫 만료도 한 주기 뒤
+    
+    if (timerfd_settime(timer_fd, 0, &spec, NULL) < 0) {
+        perror("❌ timerfd_settime failed");
+        close(timer_fd);
+        return -1;
+    }
+    
+    return timer_fd;
+}
+
+// 타이머 만료 횟수 읽기
+uint64_t timer_fd_ack(int timer_fd) {
+    uint64_t expirations = 0;
+    
+    if (read(timer_fd, &expirations, sizeof(expirations)) < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            perror("❌ timerfd read failed");
+        }
+        return 0;
+    }
+    
+    return expirations;
+}
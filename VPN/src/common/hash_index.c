@@ -0,0 +1,155 @@
+// src/common/hash_index.c
+
+#include "hash_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HASH_INDEX_ALIGN 64
+
+// 64비트 정수 해시 (murmur3 finalizer)
+static inline uint32_t hash_key(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+// 인덱스 생성
+int hash_index_init(hash_index_t *index, uint32_t max_entries) {
+    uint32_t size = 16;
+    
+    // 부하율 50% 이하
+    while (size < max_entries * 2) {
+        size <<= 1;
+    }
+    
+    void *mem = NULL;
+    if (posix_memalign(&mem, HASH_INDEX_ALIGN, sizeof(hash_bucket_t) * size) != 0) {
+        perror("posix_memalign hash index");
+        return -1;
+    }
+    
+    index->buckets = (hash_bucket_t*)mem;
+    index->mask = size - 1;
+    index->count = 0;
+    
+    for (uint32_t i = 0; i < size; i++) {
+        index->buckets[i].key = 0;
+        index->buckets[i].value = HASH_INDEX_EMPTY;
+        index->buckets[i].reserved = 0;
+    }
+    
+    return 0;
+}
+
+// 인덱스 해제
+void hash_index_destroy(hash_index_t *index) {
+    free(index->buckets);
+    index->buckets = NULL;
+    index->mask = 0;
+    index->count = 0;
+}
+
+// 최대 엔트리 수 늘리기
+int hash_index_reserve(hash_index_t *index, uint32_t max_entries) {
+    if (max_entries * 2 <= index->mask + 1) {
+        return 0;
+    }
+    
+    hash_index_t grown;
+    if (hash_index_init(&grown, max_entries) != 0) {
+        return -1;
+    }
+    
+    for (uint32_t i = 0; i <= index->mask; i++) {
+        if (index->buckets[i].value != HASH_INDEX_EMPTY) {
+            hash_index_put(&grown, index->buckets[i].key, index->buckets[i].value);
+        }
+    }
+    
+    hash_index_destroy(index);
+    *index = grown;
+    return 0;
+}
+
+// 키 조회
+int32_t hash_index_get(const hash_index_t *index, uint64_t key) {
+    uint32_t pos = hash_key(key) & index->mask;
+    
+    for (;;) {
+        const hash_bucket_t *bucket = &index->buckets[pos];
+        
+        if (bucket->value == HASH_INDEX_EMPTY) {
+            return HASH_INDEX_EMPTY;
+        }
+        if (bucket->key == key) {
+            return bucket->value;
+        }
+        pos = (pos + 1) & index->mask;
+    }
+}
+
+// 키 추가
+int hash_index_put(hash_index_t *index, uint64_t key, int32_t value) {
+    uint32_t pos = hash_key(key) & index->mask;
+    
+    for (;;) {
+        hash_bucket_t *bucket = &index->buckets[pos];
+        
+        if (bucket->value == HASH_INDEX_EMPTY) {
+            // 빈 버킷이 항상 하나 이상 남도록 (조회 루프 종료 보장)
+            if (index->count + 1 > index->mask) {
+                return -1;
+            }
+            bucket->key = key;
+            bucket->value = value;
+            index->count++;
+            return 0;
+        }
+        if (bucket->key == key) {
+            bucket->value = value;
+            return 0;
+        }
+        pos = (pos + 1) & index->mask;
+    }
+}
+
+// 키 제거 (backward shift: 뒤따르는 버킷을 당겨 탐사 체인 유지)
+int hash_index_remove(hash_index_t *index, uint64_t key) {
+    uint32_t pos = hash_key(key) & index->mask;
+    
+    for (;;) {
+        hash_bucket_t *bucket = &index->buckets[pos];
+        
+        if (bucket->value == HASH_INDEX_EMPTY) {
+            return -1;
+        }
+        if (bucket->key == key) {
+            break;
+        }
+        pos = (pos + 1) & index->mask;
+    }
+    
+    uint32_t hole = pos;
+    uint32_t next = (hole + 1) & index->mask;
+    
+    while (index->buckets[next].value != HASH_INDEX_EMPTY) {
+        uint32_t home = hash_key(index->buckets[next].key) & index->mask;
+        
+        // next의 원래 위치(home)가 (hole, next] 구간 밖이면 hole로 옮길 수 있음
+        if (((next - home) & index->mask) >= ((next - hole) & index->mask)) {
+            index->buckets[hole] = index->buckets[next];
+            hole = next;
+        }
+        next = (next + 1) & index->mask;
+    }
+    
+    index->buckets[hole].key = 0;
+    index->buckets[hole].value = HASH_INDEX_EMPTY;
+    index->count--;
+    
+    return 0;
+}
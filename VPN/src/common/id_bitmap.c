@@ -0,0 +1,125 @@
+// src/common/id_bitmap.c
+
+#include "id_bitmap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ID_WORD_BITS 64
+
+static inline uint32_t words_for(uint32_t bits) {
+    return (bits + ID_WORD_BITS - 1) / ID_WORD_BITS;
+}
+
+// 비트 지우기 (워드가 0이 되면 위 단계 비트도)
+static void clear_bit(id_bitmap_t *bm, uint32_t pos) {
+    for (int l = 0; l < bm->levels; l++) {
+        uint64_t *word = &bm->words[l][pos / ID_WORD_BITS];
+        *word &= ~(1ULL << (pos % ID_WORD_BITS));
+        if (*word != 0) {
+            break;
+        }
+        pos /= ID_WORD_BITS;
+    }
+}
+
+// 비트 세우기 (워드가 0이었으면 위 단계 비트도)
+static void set_bit(id_bitmap_t *bm, uint32_t pos) {
+    for (int l = 0; l < bm->levels; l++) {
+        uint64_t *word = &bm->words[l][pos / ID_WORD_BITS];
+        uint64_t was = *word;
+        *word |= 1ULL << (pos % ID_WORD_BITS);
+        if (was != 0) {
+            break;
+        }
+        pos /= ID_WORD_BITS;
+    }
+}
+
+// 비트맵 생성
+int id_bitmap_init(id_bitmap_t *bm, uint32_t size) {
+    memset(bm, 0, sizeof(*bm));
+    
+    if (size == 0 || size > ID_BITMAP_MAX_SIZE) {
+        fprintf(stderr, "❌ Invalid bitmap size: %u\n", size);
+        return -1;
+    }
+    
+    // 단계마다 아래 단계 워드 수만큼의 비트 (워드 1개가 될 때까지)
+    uint32_t bits = size;
+    for (;;) {
+        uint32_t count = words_for(bits);
+        
+        bm->words[bm->levels] = (uint64_t*)calloc(count, sizeof(uint64_t));
+        if (!bm->words[bm->levels]) {
+            perror("calloc bitmap");
+            id_bitmap_destroy(bm);
+            return -1;
+        }
+        
+        // 전부 비어 있음 (범위 밖 비트는 0으로 남겨서 할당되지 않게)
+        for (uint32_t i = 0; i < bits; i++) {
+            bm->words[bm->levels][i / ID_WORD_BITS] |= 1ULL << (i % ID_WORD_BITS);
+        }
+        
+        bm->levels++;
+        if (count == 1) {
+            break;
+        }
+        bits = count;
+    }
+    
+    bm->size = size;
+    return 0;
+}
+
+// 비트맵 해제
+void id_bitmap_destroy(id_bitmap_t *bm) {
+    for (int l = 0; l < ID_BITMAP_MAX_LEVELS; l++) {
+        free(bm->words[l]);
+        bm->words[l] = NULL;
+    }
+    bm->levels = 0;
+    bm->size = 0;
+    bm->used = 0;
+}
+
+// 가장 작은 빈 번호 할당
+int32_t id_bitmap_alloc(id_bitmap_t *bm) {
+    if (bm->levels == 0 || bm->words[bm->levels - 1][0] == 0) {
+        return -1;
+    }
+    
+    // 맨 위 워드부터 내려가며 첫 번째 1비트 따라가기
+    uint32_t pos = 0;
+    for (int l = bm->levels - 1; l >= 0; l--) {
+        pos = pos * ID_WORD_BITS + (uint32_t)__builtin_ctzll(bm->words[l][pos]);
+    }
+    
+    clear_bit(bm, pos);
+    bm->used++;
+    return (int32_t)pos;
+}
+
+// 특정 번호 할당
+int id_bitmap_take(id_bitmap_t *bm, uint32_t id) {
+    if (id >= bm->size ||
+        !(bm->words[0][id / ID_WORD_BITS] & (1ULL << (id % ID_WORD_BITS)))) {
+        return -1;
+    }
+    
+    clear_bit(bm, id);
+    bm->used++;
+    return 0;
+}
+
+// 번호 반납
+void id_bitmap_release(id_bitmap_t *bm, uint32_t id) {
+    if (id >= bm->size ||
+        (bm->words[0][id / ID_WORD_BITS] & (1ULL << (id % ID_WORD_BITS)))) {
+        return;
+    }
+    
+    set_bit(bm, id);
+    bm->used--;
+}
@@ -3,7 +3,11 @@
 #include "ipc_protocol.h"
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 static uint32_t global_request_id = 0;
 
@@ -16,6 +20,10 @@ const char* ipc_command_str(uint8_t command) {
         case IPC_ADD_KEY:     return "ADD_KEY";
         case IPC_REMOVE_KEY:  return "REMOVE_KEY";
         case IPC_HANDSHAKE:   return "HANDSHAKE";
+        case IPC_RING_SETUP:  return "RING_SETUP";
+        case IPC_ENCRYPT_BATCH: return "ENCRYPT_BATCH";
+        case IPC_DECRYPT_BATCH: return "DECRYPT_BATCH";
+        case IPC_REMOVE_KEYS: return "REMOVE_KEYS";
         case IPC_SHUTDOWN:    return "SHUTDOWN";
         default:              return "UNKNOWN";
     }
@@ -25,7 +33,12 @@ const char* ipc_command_str(uint8_t command) {
 void init_ipc_request(ipc_request_t *req, uint8_t command,
                       uint32_t vpn_ip, const uint8_t *data, uint16_t data_len) {
     req->command = command;
-    req->request_id = htonl(++global_request_id);
+    // 0은 "ID 없음"(비동기 토큰 실패)으로 쓰므로 건너뜀
+    uint32_t id;
+    do {
+        id = __atomic_add_fetch(&global_request_id, 1, __ATOMIC_RELAXED);
+    } while (id == 0);
+    req->request_id = htonl(id);
     req->vpn_ip = vpn_ip;
     req->data_len = htons(data_len);
     
@@ -45,3 +58,109 @@ void init_ipc_response(ipc_response_t *resp, uint32_t request_id,
         memcpy(resp->data, data, data_len);
     }
 }
+
+// 헤더 + 데이터를 메시지 1개로 전송 (fd 첨부 가능)
+ssize_t ipc_send_msg(int sock_fd, const void *hdr, size_t hdr_len,
+                     const void *data, size_t data_len,
+                     const int *fds, int fd_count) {
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int) * IPC_RING_FD_COUNT)];
+    } control;
+    struct iovec iov[2] = {
+        { .iov_base = (void*)hdr, .iov_len = hdr_len },
+        { .iov_base = (void*)data, .iov_len = data_len },
+    };
+    struct msghdr msg;
+    
+    if (fd_count < 0 || fd_count > IPC_RING_FD_COUNT) {
+        return -1;
+    }
+    
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = (data && data_len > 0) ? 2 : 1;
+    
+    if (fd_count > 0) {
+        memset(&control, 0, sizeof(control));
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fd_count);
+        
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fd_count);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fd_count);
+    }
+    
+    // 상대가 죽은 경우 SIGPIPE 대신 EPIPE로 받기
+    return sendmsg(sock_fd, &msg, MSG_NOSIGNAL);
+}
+
+// fd 첨부 전송
+ssize_t ipc_send_fds(int sock_fd, const void *buf, size_t len,
+                     const int *fds, int fd_count) {
+    return ipc_send_msg(sock_fd, buf, len, NULL, 0, fds, fd_count);
+}
+
+// 메시지 1개 수신 + fd 회수
+ssize_t ipc_recv_fds(int sock_fd, void *buf, size_t len,
+                     int *fds, int *fd_count) {
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int) * IPC_RING_FD_COUNT)];
+    } control;
+    struct iovec iov = { .iov_base = buf, .iov_len = len };
+    struct msghdr msg;
+    int received_count = 0;
+    
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    
+    if (fd_count) {
+        *fd_count = 0;
+    }
+    
+    ssize_t n = recvmsg(sock_fd, &msg, MSG_CMSG_CLOEXEC);
+    if (n < 0) {
+        return -1;
+    }
+    
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            int *received = (int*)CMSG_DATA(cmsg);
+            
+            // 받을 자리가 없거나 예상보다 많이 오면 초과분은 닫음
+            for (int i = 0; i < count; i++) {
+                if (fds && fd_count && received_count < IPC_RING_FD_COUNT) {
+                    fds[received_count++] = received[i];
+                } else {
+                    close(received[i]);
+                }
+            }
+        }
+    }
+    
+    if (fd_count) {
+        *fd_count = received_count;
+    }
+    
+    // 버퍼보다 큰 메시지는 나머지가 버려지므로 실패 처리
+    if (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) {
+        for (int i = 0; i < received_count; i++) {
+            close(fds[i]);
+        }
+        if (fd_count) {
+            *fd_count = 0;
+        }
+        errno = EMSGSIZE;
+        return -1;
+    }
+    
+    return n;
+}
@@ -0,0 +1,467 @@
+// src/common/packet_io.c
+
+#include "packet_io.h"
+#include "tun_manager.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <signal.h>
+#include <byteswap.h>
+#include <sys/socket.h>
+
+// pcap 파일 형식 (libpcap 클래식 포맷, pcapng 아님)
+#define PCAP_MAGIC_USEC     0xa1b2c3d4
+#define PCAP_MAGIC_NSEC     0xa1b23c4d
+#define PCAP_VERSION_MAJOR  2
+#define PCAP_VERSION_MINOR  4
+
+// 지원하는 링크 타입
+#define LINKTYPE_NULL       0      // BSD loopback (4바이트 주소 패밀리)
+#define LINKTYPE_ETHERNET   1
+#define LINKTYPE_RAW        101    // IP 패킷 그대로 (record가 쓰는 형식)
+#define LINKTYPE_LOOP       108
+#define LINKTYPE_LINUX_SLL  113    // tcpdump -i any
+#define LINKTYPE_IPV4       228
+#define LINKTYPE_IPV6       229
+#define LINKTYPE_LINUX_SLL2 276
+
+#define ETHERTYPE_IPV4      0x0800
+#define ETHERTYPE_IPV6      0x86DD
+#define ETHERTYPE_VLAN      0x8100
+#define ETHERTYPE_QINQ      0x88A8
+
+#define REPLAY_BUF_SIZE     262144 // 레코드 최대 크기 (libpcap MAXIMUM_SNAPLEN)
+#define REPLAY_POLL_MIN_NS  2000000LL
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t  thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+} pcap_file_header_t;
+
+typedef struct {
+    uint32_t ts_sec;
+    uint32_t ts_frac;          // 마이크로초 또는 나노초
+    uint32_t incl_len;
+    uint32_t orig_len;
+} pcap_record_header_t;
+
+const char* packet_io_name(packet_io_type_t type) {
+    return type == PACKET_IO_PCAP ? "pcap" : "tun";
+}
+
+static int64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static uint32_t pcap_u32(const packet_io_t *io, uint32_t v) {
+    return io->replay_swapped ? bswap_32(v) : v;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// replay (pcap → 데이터 경로)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 파일 헤더 검사
+// 반환값: 0 (성공), -1 (지원하지 않는 파일)
+static int replay_open(packet_io_t *io, const char *path) {
+    pcap_file_header_t hdr;
+    
+    io->replay_file = fopen(path, "rb");
+    if (!io->replay_file) {
+        perror("❌ pcap replay: fopen");
+        return -1;
+    }
+    
+    if (fread(&hdr, sizeof(hdr), 1, io->replay_file) != 1) {
+        fprintf(stderr, "❌ pcap replay: %s is too short\n", path);
+        return -1;
+    }
+    
+    if (hdr.magic == PCAP_MAGIC_USEC || hdr.magic == PCAP_MAGIC_NSEC) {
+        io->replay_swapped = 0;
+    } else if (bswap_32(hdr.magic) == PCAP_MAGIC_USEC || bswap_32(hdr.magic) == PCAP_MAGIC_NSEC) {
+        io->replay_swapped = 1;
+    } else {
+        fprintf(stderr, "❌ pcap replay: %s is not a pcap file (pcapng: convert with 'editcap -F pcap')\n",
+                path);
+        return -1;
+    }
+    io->replay_nsec = (pcap_u32(io, hdr.magic) == PCAP_MAGIC_NSEC);
+    io->replay_linktype = pcap_u32(io, hdr.linktype);
+    
+    switch (io->replay_linktype) {
+        case LINKTYPE_NULL:
+        case LINKTYPE_ETHERNET:
+        case LINKTYPE_RAW:
+        case LINKTYPE_LOOP:
+        case LINKTYPE_LINUX_SLL:
+        case LINKTYPE_IPV4:
+        case LINKTYPE_IPV6:
+        case LINKTYPE_LINUX_SLL2:
+            break;
+        default:
+            fprintf(stderr, "❌ pcap replay: unsupported link type %u\n", io->replay_linktype);
+            return -1;
+    }
+    
+    return 0;
+}
+
+// 링크 계층 헤더를 벗겨 IP 패킷 위치 찾기
+// 반환값: IP 패킷 길이 (0 = IP 아님)
+static size_t replay_strip_link(const packet_io_t *io, const uint8_t *frame, size_t len,
+                                const uint8_t **ip) {
+    size_t off = 0;
+    uint16_t ethertype;
+    
+    switch (io->replay_linktype) {
+        case LINKTYPE_NULL:
+        case LINKTYPE_LOOP:
+            off = 4;
+            break;
+        case LINKTYPE_ETHERNET:
+            off = 12;
+            do {
+                if (off + 2 > len) {
+                    return 0;
+                }
+                ethertype = (uint16_t)(frame[off] << 8 | frame[off + 1]);
+                off += (ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_QINQ) ? 4 : 2;
+            } while (ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_QINQ);
+            if (ethertype != ETHERTYPE_IPV4 && ethertype != ETHERTYPE_IPV6) {
+                return 0;
+            }
+            break;
+        case LINKTYPE_LINUX_SLL:
+            if (len < 16) {
+                return 0;
+            }
+            ethertype = (uint16_t)(frame[14] << 8 | frame[15]);
+            if (ethertype != ETHERTYPE_IPV4 && ethertype != ETHERTYPE_IPV6) {
+                return 0;
+            }
+            off = 16;
+            break;
+        case LINKTYPE_LINUX_SLL2:
+            if (len < 20) {
+                return 0;
+            }
+            ethertype = (uint16_t)(frame[0] << 8 | frame[1]);
+            if (ethertype != ETHERTYPE_IPV4 && ethertype != ETHERTYPE_IPV6) {
+                return 0;
+            }
+            off = 20;
+            break;
+        default:
+            break;
+    }
+    
+    if (off + 20 > len) {
+        return 0;
+    }
+    
+    const uint8_t *pkt = frame + off;
+    size_t ip_len;
+    
+    // 버전 확인 + 이더넷 최소 프레임 패딩 제거
+    if ((pkt[0] >> 4) == 4) {
+        ip_len = (size_t)(pkt[2] << 8 | pkt[3]);
+    } else if ((pkt[0] >> 4) == 6 && off + 40 <= len) {
+        ip_len = 40 + (size_t)(pkt[4] << 8 | pkt[5]);
+    } else {
+        return 0;
+    }
+    
+    if (ip_len < 20 || ip_len > len - off) {
+        return 0;   // 잘린 패킷
+    }
+    
+    *ip = pkt;
+    return ip_len;
+}
+
+// deadline(CLOCK_MONOTONIC ns)까지 대기
+// 긴 대기는 peer_fd poll로 (packet_io_close의 shutdown으로 바로 깨어남)
+// 반환값: 0 (시간 도달), -1 (종료 요청)
+static int replay_wait_until(packet_io_t *io, int64_t deadline) {
+    for (;;) {
+        int64_t remaining = deadline - mono_ns();
+        if (remaining <= 0) {
+            return 0;
+        }
+    
+        if (remaining >= REPLAY_POLL_MIN_NS) {
+            struct pollfd pfd = { .fd = io->peer_fd, .events = 0 };
+            if (poll(&pfd, 1, (int)((remaining - REPLAY_POLL_MIN_NS / 2) / 1000000)) > 0 &&
+                (pfd.revents & (POLLHUP | POLLERR))) {
+                return -1;
+            }
+            continue;
+        }
+    
+        struct timespec ts = {
+            .tv_sec = deadline / 1000000000LL,
+            .tv_nsec = deadline % 1000000000LL,
+        };
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+}
+
+static void* replay_thread_main(void *arg) {
+    packet_io_t *io = (packet_io_t*)arg;
+    pcap_record_header_t rec;
+    int64_t first_ts = -1;
+    int64_t start = mono_ns();
+    
+    uint8_t *frame = (uint8_t*)malloc(REPLAY_BUF_SIZE);
+    if (!frame) {
+        perror("❌ pcap replay: malloc");
+        return NULL;
+    }
+    
+    while (fread(&rec, sizeof(rec), 1, io->replay_file) == 1) {
+        uint32_t incl_len = pcap_u32(io, rec.incl_len);
+        uint32_t orig_len = pcap_u32(io, rec.orig_len);
+    
+        if (incl_len > REPLAY_BUF_SIZE) {
+            fprintf(stderr, "❌ pcap replay: corrupt record (%u bytes)\n", incl_len);
+            break;
+        }
+        if (fread(frame, 1, incl_len, io->replay_file) != incl_len) {
+            break;   // 마지막 레코드가 잘림
+        }
+    
+        const uint8_t *pkt = NULL;
+        size_t len = (incl_len == orig_len) ? replay_strip_link(io, frame, incl_len, &pkt) : 0;
+        if (len == 0 || len > PACKET_IO_MTU) {
+            io->skipped++;
+            continue;
+        }
+    
+        // 원래 속도: 첫 패킷 기준 상대 시각에 맞춰 보냄
+        if (!io->replay_max_rate) {
+            int64_t ts = (int64_t)pcap_u32(io, rec.ts_sec) * 1000000000LL +
+                         (int64_t)pcap_u32(io, rec.ts_frac) * (io->replay_nsec ? 1 : 1000);
+            if (first_ts < 0) {
+                first_ts = ts;
+            }
+            if (ts > first_ts && replay_wait_until(io, start + (ts - first_ts)) < 0) {
+                break;
+            }
+        }
+    
+        // 블로킹 send: 데이터 경로가 못 따라오면 여기서 기다림 (버리지 않음)
+        if (send(io->peer_fd, pkt, len, MSG_NOSIGNAL) < 0) {
+            if (errno != EPIPE && errno != ECONNRESET) {
+                perror("❌ pcap replay: send");
+            }
+            break;
+        }
+        io->replayed++;
+    }
+    
+    double elapsed = (double)(mono_ns() - start) / 1e9;
+    printf("📼 pcap replay finished: %llu packets in %.3f s (%llu skipped)\n",
+           (unsigned long long)io->replayed, elapsed, (unsigned long long)io->skipped);
+    
+    free(frame);
+    return NULL;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// record (데이터 경로 → pcap)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+static int record_open(packet_io_t *io, const char *path) {
+    pcap_file_header_t hdr = {
+        .magic = PCAP_MAGIC_NSEC,
+        .version_major = PCAP_VERSION_MAJOR,
+        .version_minor = PCAP_VERSION_MINOR,
+        .snaplen = PACKET_IO_SNAPLEN,
+        .linktype = LINKTYPE_RAW,
+    };
+    
+    io->record_file = fopen(path, "wb");
+    if (!io->record_file) {
+        perror("❌ pcap record: fopen");
+        return -1;
+    }
+    
+    if (fwrite(&hdr, sizeof(hdr), 1, io->record_file) != 1) {
+        perror("❌ pcap record: fwrite");
+        return -1;
+    }
+    
+    return 0;
+}
+
+// 데이터 경로가 쓴 패킷을 EOF(소켓 shutdown)까지 읽기
+// 파일이 없어도 계속 읽어서 데이터 경로 write가 막히지 않게 함
+static void* record_thread_main(void *arg) {
+    packet_io_t *io = (packet_io_t*)arg;
+    int write_failed = 0;
+    
+    uint8_t *buf = (uint8_t*)malloc(PACKET_IO_SNAPLEN);
+    if (!buf) {
+        perror("❌ pcap record: malloc");
+        return NULL;
+    }
+    
+    for (;;) {
+        ssize_t n = recv(io->peer_fd, buf, PACKET_IO_SNAPLEN, MSG_TRUNC);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        io->recorded++;
+    
+        if (!io->record_file || write_failed) {
+            continue;
+        }
+    
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+    
+        uint32_t incl_len = (n > PACKET_IO_SNAPLEN) ? PACKET_IO_SNAPLEN : (uint32_t)n;
+        pcap_record_header_t rec = {
+            .ts_sec = (uint32_t)now.tv_sec,
+            .ts_frac = (uint32_t)now.tv_nsec,
+            .incl_len = incl_len,
+            .orig_len = (uint32_t)n,
+        };
+    
+        if (fwrite(&rec, sizeof(rec), 1, io->record_file) != 1 ||
+            fwrite(buf, 1, incl_len, io->record_file) != incl_len) {
+            perror("❌ pcap record: fwrite (recording stopped)");
+            write_failed = 1;
+        }
+    }
+    
+    free(buf);
+    return NULL;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 열기 / 닫기
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 소켓쌍 + 파일 + 스레드
+static int pcap_open(packet_io_t *io, const packet_io_config_t *config, int *fd) {
+    int sv[2];
+    int buf_size = PACKET_IO_SOCK_BUF;
+    
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        perror("❌ pcap backend: socketpair");
+        return -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        setsockopt(sv[i], SOL_SOCKET, SO_SNDBUF, &buf_size, sizeof(buf_size));
+        setsockopt(sv[i], SOL_SOCKET, SO_RCVBUF, &buf_size, sizeof(buf_size));
+    }
+    *fd = sv[0];
+    io->peer_fd = sv[1];
+    io->replay_max_rate = config->replay_max_rate;
+    
+    if ((config->replay_path && replay_open(io, config->replay_path) < 0) ||
+        (config->record_path && record_open(io, config->record_path) < 0)) {
+        close(*fd);
+        return -1;
+    }
+    
+    // 시그널은 메인 스레드만 받도록 막아둔 상태로 생성
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    sigaddset(&block, SIGUSR1);
+    sigaddset(&block, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    
+    if (pthread_create(&io->record_thread, NULL, record_thread_main, io) == 0) {
+        io->record_started = 1;
+    }
+    if (io->record_started && io->replay_file &&
+        pthread_create(&io->replay_thread, NULL, replay_thread_main, io) == 0) {
+        io->replay_started = 1;
+    }
+    
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    
+    if (!io->record_started || (io->replay_file && !io->replay_started)) {
+        fprintf(stderr, "❌ pcap backend: failed to start backend threads\n");
+        close(*fd);
+        return -1;
+    }
+    
+    printf("📼 pcap backend (fd=%d)\n", *fd);
+    printf("   Replay: %s%s\n", config->replay_path ? config->replay_path : "(none)",
+           config->replay_path ? (config->replay_max_rate ? " at max rate" : " at original rate") : "");
+    printf("   Record: %s\n", config->record_path ? config->record_path : "(discard)");
+    
+    return 0;
+}
+
+int packet_io_open(packet_io_t *io, const packet_io_config_t *config, int *fds, int count) {
+    memset(io, 0, sizeof(*io));
+    io->type = config->type;
+    
+    if (config->type == PACKET_IO_TUN) {
+        if (count == 1) {
+            fds[0] = create_tun_interface_flags(config->dev_name, config->tun_flags);
+            return fds[0] < 0 ? -1 : 0;
+        }
+        return create_tun_queues(config->dev_name, fds, count, config->tun_flags);
+    }
+    
+    if (count != 1) {
+        fprintf(stderr, "❌ pcap backend supports a single queue only\n");
+        return -1;
+    }
+    
+    if (pcap_open(io, config, &fds[0]) < 0) {
+        packet_io_close(io);
+        return -1;
+    }
+    
+    return 0;
+}
+
+void packet_io_close(packet_io_t *io) {
+    if (io->type != PACKET_IO_PCAP) {
+        return;
+    }
+    
+    // 대기 중인 send/recv/poll 깨우기
+    shutdown(io->peer_fd, SHUT_RDWR);
+    
+    if (io->replay_started) {
+        pthread_join(io->replay_thread, NULL);
+    }
+    if (io->record_started) {
+        pthread_join(io->record_thread, NULL);
+        printf("📼 pcap record: %llu packets%s\n", (unsigned long long)io->recorded,
+               io->record_file ? "" : " (discarded)");
+    }
+    
+    if (io->replay_file) {
+        fclose(io->replay_file);
+    }
+    if (io->record_file) {
+        fclose(io->record_file);
+    }
+    close(io->peer_fd);
+    
+    memset(io, 0, sizeof(*io));
+}
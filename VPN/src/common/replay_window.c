@@ -0,0 +1,51 @@
+// src/common/replay_window.c
+
+#include "replay_window.h"
+#include <string.h>
+
+// 창 초기화
+void replay_window_init(replay_window_t *win) {
+    memset(win, 0, sizeof(*win));
+}
+
+// 받아도 되는 카운터인지 확인
+int replay_window_check(const replay_window_t *win, uint64_t counter) {
+    // 카운터 고갈 (재핸드셰이크 필요)
+    if (counter == UINT64_MAX) {
+        return -1;
+    }
+    
+    if (counter > win->last) {
+        return 0;
+    }
+    
+    if (win->last - counter >= REPLAY_WINDOW_SIZE) {
+        return -1;   // 너무 오래됨
+    }
+    
+    uint64_t word = win->bitmap[(counter >> 6) & (REPLAY_WINDOW_WORDS - 1)];
+    return (word >> (counter & 63)) & 1 ? -1 : 0;
+}
+
+// 카운터를 받은 것으로 기록
+int replay_window_update(replay_window_t *win, uint64_t counter) {
+    if (replay_window_check(win, counter) != 0) {
+        return -1;
+    }
+    
+    // 앞으로 이동: last 다음 워드부터 새 카운터 워드까지 비움 (최대 한 바퀴)
+    if (counter > win->last) {
+        uint64_t current = win->last >> 6;
+        uint64_t diff = (counter >> 6) - current;
+        if (diff > REPLAY_WINDOW_WORDS) {
+            diff = REPLAY_WINDOW_WORDS;
+        }
+        for (uint64_t i = 1; i <= diff; i++) {
+            win->bitmap[(current + i) & (REPLAY_WINDOW_WORDS - 1)] = 0;
+        }
+        win->last = counter;
+    }
+    
+    win->bitmap[(counter >> 6) & (REPLAY_WINDOW_WORDS - 1)] |= 1ULL << (counter & 63);
+    return 0;
+}
@@ -0,0 +1,254 @@
+// src/common/shm_ring.c
+
+#define _GNU_SOURCE
+#include "shm_ring.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+
+// CPU에게 spin 중임을 알림
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// eventfd 깨우기
+static void event_kick(int event_fd) {
+    uint64_t one = 1;
+    if (write(event_fd, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN) {
+        perror("eventfd write");
+    }
+}
+
+static int map_shared(shm_ring_t *ring) {
+    void *addr = mmap(NULL, sizeof(shm_ring_shared_t), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, ring->mem_fd, 0);
+    if (addr == MAP_FAILED) {
+        perror("mmap ring");
+        return -1;
+    }
+    ring->shared = (shm_ring_shared_t*)addr;
+    return 0;
+}
+
+// 링 생성 (서버 측)
+int shm_ring_create(shm_ring_t *ring) {
+    memset(ring, 0, sizeof(*ring));
+    ring->sq_event_fd = -1;
+    ring->cq_event_fd = -1;
+
+    ring->mem_fd = memfd_create("vpn-enclave-ring", MFD_CLOEXEC);
+    if (ring->mem_fd < 0) {
+        perror("memfd_create");
+        return -1;
+    }
+
+    if (ftruncate(ring->mem_fd, sizeof(shm_ring_shared_t)) < 0) {
+        perror("ftruncate ring");
+        shm_ring_destroy(ring);
+        return -1;
+    }
+
+    ring->sq_event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    ring->cq_event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (ring->sq_event_fd < 0 || ring->cq_event_fd < 0) {
+        perror("eventfd");
+        shm_ring_destroy(ring);
+        return -1;
+    }
+
+    if (map_shared(ring) != 0) {
+        shm_ring_destroy(ring);
+        return -1;
+    }
+
+    // memfd는 0으로 초기화되어 있으므로 인덱스/플래그도 모두 0
+    return 0;
+}
+
+// 링 매핑 (Enclave 측)
+int shm_ring_map(shm_ring_t *ring, int mem_fd, int sq_event_fd, int cq_event_fd) {
+    memset(ring, 0, sizeof(*ring));
+    ring->mem_fd = mem_fd;
+    ring->sq_event_fd = sq_event_fd;
+    ring->cq_event_fd = cq_event_fd;
+
+    // 크기 확인 (서로 다른 빌드의 레이아웃 불일치 방지)
+    off_t size = lseek(mem_fd, 0, SEEK_END);
+    if (size != (off_t)sizeof(shm_ring_shared_t)) {
+        fprintf(stderr, "❌ Ring size mismatch: %ld != %zu\n",
+                (long)size, sizeof(shm_ring_shared_t));
+        shm_ring_destroy(ring);
+        return -1;
+    }
+
+    if (map_shared(ring) != 0) {
+        shm_ring_destroy(ring);
+        return -1;
+    }
+
+    return 0;
+}
+
+// 링 해제
+void shm_ring_destroy(shm_ring_t *ring) {
+    if (ring->shared) {
+        munmap(ring->shared, sizeof(shm_ring_shared_t));
+        ring->shared = NULL;
+    }
+    if (ring->mem_fd >= 0) close(ring->mem_fd);
+    if (ring->sq_event_fd >= 0) close(ring->sq_event_fd);
+    if (ring->cq_event_fd >= 0) close(ring->cq_event_fd);
+    ring->mem_fd = ring->sq_event_fd = ring->cq_event_fd = -1;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 서버 측 (생산자)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+uint32_t shm_ring_free_slots(const shm_ring_t *ring) {
+    uint32_t tail = ring->shared->sq_tail;   // 서버만 기록
+    uint32_t head = ring->shared->cq_head;   // 서버만 기록
+    return SHM_RING_ENTRIES - (tail - head);
+}
+
+uint32_t shm_ring_in_flight(const shm_ring_t *ring) {
+    return ring->shared->sq_tail - ring->shared->cq_head;
+}
+
+uint32_t shm_ring_tail(const shm_ring_t *ring) {
+    return ring->shared->sq_tail;
+}
+
+shm_ring_slot_t* shm_ring_next_slot(shm_ring_t *ring, uint32_t index) {
+    uint32_t pos = ring->shared->sq_tail + index;
+    return &ring->shared->slots[pos & SHM_RING_MASK];
+}
+
+void shm_ring_submit(shm_ring_t *ring, uint32_t count) {
+    shm_ring_shared_t *sh = ring->shared;
+
+    // 슬롯 내용이 먼저 보이도록 release
+    __atomic_store_n(&sh->sq_tail, sh->sq_tail + count, __ATOMIC_RELEASE);
+
+    // sq_tail 기록과 idle 플래그 읽기 사이의 순서 보장 (lost wakeup 방지)
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&sh->enclave_idle, __ATOMIC_RELAXED)) {
+        event_kick(ring->sq_event_fd);
+    }
+}
+
+int shm_ring_wait(shm_ring_t *ring, uint32_t target) {
+    shm_ring_shared_t *sh = ring->shared;
+
+    for (;;) {
+        // 1. 잠깐 spin (Enclave가 바쁘게 처리 중이면 곧 끝남)
+        for (int i = 0; i < SHM_RING_SPIN; i++) {
+            uint32_t done = __atomic_load_n(&sh->cq_tail, __ATOMIC_ACQUIRE);
+            if ((int32_t)(done - target) >= 0) {
+                return 0;
+            }
+            cpu_relax();
+        }
+
+        // 2. 대기 플래그 설정 후 재확인
+        __atomic_store_n(&sh->server_waiting, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        uint32_t done = __atomic_load_n(&sh->cq_tail, __ATOMIC_ACQUIRE);
+        if ((int32_t)(done - target) >= 0) {
+            __atomic_store_n(&sh->server_waiting, 0, __ATOMIC_RELAXED);
+            return 0;
+        }
+
+        // 3. eventfd에서 대기 (Enclave가 죽었을 때 영원히 막히지 않도록 timeout)
+        struct pollfd pfd = { .fd = ring->cq_event_fd, .events = POLLIN };
+        int ret = poll(&pfd, 1, SHM_RING_WAIT_MS);
+        __atomic_store_n(&sh->server_waiting, 0, __ATOMIC_RELAXED);
+
+        if (ret < 0 && errno != EINTR) {
+            perror("poll ring");
+            return -1;
+        }
+        if (ret == 0) {
+            fprintf(stderr, "❌ Enclave ring timeout\n");
+            return -1;
+        }
+        if (ret > 0) {
+            uint64_t value;
+            if (read(ring->cq_event_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                perror("eventfd read");
+                return -1;
+            }
+        }
+    }
+}
+
+void shm_ring_release(shm_ring_t *ring, uint32_t count) {
+    shm_ring_shared_t *sh = ring->shared;
+    __atomic_store_n(&sh->cq_head, sh->cq_head + count, __ATOMIC_RELEASE);
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// Enclave 측 (소비자)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+uint32_t shm_ring_pending(const shm_ring_t *ring) {
+    uint32_t tail = __atomic_load_n(&ring->shared->sq_tail, __ATOMIC_ACQUIRE);
+    return tail - ring->shared->cq_tail;     // cq_tail은 Enclave만 기록
+}
+
+shm_ring_slot_t* shm_ring_pending_slot(shm_ring_t *ring, uint32_t index) {
+    uint32_t pos = ring->shared->cq_tail + index;
+    return &ring->shared->slots[pos & SHM_RING_MASK];
+}
+
+void shm_ring_complete(shm_ring_t *ring, uint32_t count) {
+    shm_ring_shared_t *sh = ring->shared;
+
+    __atomic_store_n(&sh->cq_tail, sh->cq_tail + count, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&sh->server_waiting, __ATOMIC_RELAXED)) {
+        event_kick(ring->cq_event_fd);
+    }
+}
+
+int shm_ring_prepare_sleep(shm_ring_t *ring) {
+    shm_ring_shared_t *sh = ring->shared;
+
+    // 바로 잠들지 않고 잠깐 spin
+    for (int i = 0; i < SHM_RING_SPIN; i++) {
+        if (shm_ring_pending(ring) > 0) {
+            return 0;
+        }
+        cpu_relax();
+    }
+
+    __atomic_store_n(&sh->enclave_idle, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (shm_ring_pending(ring) > 0) {
+        __atomic_store_n(&sh->enclave_idle, 0, __ATOMIC_RELAXED);
+        return 0;
+    }
+
+    return 1;
+}
+
+void shm_ring_wakeup_ack(shm_ring_t *ring) {
+    uint64_t value;
+    // 논블로킹 eventfd: 값이 없으면 EAGAIN
+    if (read(ring->sq_event_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        perror("eventfd read");
+    }
+    __atomic_store_n(&ring->shared->enclave_idle, 0, __ATOMIC_RELAXED);
+}
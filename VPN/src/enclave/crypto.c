@@ -3,8 +3,14 @@
 #include "crypto.h"
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <sodium.h>
 
+#define SUITE_BENCH_PACKET 1400       // 벤치마크 패킷 크기 (MTU 근처)
+#define SUITE_BENCH_ROUNDS 2000       // 스위트당 반복 횟수
+
+static uint8_t preferred_suite = CRYPTO_SUITE_CHACHA20_POLY1305;
+
 // libsodium 초기화
 int crypto_init(void) {
     if (sodium_init() < 0) {
@@ -63,6 +69,192 @@ int crypto_decrypt(const uint8_t *ciphertext, size_t ciphertext_len,
     return 0;
 }
 
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 스위트 선택
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+uint8_t crypto_supported_suites(void) {
+    uint8_t suites = CRYPTO_SUITE_CHACHA20_POLY1305;
+    if (crypto_aead_aes256gcm_is_available()) {
+        suites |= CRYPTO_SUITE_AES256_GCM;
+    }
+    return suites;
+}
+
+const char* crypto_suite_name(uint8_t suite) {
+    switch (suite) {
+        case CRYPTO_SUITE_CHACHA20_POLY1305: return "ChaCha20-Poly1305";
+        case CRYPTO_SUITE_AES256_GCM:        return "AES-256-GCM";
+        default:                             return "UNKNOWN";
+    }
+}
+
+// 스위트 하나를 벤치마크 (나노초/패킷)
+static double bench_suite(uint8_t suite) {
+    static crypto_session_t session;
+    static uint8_t packet[SUITE_BENCH_PACKET + CRYPTO_MAC_SIZE];
+    uint8_t key[CRYPTO_KEY_SIZE];
+    uint8_t nonce[CRYPTO_NONCE_SIZE];
+    struct timespec start, end;
+    
+    randombytes_buf(key, sizeof(key));
+    randombytes_buf(packet, sizeof(packet));
+    if (crypto_session_init(&session, suite, key) != 0) {
+        return -1.0;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t i = 0; i < SUITE_BENCH_ROUNDS; i++) {
+        crypto_counter_nonce(nonce, CRYPTO_DIR_SERVER_TO_CLIENT, i);
+        crypto_session_encrypt_inplace(&session, packet, SUITE_BENCH_PACKET, nonce);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    crypto_session_clear(&session);
+    sodium_memzero(key, sizeof(key));
+    
+    double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    return ns / SUITE_BENCH_ROUNDS;
+}
+
+uint8_t crypto_select_suite(void) {
+    double chacha_ns = bench_suite(CRYPTO_SUITE_CHACHA20_POLY1305);
+    printf("   %-18s %7.0f ns/packet (%d B)\n",
+           crypto_suite_name(CRYPTO_SUITE_CHACHA20_POLY1305), chacha_ns, SUITE_BENCH_PACKET);
+    
+    preferred_suite = CRYPTO_SUITE_CHACHA20_POLY1305;
+    
+    if (crypto_supported_suites() & CRYPTO_SUITE_AES256_GCM) {
+        double aes_ns = bench_suite(CRYPTO_SUITE_AES256_GCM);
+        printf("   %-18s %7.0f ns/packet (%d B)\n",
+               crypto_suite_name(CRYPTO_SUITE_AES256_GCM), aes_ns, SUITE_BENCH_PACKET);
+        if (aes_ns > 0 && aes_ns < chacha_ns) {
+            preferred_suite = CRYPTO_SUITE_AES256_GCM;
+        }
+    } else {
+        printf("   %-18s unavailable (no hardware AES)\n",
+               crypto_suite_name(CRYPTO_SUITE_AES256_GCM));
+    }
+    
+    printf("✅ Preferred cipher suite: %s\n", crypto_suite_name(preferred_suite));
+    return preferred_suite;
+}
+
+uint8_t crypto_preferred_suite(void) {
+    return preferred_suite;
+}
+
+uint8_t crypto_negotiate_suite(uint8_t offered) {
+    if (offered == 0) {
+        return CRYPTO_SUITE_CHACHA20_POLY1305;
+    }
+    
+    offered &= crypto_supported_suites();
+    if (offered & preferred_suite) {
+        return preferred_suite;
+    }
+    if (offered & CRYPTO_SUITE_CHACHA20_POLY1305) {
+        return CRYPTO_SUITE_CHACHA20_POLY1305;
+    }
+    if (offered & CRYPTO_SUITE_AES256_GCM) {
+        return CRYPTO_SUITE_AES256_GCM;
+    }
+    return 0;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 세션 암호화/복호화
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+int crypto_session_init(crypto_session_t *session, uint8_t suite, const uint8_t *key) {
+    switch (suite) {
+        case CRYPTO_SUITE_CHACHA20_POLY1305:
+            break;
+        case CRYPTO_SUITE_AES256_GCM:
+            if (!crypto_aead_aes256gcm_is_available()) {
+                return -1;
+            }
+            crypto_aead_aes256gcm_beforenm(&session->aes_state, key);
+            break;
+        default:
+            return -1;
+    }
+    
+    memcpy(session->key, key, CRYPTO_KEY_SIZE);
+    session->suite = suite;
+    return 0;
+}
+
+void crypto_session_clear(crypto_session_t *session) {
+    sodium_memzero(session, sizeof(*session));
+}
+
+int crypto_session_encrypt(const crypto_session_t *session,
+                           const uint8_t *in, size_t len,
+                           uint8_t *out, const uint8_t *nonce) {
+    if (session->suite == CRYPTO_SUITE_AES256_GCM) {
+        return crypto_aead_aes256gcm_encrypt_afternm(out, NULL, in, len, NULL, 0, NULL,
+                                                     nonce, &session->aes_state) == 0 ? 0 : -1;
+    }
+    return crypto_aead_chacha20poly1305_ietf_encrypt(out, NULL, in, len, NULL, 0, NULL,
+                                                     nonce, session->key) == 0 ? 0 : -1;
+}
+
+int crypto_session_decrypt(const crypto_session_t *session,
+                           const uint8_t *in, size_t len,
+                           uint8_t *out, const uint8_t *nonce) {
+    if (len < CRYPTO_MAC_SIZE) {
+        return -1;
+    }
+    
+    int ret;
+    if (session->suite == CRYPTO_SUITE_AES256_GCM) {
+        ret = crypto_aead_aes256gcm_decrypt_afternm(out, NULL, NULL, in, len, NULL, 0,
+                                                    nonce, &session->aes_state);
+    } else {
+        ret = crypto_aead_chacha20poly1305_ietf_decrypt(out, NULL, NULL, in, len, NULL, 0,
+                                                        nonce, session->key);
+    }
+    return ret == 0 ? (int)(len - CRYPTO_MAC_SIZE) : -1;
+}
+
+int crypto_session_encrypt_inplace(const crypto_session_t *session,
+                                   uint8_t *data, size_t len,
+                                   const uint8_t *nonce) {
+    int ret;
+    if (session->suite == CRYPTO_SUITE_AES256_GCM) {
+        ret = crypto_aead_aes256gcm_encrypt_detached_afternm(data, data + len, NULL,
+                                                             data, len, NULL, 0, NULL,
+                                                             nonce, &session->aes_state);
+    } else {
+        ret = crypto_aead_chacha20poly1305_ietf_encrypt_detached(data, data + len, NULL,
+                                                                 data, len, NULL, 0, NULL,
+                                                                 nonce, session->key);
+    }
+    return ret == 0 ? 0 : -1;
+}
+
+int crypto_session_decrypt_inplace(const crypto_session_t *session,
+                                   uint8_t *data, size_t len,
+                                   const uint8_t *nonce) {
+    if (len < CRYPTO_MAC_SIZE) {
+        return -1;
+    }
+    
+    size_t plaintext_len = len - CRYPTO_MAC_SIZE;
+    int ret;
+    if (session->suite == CRYPTO_SUITE_AES256_GCM) {
+        ret = crypto_aead_aes256gcm_decrypt_detached_afternm(data, NULL, data, plaintext_len,
+                                                             data + plaintext_len, NULL, 0,
+                                                             nonce, &session->aes_state);
+    } else {
+        ret = crypto_aead_chacha20poly1305_ietf_decrypt_detached(data, NULL, data, plaintext_len,
+                                                                 data + plaintext_len, NULL, 0,
+                                                                 nonce, session->key);
+    }
+    return ret == 0 ? (int)plaintext_len : -1;
+}
+
 // Curve25519 키 쌍 생성
 void crypto_generate_keypair(uint8_t *public_key, uint8_t *private_key) {
     crypto_box_keypair(public_key, private_key);
@@ -105,9 +297,30 @@ void crypto_derive_session_key(uint8_t *session_key,
     }
 }
 
-// 랜덤 nonce 생성
-void crypto_random_nonce(uint8_t *nonce) {
-    randombytes_buf(nonce, CRYPTO_NONCE_SIZE);
+// 와이어 카운터 기록 (빅엔디안)
+void crypto_put_counter(uint8_t *wire, uint64_t counter) {
+    for (int i = CRYPTO_COUNTER_SIZE - 1; i >= 0; i--) {
+        wire[i] = (uint8_t)counter;
+        counter >>= 8;
+    }
+}
+
+// 와이어 카운터 읽기
+uint64_t crypto_get_counter(const uint8_t *wire) {
+    uint64_t counter = 0;
+    for (int i = 0; i < CRYPTO_COUNTER_SIZE; i++) {
+        counter = (counter << 8) | wire[i];
+    }
+    return counter;
+}
+
+// 카운터 nonce 생성 (CSPRNG 호출 없음)
+void crypto_counter_nonce(uint8_t *nonce, uint32_t direction, uint64_t counter) {
+    nonce[0] = (uint8_t)(direction >> 24);
+    nonce[1] = (uint8_t)(direction >> 16);
+    nonce[2] = (uint8_t)(direction >> 8);
+    nonce[3] = (uint8_t)direction;
+    crypto_put_counter(nonce + 4, counter);
 }
 
 // 랜덤 키 생성
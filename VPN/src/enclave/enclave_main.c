@@ -4,6 +4,8 @@
 #include "crypto.h"
 #include "key_manager.h"
 #include "ipc_protocol.h"
+#include "shm_ring.h"
+#include "event_loop.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,6 +17,8 @@
 #include <sys/mman.h>
 #include <sys/resource.h>
 #include <errno.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
 
 volatile sig_atomic_t enclave_running = 1;
 
@@ -71,7 +75,7 @@ int setup_memory_security(void) {
 	    unlink(socket_path);
 	    
 	    // 소켓 생성
-	    sock_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	    sock_fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
 	    if (sock_fd < 0) {
 		perror("socket");
 		return -1;
@@ -101,31 +105,479 @@ int setup_memory_security(void) {
 	    return sock_fd;
 	}
 
-	// IPC 요청 처리
-	void handle_ipc_request(int client_fd, key_manager_t *km) {
-	    uint8_t request_buffer[sizeof(ipc_request_t) + IPC_MAX_DATA_SIZE];
-	    uint8_t response_buffer[sizeof(ipc_response_t) + IPC_MAX_DATA_SIZE];
-	    
-	    // 요청 수신 (헤더 먼저)
-	    ssize_t n = recv(client_fd, request_buffer, sizeof(ipc_request_t), MSG_PEEK);
-	    if (n < (ssize_t)sizeof(ipc_request_t)) {
-		if (n == 0) {
-		    // 연결 종료
-		    return;
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 패킷 암호화/복호화 (소켓, 배치, 링 공용)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 암호화: out = 카운터(8) + 암호문 + MAC(16)
+// nonce = [서버→클라이언트][카운터], 카운터는 세션마다 0부터 증가
+// in == out + CRYPTO_COUNTER_SIZE 이면 in-place
+// 반환값: 출력 길이, -1 (실패)
+static int encrypt_packet(key_entry_t *entry, const uint8_t *in, size_t len,
+                          uint8_t *out) {
+    uint64_t counter = __atomic_fetch_add(&entry->tx_counter, 1, __ATOMIC_RELAXED);
+    if (counter == UINT64_MAX) {
+        return -1;   // 카운터 고갈 (재핸드셰이크 필요)
+    }
+    
+    uint8_t nonce[CRYPTO_NONCE_SIZE];
+    crypto_counter_nonce(nonce, CRYPTO_DIR_SERVER_TO_CLIENT, counter);
+    crypto_put_counter(out, counter);
+    
+    uint8_t *body = out + CRYPTO_COUNTER_SIZE;
+    int ret = (in == body) ? crypto_session_encrypt_inplace(&entry->session, body, len, nonce)
+                           : crypto_session_encrypt(&entry->session, in, len, body, nonce);
+    if (ret != 0) {
+        return -1;
+    }
+    return CRYPTO_COUNTER_SIZE + len + CRYPTO_MAC_SIZE;
+}
+
+// 복호화: in = 카운터(8) + 암호문 + MAC(16), out = 평문
+// 재전송 창 확인 → 복호화 → 인증에 성공한 경우에만 창 갱신
+// out == in + CRYPTO_COUNTER_SIZE 이면 in-place
+// 반환값: 평문 길이, -1 (실패 또는 재전송)
+static int decrypt_packet(key_entry_t *entry, const uint8_t *in, size_t len,
+                          uint8_t *out) {
+    if (len < CRYPTO_COUNTER_SIZE + CRYPTO_MAC_SIZE) {
+        return -1;
+    }
+    
+    uint64_t counter = crypto_get_counter(in);
+    if (key_entry_replay_check(entry, counter) != 0) {
+        return -1;
+    }
+    
+    uint8_t nonce[CRYPTO_NONCE_SIZE];
+    crypto_counter_nonce(nonce, CRYPTO_DIR_CLIENT_TO_SERVER, counter);
+    
+    const uint8_t *body = in + CRYPTO_COUNTER_SIZE;
+    size_t ciphertext_len = len - CRYPTO_COUNTER_SIZE;
+    int result = (out == body)
+        ? crypto_session_decrypt_inplace(&entry->session, out, ciphertext_len, nonce)
+        : crypto_session_decrypt(&entry->session, body, ciphertext_len, out, nonce);
+    
+    if (result < 0 || key_entry_replay_update(entry, counter) != 0) {
+        return -1;
+    }
+    return result;
+}
+
+// 데이터 경로 키 조회: 핸들이 있으면 범위/세대 확인만, 없으면 VPN IP 인덱스
+static key_entry_t* lookup_key(key_manager_t *km, key_handle_t handle, uint32_t vpn_ip) {
+    if (handle != KEY_HANDLE_INVALID) {
+        return get_key_entry_by_handle(km, handle);
+    }
+    return get_key_entry(km, vpn_ip);
+}
+
+// ENCRYPT_BATCH / DECRYPT_BATCH 처리
+// 반환값: 응답 데이터 길이, -1 (형식 오류)
+static int handle_batch(key_manager_t *km, uint8_t command,
+                        const uint8_t *in, size_t in_len,
+                        uint8_t *out, size_t out_max) {
+    if (in_len < sizeof(ipc_batch_header_t)) {
+        return -1;
+    }
+    
+    uint16_t count = ntohs(((const ipc_batch_header_t*)in)->count);
+    if (count > IPC_MAX_BATCH) {
+        return -1;
+    }
+    
+    ((ipc_batch_header_t*)out)->count = htons(count);
+    size_t in_off = sizeof(ipc_batch_header_t);
+    size_t out_off = sizeof(ipc_batch_header_t);
+    
+    for (uint16_t i = 0; i < count; i++) {
+        if (in_off + sizeof(ipc_batch_entry_t) > in_len) {
+            return -1;
+        }
+        const ipc_batch_entry_t *req = (const ipc_batch_entry_t*)(in + in_off);
+        size_t len = ntohs(req->data_len);
+        if (in_off + sizeof(ipc_batch_entry_t) + len > in_len) {
+            return -1;
+        }
+        
+        // 출력 공간 확인 (암호화는 24 bytes 증가)
+        size_t grow = (command == IPC_ENCRYPT_BATCH) ? IPC_CRYPTO_OVERHEAD : 0;
+        if (out_off + sizeof(ipc_batch_entry_t) + len + grow > out_max) {
+            return -1;
+        }
+        
+        ipc_batch_entry_t *resp = (ipc_batch_entry_t*)(out + out_off);
+        resp->vpn_ip = req->vpn_ip;
+        resp->key_handle = req->key_handle;
+        resp->status = -1;
+        resp->data_len = 0;
+        
+        key_entry_t *entry = lookup_key(km, ntohl(req->key_handle), req->vpn_ip);
+        int result = -1;
+        if (entry) {
+            if (command == IPC_ENCRYPT_BATCH) {
+                result = encrypt_packet(entry, req->data, len, resp->data);
+            } else {
+                result = decrypt_packet(entry, req->data, len, resp->data);
+            }
+        }
+        
+        if (result >= 0) {
+            resp->status = 0;
+            resp->data_len = htons(result);
+        } else {
+            result = 0;
+        }
+        
+        in_off += sizeof(ipc_batch_entry_t) + len;
+        out_off += sizeof(ipc_batch_entry_t) + result;
+    }
+    
+    return out_off;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 연결 / 암호화 워커
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// 제어 스레드(main): epoll로 listen 소켓과 모든 IPC 연결을 동시에 처리
+//   (HANDSHAKE, ADD_KEY 같은 제어 명령 + 소켓 경로 ENCRYPT/DECRYPT)
+// 워커 스레드: RING_SETUP으로 받은 링을 나눠 맡아 암호화/복호화만 수행
+//   링 하나는 항상 한 워커만 처리하므로 링 안의 순서(완료 = 제출 순서)는 유지된다.
+
+#define ENCLAVE_MAX_CONNS    16                                   // 동시 IPC 연결 수
+#define ENCLAVE_MAX_WORKERS  8                                    // 워커 스레드 상한
+#define ENCLAVE_WORKER_RINGS (ENCLAVE_MAX_CONNS * IPC_MAX_RINGS)  // 워커당 링 상한
+#define ENCLAVE_TAG_LISTEN   UINT32_MAX                           // main epoll: listen 소켓
+#define ENCLAVE_TAG_WAKE     UINT32_MAX                           // 워커 epoll: wake eventfd
+
+// IPC 연결 (제어 소켓 1개 + 링 여러 개)
+typedef struct {
+    int fd;                               // -1 = 빈 자리
+    shm_ring_t rings[IPC_MAX_RINGS];
+    int ring_worker[IPC_MAX_RINGS];       // 링을 맡은 워커 번호
+    int ring_count;
+} enclave_conn_t;
+
+// 암호화 워커
+typedef struct {
+    pthread_t thread;
+    int id;
+    int epoll_fd;                         // 맡은 링들의 sq_eventfd + wake_fd
+    int wake_fd;                          // 링 추가/종료 알림
+    pthread_mutex_t lock;                 // rings[] 보호 (제어 스레드 ↔ 워커)
+    shm_ring_t *rings[ENCLAVE_WORKER_RINGS];
+    uint32_t ring_tags[ENCLAVE_WORKER_RINGS];
+    int ring_count;
+    key_manager_t *km;
+} enclave_worker_t;
+
+static enclave_conn_t conns[ENCLAVE_MAX_CONNS];
+static enclave_worker_t workers[ENCLAVE_MAX_WORKERS];
+static int worker_count = 0;
+
+// 링 태그 (워커 epoll 이벤트 → 링)
+static inline uint32_t ring_tag(int conn_index, int ring_index) {
+    return (uint32_t)(conn_index * IPC_MAX_RINGS + ring_index);
+}
+
+static void worker_kick(enclave_worker_t *w) {
+    uint64_t one = 1;
+    if (write(w->wake_fd, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN) {
+        perror("eventfd write");
+    }
+}
+
+// 링을 워커에 붙임 (제어 스레드)
+static int worker_attach(enclave_worker_t *w, shm_ring_t *ring, uint32_t tag) {
+    pthread_mutex_lock(&w->lock);
+    
+    if (w->ring_count >= ENCLAVE_WORKER_RINGS ||
+        event_loop_add(w->epoll_fd, ring->sq_event_fd, EPOLLIN, tag) != 0) {
+        pthread_mutex_unlock(&w->lock);
+        return -1;
+    }
+    
+    w->rings[w->ring_count] = ring;
+    w->ring_tags[w->ring_count] = tag;
+    w->ring_count++;
+    
+    pthread_mutex_unlock(&w->lock);
+    
+    // 자고 있으면 깨워서 새 링도 보게 함
+    worker_kick(w);
+    return 0;
+}
+
+// 링을 워커에서 뗌 (제어 스레드, 반환 후에는 워커가 링을 만지지 않음)
+static void worker_detach(enclave_worker_t *w, uint32_t tag) {
+    pthread_mutex_lock(&w->lock);
+    
+    for (int i = 0; i < w->ring_count; i++) {
+        if (w->ring_tags[i] != tag) {
+            continue;
+        }
+        epoll_ctl(w->epoll_fd, EPOLL_CTL_DEL, w->rings[i]->sq_event_fd, NULL);
+        w->ring_count--;
+        w->rings[i] = w->rings[w->ring_count];
+        w->ring_tags[i] = w->ring_tags[w->ring_count];
+        break;
+    }
+    
+    pthread_mutex_unlock(&w->lock);
+}
+
+// 링 등록 (IPC_RING_SETUP): 링이 가장 적은 워커에 배정
+// 반환값: 워커 번호, -1 (실패)
+static int register_ring(enclave_conn_t *conn, const int *fds, int fd_count) {
+    if (fd_count != IPC_RING_FD_COUNT || conn->ring_count >= IPC_MAX_RINGS) {
+        return -1;
+    }
+    
+    int index = conn->ring_count;
+    shm_ring_t *ring = &conn->rings[index];
+    if (shm_ring_map(ring, fds[0], fds[1], fds[2]) != 0) {
+        return -1;
+    }
+    
+    int best = 0;
+    for (int i = 1; i < worker_count; i++) {
+        if (workers[i].ring_count < workers[best].ring_count) {
+            best = i;
+        }
+    }
+    
+    if (worker_attach(&workers[best], ring, ring_tag(conn - conns, index)) != 0) {
+        // fd는 호출자가 닫으므로 매핑만 해제
+        munmap(ring->shared, sizeof(shm_ring_shared_t));
+        return -1;
+    }
+    
+    conn->ring_worker[index] = best;
+    conn->ring_count++;
+    return best;
+}
+
+// 연결의 모든 링 해제 (연결 종료 시)
+static void release_rings(enclave_conn_t *conn) {
+    for (int i = 0; i < conn->ring_count; i++) {
+        worker_detach(&workers[conn->ring_worker[i]], ring_tag(conn - conns, i));
+        shm_ring_destroy(&conn->rings[i]);
+    }
+    conn->ring_count = 0;
+}
+
+// 링 슬롯 1개 처리 (in-place)
+static void process_ring_slot(shm_ring_slot_t *slot, key_manager_t *km) {
+    // 공유 메모리 값은 서버가 언제든 바꿀 수 있으므로 한 번만 읽어서 사용
+    uint8_t command = slot->command;
+    uint32_t vpn_ip = slot->vpn_ip;
+    key_handle_t key_handle = slot->key_handle;
+    size_t off = slot->data_off;
+    size_t len = slot->data_len;
+    
+    slot->status = -1;
+    
+    key_entry_t *entry = lookup_key(km, key_handle, vpn_ip);
+    if (!entry) {
+        return;
+    }
+    
+    switch (command) {
+        case IPC_ENCRYPT: {
+            // [카운터 자리][평문] → [카운터][암호문 + MAC]
+            if (off < CRYPTO_COUNTER_SIZE ||
+                off + len + CRYPTO_MAC_SIZE > SHM_RING_SLOT_SIZE) {
+                return;
+            }
+            
+            uint8_t *out = slot->data + off - CRYPTO_COUNTER_SIZE;
+            int result = encrypt_packet(entry, slot->data + off, len, out);
+            if (result < 0) {
+                return;
+            }
+            
+            slot->data_off = off - CRYPTO_COUNTER_SIZE;
+            slot->data_len = result;
+            slot->status = 0;
+            break;
+        }
+        
+        case IPC_DECRYPT: {
+            // [카운터][암호문 + MAC] → [카운터 자리][평문]
+            if (off + len > SHM_RING_SLOT_SIZE) {
+                return;
+            }
+            
+            uint8_t *in = slot->data + off;
+            int result = decrypt_packet(entry, in, len, in + CRYPTO_COUNTER_SIZE);
+            if (result < 0) {
+                return;
+            }
+            
+            slot->data_off = off + CRYPTO_COUNTER_SIZE;
+            slot->data_len = result;
+            slot->status = 0;
+            break;
+        }
+        
+        default:
+            break;
+    }
+}
+
+// 워커가 맡은 링의 대기 요청 처리 (w->lock 보유 상태)
+// 키 테이블 읽기 잠금은 패킷마다가 아니라 한 번의 처리 단위로 잡음
+// 반환값: 처리한 요청 수
+static int worker_serve_rings(enclave_worker_t *w) {
+    int processed = 0;
+    
+    key_manager_read_lock(w->km);
+    
+    for (int i = 0; i < w->ring_count; i++) {
+        shm_ring_t *ring = w->rings[i];
+        uint32_t pending = shm_ring_pending(ring);
+        if (pending == 0) {
+            continue;
+        }
+        
+        for (uint32_t j = 0; j < pending; j++) {
+            process_ring_slot(shm_ring_pending_slot(ring, j), w->km);
+        }
+        
+        shm_ring_complete(ring, pending);
+        processed += pending;
+    }
+    
+    key_manager_read_unlock(w->km);
+    
+    return processed;
+}
+
+// 맡은 링이 모두 잠들 준비가 되었는지 확인 (w->lock 보유 상태)
+static int worker_ready_to_sleep(enclave_worker_t *w) {
+    for (int i = 0; i < w->ring_count; i++) {
+        if (!shm_ring_prepare_sleep(w->rings[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// 워커 스레드: 일이 있으면 계속 처리, 없으면 idle 플래그를 세우고 epoll에서 대기
+static void* crypto_worker_main(void *arg) {
+    enclave_worker_t *w = (enclave_worker_t*)arg;
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+    
+    while (enclave_running) {
+        pthread_mutex_lock(&w->lock);
+        int busy = worker_serve_rings(w) > 0;
+        int can_sleep = !busy && worker_ready_to_sleep(w);
+        pthread_mutex_unlock(&w->lock);
+        
+        if (!can_sleep) {
+            continue;
+        }
+        
+        int n = epoll_wait(w->epoll_fd, events, EVENT_LOOP_MAX_EVENTS, 1000);
+        if (n <= 0) {
+            continue;   // 타임아웃 또는 시그널
+        }
+        
+        // 이벤트를 받은 사이 링이 떨어졌을 수 있으므로 태그로 다시 찾음
+        pthread_mutex_lock(&w->lock);
+        for (int i = 0; i < n; i++) {
+            uint32_t tag = events[i].data.u32;
+            if (tag == ENCLAVE_TAG_WAKE) {
+                uint64_t value;
+                if (read(w->wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                    perror("eventfd read");
+                }
+                continue;
+            }
+            for (int j = 0; j < w->ring_count; j++) {
+                if (w->ring_tags[j] == tag) {
+                    shm_ring_wakeup_ack(w->rings[j]);
+                    break;
+                }
+            }
+        }
+        pthread_mutex_unlock(&w->lock);
+    }
+    
+    return NULL;
+}
+
+// 워커 풀 시작
+// 반환값: 0 (성공), -1 (실패)
+static int start_workers(int count, key_manager_t *km) {
+    for (int i = 0; i < count; i++) {
+        enclave_worker_t *w = &workers[i];
+        memset(w, 0, sizeof(*w));
+        w->id = i;
+        w->km = km;
+        w->epoll_fd = event_loop_create();
+        w->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (w->epoll_fd < 0 || w->wake_fd < 0 ||
+            event_loop_add(w->epoll_fd, w->wake_fd, EPOLLIN, ENCLAVE_TAG_WAKE) != 0) {
+            perror("worker setup");
+            return -1;
+        }
+        pthread_mutex_init(&w->lock, NULL);
+        
+        if (pthread_create(&w->thread, NULL, crypto_worker_main, w) != 0) {
+            perror("pthread_create");
+            return -1;
+        }
+        worker_count++;
+    }
+    
+    printf("✅ %d crypto worker thread(s) started\n", worker_count);
+    return 0;
+}
+
+// 워커 풀 종료 (enclave_running = 0 이후)
+static void stop_workers(void) {
+    for (int i = 0; i < worker_count; i++) {
+        worker_kick(&workers[i]);
+    }
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(workers[i].thread, NULL);
+        close(workers[i].epoll_fd);
+        close(workers[i].wake_fd);
+        pthread_mutex_destroy(&workers[i].lock);
+    }
+    worker_count = 0;
+}
+
+	// IPC 요청 처리 (제어 스레드 전용)
+	// 반환값: 0 (계속), -1 (연결 종료)
+	int handle_ipc_request(enclave_conn_t *conn, key_manager_t *km) {
+	    int client_fd = conn->fd;
+	    
+	    // 배치 요청(최대 64KB)까지 받을 수 있도록 정적 버퍼 사용 (제어 스레드만 호출)
+	    static uint8_t request_buffer[sizeof(ipc_request_t) + IPC_MAX_BATCH_DATA];
+	    static uint8_t response_buffer[sizeof(ipc_response_t) + IPC_MAX_BATCH_DATA];
+	    
+	    // 요청 수신 (메시지 1개 = 요청 1개, RING_SETUP은 fd가 첨부됨)
+	    int fds[IPC_RING_FD_COUNT];
+	    int fd_count = 0;
+	    ssize_t n = ipc_recv_fds(client_fd, request_buffer, sizeof(request_buffer),
+				     fds, &fd_count);
+	    if (n <= 0) {
+		if (n < 0) {
+		    perror("recv request");
 		}
-		perror("recv header");
-		return;
+		// 0 = 연결 종료
+		return -1;
 	    }
 	    
 	    ipc_request_t *req = (ipc_request_t*)request_buffer;
-	    uint16_t data_len = ntohs(req->data_len);
-	    size_t total_len = sizeof(ipc_request_t) + data_len;
-	    
-	    // 전체 요청 수신
-	    n = recv(client_fd, request_buffer, total_len, 0);
-	    if (n != (ssize_t)total_len) {
-		perror("recv full request");
-		return;
+	    uint16_t data_len = n >= (ssize_t)sizeof(ipc_request_t) ? ntohs(req->data_len) : 0;
+	    if (n < (ssize_t)sizeof(ipc_request_t) ||
+		n != (ssize_t)(sizeof(ipc_request_t) + data_len)) {
+		fprintf(stderr, "❌ Malformed IPC request (%zd bytes)\n", n);
+		for (int i = 0; i < fd_count; i++) close(fds[i]);
+		return -1;
 	    }
 	    
 	    printf("📥 IPC Request: %s (ID=%u, VPN IP=%08x, len=%u)\n",
@@ -156,8 +608,13 @@ int setup_memory_security(void) {
 		    }
 		    
 		    ipc_add_key_data_t *key_data = (ipc_add_key_data_t*)req->data;
+		    key_handle_t handle = add_key(km, req->vpn_ip, key_data->session_key,
+						  key_data->cipher_suite);
 		    
-		    if (add_key(km, req->vpn_ip, key_data->session_key) == 0) {
+		    if (handle != KEY_HANDLE_INVALID) {
+			ipc_key_handle_data_t *handle_data = (ipc_key_handle_data_t*)resp->data;
+			handle_data->key_handle = htonl(handle);
+			resp->data_len = htons(sizeof(ipc_key_handle_data_t));
 			printf("   → Key added\n");
 			resp->status = 0;
 		    } else {
@@ -174,26 +631,42 @@ int setup_memory_security(void) {
 		    break;
 		}
 		
-		case IPC_ENCRYPT: {
-		    const uint8_t *key = get_key(km, req->vpn_ip);
-		    if (!key) {
-			fprintf(stderr, "   ❌ Key not found\n");
+		case IPC_REMOVE_KEYS: {
+		    static uint32_t vpn_ips[IPC_MAX_REMOVE_KEYS];
+		    uint16_t count = 0;
+		    
+		    if (data_len >= sizeof(ipc_batch_header_t)) {
+			count = ntohs(((const ipc_batch_header_t*)req->data)->count);
+		    }
+		    if (data_len < sizeof(ipc_batch_header_t) || count > IPC_MAX_REMOVE_KEYS ||
+			data_len != sizeof(ipc_batch_header_t) + count * sizeof(uint32_t)) {
+			fprintf(stderr, "   ❌ Invalid data length\n");
 			resp->status = -1;
 			break;
 		    }
 		    
-		    // Nonce 생성
-		    uint8_t nonce[CRYPTO_NONCE_SIZE];
-		    crypto_random_nonce(nonce);
+		    // 패킹된 요청이라 정렬된 배열로 옮긴 뒤 한 번의 잠금으로 제거
+		    memcpy(vpn_ips, req->data + sizeof(ipc_batch_header_t), count * sizeof(uint32_t));
+		    int removed = remove_keys(km, vpn_ips, count);
 		    
-		    // 암호화: nonce(12) + ciphertext(data_len + 16)
-		    uint8_t *output = resp->data;
-		    memcpy(output, nonce, CRYPTO_NONCE_SIZE);
+		    ((ipc_batch_header_t*)resp->data)->count = htons((uint16_t)removed);
+		    resp->data_len = htons(sizeof(ipc_batch_header_t));
+		    resp->status = 0;
+		    break;
+		}
+		
+		case IPC_ENCRYPT: {
+		    key_entry_t *entry = get_key_entry(km, req->vpn_ip);
+		    if (!entry) {
+			fprintf(stderr, "   ❌ Key not found\n");
+			resp->status = -1;
+			break;
+		    }
 		    
-		    if (crypto_encrypt(req->data, data_len,
-				      output + CRYPTO_NONCE_SIZE,
-				      key, nonce) == 0) {
-			resp->data_len = htons(CRYPTO_NONCE_SIZE + data_len + CRYPTO_MAC_SIZE);
+		    // 암호화: counter(8) + ciphertext(data_len + 16)
+		    int result = encrypt_packet(entry, req->data, data_len, resp->data);
+		    if (result >= 0) {
+			resp->data_len = htons(result);
 			printf("   → Encrypted %u bytes\n", data_len);
 			resp->status = 0;
 		    } else {
@@ -204,37 +677,46 @@ int setup_memory_security(void) {
 		}
 		
 		case IPC_DECRYPT: {
-		    const uint8_t *key = get_key(km, req->vpn_ip);
-		    if (!key) {
+		    key_entry_t *entry = get_key_entry(km, req->vpn_ip);
+		    if (!entry) {
 			fprintf(stderr, "   ❌ Key not found\n");
 			resp->status = -1;
 			break;
 		    }
 		    
-		    if (data_len < CRYPTO_NONCE_SIZE + CRYPTO_MAC_SIZE) {
+		    if (data_len < CRYPTO_COUNTER_SIZE + CRYPTO_MAC_SIZE) {
 			fprintf(stderr, "   ❌ Data too short\n");
 			resp->status = -1;
 			break;
 		    }
 		    
-		    // nonce 추출
-		    uint8_t *nonce = req->data;
-		    uint8_t *ciphertext = req->data + CRYPTO_NONCE_SIZE;
-		    size_t ciphertext_len = data_len - CRYPTO_NONCE_SIZE;
-		    
-		    // 복호화
-		    if (crypto_decrypt(ciphertext, ciphertext_len,
-				      resp->data, key, nonce) == 0) {
-			resp->data_len = htons(ciphertext_len - CRYPTO_MAC_SIZE);
-			printf("   → Decrypted %zu bytes\n", ciphertext_len - CRYPTO_MAC_SIZE);
+		    // 복호화 (재전송 창 확인 포함)
+		    int result = decrypt_packet(entry, req->data, data_len, resp->data);
+		    if (result >= 0) {
+			resp->data_len = htons(result);
+			printf("   → Decrypted %d bytes\n", result);
 			resp->status = 0;
 		    } else {
-			fprintf(stderr, "   ❌ Decryption failed\n");
+			fprintf(stderr, "   ❌ Decryption failed (or replayed)\n");
 			resp->status = -1;
 		    }
 		    break;
 		}
 		
+		case IPC_ENCRYPT_BATCH:
+		case IPC_DECRYPT_BATCH: {
+		    int out_len = handle_batch(km, req->command, req->data, data_len,
+					       resp->data, IPC_MAX_BATCH_DATA);
+		    if (out_len < 0) {
+			fprintf(stderr, "   ❌ Invalid batch request\n");
+			resp->status = -1;
+			break;
+		    }
+		    resp->data_len = htons(out_len);
+		    resp->status = 0;
+		    break;
+		}
+		
 		case IPC_HANDSHAKE: {
 		    if (data_len != sizeof(ipc_handshake_data_t)) {
 			fprintf(stderr, "   ❌ Invalid handshake data\n");
@@ -245,15 +727,18 @@ int setup_memory_security(void) {
 		    ipc_handshake_data_t *hs_data = (ipc_handshake_data_t*)req->data;
 		    ipc_handshake_response_t *hs_resp = (ipc_handshake_response_t*)resp->data;
 		    
-		    // 서버 공개키 제공
-		    get_server_public_key(km, hs_resp->server_public_key);
-		    
-		    // ECDH 핸드셰이크
+		    // ECDH 핸드셰이크 (이번 핸드셰이크의 서버 공개키도 같이 돌려줌)
+		    key_handle_t handle;
 		    if (perform_handshake(km, req->vpn_ip,
 					 hs_data->client_public_key,
-					 hs_resp->session_key) == 0) {
+					 hs_data->cipher_suites,
+					 hs_resp->server_public_key,
+					 hs_resp->session_key,
+					 &hs_resp->cipher_suite, &handle) == 0) {
+			hs_resp->key_handle = htonl(handle);
 			resp->data_len = htons(sizeof(ipc_handshake_response_t));
-			printf("   → Handshake complete\n");
+			printf("   → Handshake complete (%s)\n",
+			       crypto_suite_name(hs_resp->cipher_suite));
 			resp->status = 0;
 		    } else {
 			fprintf(stderr, "   ❌ Handshake failed\n");
@@ -262,6 +747,20 @@ int setup_memory_security(void) {
 		    break;
 		}
 		
+		case IPC_RING_SETUP: {
+		    int worker = register_ring(conn, fds, fd_count);
+		    if (worker >= 0) {
+			printf("   → Ring registered (%d/%d, worker %d)\n",
+			       conn->ring_count, IPC_MAX_RINGS, worker);
+			fd_count = 0;  // 링이 fd를 소유
+			resp->status = 0;
+		    } else {
+			fprintf(stderr, "   ❌ Ring setup failed\n");
+			resp->status = -1;
+		    }
+		    break;
+		}
+		
 		case IPC_SHUTDOWN: {
 		    printf("   → Shutdown requested\n");
 		    resp->status = 0;
@@ -276,15 +775,84 @@ int setup_memory_security(void) {
 		}
 	    }
 	    
-	    // 응답 전송
+	    // 사용하지 않은 fd 정리
+	    for (int i = 0; i < fd_count; i++) {
+		close(fds[i]);
+	    }
+	    
+	    // 응답 전송 (결과는 이미 헤더 뒤에 기록되어 있으므로 메시지 1개로 바로)
 	    size_t response_len = sizeof(ipc_response_t) + ntohs(resp->data_len);
-	    send(client_fd, response_buffer, response_len, 0);
+	    if (send(client_fd, response_buffer, response_len, MSG_NOSIGNAL) != (ssize_t)response_len) {
+		perror("send response");
+		return -1;
+	    }
+	    
+	    return 0;
 	}
 
+	// 빈 연결 자리에 새 연결 등록
+	// 반환값: 연결 번호, -1 (가득 참)
+	static int accept_conn(int sock_fd, int epoll_fd) {
+	    int client_fd = accept(sock_fd, NULL, NULL);
+	    if (client_fd < 0) {
+		perror("accept");
+		return -1;
+	    }
+	    
+	    for (int i = 0; i < ENCLAVE_MAX_CONNS; i++) {
+		if (conns[i].fd >= 0) {
+		    continue;
+		}
+		if (event_loop_add(epoll_fd, client_fd, EPOLLIN, (uint32_t)i) != 0) {
+		    break;
+		}
+		conns[i].fd = client_fd;
+		conns[i].ring_count = 0;
+		printf("📞 Client connected (fd=%d, conn=%d)\n", client_fd, i);
+		return i;
+	    }
+	    
+	    fprintf(stderr, "❌ Too many IPC connections (max %d)\n", ENCLAVE_MAX_CONNS);
+	    close(client_fd);
+	    return -1;
+	}
+	
+	// 연결 종료 (링은 워커에서 먼저 뗀 뒤 해제)
+	static void close_conn(enclave_conn_t *conn, int epoll_fd) {
+	    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+	    release_rings(conn);
+	    close(conn->fd);
+	    printf("📞 Client disconnected (fd=%d)\n", conn->fd);
+	    conn->fd = -1;
+	}
+	
+	// 워커 수 기본값: 온라인 CPU 수 (상한 ENCLAVE_MAX_WORKERS)
+	static int default_worker_count(void) {
+	    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	    if (cpus < 1) cpus = 1;
+	    if (cpus > ENCLAVE_MAX_WORKERS) cpus = ENCLAVE_MAX_WORKERS;
+	    return (int)cpus;
+	}
+	
 	// Enclave 메인
-	int main(void) {
-	    int sock_fd, client_fd;
+	int main(int argc, char *argv[]) {
+	    int sock_fd, epoll_fd;
 	    key_manager_t *km = NULL;
+	    int worker_target = default_worker_count();
+	    
+	    // 인자: --workers N
+	    for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+		    worker_target = atoi(argv[++i]);
+		    if (worker_target < 1 || worker_target > ENCLAVE_MAX_WORKERS) {
+			fprintf(stderr, "❌ --workers must be 1..%d\n", ENCLAVE_MAX_WORKERS);
+			return 1;
+		    }
+		} else {
+		    fprintf(stderr, "Usage: %s [--workers N]\n", argv[0]);
+		    return 1;
+		}
+	    }
 	    
 	    printf("🔐 VPN Enclave Process Starting...\n");
 	    printf("═══════════════════════════════════════\n\n");
@@ -305,6 +873,7 @@ int setup_memory_security(void) {
 	    if (crypto_init() != 0) {
 		return 1;
 	    }
+	    crypto_select_suite();
 	    printf("\n");
 	    
 	    // 3. 키 관리자 초기화
@@ -322,72 +891,78 @@ int setup_memory_security(void) {
 		destroy_key_manager(km);
 		return 1;
 	    }
+	    
+	    for (int i = 0; i < ENCLAVE_MAX_CONNS; i++) {
+		conns[i].fd = -1;
+	    }
+	    
+	    epoll_fd = event_loop_create();
+	    if (epoll_fd < 0 ||
+		event_loop_add(epoll_fd, sock_fd, EPOLLIN, ENCLAVE_TAG_LISTEN) != 0) {
+		close(sock_fd);
+		destroy_key_manager(km);
+		return 1;
+	    }
+	    
+	    // 5. 암호화 워커 풀
+	    if (start_workers(worker_target, km) != 0) {
+		enclave_running = 0;
+		stop_workers();
+		close(epoll_fd);
+		close(sock_fd);
+		destroy_key_manager(km);
+		return 1;
+	    }
 	    printf("\n");
 	    
 	    printf("✅ Enclave is ready!\n");
 	    printf("═══════════════════════════════════════\n");
 	    printf("⏳ Waiting for IPC connections...\n\n");
 	    
-	    // 5. 메인 루프
+	    // 6. 제어 루프 (연결 수락 + 모든 연결의 제어 요청)
+	    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
 	    while (enclave_running) {
-		fd_set read_fds;
-		struct timeval tv = {1, 0};  // 1초 타임아웃
-		
-		FD_ZERO(&read_fds);
-		FD_SET(sock_fd, &read_fds);
-		
-		int activity = select(sock_fd + 1, &read_fds, NULL, NULL, &tv);
-		
-		if (activity < 0) {
-		    if (enclave_running) {
-			perror("select");
+		int n = epoll_wait(epoll_fd, events, EVENT_LOOP_MAX_EVENTS, 1000);
+		if (n < 0) {
+		    if (errno != EINTR) {
+			perror("epoll_wait");
+			break;
 		    }
-		    break;
-		}
-		
-		if (activity == 0) {
-		    // 타임아웃
-		    continue;
-		}
-		
-		// 새 연결 수락
-		client_fd = accept(sock_fd, NULL, NULL);
-		if (client_fd < 0) {
-		    perror("accept");
 		    continue;
 		}
 		
-		printf("📞 Client connected (fd=%d)\n", client_fd);
-		
-		// 클라이언트 요청 처리 (동기)
-		while (enclave_running) {
-		    fd_set client_fds;
-		    struct timeval client_tv = {5, 0};  // 5초 타임아웃
-		    
-		    FD_ZERO(&client_fds);
-		    FD_SET(client_fd, &client_fds);
+		for (int i = 0; i < n && enclave_running; i++) {
+		    uint32_t tag = events[i].data.u32;
 		    
-		    int ret = select(client_fd + 1, &client_fds, NULL, NULL, &client_tv);
+		    if (tag == ENCLAVE_TAG_LISTEN) {
+			accept_conn(sock_fd, epoll_fd);
+			continue;
+		    }
 		    
-		    if (ret <= 0) {
-			// 타임아웃 또는 에러
+		    enclave_conn_t *conn = &conns[tag];
+		    if (conn->fd < 0) {
 			continue;
-            }
-            
-            handle_ipc_request(client_fd, km);
-        }
-        
-        close(client_fd);
-        printf("📞 Client disconnected\n");
-    }
-    
-    // 6. 정리
-    printf("\n🧹 Cleaning up...\n");
-    close(sock_fd);
-    unlink(IPC_SOCKET_PATH);
-    destroy_key_manager(km);
-    
-    printf("✅ Enclave stopped.\n");
-    
-    return 0;
-}
+		    }
+		    if (handle_ipc_request(conn, km) != 0) {
+			close_conn(conn, epoll_fd);
+		    }
+		}
+	    }
+	    
+	    // 7. 정리 (워커를 먼저 멈춘 뒤 링/연결 해제)
+	    printf("\n🧹 Cleaning up...\n");
+	    stop_workers();
+	    for (int i = 0; i < ENCLAVE_MAX_CONNS; i++) {
+		if (conns[i].fd >= 0) {
+		    close_conn(&conns[i], epoll_fd);
+		}
+	    }
+	    close(epoll_fd);
+	    close(sock_fd);
+	    unlink(IPC_SOCKET_PATH);
+	    destroy_key_manager(km);
+	    
+	    printf("✅ Enclave stopped.\n");
+	    
+	    return 0;
+	}
@@ -1,5 +1,6 @@
 // src/enclave/key_manager.c
 
+#define _GNU_SOURCE
 #include "key_manager.h"
 #include "crypto.h"
 #include <stdio.h>
@@ -7,6 +8,8 @@
 #include <string.h>
 #include <arpa/inet.h>
 
+#define KEY_CHUNK_ALIGN 64
+
 // 키 관리자 초기화
 key_manager_t* init_key_manager(void) {
     key_manager_t *km = (key_manager_t*)malloc(sizeof(key_manager_t));
@@ -18,15 +21,26 @@ key_manager_t* init_key_manager(void) {
     memset(km, 0, sizeof(key_manager_t));
     km->count = 0;
     
-    // 서버 키 쌍 생성
-    crypto_generate_keypair(km->server_public_key, km->server_private_key);
+    if (id_bitmap_init(&km->slots, MAX_KEYS) != 0) {
+        free(km);
+        return NULL;
+    }
     
-    printf("✅ Key manager initialized\n");
-    printf("   Server public key: ");
-    for (int i = 0; i < 8; i++) {
-        printf("%02x", km->server_public_key[i]);
+    // VPN IP 인덱스는 청크가 늘 때 같이 키움
+    if (hash_index_init(&km->by_vpn_ip, KEY_CHUNK_SIZE) != 0) {
+        id_bitmap_destroy(&km->slots);
+        free(km);
+        return NULL;
     }
-    printf("...\n");
+    
+    // 핸드셰이크가 워커들의 연속된 읽기 구간 뒤에서 굶지 않도록 쓰기 우선
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&km->lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+    
+    printf("✅ Key manager initialized\n");
     
     return km;
 }
@@ -34,83 +48,262 @@ key_manager_t* init_key_manager(void) {
 // 키 관리자 제거
 void destroy_key_manager(key_manager_t *km) {
     if (km) {
+        hash_index_destroy(&km->by_vpn_ip);
+        id_bitmap_destroy(&km->slots);
+        pthread_rwlock_destroy(&km->lock);
+        
         // 민감한 데이터 제거
+        for (int c = 0; c < KEY_CHUNK_COUNT; c++) {
+            if (km->chunks[c]) {
+                sodium_memzero(km->chunks[c], sizeof(key_entry_t) * KEY_CHUNK_SIZE);
+                free(km->chunks[c]);
+            }
+        }
         sodium_memzero(km, sizeof(key_manager_t));
         free(km);
         printf("🧹 Key manager destroyed\n");
     }
 }
 
-// 키 추가
-int add_key(key_manager_t *km, uint32_t vpn_ip, const uint8_t *session_key) {
-    // 빈 슬롯 찾기
-    int index = -1;
-    for (int i = 0; i < MAX_KEYS; i++) {
-        if (!km->keys[i].active) {
-            index = i;
-            break;
-        }
+// 슬롯 세대 증가 (0은 KEY_HANDLE_INVALID와 겹치지 않도록 건너뜀)
+static void bump_generation(key_entry_t *entry) {
+    entry->generation++;
+    if (entry->generation == 0) {
+        entry->generation = 1;
     }
+}
+
+// 슬롯 → 엔트리 (청크가 없으면 NULL)
+static inline key_entry_t* slot_entry(key_manager_t *km, uint32_t slot) {
+    key_entry_t *chunk = km->chunks[slot >> KEY_CHUNK_BITS];
+    return chunk ? &chunk[slot & (KEY_CHUNK_SIZE - 1)] : NULL;
+}
+
+// 슬롯이 들어갈 청크 준비 (쓰기 잠금 보유 상태)
+// 반환값: 0 (성공), -1 (메모리 부족)
+static int ensure_chunk(key_manager_t *km, uint32_t slot) {
+    uint32_t c = slot >> KEY_CHUNK_BITS;
     
-    if (index == -1) {
-        fprintf(stderr, "❌ Key table full\n");
+    if (km->chunks[c]) {
+        return 0;
+    }
+    
+    // VPN IP 인덱스가 부하율을 넘지 않도록 먼저 키움
+    if (hash_index_reserve(&km->by_vpn_ip, (km->chunk_count + 1) * KEY_CHUNK_SIZE) != 0) {
         return -1;
     }
     
-    km->keys[index].vpn_ip = vpn_ip;
-    memcpy(km->keys[index].session_key, session_key, 32);
-    km->keys[index].active = 1;
-    km->count++;
+    void *mem = NULL;
+    if (posix_memalign(&mem, KEY_CHUNK_ALIGN, sizeof(key_entry_t) * KEY_CHUNK_SIZE) != 0) {
+        perror("posix_memalign key chunk");
+        return -1;
+    }
+    memset(mem, 0, sizeof(key_entry_t) * KEY_CHUNK_SIZE);
+    
+    km->chunks[c] = (key_entry_t*)mem;
+    km->chunk_count++;
+    return 0;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 동시성
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+void key_manager_read_lock(key_manager_t *km) {
+    pthread_rwlock_rdlock(&km->lock);
+}
+
+void key_manager_read_unlock(key_manager_t *km) {
+    pthread_rwlock_unlock(&km->lock);
+}
+
+static inline void entry_lock(key_entry_t *entry) {
+    while (__atomic_exchange_n(&entry->rx_lock, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&entry->rx_lock, __ATOMIC_RELAXED)) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+    }
+}
+
+static inline void entry_unlock(key_entry_t *entry) {
+    __atomic_store_n(&entry->rx_lock, 0, __ATOMIC_RELEASE);
+}
+
+int key_entry_replay_check(key_entry_t *entry, uint64_t counter) {
+    entry_lock(entry);
+    int ret = replay_window_check(&entry->rx_window, counter);
+    entry_unlock(entry);
+    return ret;
+}
+
+int key_entry_replay_update(key_entry_t *entry, uint64_t counter) {
+    entry_lock(entry);
+    int ret = replay_window_update(&entry->rx_window, counter);
+    entry_unlock(entry);
+    return ret;
+}
+
+// 키 추가
+key_handle_t add_key(key_manager_t *km, uint32_t vpn_ip, const uint8_t *session_key,
+                     uint8_t suite) {
+    // 스위트 검증은 슬롯을 잡기 전에 (실패해도 기존 키는 유지)
+    crypto_session_t session;
+    if (crypto_session_init(&session, suite, session_key) != 0) {
+        fprintf(stderr, "❌ Unsupported cipher suite: 0x%02x\n", suite);
+        return KEY_HANDLE_INVALID;
+    }
+    
+    pthread_rwlock_wrlock(&km->lock);
+    
+    // 재핸드셰이크: 같은 VPN IP의 슬롯을 재사용 (중복 슬롯 방지)
+    int index = hash_index_get(&km->by_vpn_ip, vpn_ip);
+    
+    if (index == HASH_INDEX_EMPTY) {
+        // 빈 슬롯 (가장 작은 번호, 필요하면 청크 추가)
+        index = id_bitmap_alloc(&km->slots);
+        
+        if (index < 0 || ensure_chunk(km, (uint32_t)index) != 0) {
+            if (index >= 0) {
+                id_bitmap_release(&km->slots, (uint32_t)index);
+            }
+            pthread_rwlock_unlock(&km->lock);
+            fprintf(stderr, "❌ Key table full\n");
+            crypto_session_clear(&session);
+            return KEY_HANDLE_INVALID;
+        }
+        
+        key_entry_t *slot = slot_entry(km, (uint32_t)index);
+        slot->vpn_ip = vpn_ip;
+        slot->active = 1;
+        km->count++;
+        hash_index_put(&km->by_vpn_ip, vpn_ip, index);
+    }
+    
+    // 키가 바뀌므로 이전 핸들은 무효화
+    key_entry_t *entry = slot_entry(km, (uint32_t)index);
+    entry->session = session;
+    crypto_session_clear(&session);
+    bump_generation(entry);
+    
+    // 핸드셰이크마다 서버 키 쌍을 새로 만들므로 키도 매번 새 키 → nonce 카운터와 재전송 창도 처음부터
+    entry->tx_counter = 0;
+    replay_window_init(&entry->rx_window);
+    
+    key_handle_t handle = KEY_HANDLE_MAKE(index, entry->generation);
+    pthread_rwlock_unlock(&km->lock);
     
     struct in_addr addr;
     addr.s_addr = vpn_ip;
-    printf("🔑 Key added for %s\n", inet_ntoa(addr));
+    printf("🔑 Key added for %s (slot=%d, gen=%u, %s)\n",
+           inet_ntoa(addr), index, KEY_HANDLE_GEN(handle), crypto_suite_name(suite));
     
-    return 0;
+    return handle;
 }
 
-// 키 조회
-const uint8_t* get_key(key_manager_t *km, uint32_t vpn_ip) {
-    for (int i = 0; i < MAX_KEYS; i++) {
-        if (km->keys[i].active && km->keys[i].vpn_ip == vpn_ip) {
-            return km->keys[i].session_key;
-        }
+// 엔트리 조회 (VPN IP)
+key_entry_t* get_key_entry(key_manager_t *km, uint32_t vpn_ip) {
+    int index = hash_index_get(&km->by_vpn_ip, vpn_ip);
+    if (index == HASH_INDEX_EMPTY) {
+        return NULL;
+    }
+    return slot_entry(km, (uint32_t)index);
+}
+
+// 엔트리 조회 (핸들)
+key_entry_t* get_key_entry_by_handle(key_manager_t *km, key_handle_t handle) {
+    uint32_t index = KEY_HANDLE_SLOT(handle);
+    
+    key_entry_t *entry = slot_entry(km, index);
+    if (!entry || !entry->active || entry->generation != KEY_HANDLE_GEN(handle)) {
+        return NULL;
     }
-    return NULL;
+    return entry;
+}
+
+// 키 조회 (VPN IP)
+const uint8_t* get_key(key_manager_t *km, uint32_t vpn_ip) {
+    key_entry_t *entry = get_key_entry(km, vpn_ip);
+    return entry ? entry->session.key : NULL;
 }
 
+// 키 조회 (핸들)
+const uint8_t* get_key_by_handle(key_manager_t *km, key_handle_t handle) {
+    key_entry_t *entry = get_key_entry_by_handle(km, handle);
+    return entry ? entry->session.key : NULL;
+}
+
+// 키 제거 (쓰기 잠금은 호출자가 보유)
+// 반환값: 1 (제거), 0 (없음)
+static int remove_key_locked(key_manager_t *km, uint32_t vpn_ip) {
+    int index = hash_index_get(&km->by_vpn_ip, vpn_ip);
+    if (index == HASH_INDEX_EMPTY) {
+        return 0;
+    }
+    
+    key_entry_t *entry = slot_entry(km, (uint32_t)index);
+    crypto_session_clear(&entry->session);
+    entry->active = 0;
+    bump_generation(entry);
+    km->count--;
+    hash_index_remove(&km->by_vpn_ip, vpn_ip);
+    id_bitmap_release(&km->slots, (uint32_t)index);
+    return 1;
+}
+    
 // 키 제거
 void remove_key(key_manager_t *km, uint32_t vpn_ip) {
-    for (int i = 0; i < MAX_KEYS; i++) {
-        if (km->keys[i].active && km->keys[i].vpn_ip == vpn_ip) {
-            sodium_memzero(km->keys[i].session_key, 32);
-            km->keys[i].active = 0;
-            km->count--;
-            
-            struct in_addr addr;
-            addr.s_addr = vpn_ip;
-            printf("🔓 Key removed for %s\n", inet_ntoa(addr));
-            return;
-        }
+    pthread_rwlock_wrlock(&km->lock);
+    int removed = remove_key_locked(km, vpn_ip);
+    pthread_rwlock_unlock(&km->lock);
+    
+    if (removed) {
+        struct in_addr addr;
+        addr.s_addr = vpn_ip;
+        printf("🔓 Key removed for %s\n", inet_ntoa(addr));
     }
 }
 
-// 서버 공개키 가져오기
-void get_server_public_key(key_manager_t *km, uint8_t *public_key) {
-    memcpy(public_key, km->server_public_key, 32);
+// 여러 키 제거 (쓰기 잠금 1회)
+int remove_keys(key_manager_t *km, const uint32_t *vpn_ips, int count) {
+    int removed = 0;
+    
+    pthread_rwlock_wrlock(&km->lock);
+    for (int i = 0; i < count; i++) {
+        removed += remove_key_locked(km, vpn_ips[i]);
+    }
+    pthread_rwlock_unlock(&km->lock);
+    
+    printf("🔓 Keys removed: %d / %d\n", removed, count);
+    return removed;
 }
 
 // ECDH 핸드셰이크
 int perform_handshake(key_manager_t *km, uint32_t vpn_ip,
                       const uint8_t *client_public_key,
-                      uint8_t *session_key_out) {
+                      uint8_t offered_suites,
+                      uint8_t *server_public_key_out,
+                      uint8_t *session_key_out,
+                      uint8_t *suite_out,
+                      key_handle_t *handle_out) {
+    uint8_t suite = crypto_negotiate_suite(offered_suites);
+    if (suite == 0) {
+        fprintf(stderr, "❌ No common cipher suite (offered 0x%02x)\n", offered_suites);
+        return -1;
+    }
+
    
 
     // ✅ 디버깅: 입력 출력
+    // 핸드셰이크마다 새 서버 키 쌍 (클라이언트 키가 같아도, CONNECT_REQ가 중복돼도 세션키가 겹치지 않음)
+    uint8_t server_private_key[32];
+    crypto_generate_keypair(server_public_key_out, server_private_key);
+    
     printf("   🔐 Enclave ECDH:\n");
-    printf("      Server private key: ");
+    printf("      Server public key: ");
     for (int i = 0; i < 8; i++) {
-        printf("%02x", km->server_private_key[i]);
+        printf("%02x", server_public_key_out[i]);
     }
     printf("...\n");
     printf("      Client public key: ");
@@ -121,8 +314,10 @@ int perform_handshake(key_manager_t *km, uint32_t vpn_ip,
 
     uint8_t shared_secret[32];
     
-    // ECDH 계산
-    if (crypto_ecdh(shared_secret, km->server_private_key, client_public_key) != 0) {
+    // ECDH 계산 (서버 비밀키는 이 핸드셰이크에서만 쓰고 지움)
+    int ret = crypto_ecdh(shared_secret, server_private_key, client_public_key);
+    sodium_memzero(server_private_key, sizeof(server_private_key));
+    if (ret != 0) {
         return -1;
     }
 
@@ -143,11 +338,15 @@ int perform_handshake(key_manager_t *km, uint32_t vpn_ip,
     }
     printf("...\n");
 
-    // 키 테이블에 추가
-    add_key(km, vpn_ip, session_key_out);
-    
     // 공유 비밀 제거
     sodium_memzero(shared_secret, 32);
     
+    // 키 테이블에 추가
+    *handle_out = add_key(km, vpn_ip, session_key_out, suite);
+    if (*handle_out == KEY_HANDLE_INVALID) {
+        return -1;
+    }
+    *suite_out = suite;
+    
     return 0;
 }
@@ -6,8 +6,68 @@
 #include <string.h>
 #include <arpa/inet.h>
 
+#define CLIENT_CHUNK_ALIGN 64
+
+// 타이머 콜백 컨텍스트
+typedef struct {
+    client_table_t *table;
+    client_probe_fn probe;
+    client_expired_fn expired;
+    void *arg;
+    int removed;
+} timer_ctx_t;
+
+// 거친 단조 시계 (초, vDSO라 시스템 콜 없음)
+static time_t coarse_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return ts.tv_sec;
+}
+
+// VPN IP 풀 해석
+int parse_client_pool(const char *cidr, uint32_t *network, int *prefix) {
+    char addr_str[INET_ADDRSTRLEN];
+    const char *slash = strchr(cidr, '/');
+    struct in_addr addr;
+    
+    if (!slash || (size_t)(slash - cidr) >= sizeof(addr_str)) {
+        fprintf(stderr, "❌ Invalid pool (expected a.b.c.d/N): %s\n", cidr);
+        return -1;
+    }
+    memcpy(addr_str, cidr, slash - cidr);
+    addr_str[slash - cidr] = '\0';
+    
+    char *end;
+    long bits = strtol(slash + 1, &end, 10);
+    if (inet_pton(AF_INET, addr_str, &addr) != 1 || *end != '\0' || end == slash + 1) {
+        fprintf(stderr, "❌ Invalid pool (expected a.b.c.d/N): %s\n", cidr);
+        return -1;
+    }
+    
+    if (bits < CLIENT_POOL_MIN_PREFIX || bits > CLIENT_POOL_MAX_PREFIX) {
+        fprintf(stderr, "❌ Pool prefix must be /%d../%d: %s\n",
+                CLIENT_POOL_MIN_PREFIX, CLIENT_POOL_MAX_PREFIX, cidr);
+        return -1;
+    }
+    
+    uint32_t host_mask = (1u << (32 - bits)) - 1;
+    if (ntohl(addr.s_addr) & host_mask) {
+        fprintf(stderr, "❌ Pool address has host bits set: %s\n", cidr);
+        return -1;
+    }
+    
+    *network = addr.s_addr;
+    *prefix = (int)bits;
+    return 0;
+}
+
+// 청크 디렉터리 크기 (/30 같은 작은 풀도 청크 1개)
+static inline uint32_t chunk_dir_size(const client_table_t *table) {
+    return (table->capacity + CLIENT_CHUNK_SIZE - 1) / CLIENT_CHUNK_SIZE;
+}
+
 // 클라이언트 테이블 생성
-client_table_t* init_client_table(void) {
+client_table_t* init_client_table(uint32_t network, int prefix) {
     client_table_t *table = (client_table_t*)malloc(sizeof(client_table_t));
     if (!table) {
         perror("malloc failed");
@@ -16,9 +76,49 @@ client_table_t* init_client_table(void) {
     
     memset(table, 0, sizeof(client_table_t));
     table->count = 0;
-    table->next_ip = 0x0a080002;  // 10.8.0.2 (호스트 바이트 오더)
+    table->base = ntohl(network);
+    table->prefix = prefix;
+    table->capacity = 1u << (32 - prefix);
+    table->now = coarse_now();
+    timer_wheel_init(&table->timers, (uint64_t)table->now);
     
-    printf("✅ Client table initialized (capacity: %d)\n", MAX_CLIENTS);
+    table->chunks = (client_chunk_t**)calloc(chunk_dir_size(table), sizeof(client_chunk_t*));
+    if (!table->chunks) {
+        perror("calloc client chunks");
+        free(table);
+        return NULL;
+    }
+    
+    // 네트워크 주소, 서버 TUN 주소, 브로드캐스트 주소는 미리 빼둠
+    if (id_bitmap_init(&table->ips, table->capacity) != 0) {
+        free(table->chunks);
+        free(table);
+        return NULL;
+    }
+    id_bitmap_take(&table->ips, 0);
+    id_bitmap_take(&table->ips, 1);
+    id_bitmap_take(&table->ips, table->capacity - 1);
+    
+    // 주소 인덱스는 청크가 늘 때 같이 키움
+    if (hash_index_init(&table->by_addr, CLIENT_CHUNK_SIZE) != 0) {
+        id_bitmap_destroy(&table->ips);
+        free(table->chunks);
+        free(table);
+        return NULL;
+    }
+    
+    if (pthread_rwlock_init(&table->lock, NULL) != 0) {
+        fprintf(stderr, "❌ Client table lock init failed\n");
+        hash_index_destroy(&table->by_addr);
+        id_bitmap_destroy(&table->ips);
+        free(table->chunks);
+        free(table);
+        return NULL;
+    }
+    
+    struct in_addr pool_addr = { .s_addr = network };
+    printf("✅ Client table initialized (pool: %s/%d, capacity: %u)\n",
+           inet_ntoa(pool_addr), prefix, client_pool_hosts(prefix));
     
     return table;
 }
@@ -27,131 +127,272 @@ client_table_t* init_client_table(void) {
 void destroy_client_table(client_table_t *table) {
     if (table) {
         printf("🧹 Destroying client table (%d active clients)\n", table->count);
+        pthread_rwlock_destroy(&table->lock);
+        hash_index_destroy(&table->by_addr);
+        id_bitmap_destroy(&table->ips);
+        for (uint32_t i = 0; i < chunk_dir_size(table); i++) {
+            free(table->chunks[i]);
+        }
+        free(table->chunks);
         free(table);
     }
 }
 
+// 슬롯 → 엔트리 (청크가 없으면 NULL, lock은 호출자가 보유)
+static inline client_entry_t* slot_entry(const client_table_t *table, uint32_t slot) {
+    client_chunk_t *chunk = table->chunks[slot >> CLIENT_CHUNK_BITS];
+    return chunk ? &chunk->clients[slot & (CLIENT_CHUNK_SIZE - 1)] : NULL;
+}
+
+// 슬롯 → 부가 정보 (청크가 있는 슬롯만)
+static inline client_info_t* slot_info(const client_table_t *table, uint32_t slot) {
+    return &table->chunks[slot >> CLIENT_CHUNK_BITS]->info[slot & (CLIENT_CHUNK_SIZE - 1)];
+}
+
+// 슬롯이 들어갈 청크 준비 (lock은 호출자가 보유)
+// 반환값: 0 (성공), -1 (메모리 부족)
+static int ensure_chunk(client_table_t *table, uint32_t slot) {
+    uint32_t c = slot >> CLIENT_CHUNK_BITS;
+    
+    if (table->chunks[c]) {
+        return 0;
+    }
+    
+    // 주소 인덱스가 부하율을 넘지 않도록 먼저 키움
+    if (hash_index_reserve(&table->by_addr, (table->chunk_count + 1) * CLIENT_CHUNK_SIZE) != 0) {
+        return -1;
+    }
+    
+    void *mem = NULL;
+    if (posix_memalign(&mem, CLIENT_CHUNK_ALIGN, sizeof(client_chunk_t)) != 0) {
+        perror("posix_memalign client chunk");
+        return -1;
+    }
+    memset(mem, 0, sizeof(client_chunk_t));
+    
+    table->chunks[c] = (client_chunk_t*)mem;
+    table->chunk_count++;
+    return 0;
+}
+
 // 세션 ID 생성 (간단한 랜덤)
 uint32_t generate_session_id(void) {
     return (uint32_t)time(NULL) ^ (uint32_t)rand();
 }
 
-// 클라이언트 추가
-uint32_t add_client(client_table_t *table, struct sockaddr_in *addr) {
-    if (table->count >= MAX_CLIENTS) {
-        fprintf(stderr, "❌ Client table full!\n");
-        return 0;
+// 주소 인덱스 키: IP(32비트) | 포트(16비트)
+static inline uint64_t addr_key(const struct sockaddr_in *addr) {
+    return ((uint64_t)addr->sin_addr.s_addr << 16) | addr->sin_port;
+}
+
+// VPN IP로 찾기 (슬롯 = 풀 오프셋, lock은 호출자가 보유)
+static client_entry_t* lookup_by_vpn_ip(client_table_t *table, uint32_t vpn_ip) {
+    uint32_t slot = ntohl(vpn_ip) - table->base;
+    
+    if (slot >= table->capacity) {
+        return NULL;
     }
     
+    client_entry_t *client = slot_entry(table, slot);
+    return (client && client->active) ? client : NULL;
+}
+
+// 실제 주소로 찾기 (lock은 호출자가 보유)
+static client_entry_t* lookup_by_addr(client_table_t *table, const struct sockaddr_in *addr) {
+    int32_t slot = hash_index_get(&table->by_addr, addr_key(addr));
+    return (slot == HASH_INDEX_EMPTY) ? NULL : slot_entry(table, (uint32_t)slot);
+}
+
+// 슬롯 비활성화 + 인덱스/주소 반납 (lock은 호출자가 보유)
+static void release_slot(client_table_t *table, client_entry_t *client) {
+    int slot = client_slot(table, client);
+    
+    client_info_t *info = slot_info(table, (uint32_t)slot);
+    
+    timer_wheel_cancel(&table->timers, &info->expiry);
+    timer_wheel_cancel(&table->timers, &info->probe);
+    hash_index_remove(&table->by_addr, addr_key(&client->real_addr));
+    id_bitmap_release(&table->ips, (uint32_t)slot);
+    client->active = 0;
+    table->count--;
+    
+    if (table->stats) {
+        server_stats_client_down(table->stats, slot);
+    }
+}
+
+// 클라이언트 추가 (lock은 호출자가 보유)
+static uint32_t add_client_locked(client_table_t *table, struct sockaddr_in *addr) {
     // 이미 존재하는 클라이언트인지 확인
-    client_entry_t *existing = find_client_by_addr(table, addr);
+    client_entry_t *existing = lookup_by_addr(table, addr);
     if (existing) {
         printf("⚠️  Client already exists, updating activity\n");
-        update_client_activity(existing);
+        update_client_activity(table, existing);
         return existing->vpn_ip;
     }
     
-    // VPN IP 할당 (10.8.0.2 ~ 10.8.0.255)
-    uint32_t vpn_ip_host = table->next_ip;
-    
-    // 255를 넘으면 2부터 다시 시작
-    if (vpn_ip_host > 0x0a0800ff) {
-        vpn_ip_host = 0x0a080002;
-    }
-    
-    uint32_t vpn_ip = htonl(vpn_ip_host);
-    
-    // 빈 슬롯 찾기
-    int index = -1;
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (!table->clients[i].active) {
-            index = i;
-            break;
-        }
+    // VPN IP 할당 (풀에서 가장 작은 빈 주소, 슬롯 번호도 같음)
+    int32_t index = id_bitmap_alloc(&table->ips);
+    if (index < 0) {
+        fprintf(stderr, "❌ Client table full! (pool /%d)\n", table->prefix);
+        return 0;
     }
     
-    if (index == -1) {
-        fprintf(stderr, "❌ No available slot!\n");
+    if (ensure_chunk(table, (uint32_t)index) != 0) {
+        id_bitmap_release(&table->ips, (uint32_t)index);
         return 0;
     }
     
+    uint32_t vpn_ip = htonl(table->base + (uint32_t)index);
+    
     // 클라이언트 정보 저장
-    client_entry_t *client = &table->clients[index];
+    client_entry_t *client = slot_entry(table, (uint32_t)index);
     client->vpn_ip = vpn_ip;
     client->real_addr = *addr;
-    client->last_seen = time(NULL);
-    client->session_id = generate_session_id();
+    client->last_seen = table->now;
+    client->key_handle = KEY_HANDLE_INVALID;
     client->active = 1;
     
+    client_info_t *info = slot_info(table, (uint32_t)index);
+    info->session_id = generate_session_id();
+    info->connected_at = time(NULL);
+    
+    timer_node_init(&info->expiry, (uint32_t)index);
+    timer_node_init(&info->probe, (uint32_t)index);
+    timer_wheel_arm(&table->timers, &info->expiry, (uint64_t)(table->now + CLIENT_TIMEOUT + 1));
+    timer_wheel_arm(&table->timers, &info->probe, (uint64_t)(table->now + STATS_RTT_PROBE_SEC));
+    
+    hash_index_put(&table->by_addr, addr_key(addr), index);
+    
+    if (table->stats) {
+        server_stats_client_up(table->stats, index, vpn_ip, addr,
+                               info->session_id, info->connected_at);
+    }
+    
     table->count++;
-    table->next_ip = vpn_ip_host + 1;
     
     printf("➕ Client added:\n");
-    print_client_info(client);
+    print_client_info(table, client);
     
     return vpn_ip;
 }
 
+// 클라이언트 추가
+uint32_t add_client(client_table_t *table, struct sockaddr_in *addr) {
+    pthread_rwlock_wrlock(&table->lock);
+    uint32_t vpn_ip = add_client_locked(table, addr);
+    pthread_rwlock_unlock(&table->lock);
+    return vpn_ip;
+}
+    
 // VPN IP로 클라이언트 찾기
 client_entry_t* find_client_by_vpn_ip(client_table_t *table, uint32_t vpn_ip) {
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (table->clients[i].active && table->clients[i].vpn_ip == vpn_ip) {
-            return &table->clients[i];
-        }
-    }
-    return NULL;
+    pthread_rwlock_rdlock(&table->lock);
+    client_entry_t *client = lookup_by_vpn_ip(table, vpn_ip);
+    pthread_rwlock_unlock(&table->lock);
+    return client;
 }
 
 // 실제 주소로 클라이언트 찾기
 client_entry_t* find_client_by_addr(client_table_t *table, struct sockaddr_in *addr) {
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (table->clients[i].active &&
-            table->clients[i].real_addr.sin_addr.s_addr == addr->sin_addr.s_addr &&
-            table->clients[i].real_addr.sin_port == addr->sin_port) {
-            return &table->clients[i];
-        }
+    pthread_rwlock_rdlock(&table->lock);
+    client_entry_t *client = lookup_by_addr(table, addr);
+    pthread_rwlock_unlock(&table->lock);
+    return client;
+}
+
+// VPN IP로 경로 복사
+int client_table_route(client_table_t *table, uint32_t vpn_ip, client_route_t *route) {
+    pthread_rwlock_rdlock(&table->lock);
+    client_entry_t *client = lookup_by_vpn_ip(table, vpn_ip);
+    if (client) {
+        client_route_fill(table, client, route);
     }
-    return NULL;
+    pthread_rwlock_unlock(&table->lock);
+    return client ? 0 : -1;
 }
 
 // 클라이언트 제거
 void remove_client(client_table_t *table, uint32_t vpn_ip) {
-    client_entry_t *client = find_client_by_vpn_ip(table, vpn_ip);
+    pthread_rwlock_wrlock(&table->lock);
+    client_entry_t *client = lookup_by_vpn_ip(table, vpn_ip);
     if (client) {
         printf("➖ Client removed:\n");
-        print_client_info(client);
+        print_client_info(table, client);
         
-        client->active = 0;
-        table->count--;
+        release_slot(table, client);
     }
+    pthread_rwlock_unlock(&table->lock);
+}
+
+// 테이블 시계 갱신
+void client_table_tick(client_table_t *table) {
+    __atomic_store_n(&table->now, coarse_now(), __ATOMIC_RELAXED);
 }
 
-// 타임아웃된 클라이언트 제거
-void check_client_timeouts(client_table_t *table) {
-    time_t now = time(NULL);
+// 타이머 만료 처리 (걸린 클라이언트는 모두 활성 상태)
+static void on_client_timer(timer_node_t *node, void *arg) {
+    timer_ctx_t *ctx = (timer_ctx_t*)arg;
+    client_table_t *table = ctx->table;
+    client_entry_t *client = slot_entry(table, node->id);
+    client_info_t *info = slot_info(table, node->id);
     
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (table->clients[i].active) {
-            if (now - table->clients[i].last_seen > CLIENT_TIMEOUT) {
-                struct in_addr vpn_addr;
-                vpn_addr.s_addr = table->clients[i].vpn_ip;
-                
-                printf("⏱️  Client timeout: %s\n", inet_ntoa(vpn_addr));
-                
-                table->clients[i].active = 0;
-                table->count--;
-            }
+    if (node == &info->probe) {
+        timer_wheel_arm(&table->timers, node, (uint64_t)(table->now + STATS_RTT_PROBE_SEC));
+        if (ctx->probe) {
+            ctx->probe(client, ctx->arg);
         }
+        return;
+    }
+    
+    // 그 사이 통신이 있었으면 마지막 통신 기준으로 다시 걸기
+    time_t deadline = __atomic_load_n(&client->last_seen, __ATOMIC_RELAXED) + CLIENT_TIMEOUT + 1;
+    if (deadline > table->now) {
+        timer_wheel_arm(&table->timers, node, (uint64_t)deadline);
+        return;
+    }
+    
+    uint32_t vpn_ip = client->vpn_ip;
+    struct in_addr vpn_addr = { .s_addr = vpn_ip };
+    printf("⏱️  Client timeout: %s\n", inet_ntoa(vpn_addr));
+    
+    pthread_rwlock_wrlock(&table->lock);
+    release_slot(table, client);
+    pthread_rwlock_unlock(&table->lock);
+                
+    ctx->removed++;
+    if (ctx->expired) {
+        ctx->expired(vpn_ip, ctx->arg);
     }
 }
 
-// 클라이언트 활동 갱신
-void update_client_activity(client_entry_t *client) {
-    client->last_seen = time(NULL);
+// 클라이언트 타이머 진행
+int run_client_timers(client_table_t *table, client_probe_fn probe,
+                      client_expired_fn expired, void *arg) {
+    timer_ctx_t ctx = {
+        .table = table,
+        .probe = probe,
+        .expired = expired,
+        .arg = arg,
+        .removed = 0,
+    };
+
+    timer_wheel_advance(&table->timers, (uint64_t)table->now, on_client_timer, &ctx);
+    return ctx.removed;
+}
+
+// 클라이언트 부가 정보
+client_info_t* get_client_info(client_table_t *table, const client_entry_t *client) {
+    return slot_info(table, (uint32_t)client_slot(table, client));
+}
+
+// 세션키 핸들 설정
+void set_client_key_handle(client_entry_t *client, key_handle_t key_handle) {
+    __atomic_store_n(&client->key_handle, key_handle, __ATOMIC_RELEASE);
 }
 
 // 클라이언트 정보 출력
-void print_client_info(const client_entry_t *client) {
+void print_client_info(const client_table_t *table, const client_entry_t *client) {
     struct in_addr vpn_addr, real_addr;
     vpn_addr.s_addr = client->vpn_ip;
     real_addr = client->real_addr.sin_addr;
@@ -160,15 +401,15 @@ void print_client_info(const client_entry_t *client) {
     printf("   Real Addr:  %s:%d\n", 
            inet_ntoa(real_addr), 
            ntohs(client->real_addr.sin_port));
-    printf("   Session ID: %u\n", client->session_id);
+    printf("   Session ID: %u\n", slot_info(table, (uint32_t)client_slot(table, client))->session_id);
     printf("   Last Seen:  %ld seconds ago\n", 
-           time(NULL) - client->last_seen);
+           (long)(table->now - client->last_seen));
 }
 
 // 클라이언트 테이블 출력
 void print_client_table(const client_table_t *table) {
     printf("\n━━━ Client Table ━━━\n");
-    printf("Active Clients: %d / %d\n", table->count, MAX_CLIENTS);
+    printf("Active Clients: %d / %u\n", table->count, client_pool_hosts(table->prefix));
     
     if (table->count == 0) {
         printf("(No active clients)\n");
@@ -176,10 +417,15 @@ void print_client_table(const client_table_t *table) {
     }
     
     printf("\n");
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (table->clients[i].active) {
-            printf("Client #%d:\n", i);
-            print_client_info(&table->clients[i]);
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        const client_entry_t *client = slot_entry(table, i);
+        if (!client) {
+            i |= CLIENT_CHUNK_SIZE - 1;   // 빈 청크 건너뛰기
+            continue;
+        }
+        if (client->active) {
+            printf("Client #%u:\n", i);
+            print_client_info(table, client);
             printf("\n");
         }
     }
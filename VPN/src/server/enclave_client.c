@@ -2,9 +2,13 @@
 
 #include "enclave_client.h"
 #include "ipc_protocol.h"
+#include "shm_ring.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -16,7 +20,7 @@ int enclave_connect(void) {
     struct sockaddr_un addr;
     
     // 소켓 생성
-    sock_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sock_fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
     if (sock_fd < 0) {
         perror("socket");
         return -1;
@@ -47,36 +51,37 @@ void enclave_disconnect(int enclave_fd) {
     }
 }
 
-// IPC 요청 전송 및 응답 수신 (내부 함수)
-static int send_ipc_request(int enclave_fd, const ipc_request_t *req,
-                            size_t req_len, ipc_response_t *resp,
-                            size_t resp_max_len) {
-    // 요청 전송
-    ssize_t sent = send(enclave_fd, req, req_len, 0);
+// IPC 요청 전송 및 응답 수신 (내부 함수, fd 첨부 가능)
+// req: 헤더 (data_len 설정됨), data: 헤더 뒤에 붙일 데이터 (NULL 가능)
+// SOCK_SEQPACKET이므로 요청 sendmsg 1회, 응답 recvmsg 1회
+static int send_ipc_request_fds(int enclave_fd, const ipc_request_t *req,
+                                const void *data, const int *fds, int fd_count,
+                                ipc_response_t *resp, size_t resp_max_len) {
+    // 요청 전송 (헤더 + 데이터를 복사 없이 한 메시지로)
+    size_t req_len = sizeof(ipc_request_t) + ntohs(req->data_len);
+    ssize_t sent = ipc_send_msg(enclave_fd, req, sizeof(ipc_request_t),
+                                data, ntohs(req->data_len), fds, fd_count);
     if (sent != (ssize_t)req_len) {
         perror("send to enclave");
         return -1;
     }
     
-    // 응답 수신 (헤더 먼저)
-    ssize_t n = recv(enclave_fd, resp, sizeof(ipc_response_t), MSG_PEEK);
-    if (n < (ssize_t)sizeof(ipc_response_t)) {
-        perror("recv from enclave (header)");
+    // 응답 수신 (메시지 1개)
+    ssize_t n = ipc_recv_fds(enclave_fd, resp, resp_max_len, NULL, NULL);
+    if (n < 0) {
+        perror("recv from enclave");
         return -1;
     }
-    
-    // 전체 응답 수신
-    uint16_t data_len = ntohs(resp->data_len);
-    size_t total_len = sizeof(ipc_response_t) + data_len;
-    
-    if (total_len > resp_max_len) {
-        fprintf(stderr, "Response too large: %zu > %zu\n", total_len, resp_max_len);
+    if (n < (ssize_t)sizeof(ipc_response_t) ||
+        n != (ssize_t)(sizeof(ipc_response_t) + ntohs(resp->data_len))) {
+        fprintf(stderr, "❌ Malformed Enclave response (%zd bytes)\n", n);
         return -1;
     }
     
-    n = recv(enclave_fd, resp, total_len, 0);
-    if (n != (ssize_t)total_len) {
-        perror("recv from enclave (full)");
+    // 한 번에 요청 하나이므로 응답은 방금 보낸 요청의 것이어야 함
+    if (resp->request_id != req->request_id) {
+        fprintf(stderr, "❌ Enclave response ID mismatch: %u != %u\n",
+                ntohl(resp->request_id), ntohl(req->request_id));
         return -1;
     }
     
@@ -89,17 +94,24 @@ static int send_ipc_request(int enclave_fd, const ipc_request_t *req,
     return 0;
 }
 
+// IPC 요청 전송 및 응답 수신 (내부 함수)
+static int send_ipc_request(int enclave_fd, const ipc_request_t *req,
+                            const void *data, ipc_response_t *resp,
+                            size_t resp_max_len) {
+    return send_ipc_request_fds(enclave_fd, req, data, NULL, 0,
+                                resp, resp_max_len);
+}
+
 // PING
 int enclave_ping(int enclave_fd) {
-    uint8_t req_buffer[sizeof(ipc_request_t)];
+    ipc_request_t req;
     uint8_t resp_buffer[sizeof(ipc_response_t)];
     
-    ipc_request_t *req = (ipc_request_t*)req_buffer;
     ipc_response_t *resp = (ipc_response_t*)resp_buffer;
     
-    init_ipc_request(req, IPC_PING, 0, NULL, 0);
+    init_ipc_request(&req, IPC_PING, 0, NULL, 0);
     
-    if (send_ipc_request(enclave_fd, req, sizeof(ipc_request_t),
+    if (send_ipc_request(enclave_fd, &req, NULL,
                         resp, sizeof(resp_buffer)) != 0) {
         return -1;
     }
@@ -109,26 +121,33 @@ int enclave_ping(int enclave_fd) {
 }
 
 // 키 추가
-int enclave_add_key(int enclave_fd, uint32_t vpn_ip, const uint8_t *session_key) {
-    uint8_t req_buffer[sizeof(ipc_request_t) + sizeof(ipc_add_key_data_t)];
-    uint8_t resp_buffer[sizeof(ipc_response_t)];
+int enclave_add_key(int enclave_fd, uint32_t vpn_ip, const uint8_t *session_key,
+                    uint8_t cipher_suite, key_handle_t *key_handle) {
+    ipc_request_t req;
+    uint8_t resp_buffer[sizeof(ipc_response_t) + sizeof(ipc_key_handle_data_t)];
     
-    ipc_request_t *req = (ipc_request_t*)req_buffer;
     ipc_response_t *resp = (ipc_response_t*)resp_buffer;
     
     ipc_add_key_data_t key_data;
     memcpy(key_data.session_key, session_key, 32);
+    key_data.cipher_suite = cipher_suite;
     
-    init_ipc_request(req, IPC_ADD_KEY, vpn_ip,
-                    (uint8_t*)&key_data, sizeof(key_data));
+    init_ipc_request(&req, IPC_ADD_KEY, vpn_ip, NULL, sizeof(key_data));
     
-    size_t req_len = sizeof(ipc_request_t) + sizeof(ipc_add_key_data_t);
-    
-    if (send_ipc_request(enclave_fd, req, req_len,
+    if (send_ipc_request(enclave_fd, &req, &key_data,
                         resp, sizeof(resp_buffer)) != 0) {
         return -1;
     }
     
+    if (ntohs(resp->data_len) != sizeof(ipc_key_handle_data_t)) {
+        fprintf(stderr, "❌ Invalid ADD_KEY response\n");
+        return -1;
+    }
+    
+    if (key_handle) {
+        *key_handle = ntohl(((ipc_key_handle_data_t*)resp->data)->key_handle);
+    }
+    
     struct in_addr addr;
     addr.s_addr = vpn_ip;
     printf("🔑 Key added to Enclave for %s\n", inet_ntoa(addr));
@@ -138,15 +157,14 @@ int enclave_add_key(int enclave_fd, uint32_t vpn_ip, const uint8_t *session_key)
 
 // 키 제거
 int enclave_remove_key(int enclave_fd, uint32_t vpn_ip) {
-    uint8_t req_buffer[sizeof(ipc_request_t)];
+    ipc_request_t req;
     uint8_t resp_buffer[sizeof(ipc_response_t)];
     
-    ipc_request_t *req = (ipc_request_t*)req_buffer;
     ipc_response_t *resp = (ipc_response_t*)resp_buffer;
     
-    init_ipc_request(req, IPC_REMOVE_KEY, vpn_ip, NULL, 0);
+    init_ipc_request(&req, IPC_REMOVE_KEY, vpn_ip, NULL, 0);
     
-    if (send_ipc_request(enclave_fd, req, sizeof(ipc_request_t),
+    if (send_ipc_request(enclave_fd, &req, NULL,
                         resp, sizeof(resp_buffer)) != 0) {
         return -1;
     }
@@ -161,23 +179,23 @@ int enclave_remove_key(int enclave_fd, uint32_t vpn_ip) {
 // ECDH 핸드셰이크
 int enclave_handshake(int enclave_fd, uint32_t vpn_ip,
                       const uint8_t *client_public_key,
+                      uint8_t offered_suites,
                       uint8_t *server_public_key,
-                      uint8_t *session_key) {
-    uint8_t req_buffer[sizeof(ipc_request_t) + sizeof(ipc_handshake_data_t)];
+                      uint8_t *session_key,
+                      uint8_t *cipher_suite,
+                      key_handle_t *key_handle) {
+    ipc_request_t req;
     uint8_t resp_buffer[sizeof(ipc_response_t) + sizeof(ipc_handshake_response_t)];
     
-    ipc_request_t *req = (ipc_request_t*)req_buffer;
     ipc_response_t *resp = (ipc_response_t*)resp_buffer;
     
     ipc_handshake_data_t hs_data;
     memcpy(hs_data.client_public_key, client_public_key, 32);
+    hs_data.cipher_suites = offered_suites;
     
-    init_ipc_request(req, IPC_HANDSHAKE, vpn_ip,
-                    (uint8_t*)&hs_data, sizeof(hs_data));
+    init_ipc_request(&req, IPC_HANDSHAKE, vpn_ip, NULL, sizeof(hs_data));
     
-    size_t req_len = sizeof(ipc_request_t) + sizeof(ipc_handshake_data_t);
-    
-    if (send_ipc_request(enclave_fd, req, req_len,
+    if (send_ipc_request(enclave_fd, &req, &hs_data,
                         resp, sizeof(resp_buffer)) != 0) {
         return -1;
     }
@@ -187,6 +205,10 @@ int enclave_handshake(int enclave_fd, uint32_t vpn_ip,
     
     memcpy(server_public_key, hs_resp->server_public_key, 32);
     memcpy(session_key, hs_resp->session_key, 32);
+    *cipher_suite = hs_resp->cipher_suite;
+    if (key_handle) {
+        *key_handle = ntohl(hs_resp->key_handle);
+    }
     
     struct in_addr addr;
     addr.s_addr = vpn_ip;
@@ -199,7 +221,7 @@ int enclave_handshake(int enclave_fd, uint32_t vpn_ip,
 int enclave_encrypt(int enclave_fd, uint32_t vpn_ip,
                     const uint8_t *plaintext, size_t plaintext_len,
                     uint8_t *ciphertext, size_t *ciphertext_len) {
-    uint8_t req_buffer[sizeof(ipc_request_t) + IPC_MAX_DATA_SIZE];
+    ipc_request_t req;
     uint8_t resp_buffer[sizeof(ipc_response_t) + IPC_MAX_DATA_SIZE];
     
     if (plaintext_len > IPC_MAX_DATA_SIZE) {
@@ -207,14 +229,11 @@ int enclave_encrypt(int enclave_fd, uint32_t vpn_ip,
         return -1;
     }
     
-    ipc_request_t *req = (ipc_request_t*)req_buffer;
     ipc_response_t *resp = (ipc_response_t*)resp_buffer;
     
-    init_ipc_request(req, IPC_ENCRYPT, vpn_ip, plaintext, plaintext_len);
-    
-    size_t req_len = sizeof(ipc_request_t) + plaintext_len;
+    init_ipc_request(&req, IPC_ENCRYPT, vpn_ip, NULL, plaintext_len);
     
-    if (send_ipc_request(enclave_fd, req, req_len,
+    if (send_ipc_request(enclave_fd, &req, plaintext,
                         resp, sizeof(resp_buffer)) != 0) {
         return -1;
     }
@@ -230,7 +249,7 @@ int enclave_encrypt(int enclave_fd, uint32_t vpn_ip,
 int enclave_decrypt(int enclave_fd, uint32_t vpn_ip,
                     const uint8_t *ciphertext, size_t ciphertext_len,
                     uint8_t *plaintext, size_t *plaintext_len) {
-    uint8_t req_buffer[sizeof(ipc_request_t) + IPC_MAX_DATA_SIZE];
+    ipc_request_t req;
     uint8_t resp_buffer[sizeof(ipc_response_t) + IPC_MAX_DATA_SIZE];
     
     if (ciphertext_len > IPC_MAX_DATA_SIZE) {
@@ -238,14 +257,11 @@ int enclave_decrypt(int enclave_fd, uint32_t vpn_ip,
         return -1;
     }
     
-    ipc_request_t *req = (ipc_request_t*)req_buffer;
     ipc_response_t *resp = (ipc_response_t*)resp_buffer;
     
-    init_ipc_request(req, IPC_DECRYPT, vpn_ip, ciphertext, ciphertext_len);
+    init_ipc_request(&req, IPC_DECRYPT, vpn_ip, NULL, ciphertext_len);
     
-    size_t req_len = sizeof(ipc_request_t) + ciphertext_len;
-    
-    if (send_ipc_request(enclave_fd, req, req_len,
+    if (send_ipc_request(enclave_fd, &req, ciphertext,
                         resp, sizeof(resp_buffer)) != 0) {
         return -1;
     }
@@ -259,15 +275,14 @@ int enclave_decrypt(int enclave_fd, uint32_t vpn_ip,
 
 // Enclave 종료
 int enclave_shutdown(int enclave_fd) {
-    uint8_t req_buffer[sizeof(ipc_request_t)];
+    ipc_request_t req;
     uint8_t resp_buffer[sizeof(ipc_response_t)];
     
-    ipc_request_t *req = (ipc_request_t*)req_buffer;
     ipc_response_t *resp = (ipc_response_t*)resp_buffer;
     
-    init_ipc_request(req, IPC_SHUTDOWN, 0, NULL, 0);
+    init_ipc_request(&req, IPC_SHUTDOWN, 0, NULL, 0);
     
-    if (send_ipc_request(enclave_fd, req, sizeof(ipc_request_t),
+    if (send_ipc_request(enclave_fd, &req, NULL,
                         resp, sizeof(resp_buffer)) != 0) {
         return -1;
     }
@@ -276,3 +291,633 @@ int enclave_shutdown(int enclave_fd) {
     
     return 0;
 }
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 배치 암호화/복호화 (소켓)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 배치 요청/응답 버퍼 (64KB씩이라 스택 대신 호출마다 할당)
+#define BATCH_REQ_BUFFER_SIZE (sizeof(ipc_request_t) + IPC_MAX_BATCH_DATA)
+#define BATCH_RESP_BUFFER_SIZE (sizeof(ipc_response_t) + IPC_MAX_BATCH_DATA)
+
+// 엔트리 1개가 요청/응답에서 차지하는 최대 크기
+static size_t batch_entry_size(uint8_t command, const enclave_batch_entry_t *entry) {
+    size_t overhead = (command == IPC_ENCRYPT_BATCH) ? IPC_CRYPTO_OVERHEAD : 0;
+    return sizeof(ipc_batch_entry_t) + entry->input_len + overhead;
+}
+
+// 엔트리 출력 버퍼에 써도 되는 최대 길이 (헤더에 적힌 호출자 계약)
+static size_t batch_output_max(uint8_t command, const enclave_batch_entry_t *entry) {
+    size_t overhead = (command == IPC_ENCRYPT_BATCH) ? IPC_CRYPTO_OVERHEAD : 0;
+    return entry->input_len + overhead;
+}
+
+// 배치 1회 IPC (entries 전체가 IPC_MAX_BATCH_DATA 안에, IPC_MAX_BATCH개 이하)
+static int send_batch_chunk(int enclave_fd, uint8_t command,
+                            enclave_batch_entry_t *entries, int count,
+                            ipc_request_t *req, ipc_response_t *resp) {
+    
+    // 요청 조립: 헤더 + 엔트리들
+    ipc_batch_header_t *hdr = (ipc_batch_header_t*)req->data;
+    hdr->count = htons(count);
+    size_t offset = sizeof(ipc_batch_header_t);
+    
+    for (int i = 0; i < count; i++) {
+        ipc_batch_entry_t *e = (ipc_batch_entry_t*)(req->data + offset);
+        e->vpn_ip = entries[i].vpn_ip;
+        e->key_handle = htonl(entries[i].key_handle);
+        e->status = 0;
+        e->data_len = htons(entries[i].input_len);
+        memcpy(e->data, entries[i].input, entries[i].input_len);
+        offset += sizeof(ipc_batch_entry_t) + entries[i].input_len;
+    }
+    
+    init_ipc_request(req, command, 0, NULL, offset);
+    
+    if (send_ipc_request(enclave_fd, req, req->data,
+                        resp, BATCH_RESP_BUFFER_SIZE) != 0) {
+        return -1;
+    }
+    
+    // 응답 분해
+    size_t resp_len = ntohs(resp->data_len);
+    if (resp_len < sizeof(ipc_batch_header_t) ||
+        ntohs(((ipc_batch_header_t*)resp->data)->count) != count) {
+        fprintf(stderr, "❌ Invalid batch response\n");
+        return -1;
+    }
+    
+    int ok = 0;
+    offset = sizeof(ipc_batch_header_t);
+    
+    for (int i = 0; i < count; i++) {
+        if (offset + sizeof(ipc_batch_entry_t) > resp_len) {
+            return -1;
+        }
+        ipc_batch_entry_t *e = (ipc_batch_entry_t*)(resp->data + offset);
+        size_t len = ntohs(e->data_len);
+        if (offset + sizeof(ipc_batch_entry_t) + len > resp_len) {
+            return -1;
+        }
+        
+        entries[i].status = e->status;
+        entries[i].output_len = 0;
+        
+        // 요청과 어긋난 응답이 호출자 버퍼를 넘치게 하지 않도록 엔트리만 거부
+        if (e->status == 0 && len > batch_output_max(command, &entries[i])) {
+            fprintf(stderr, "❌ Batch entry %d: output %zu bytes exceeds buffer\n", i, len);
+            entries[i].status = -1;
+        }
+        if (entries[i].status == 0) {
+            memcpy(entries[i].output, e->data, len);
+            entries[i].output_len = len;
+            ok++;
+        }
+        
+        offset += sizeof(ipc_batch_entry_t) + len;
+    }
+    
+    return ok;
+}
+
+// 배치 처리 (IPC_MAX_BATCH개 / IPC_MAX_BATCH_DATA 단위로 분할 전송)
+static int send_batch(int enclave_fd, uint8_t command,
+                      enclave_batch_entry_t *entries, int count) {
+    ipc_request_t *req = (ipc_request_t*)malloc(BATCH_REQ_BUFFER_SIZE);
+    ipc_response_t *resp = (ipc_response_t*)malloc(BATCH_RESP_BUFFER_SIZE);
+    int ok = 0;
+    int start = 0;
+    
+    if (!req || !resp) {
+        perror("malloc batch buffer");
+        free(req);
+        free(resp);
+        return -1;
+    }
+    
+    while (start < count) {
+        size_t used = sizeof(ipc_batch_header_t);
+        int n = 0;
+        
+        while (start + n < count && n < IPC_MAX_BATCH) {
+            size_t size = batch_entry_size(command, &entries[start + n]);
+            if (used + size > IPC_MAX_BATCH_DATA) {
+                break;
+            }
+            used += size;
+            n++;
+        }
+        
+        if (n == 0) {
+            // 단일 엔트리가 너무 큼
+            entries[start].status = -1;
+            entries[start].output_len = 0;
+            start++;
+            continue;
+        }
+        
+        int ret = send_batch_chunk(enclave_fd, command, &entries[start], n, req, resp);
+        if (ret < 0) {
+            ok = -1;
+            break;
+        }
+        
+        ok += ret;
+        start += n;
+    }
+    
+    free(req);
+    free(resp);
+    return ok;
+}
+
+// 배치 암호화
+int enclave_encrypt_batch(int enclave_fd, enclave_batch_entry_t *entries, int count) {
+    return send_batch(enclave_fd, IPC_ENCRYPT_BATCH, entries, count);
+}
+
+// 배치 복호화
+int enclave_decrypt_batch(int enclave_fd, enclave_batch_entry_t *entries, int count) {
+    return send_batch(enclave_fd, IPC_DECRYPT_BATCH, entries, count);
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 공유 메모리 링
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+struct enclave_ring {
+    shm_ring_t ring;
+    uint32_t next_request_id;
+};
+
+// 링 생성 + 등록
+enclave_ring_t* enclave_ring_attach(int enclave_fd) {
+    enclave_ring_t *er = (enclave_ring_t*)malloc(sizeof(enclave_ring_t));
+    if (!er) {
+        perror("malloc");
+        return NULL;
+    }
+    memset(er, 0, sizeof(*er));
+    
+    if (shm_ring_create(&er->ring) != 0) {
+        free(er);
+        return NULL;
+    }
+    
+    ipc_request_t req;
+    uint8_t resp_buffer[sizeof(ipc_response_t)];
+    
+    ipc_response_t *resp = (ipc_response_t*)resp_buffer;
+    
+    init_ipc_request(&req, IPC_RING_SETUP, 0, NULL, 0);
+    
+    int fds[IPC_RING_FD_COUNT] = {
+        er->ring.mem_fd, er->ring.sq_event_fd, er->ring.cq_event_fd
+    };
+    
+    if (send_ipc_request_fds(enclave_fd, &req, NULL,
+                             fds, IPC_RING_FD_COUNT,
+                             resp, sizeof(resp_buffer)) != 0) {
+        shm_ring_destroy(&er->ring);
+        free(er);
+        return NULL;
+    }
+    
+    printf("🔁 Enclave ring attached (%d slots)\n", SHM_RING_ENTRIES);
+    
+    return er;
+}
+
+// 링 해제
+void enclave_ring_detach(enclave_ring_t *ring) {
+    if (ring) {
+        shm_ring_destroy(&ring->ring);
+        free(ring);
+    }
+}
+
+// 이전 요청이 timeout으로 남아있으면 먼저 정리
+static int ring_drain(enclave_ring_t *er) {
+    shm_ring_t *ring = &er->ring;
+    uint32_t in_flight = shm_ring_in_flight(ring);
+    
+    if (in_flight > 0) {
+        if (shm_ring_wait(ring, shm_ring_tail(ring)) != 0) {
+            return -1;
+        }
+        shm_ring_release(ring, in_flight);
+    }
+    return 0;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 제로카피 링 (슬롯 = 패킷 버퍼)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 다음에 제출될 슬롯들을 패킷 버퍼로 빌려줌
+int enclave_ring_reserve(enclave_ring_t *er, enclave_ring_packet_t *pkts,
+                         int count, size_t headroom) {
+    shm_ring_t *ring = &er->ring;
+    
+    if (ring_drain(er) != 0) {
+        return -1;
+    }
+    
+    uint32_t n = count;
+    if (n > shm_ring_free_slots(ring)) {
+        n = shm_ring_free_slots(ring);
+    }
+    
+    for (uint32_t i = 0; i < n; i++) {
+        shm_ring_slot_t *slot = shm_ring_next_slot(ring, i);
+        
+        pkt_buf_init(&pkts[i].pkt, slot->data, SHM_RING_SLOT_SIZE, headroom);
+        pkts[i].command = 0;
+        pkts[i].vpn_ip = 0;
+        pkts[i].key_handle = KEY_HANDLE_INVALID;
+        pkts[i].status = -1;
+    }
+    
+    return n;
+}
+
+// 예약 순서대로 앞에서 count개 제출 → 완료 대기 → 결과를 pkt에 반영
+int enclave_ring_process(enclave_ring_t *er, enclave_ring_packet_t *pkts, int count) {
+    shm_ring_t *ring = &er->ring;
+    int ok = 0;
+    
+    if (count <= 0) {
+        return 0;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        enclave_ring_packet_t *p = &pkts[i];
+        shm_ring_slot_t *slot = shm_ring_next_slot(ring, i);
+        
+        // 예약한 슬롯이 아니면 순서가 어긋난 것
+        if (p->pkt.head != slot->data) {
+            fprintf(stderr, "❌ Ring packet %d is not the next reserved slot\n", i);
+            return -1;
+        }
+        
+        slot->command = p->command;   // 0 = 건너뜀 (Enclave가 실패 처리)
+        slot->status = -1;
+        slot->request_id = ++er->next_request_id;
+        slot->vpn_ip = p->vpn_ip;
+        slot->key_handle = p->key_handle;
+        slot->data_off = p->pkt.data - p->pkt.head;
+        slot->data_len = p->pkt.len;
+    }
+    
+    uint32_t target = shm_ring_tail(ring) + count;
+    shm_ring_submit(ring, count);
+    
+    if (shm_ring_wait(ring, target) != 0) {
+        return -1;
+    }
+    
+    // 결과는 같은 슬롯에 in-place로 있으므로 위치/길이만 반영
+    for (int i = 0; i < count; i++) {
+        enclave_ring_packet_t *p = &pkts[i];
+        shm_ring_slot_t *slot = &ring->shared->slots[(target - count + i) & SHM_RING_MASK];
+        
+        p->status = -1;
+        if (p->command != 0 && slot->status == 0 &&
+            (size_t)slot->data_off + slot->data_len <= SHM_RING_SLOT_SIZE) {
+            p->pkt.data = p->pkt.head + slot->data_off;
+            p->pkt.len = slot->data_len;
+            p->status = 0;
+            ok++;
+        }
+    }
+    
+    shm_ring_release(ring, count);
+    
+    return ok;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 비동기 IPC (파이프라인)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 응답을 기다리는 요청 1개
+typedef struct {
+    uint32_t token;            // request_id (호스트 바이트 오더, 0 = 빈 칸)
+    enclave_async_cb_t cb;
+    void *user;
+} async_pending_t;
+
+struct enclave_async {
+    int fd;
+    int window;
+    int in_flight;
+    int dispatch_depth;        // 콜백 실행 중이면 > 0 (rx_buf에 바깥 콜백의 data가 있음)
+    async_pending_t pending[ENCLAVE_ASYNC_MAX_WINDOW];
+    uint8_t rx_buf[sizeof(ipc_response_t) + IPC_MAX_BATCH_DATA];
+};
+
+// 컨텍스트 생성
+enclave_async_t* enclave_async_create(int enclave_fd, int window) {
+    if (window < 1 || window > ENCLAVE_ASYNC_MAX_WINDOW) {
+        fprintf(stderr, "❌ Invalid async window: %d (1..%d)\n",
+                window, ENCLAVE_ASYNC_MAX_WINDOW);
+        return NULL;
+    }
+    
+    int flags = fcntl(enclave_fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(enclave_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        perror("fcntl O_NONBLOCK (enclave async)");
+        return NULL;
+    }
+    
+    enclave_async_t *ctx = (enclave_async_t*)malloc(sizeof(enclave_async_t));
+    if (!ctx) {
+        perror("malloc");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->fd = enclave_fd;
+    ctx->window = window;
+    
+    return ctx;
+}
+
+// 남은 요청 전부 실패 처리
+static void async_fail_all(enclave_async_t *ctx) {
+    for (int i = 0; i < ENCLAVE_ASYNC_MAX_WINDOW; i++) {
+        async_pending_t *p = &ctx->pending[i];
+        if (p->token == 0) {
+            continue;
+        }
+        
+        async_pending_t done = *p;
+        p->token = 0;
+        ctx->in_flight--;
+        if (done.cb) {
+            done.cb(done.user, done.token, -1, NULL, 0);
+        }
+    }
+}
+
+// 컨텍스트 해제
+void enclave_async_destroy(enclave_async_t *ctx) {
+    if (ctx) {
+        async_fail_all(ctx);
+        enclave_disconnect(ctx->fd);
+        free(ctx);
+    }
+}
+
+int enclave_async_fd(const enclave_async_t *ctx) {
+    return ctx->fd;
+}
+
+int enclave_async_in_flight(const enclave_async_t *ctx) {
+    return ctx->in_flight;
+}
+
+// 응답 1개를 request_id로 매칭해 콜백 호출
+// 반환값: 1 (요청 완료), 0 (매칭 실패)
+static int async_dispatch(enclave_async_t *ctx, size_t len) {
+    ipc_response_t *resp = (ipc_response_t*)ctx->rx_buf;
+    size_t data_len = len >= sizeof(ipc_response_t) ? ntohs(resp->data_len) : 0;
+    
+    if (len < sizeof(ipc_response_t) || len != sizeof(ipc_response_t) + data_len) {
+        fprintf(stderr, "⚠️  Malformed Enclave response (%zu bytes)\n", len);
+        return 0;
+    }
+    
+    uint32_t token = ntohl(resp->request_id);
+    async_pending_t *p = NULL;
+    for (int i = 0; i < ENCLAVE_ASYNC_MAX_WINDOW; i++) {
+        if (ctx->pending[i].token == token) {
+            p = &ctx->pending[i];
+            break;
+        }
+    }
+    
+    if (token == 0 || !p) {
+        fprintf(stderr, "⚠️  Unmatched Enclave response (ID=%u)\n", token);
+        return 0;
+    }
+    
+    // 콜백 안에서 다시 submit 할 수 있도록 칸을 먼저 비움
+    async_pending_t done = *p;
+    p->token = 0;
+    ctx->in_flight--;
+    
+    if (done.cb) {
+        ctx->dispatch_depth++;
+        done.cb(done.user, token, resp->status, resp->data, data_len);
+        ctx->dispatch_depth--;
+    }
+    
+    return 1;
+}
+
+// 소켓에 도착한 응답을 모두 처리 (논블로킹, 메시지 1개 = 응답 1개)
+// 반환값: 완료된 요청 수, -1 (연결 끊김)
+static int async_read(enclave_async_t *ctx) {
+    int completed = 0;
+    
+    // 콜백 안에서는 rx_buf(바깥 콜백의 data)를 덮어쓰지 않도록 읽지 않음
+    if (ctx->dispatch_depth > 0) {
+        return 0;
+    }
+    
+    for (;;) {
+        ssize_t n = ipc_recv_fds(ctx->fd, ctx->rx_buf, sizeof(ctx->rx_buf), NULL, NULL);
+        if (n > 0) {
+            completed += async_dispatch(ctx, n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return completed;
+        }
+        
+        if (n == 0) {
+            fprintf(stderr, "❌ Enclave closed the async connection\n");
+        } else {
+            perror("recv from enclave (async)");
+        }
+        async_fail_all(ctx);
+        return -1;
+    }
+}
+
+// 응답 회수
+int enclave_async_poll(enclave_async_t *ctx, int timeout_ms) {
+    if (timeout_ms != 0 && ctx->dispatch_depth == 0) {
+        struct pollfd pfd = { .fd = ctx->fd, .events = POLLIN };
+        int ret = poll(&pfd, 1, timeout_ms);
+        if (ret < 0 && errno != EINTR) {
+            perror("poll enclave (async)");
+            return -1;
+        }
+        if (ret <= 0) {
+            return 0;
+        }
+    }
+    
+    return async_read(ctx);
+}
+
+// 요청 메시지 전송 (헤더 + 데이터, sendmsg 1회)
+// 소켓 버퍼가 가득 차면 Enclave도 응답을 못 보내고 막혀 있을 수 있으므로
+// 기다리는 동안 도착한 응답도 같이 회수한다.
+static int async_send(enclave_async_t *ctx, const ipc_request_t *req, const void *data) {
+    size_t data_len = ntohs(req->data_len);
+    
+    for (;;) {
+        ssize_t n = ipc_send_msg(ctx->fd, req, sizeof(ipc_request_t),
+                                 data, data_len, NULL, 0);
+        if (n == (ssize_t)(sizeof(ipc_request_t) + data_len)) {
+            return 0;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            perror("send to enclave (async)");
+            return -1;
+        }
+        
+        struct pollfd pfd = { .fd = ctx->fd, .events = POLLOUT };
+        if (ctx->dispatch_depth == 0) {
+            pfd.events |= POLLIN;
+        }
+        int ret = poll(&pfd, 1, ENCLAVE_ASYNC_WAIT_MS);
+        if (ret < 0 && errno != EINTR) {
+            perror("poll enclave (async)");
+            return -1;
+        }
+        if (ret == 0) {
+            fprintf(stderr, "❌ Enclave async send timeout\n");
+            return -1;
+        }
+        if (ret > 0 && (pfd.revents & POLLIN) && async_read(ctx) < 0) {
+            return -1;
+        }
+    }
+}
+
+// 요청 전송
+uint32_t enclave_async_submit(enclave_async_t *ctx, uint8_t command, uint32_t vpn_ip,
+                              const uint8_t *data, size_t data_len,
+                              enclave_async_cb_t cb, void *user) {
+    if (data_len > IPC_MAX_BATCH_DATA) {
+        fprintf(stderr, "Async request too large: %zu > %d\n", data_len, IPC_MAX_BATCH_DATA);
+        return 0;
+    }
+    
+    // 창이 가득 차면 응답을 받아 자리 확보
+    while (ctx->in_flight >= ctx->window) {
+        int ret = enclave_async_poll(ctx, ENCLAVE_ASYNC_WAIT_MS);
+        if (ret < 0) {
+            return 0;
+        }
+        if (ret == 0 && ctx->in_flight >= ctx->window) {
+            fprintf(stderr, "❌ Enclave async window full (%d in flight)\n", ctx->in_flight);
+            return 0;
+        }
+    }
+    
+    async_pending_t *p = NULL;
+    for (int i = 0; i < ENCLAVE_ASYNC_MAX_WINDOW; i++) {
+        if (ctx->pending[i].token == 0) {
+            p = &ctx->pending[i];
+            break;
+        }
+    }
+    if (!p) {
+        return 0;
+    }
+    
+    ipc_request_t req;
+    init_ipc_request(&req, command, vpn_ip, NULL, data_len);
+    uint32_t token = ntohl(req.request_id);
+    
+    // 칸은 먼저 차지하고 콜백은 전송이 끝난 뒤 연결
+    // (전송을 기다리는 동안 회수한 응답의 콜백이 이 칸을 가져가지 않도록,
+    //  그리고 실패 시 이 요청의 콜백은 호출되지 않도록)
+    p->token = token;
+    p->cb = NULL;
+    p->user = NULL;
+    ctx->in_flight++;
+    
+    // 메시지 단위 전송이라 실패해도 일부만 나가는 일은 없음 → 이 요청만 취소
+    if (async_send(ctx, &req, data) != 0) {
+        p->token = 0;
+        ctx->in_flight--;
+        return 0;
+    }
+    
+    p->cb = cb;
+    p->user = user;
+    
+    return token;
+}
+
+// 특정 요청이 완료될 때까지 대기
+int enclave_async_wait(enclave_async_t *ctx, uint32_t token) {
+    for (;;) {
+        int found = 0;
+        for (int i = 0; i < ENCLAVE_ASYNC_MAX_WINDOW; i++) {
+            if (ctx->pending[i].token == token) {
+                found = 1;
+                break;
+            }
+        }
+        if (!found) {
+            return 0;
+        }
+        
+        int ret = enclave_async_poll(ctx, ENCLAVE_ASYNC_WAIT_MS);
+        if (ret < 0) {
+            return -1;
+        }
+        if (ret == 0) {
+            fprintf(stderr, "❌ Enclave async timeout (ID=%u)\n", token);
+            return -1;
+        }
+    }
+}
+
+// ECDH 핸드셰이크 (비동기)
+uint32_t enclave_async_handshake(enclave_async_t *ctx, uint32_t vpn_ip,
+                                 const uint8_t *client_public_key,
+                                 uint8_t offered_suites,
+                                 enclave_async_cb_t cb, void *user) {
+    ipc_handshake_data_t hs_data;
+    memcpy(hs_data.client_public_key, client_public_key, 32);
+    hs_data.cipher_suites = offered_suites;
+    
+    return enclave_async_submit(ctx, IPC_HANDSHAKE, vpn_ip,
+                                (const uint8_t*)&hs_data, sizeof(hs_data), cb, user);
+}
+
+// 키 제거 (비동기)
+uint32_t enclave_async_remove_key(enclave_async_t *ctx, uint32_t vpn_ip,
+                                  enclave_async_cb_t cb, void *user) {
+    return enclave_async_submit(ctx, IPC_REMOVE_KEY, vpn_ip, NULL, 0, cb, user);
+}
+
+// 여러 키 제거 (비동기)
+uint32_t enclave_async_remove_keys(enclave_async_t *ctx, const uint32_t *vpn_ips, int count,
+                                   enclave_async_cb_t cb, void *user) {
+    static uint8_t data[sizeof(ipc_batch_header_t) + IPC_MAX_REMOVE_KEYS * sizeof(uint32_t)];
+    
+    if (count <= 0 || count > IPC_MAX_REMOVE_KEYS) {
+        fprintf(stderr, "❌ Invalid key removal batch: %d\n", count);
+        return 0;
+    }
+    
+    ((ipc_batch_header_t*)data)->count = htons((uint16_t)count);
+    memcpy(data + sizeof(ipc_batch_header_t), vpn_ips, count * sizeof(uint32_t));
+    
+    return enclave_async_submit(ctx, IPC_REMOVE_KEYS, 0, data,
+                                sizeof(ipc_batch_header_t) + count * sizeof(uint32_t), cb, user);
+}
@@ -0,0 +1,316 @@
+// src/server/server_stats.c
+
+#include "server_stats.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define STATS_CALIBRATE_NS 10000000   // TSC 주파수 측정 시간 (10ms)
+
+static const char *stage_names[STATS_STAGE_MAX] = {
+    "udp_recv", "decrypt", "tun_write", "rx_total",
+    "tun_read", "encrypt", "udp_send", "tx_total", "sched"
+};
+
+// 영역 크기를 캐시 라인 배수로 올림
+static size_t align_line(size_t n) {
+    return (n + STATS_CACHE_LINE - 1) & ~(size_t)(STATS_CACHE_LINE - 1);
+}
+
+// 밀리초당 사이클 수 측정 (TSC는 잠들어 있는 동안에도 일정하게 증가)
+static uint64_t calibrate_cycles_per_ms(void) {
+    struct timespec pause = { .tv_sec = 0, .tv_nsec = STATS_CALIBRATE_NS };
+    uint64_t ns0 = stats_now_ns();
+    uint64_t c0 = stats_cycles();
+    
+    nanosleep(&pause, NULL);
+    
+    uint64_t ns = stats_now_ns() - ns0;
+    uint64_t cycles = stats_cycles() - c0;
+    return ns ? cycles * 1000000 / ns : 1000000;
+}
+
+// 세그먼트 생성
+int server_stats_create(server_stats_t *stats, const char *name,
+                        int worker_count, int client_capacity, int batch_size) {
+    memset(stats, 0, sizeof(*stats));
+    
+    size_t workers_offset = align_line(sizeof(stats_header_t));
+    size_t clients_offset = workers_offset + align_line(sizeof(stats_worker_t) * worker_count);
+    size_t meta_offset = clients_offset +
+                         align_line(sizeof(stats_client_t) * worker_count * client_capacity);
+    size_t latency_offset = meta_offset + align_line(sizeof(stats_client_meta_t) * client_capacity);
+    size_t size = latency_offset + align_line(sizeof(stats_latency_t) * worker_count);
+    void *addr;
+    
+    if (name) {
+        // 이전 서버가 남긴 세그먼트는 지우고 새로 만듦 (열려 있던 매핑은 그대로 유효)
+        shm_unlink(name);
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            perror("shm_open stats");
+            return -1;
+        }
+        if (ftruncate(fd, size) < 0) {
+            perror("ftruncate stats");
+            close(fd);
+            shm_unlink(name);
+            return -1;
+        }
+        addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            perror("mmap stats");
+            shm_unlink(name);
+            return -1;
+        }
+        snprintf(stats->name, sizeof(stats->name), "%s", name);
+        stats->owner = 1;
+    } else {
+        addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            perror("mmap stats");
+            return -1;
+        }
+    }
+    
+    // 새 매핑은 0으로 채워져 있으므로 헤더만 채우면 됨
+    stats->header = (stats_header_t*)addr;
+    stats->size = size;
+    
+    stats_header_t *h = stats->header;
+    h->version = STATS_VERSION;
+    h->worker_count = worker_count;
+    h->client_capacity = client_capacity;
+    h->size = size;
+    h->workers_offset = workers_offset;
+    h->clients_offset = clients_offset;
+    h->meta_offset = meta_offset;
+    h->latency_offset = latency_offset;
+    h->cycles_per_ms = calibrate_cycles_per_ms();
+    h->started_at = time(NULL);
+    h->pid = getpid();
+    h->batch_size = batch_size;
+    __atomic_store_n(&h->magic, STATS_MAGIC, __ATOMIC_RELEASE);
+    
+    return 0;
+}
+
+// 읽기 전용 연결
+int server_stats_attach(server_stats_t *stats, const char *name) {
+    memset(stats, 0, sizeof(*stats));
+    
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("shm_open stats");
+        return -1;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(stats_header_t)) {
+        fprintf(stderr, "❌ Stats segment %s is empty\n", name);
+        close(fd);
+        return -1;
+    }
+    
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        perror("mmap stats");
+        return -1;
+    }
+    
+    stats->header = (stats_header_t*)addr;
+    stats->size = st.st_size;
+    snprintf(stats->name, sizeof(stats->name), "%s", name);
+    
+    const stats_header_t *h = stats->header;
+    if (__atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != STATS_MAGIC ||
+        h->version != STATS_VERSION || h->size > stats->size) {
+        fprintf(stderr, "❌ Stats segment %s has an unknown layout (version %u)\n",
+                name, h->version);
+        server_stats_close(stats);
+        return -1;
+    }
+    
+    return 0;
+}
+
+// 매핑 해제
+void server_stats_close(server_stats_t *stats) {
+    if (!stats->header) {
+        return;
+    }
+    
+    munmap(stats->header, stats->size);
+    if (stats->owner) {
+        shm_unlink(stats->name);
+    }
+    stats->header = NULL;
+}
+
+// seqlock 쓰기 시작 / 끝
+static void meta_write_begin(stats_client_meta_t *meta) {
+    __atomic_store_n(&meta->seq, meta->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void meta_write_end(stats_client_meta_t *meta) {
+    __atomic_store_n(&meta->seq, meta->seq + 1, __ATOMIC_RELEASE);
+}
+
+// 클라이언트 등록
+// 슬롯 카운터는 이전 클라이언트 값이 남아 있으므로 모든 워커 블록에서 지움
+void server_stats_client_up(server_stats_t *stats, int slot, uint32_t vpn_ip,
+                            const struct sockaddr_in *addr, uint32_t session_id,
+                            time_t connected_at) {
+    stats_client_meta_t *meta = server_stats_meta(stats, slot);
+    
+    for (uint32_t w = 0; w < stats->header->worker_count; w++) {
+        uint64_t *counters = (uint64_t*)&server_stats_clients(stats, w)[slot];
+        for (size_t i = 0; i < sizeof(stats_client_t) / sizeof(uint64_t); i++) {
+            __atomic_store_n(&counters[i], 0, __ATOMIC_RELAXED);
+        }
+    }
+    
+    meta_write_begin(meta);
+    meta->active = 1;
+    meta->vpn_ip = vpn_ip;
+    meta->real_ip = addr->sin_addr.s_addr;
+    meta->real_port = addr->sin_port;
+    meta->session_id = session_id;
+    meta->connected_at = connected_at;
+    meta->last_rtt_ns = 0;
+    meta->rtt_measured_at = 0;
+    meta_write_end(meta);
+}
+
+// 클라이언트 해제 (카운터는 다음 등록 때까지 남겨 둠)
+void server_stats_client_down(server_stats_t *stats, int slot) {
+    stats_client_meta_t *meta = server_stats_meta(stats, slot);
+    
+    meta_write_begin(meta);
+    meta->active = 0;
+    meta_write_end(meta);
+}
+
+// 클라이언트 RTT 기록
+void server_stats_client_rtt(server_stats_t *stats, int slot, uint64_t rtt_ns) {
+    stats_client_meta_t *meta = server_stats_meta(stats, slot);
+    
+    meta_write_begin(meta);
+    meta->last_rtt_ns = rtt_ns;
+    meta->rtt_measured_at = time(NULL);
+    meta_write_end(meta);
+}
+
+// 클라이언트 메타 읽기 (쓰는 중이거나 도중에 바뀌었으면 다시)
+void server_stats_read_meta(const server_stats_t *stats, int slot, stats_client_meta_t *out) {
+    const stats_client_meta_t *meta = server_stats_meta(stats, slot);
+    uint32_t begin, end;
+    
+    do {
+        begin = __atomic_load_n(&meta->seq, __ATOMIC_ACQUIRE);
+        memcpy(out, meta, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        end = __atomic_load_n(&meta->seq, __ATOMIC_RELAXED);
+    } while ((begin & 1) || begin != end);
+}
+
+// 64비트 카운터 배열 합산 (relaxed load)
+static void sum_counters(uint64_t *dst, const uint64_t *src, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] += __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+}
+
+// 워커 전역 카운터 합산 (ipc_ns_max는 최댓값)
+void server_stats_sum_workers(const server_stats_t *stats, stats_worker_t *out) {
+    memset(out, 0, sizeof(*out));
+    
+    for (uint32_t w = 0; w < stats->header->worker_count; w++) {
+        const stats_worker_t *worker = server_stats_worker(stats, w);
+        uint64_t max = __atomic_load_n(&worker->ipc_ns_max, __ATOMIC_RELAXED);
+        uint64_t prev_max = out->ipc_ns_max;
+        
+        sum_counters((uint64_t*)out, (const uint64_t*)worker, sizeof(*out) / sizeof(uint64_t));
+        out->ipc_ns_max = max > prev_max ? max : prev_max;
+    }
+}
+
+// 클라이언트 카운터 합산
+void server_stats_sum_client(const server_stats_t *stats, int slot, stats_client_t *out) {
+    memset(out, 0, sizeof(*out));
+    
+    for (uint32_t w = 0; w < stats->header->worker_count; w++) {
+        sum_counters((uint64_t*)out, (const uint64_t*)&server_stats_clients(stats, w)[slot],
+                     sizeof(*out) / sizeof(uint64_t));
+    }
+}
+
+// 지연 측정 상태 표시
+void server_stats_set_latency(server_stats_t *stats, int enabled) {
+    __atomic_store_n(&stats->header->latency_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+// 단계 히스토그램 합치기 (max는 최댓값)
+void server_stats_merge_latency(const server_stats_t *stats, int stage, stats_hist_t *out) {
+    memset(out, 0, sizeof(*out));
+    
+    for (uint32_t w = 0; w < stats->header->worker_count; w++) {
+        const stats_hist_t *hist = &server_stats_latency(stats, w)->stages[stage];
+        uint64_t max = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+        uint64_t prev_max = out->max;
+        
+        sum_counters((uint64_t*)out, (const uint64_t*)hist, sizeof(*out) / sizeof(uint64_t));
+        out->max = max > prev_max ? max : prev_max;
+    }
+}
+
+// 칸의 중간값
+static uint64_t bucket_value(int index) {
+    if (index < (1 << STATS_HIST_SUB_BITS)) {
+        return index;
+    }
+    int shift = (index >> STATS_HIST_SUB_BITS) - 1;
+    uint64_t low = (uint64_t)((index & ((1 << STATS_HIST_SUB_BITS) - 1)) +
+                              (1 << STATS_HIST_SUB_BITS)) << shift;
+    return low + ((1ULL << shift) >> 1);
+}
+
+// 백분위 (누적 개수가 q * count에 처음 닿는 칸, 최댓값을 넘지 않게)
+uint64_t stats_hist_percentile(const stats_hist_t *hist, double q) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    
+    uint64_t target = (uint64_t)(q * hist->count + 0.5);
+    uint64_t seen = 0;
+    
+    if (target == 0) {
+        target = 1;
+    }
+    
+    for (int b = 0; b < STATS_HIST_BUCKETS; b++) {
+        seen += hist->buckets[b];
+        if (seen >= target) {
+            uint64_t value = bucket_value(b);
+            return (hist->max && value > hist->max) ? hist->max : value;
+        }
+    }
+    return hist->max;
+}
+
+// 사이클 → 마이크로초
+double server_stats_cycles_to_us(const server_stats_t *stats, uint64_t cycles) {
+    uint64_t per_ms = stats->header->cycles_per_ms;
+    return per_ms ? (double)cycles * 1000.0 / per_ms : 0.0;
+}
+
+// 단계 이름
+const char* stats_stage_name(int stage) {
+    return (stage >= 0 && stage < STATS_STAGE_MAX) ? stage_names[stage] : "?";
+}
@@ -1,11 +1,217 @@
 // src/server/test_enclave_ipc.c
 
 #include "enclave_client.h"
+#include "crypto.h"
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 
+#define ASYNC_TEST_REQUESTS 8
+#define ASYNC_TEST_WINDOW   4
+#define BATCH_TEST_PACKETS  (IPC_MAX_BATCH + 8)   // 요청 2번으로 나뉘도록
+#define BATCH_TEST_LEN      64
+#define HANDSHAKE_TEST_RUNS 2
+
+// 비동기 완료 기록
+static uint32_t async_tokens[ASYNC_TEST_REQUESTS];
+static int async_done[ASYNC_TEST_REQUESTS];
+
+// 배치 테스트 버퍼 (엔트리마다 입력 / 출력)
+static uint8_t batch_in[BATCH_TEST_PACKETS][BATCH_TEST_LEN + IPC_CRYPTO_OVERHEAD];
+static uint8_t batch_out[BATCH_TEST_PACKETS][BATCH_TEST_LEN + IPC_CRYPTO_OVERHEAD];
+static enclave_batch_entry_t batch_entries[BATCH_TEST_PACKETS];
+
+// 배치 암호화/복호화 왕복 (핸들 / VPN IP 조회, 엔트리별 실패, 분할 전송)
+// 반환값: 0 (성공), -1 (실패)
+static int test_batch_round_trip(int enclave_fd, uint32_t vpn_ip, key_handle_t handle,
+                                 const uint8_t *key) {
+    uint32_t unknown_ip = inet_addr("10.8.0.250");
+    uint8_t nonce[CRYPTO_NONCE_SIZE];
+    uint8_t plain[BATCH_TEST_LEN];
+    int n = BATCH_TEST_PACKETS;
+    
+    // 암호화: 짝수는 핸들, 홀수는 VPN IP로 조회, 마지막은 없는 키
+    for (int i = 0; i < n; i++) {
+        memset(batch_in[i], i, BATCH_TEST_LEN);
+        batch_entries[i] = (enclave_batch_entry_t){
+            .vpn_ip = (i == n - 1) ? unknown_ip : vpn_ip,
+            .key_handle = (i % 2 == 0 && i != n - 1) ? handle : KEY_HANDLE_INVALID,
+            .input = batch_in[i],
+            .input_len = BATCH_TEST_LEN,
+            .output = batch_out[i],
+        };
+    }
+    
+    int ok = enclave_encrypt_batch(enclave_fd, batch_entries, n);
+    if (ok != n - 1 || batch_entries[n - 1].status != -1) {
+        printf("   ❌ Encrypt batch: %d/%d ok\n", ok, n);
+        return -1;
+    }
+    
+    // 결과는 클라이언트처럼 테스트 키로 직접 확인
+    for (int i = 0; i < n - 1; i++) {
+        const uint8_t *out = batch_out[i];
+        crypto_counter_nonce(nonce, CRYPTO_DIR_SERVER_TO_CLIENT, crypto_get_counter(out));
+        if (batch_entries[i].status != 0 ||
+            batch_entries[i].output_len != BATCH_TEST_LEN + IPC_CRYPTO_OVERHEAD ||
+            crypto_decrypt(out + CRYPTO_COUNTER_SIZE,
+                           batch_entries[i].output_len - CRYPTO_COUNTER_SIZE,
+                           plain, key, nonce) != 0 ||
+            memcmp(plain, batch_in[i], BATCH_TEST_LEN) != 0) {
+            printf("   ❌ Encrypt batch entry %d mismatch\n", i);
+            return -1;
+        }
+    }
+    printf("   ✅ Encrypt batch: %d/%d ok (unknown key rejected)\n", ok, n);
+    
+    // 복호화: 클라이언트→서버 패킷 (카운터 0은 앞의 테스트에서 사용), 첫 엔트리는 변조
+    for (int i = 0; i < n; i++) {
+        uint64_t counter = (uint64_t)i + 1;
+        memset(plain, 0x80 + i, BATCH_TEST_LEN);
+        crypto_counter_nonce(nonce, CRYPTO_DIR_CLIENT_TO_SERVER, counter);
+        crypto_put_counter(batch_in[i], counter);
+        crypto_encrypt(plain, BATCH_TEST_LEN, batch_in[i] + CRYPTO_COUNTER_SIZE, key, nonce);
+        if (i == 0) {
+            batch_in[i][CRYPTO_COUNTER_SIZE] ^= 0x01;
+        }
+        
+        batch_entries[i] = (enclave_batch_entry_t){
+            .vpn_ip = vpn_ip,
+            .key_handle = handle,
+            .input = batch_in[i],
+            .input_len = BATCH_TEST_LEN + IPC_CRYPTO_OVERHEAD,
+            .output = batch_out[i],
+        };
+    }
+    
+    ok = enclave_decrypt_batch(enclave_fd, batch_entries, n);
+    if (ok != n - 1 || batch_entries[0].status != -1) {
+        printf("   ❌ Decrypt batch: %d/%d ok\n", ok, n);
+        return -1;
+    }
+    for (int i = 1; i < n; i++) {
+        memset(plain, 0x80 + i, BATCH_TEST_LEN);
+        if (batch_entries[i].status != 0 || batch_entries[i].output_len != BATCH_TEST_LEN ||
+            memcmp(batch_out[i], plain, BATCH_TEST_LEN) != 0) {
+            printf("   ❌ Decrypt batch entry %d mismatch\n", i);
+            return -1;
+        }
+    }
+    printf("   ✅ Decrypt batch: %d/%d ok (tampered packet rejected)\n", ok, n);
+    
+    // 같은 배치를 다시 보내면 전부 재전송으로 거부되어야 함
+    ok = enclave_decrypt_batch(enclave_fd, batch_entries, n);
+    if (ok != 0) {
+        printf("   ❌ Replayed batch: %d entries accepted\n", ok);
+        return -1;
+    }
+    printf("   ✅ Replayed batch rejected\n");
+    
+    return 0;
+}
+
+// 핸드셰이크 1회 + 직후 첫 패킷 (카운터 0)
+// key: 클라이언트 쪽에서 계산한 세션키 출력, packet: Enclave 암호화 결과 출력
+// 반환값: 0 (성공), -1 (실패)
+static int handshake_first_packet(int enclave_fd, uint32_t vpn_ip,
+                                  const uint8_t *client_public_key,
+                                  const uint8_t *client_private_key,
+                                  const char *message, uint8_t *key,
+                                  uint8_t *packet, size_t *packet_len) {
+    uint8_t server_public_key[32];
+    uint8_t enclave_key[32];
+    uint8_t shared_secret[32];
+    uint8_t suite;
+    
+    if (enclave_handshake(enclave_fd, vpn_ip, client_public_key,
+                          CRYPTO_SUITE_CHACHA20_POLY1305, server_public_key,
+                          enclave_key, &suite, NULL) != 0 ||
+        crypto_ecdh(shared_secret, client_private_key, server_public_key) != 0) {
+        printf("   ❌ Handshake failed\n");
+        return -1;
+    }
+    
+    crypto_derive_session_key(key, shared_secret, NULL, 0);
+    sodium_memzero(shared_secret, sizeof(shared_secret));
+    
+    int same = memcmp(key, enclave_key, 32) == 0;
+    sodium_memzero(enclave_key, sizeof(enclave_key));
+    if (!same) {
+        printf("   ❌ Client and enclave session keys differ\n");
+        return -1;
+    }
+    
+    if (enclave_encrypt(enclave_fd, vpn_ip, (const uint8_t*)message, strlen(message),
+                        packet, packet_len) != 0 ||
+        crypto_get_counter(packet) != 0) {
+        printf("   ❌ First packet not at counter 0\n");
+        return -1;
+    }
+    return 0;
+}
+
+// 같은 클라이언트 키 쌍으로 두 번 핸드셰이크해도 (세션키, nonce) 쌍이 겹치지 않는지
+// 카운터는 핸드셰이크마다 0부터 다시 시작하므로 세션키가 달라야 함
+// 반환값: 0 (성공), -1 (실패)
+static int test_handshake_freshness(int enclave_fd) {
+    uint32_t vpn_ip = inet_addr("10.8.0.6");
+    const char *message = "same counter, same plaintext";
+    uint8_t client_public_key[32];
+    uint8_t client_private_key[32];
+    uint8_t keys[HANDSHAKE_TEST_RUNS][32];
+    uint8_t packets[HANDSHAKE_TEST_RUNS][256];
+    size_t packet_len[HANDSHAKE_TEST_RUNS];
+    uint8_t plain[256];
+    uint8_t nonce[CRYPTO_NONCE_SIZE];
+    int ret = 0;
+    
+    crypto_generate_keypair(client_public_key, client_private_key);
+    
+    for (int run = 0; ret == 0 && run < HANDSHAKE_TEST_RUNS; run++) {
+        ret = handshake_first_packet(enclave_fd, vpn_ip, client_public_key, client_private_key,
+                                     message, keys[run], packets[run], &packet_len[run]);
+    }
+    enclave_remove_key(enclave_fd, vpn_ip);
+    sodium_memzero(client_private_key, sizeof(client_private_key));
+    
+    if (ret == 0 && memcmp(keys[0], keys[1], 32) == 0) {
+        printf("   ❌ Same session key after re-handshake\n");
+        ret = -1;
+    }
+    
+    // 두 카운터 0 패킷은 서로 다르고, 각자 자기 핸드셰이크의 키로만 열려야 함
+    crypto_counter_nonce(nonce, CRYPTO_DIR_SERVER_TO_CLIENT, 0);
+    if (ret == 0 &&
+        (memcmp(packets[0], packets[1], packet_len[1]) == 0 ||
+         crypto_decrypt(packets[1] + CRYPTO_COUNTER_SIZE, packet_len[1] - CRYPTO_COUNTER_SIZE,
+                        plain, keys[1], nonce) != 0 ||
+         crypto_decrypt(packets[1] + CRYPTO_COUNTER_SIZE, packet_len[1] - CRYPTO_COUNTER_SIZE,
+                        plain, keys[0], nonce) == 0)) {
+        printf("   ❌ Counter 0 packets share a keystream\n");
+        ret = -1;
+    }
+    sodium_memzero(keys, sizeof(keys));
+    
+    if (ret == 0) {
+        printf("   ✅ %d handshakes, distinct session keys (counter 0 packets differ)\n",
+               HANDSHAKE_TEST_RUNS);
+    }
+    return ret;
+}
+
+static void on_async_encrypt(void *user, uint32_t token, int status,
+                             const uint8_t *data, size_t len) {
+    int index = (int)(intptr_t)user;
+    (void)data;
+    
+    if (token == async_tokens[index] && status == 0 &&
+        len == strlen("Hello Enclave!") + IPC_CRYPTO_OVERHEAD) {
+        async_done[index] = 1;
+    }
+}
+
 int main() {
     int enclave_fd;
     
@@ -36,8 +242,11 @@ int main() {
     uint32_t test_vpn_ip = inet_addr("10.8.0.5");
     uint8_t test_key[32] = {0xAB, 0xCD, 0xEF};  // 테스트 키
     
-    if (enclave_add_key(enclave_fd, test_vpn_ip, test_key) == 0) {
-        printf("   ✅ Key added\n");
+    key_handle_t test_handle = KEY_HANDLE_INVALID;
+    
+    if (enclave_add_key(enclave_fd, test_vpn_ip, test_key,
+                        CRYPTO_SUITE_CHACHA20_POLY1305, &test_handle) == 0) {
+        printf("   ✅ Key added (handle=0x%08x)\n", test_handle);
     }
     
     sleep(1);
@@ -62,22 +271,100 @@ int main() {
     sleep(1);
     
     // 복호화 테스트
+    // Enclave 출력은 서버→클라이언트 방향이므로 클라이언트처럼 테스트 키로 직접 확인하고,
+    // 클라이언트→서버 방향 패킷을 만들어 Enclave에 복호화를 요청한다.
     printf("\n5. Decrypt Test...\n");
     uint8_t decrypted[256];
     size_t decrypted_len;
+    uint8_t nonce[CRYPTO_NONCE_SIZE];
+    
+    crypto_counter_nonce(nonce, CRYPTO_DIR_SERVER_TO_CLIENT, crypto_get_counter(ciphertext));
+    if (crypto_decrypt(ciphertext + CRYPTO_COUNTER_SIZE, ciphertext_len - CRYPTO_COUNTER_SIZE,
+                       decrypted, test_key, nonce) == 0) {
+        printf("   ✅ Enclave ciphertext verified (counter=%llu)\n",
+               (unsigned long long)crypto_get_counter(ciphertext));
+    }
+    
+    uint8_t request[256];
+    uint64_t counter = 0;
+    crypto_counter_nonce(nonce, CRYPTO_DIR_CLIENT_TO_SERVER, counter);
+    crypto_put_counter(request, counter);
+    crypto_encrypt((const uint8_t*)plaintext, strlen(plaintext),
+                   request + CRYPTO_COUNTER_SIZE, test_key, nonce);
+    size_t request_len = CRYPTO_COUNTER_SIZE + strlen(plaintext) + CRYPTO_MAC_SIZE;
     
     if (enclave_decrypt(enclave_fd, test_vpn_ip,
-                       ciphertext, ciphertext_len,
+                       request, request_len,
                        decrypted, &decrypted_len) == 0) {
         decrypted[decrypted_len] = '\0';
         printf("   ✅ Decrypted: %zu bytes\n", decrypted_len);
         printf("   Plaintext: %s\n", decrypted);
     }
     
+    // 같은 카운터를 다시 보내면 재전송 창에서 거부되어야 함
+    if (enclave_decrypt(enclave_fd, test_vpn_ip,
+                       request, request_len,
+                       decrypted, &decrypted_len) != 0) {
+        printf("   ✅ Replay rejected\n");
+    } else {
+        printf("   ❌ Replay accepted\n");
+    }
+    
+    sleep(1);
+    
+    // 비동기 파이프라인 테스트 (전용 연결, 창보다 많은 요청 → 제출 중 자동 회수)
+    printf("\n6. Pipelined Async Test...\n");
+    int async_fd = enclave_connect();
+    enclave_async_t *async = async_fd >= 0 ? enclave_async_create(async_fd, ASYNC_TEST_WINDOW) : NULL;
+    if (async) {
+        int submitted = 0;
+        for (int i = 0; i < ASYNC_TEST_REQUESTS; i++) {
+            async_tokens[i] = enclave_async_submit(async, IPC_ENCRYPT, test_vpn_ip,
+                                                   (const uint8_t*)plaintext, strlen(plaintext),
+                                                   on_async_encrypt, (void*)(intptr_t)i);
+            if (async_tokens[i] != 0) {
+                submitted++;
+            }
+        }
+        
+        int completed = 0;
+        if (submitted == ASYNC_TEST_REQUESTS &&
+            enclave_async_wait(async, async_tokens[ASYNC_TEST_REQUESTS - 1]) == 0) {
+            for (int i = 0; i < ASYNC_TEST_REQUESTS; i++) {
+                completed += async_done[i];
+            }
+        }
+        
+        if (completed == ASYNC_TEST_REQUESTS) {
+            printf("   ✅ %d requests completed (window %d)\n", completed, ASYNC_TEST_WINDOW);
+        } else {
+            printf("   ❌ Only %d/%d requests completed\n", completed, ASYNC_TEST_REQUESTS);
+        }
+        enclave_async_destroy(async);
+    } else if (async_fd >= 0) {
+        enclave_disconnect(async_fd);
+    }
+    
+    sleep(1);
+    
+    // 배치 왕복 테스트 (소켓 배치 API)
+    printf("\n7. Batch Round-Trip Test...\n");
+    if (test_batch_round_trip(enclave_fd, test_vpn_ip, test_handle, test_key) == 0) {
+        printf("   ✅ Batch round trip OK (%d packets)\n", BATCH_TEST_PACKETS);
+    }
+    
+    sleep(1);
+    
+    // 재핸드셰이크 테스트 (같은 클라이언트 키 쌍)
+    printf("\n8. Handshake Freshness Test...\n");
+    if (test_handshake_freshness(enclave_fd) == 0) {
+        printf("   ✅ Re-handshake derives a fresh key\n");
+    }
+    
     sleep(1);
     
     // 키 제거 테스트
-    printf("\n6. Remove Key Test...\n");
+    printf("\n9. Remove Key Test...\n");
     if (enclave_remove_key(enclave_fd, test_vpn_ip) == 0) {
         printf("   ✅ Key removed\n");
     }
@@ -85,7 +372,7 @@ int main() {
     sleep(1);
     
     // 연결 종료
-    printf("\n7. Disconnecting...\n");
+    printf("\n10. Disconnecting...\n");
     enclave_disconnect(enclave_fd);
     
     printf("\n═══════════════════════════════════\n");
@@ -0,0 +1,150 @@
+// src/server/timer_wheel.c
+
+#include "timer_wheel.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define WHEEL_RANGE (1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+// 빈 리스트 (머리가 자기 자신을 가리킴)
+static inline void list_reset(timer_node_t *head) {
+    head->next = head;
+    head->prev = head;
+}
+
+static inline void list_unlink(timer_node_t *node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = NULL;
+    node->prev = NULL;
+}
+
+// 리스트를 통째로 다른 머리로 옮김 (head는 빈 리스트가 됨)
+static inline void list_move_all(timer_node_t *head, timer_node_t *to) {
+    if (head->next == head) {
+        list_reset(to);
+        return;
+    }
+    to->next = head->next;
+    to->prev = head->prev;
+    to->next->prev = to;
+    to->prev->next = to;
+    list_reset(head);
+}
+
+static inline void list_append(timer_node_t *head, timer_node_t *node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+// 남은 틱 수로 단계를 고르고, 만료 틱의 그 단계 비트로 칸을 고름
+static void place(timer_wheel_t *wheel, timer_node_t *node) {
+    uint64_t delta = node->expires - wheel->now;
+    int level = 0;
+    
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= (1ULL << (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    
+    int slot = (int)((node->expires >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK);
+    list_append(&wheel->slots[level][slot], node);
+}
+
+// 휠 초기화
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t now) {
+    for (int l = 0; l < TIMER_WHEEL_LEVELS; l++) {
+        for (int s = 0; s < TIMER_WHEEL_SLOTS; s++) {
+            list_reset(&wheel->slots[l][s]);
+        }
+    }
+    wheel->now = now;
+    wheel->count = 0;
+}
+
+// 노드 초기화
+void timer_node_init(timer_node_t *node, uint32_t id) {
+    node->next = NULL;
+    node->prev = NULL;
+    node->expires = 0;
+    node->id = id;
+}
+
+// 타이머 걸기
+void timer_wheel_arm(timer_wheel_t *wheel, timer_node_t *node, uint64_t expires) {
+    if (timer_armed(node)) {
+        list_unlink(node);
+        wheel->count--;
+    }
+    
+    // 지난 틱은 다음 틱으로, 너무 먼 틱은 휠 범위 끝으로
+    if (expires <= wheel->now) {
+        expires = wheel->now + 1;
+    } else if (expires - wheel->now >= WHEEL_RANGE) {
+        expires = wheel->now + WHEEL_RANGE - 1;
+    }
+    
+    node->expires = expires;
+    place(wheel, node);
+    wheel->count++;
+}
+
+// 타이머 취소
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_node_t *node) {
+    if (timer_armed(node)) {
+        list_unlink(node);
+        wheel->count--;
+    }
+}
+
+// 위 단계 칸 하나를 현재 시각 기준으로 다시 배치
+static void cascade(timer_wheel_t *wheel, int level, int slot) {
+    timer_node_t pending;
+    
+    // 리스트를 통째로 떼어낸 뒤 하나씩 다시 넣음
+    list_move_all(&wheel->slots[level][slot], &pending);
+    while (pending.next != &pending) {
+        timer_node_t *node = pending.next;
+        list_unlink(node);
+        place(wheel, node);
+    }
+}
+
+// 한 틱 진행 후 0단계 현재 칸의 타이머 만료
+static int tick(timer_wheel_t *wheel, timer_fn_t fn, void *arg) {
+    wheel->now++;
+    
+    // 아래 단계가 한 바퀴 돌았으면 위 단계의 현재 칸을 내림
+    // (높은 단계부터: 내려온 노드가 아래 단계의 현재 칸에 들어가는 일은 없음)
+    for (int l = TIMER_WHEEL_LEVELS - 1; l >= 1; l--) {
+        if ((wheel->now & ((1ULL << (TIMER_WHEEL_BITS * l)) - 1)) == 0) {
+            cascade(wheel, l, (int)((wheel->now >> (TIMER_WHEEL_BITS * l)) & SLOT_MASK));
+        }
+    }
+    
+    timer_node_t expired;
+    int fired = 0;
+    
+    // 콜백이 같은 칸에 다시 걸 수 있으므로 만료 대상만 먼저 떼어냄
+    list_move_all(&wheel->slots[0][wheel->now & SLOT_MASK], &expired);
+    while (expired.next != &expired) {
+        timer_node_t *node = expired.next;
+        list_unlink(node);
+        wheel->count--;
+        fired++;
+        fn(node, arg);
+    }
+    
+    return fired;
+}
+
+// now 틱까지 진행
+int timer_wheel_advance(timer_wheel_t *wheel, uint64_t now, timer_fn_t fn, void *arg) {
+    int fired = 0;
+    
+    while (wheel->now < now) {
+        fired += tick(wheel, fn, arg);
+    }
+    return fired;
+}
@@ -10,16 +10,30 @@
 #include <sys/socket.h>
 #include <linux/if.h>
 #include <linux/if_tun.h>
+#include <errno.h>
 #include <arpa/inet.h>
 #include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/tcp.h>
 
-// TUN 인터페이스 생성
-int create_tun_interface(const char *dev_name) {
-    int tun_fd, err;
+#define TCP_FLAG_FIN 0x01
+#define TCP_FLAG_SYN 0x02
+#define TCP_FLAG_RST 0x04
+#define TCP_FLAG_PSH 0x08
+#define TCP_FLAG_ACK 0x10
+#define TCP_FLAG_URG 0x20
+#define TCP_FLAG_ECE 0x40
+#define TCP_FLAG_CWR 0x80
+#define TCP_FLAGS_OFF 13
+#define TCP_CHECK_OFF 16
+
+// /dev/net/tun 열고 TUNSETIFF
+// 반환값: fd, -1 (실패)
+static int tun_open(const char *dev_name, short tun_flags, char *name_out) {
     struct ifreq ifr;
     
     // 1. /dev/net/tun 열기
-    tun_fd = open("/dev/net/tun", O_RDWR);
+    int tun_fd = open("/dev/net/tun", O_RDWR);
     if (tun_fd < 0) {
         perror("Failed to open /dev/net/tun");
         fprintf(stderr, "   Hint: Run with sudo or check if TUN module is loaded\n");
@@ -28,26 +42,119 @@ int create_tun_interface(const char *dev_name) {
     
     // 2. TUN 설정
     memset(&ifr, 0, sizeof(ifr));
-    ifr.ifr_flags = IFF_TUN | IFF_NO_PI;  // TUN 모드, 패킷 정보 헤더 제거
+    ifr.ifr_flags = tun_flags;
     
     if (dev_name) {
         strncpy(ifr.ifr_name, dev_name, IFNAMSIZ - 1);
     }
     
-    // 3. ioctl로 TUN 생성
-    err = ioctl(tun_fd, TUNSETIFF, (void *)&ifr);
-    if (err < 0) {
+    // 3. ioctl로 TUN 생성 (멀티 큐면 같은 이름으로 큐 추가)
+    if (ioctl(tun_fd, TUNSETIFF, (void *)&ifr) < 0) {
         perror("Failed to create TUN interface (ioctl TUNSETIFF)");
         close(tun_fd);
         return -1;
     }
     
-    printf("TUN interface '%s' created successfully (fd=%d)\n", 
-           ifr.ifr_name, tun_fd);
+    if (name_out) {
+        memcpy(name_out, ifr.ifr_name, IFNAMSIZ);
+    }
+    
+    return tun_fd;
+}
+
+// 체크섬/TSO 오프로드 켜기 (IFF_VNET_HDR로 연 fd)
+// 커널 TCP가 최대 64KB 세그먼트를 그대로 넘겨주고, 체크섬은 우리가 채운다.
+static int tun_set_offload(int tun_fd) {
+    unsigned int offload = TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6;
+    
+    if (ioctl(tun_fd, TUNSETOFFLOAD, offload) < 0) {
+        perror("⚠️  Warning: TUNSETOFFLOAD failed");
+        return -1;
+    }
+    return 0;
+}
+
+// TUN 인터페이스 생성
+int create_tun_interface(const char *dev_name) {
+    return create_tun_interface_flags(dev_name, 0);
+}
+
+// TUN 인터페이스 생성 (TUN_OFFLOAD: virtio_net_hdr + TSO)
+int create_tun_interface_flags(const char *dev_name, int flags) {
+    char name[IFNAMSIZ];
+    short tun_flags = IFF_TUN | IFF_NO_PI;  // TUN 모드, 패킷 정보 헤더 제거
+    
+    if (flags & TUN_OFFLOAD) {
+        tun_flags |= IFF_VNET_HDR;
+    }
+    
+    int tun_fd = tun_open(dev_name, tun_flags, name);
+    if (tun_fd < 0) {
+        return -1;
+    }
+    
+    // 오프로드를 못 켜면 일반 TUN으로 다시 생성
+    if ((flags & TUN_OFFLOAD) && tun_set_offload(tun_fd) < 0) {
+        close(tun_fd);
+        return create_tun_interface_flags(dev_name, flags & ~TUN_OFFLOAD);
+    }
+    
+    printf("TUN interface '%s' created successfully (fd=%d%s)\n",
+           name, tun_fd, (flags & TUN_OFFLOAD) ? ", offload: csum+tso" : "");
     
     return tun_fd;
 }
 
+// 멀티 큐 TUN 인터페이스 생성
+// 같은 이름으로 TUNSETIFF를 반복하면 큐가 하나씩 추가된다.
+// 커널은 흐름 해시로 큐를 고르므로 한 흐름의 패킷은 같은 큐에 머문다.
+int create_tun_queues(const char *dev_name, int *fds, int count, int flags) {
+    short tun_flags = IFF_TUN | IFF_NO_PI | IFF_MULTI_QUEUE;
+    int opened;
+    
+    if (flags & TUN_OFFLOAD) {
+        tun_flags |= IFF_VNET_HDR;
+    }
+    
+    for (opened = 0; opened < count; opened++) {
+        int fd = tun_open(dev_name, tun_flags, NULL);
+        if (fd < 0) {
+            break;
+        }
+        fds[opened] = fd;
+        
+        // 오프로드는 장치 단위: 첫 큐에서 실패하면 일반 TUN으로 다시 생성
+        if (opened == 0 && (flags & TUN_OFFLOAD) && tun_set_offload(fd) < 0) {
+            close(fd);
+            return create_tun_queues(dev_name, fds, count, flags & ~TUN_OFFLOAD);
+        }
+    }
+    
+    if (opened < count) {
+        for (int i = 0; i < opened; i++) {
+            close(fds[i]);
+        }
+        return -1;
+    }
+    
+    printf("TUN interface '%s' created with %d queues (fd=%d..%d%s)\n",
+           dev_name, count, fds[0], fds[count - 1],
+           (flags & TUN_OFFLOAD) ? ", offload: csum+tso" : "");
+    
+    return 0;
+}
+
+// IFF_VNET_HDR 여부
+int tun_offload_enabled(int tun_fd) {
+    struct ifreq ifr;
+    
+    memset(&ifr, 0, sizeof(ifr));
+    if (ioctl(tun_fd, TUNGETIFF, (void *)&ifr) < 0) {
+        return 0;
+    }
+    return (ifr.ifr_flags & IFF_VNET_HDR) ? 1 : 0;
+}
+
 // TUN IP 설정
 int configure_tun_ip(const char *dev, const char *ip, int netmask) {
     char cmd[256];
@@ -125,3 +232,416 @@ void print_ip_packet(const uint8_t *packet, ssize_t len) {
     }
     printf("\n");
 }
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 체크섬 (인터넷 1의 보수 합)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+//
+// 네이티브 바이트 오더로 더한 뒤 접어도 결과를 그대로 저장하면 된다 (RFC 1071).
+
+static uint64_t csum_partial(const uint8_t *data, size_t len, uint64_t sum) {
+    while (len >= 4) {
+        uint32_t w;
+        memcpy(&w, data, 4);
+        sum += w;
+        data += 4;
+        len -= 4;
+    }
+    if (len >= 2) {
+        uint16_t w;
+        memcpy(&w, data, 2);
+        sum += w;
+        data += 2;
+        len -= 2;
+    }
+    if (len) {
+        uint16_t w = 0;
+        memcpy(&w, data, 1);
+        sum += w;
+    }
+    return sum;
+}
+
+static uint16_t csum_fold(uint64_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return (uint16_t)sum;
+}
+
+// TCP 의사 헤더 합 (l4_len = TCP 헤더 + 페이로드)
+static uint64_t tcp_pseudo_sum(const uint8_t *pkt, int ipv6, size_t l4_len) {
+    uint64_t sum;
+    
+    if (ipv6) {
+        const struct ip6_hdr *ip6 = (const struct ip6_hdr*)pkt;
+        sum = csum_partial((const uint8_t*)&ip6->ip6_src, 32, 0);
+        sum += htonl((uint32_t)l4_len);
+    } else {
+        const struct iphdr *ip = (const struct iphdr*)pkt;
+        sum = csum_partial((const uint8_t*)&ip->saddr, 8, 0);
+        sum += htons((uint16_t)l4_len);
+    }
+    sum += htons(IPPROTO_TCP);
+    return sum;
+}
+
+static void ip_fix_checksum(struct iphdr *ip) {
+    ip->check = 0;
+    ip->check = ~csum_fold(csum_partial((const uint8_t*)ip, ip->ihl * 4, 0));
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 오프로드 모드: 읽기 (TSO 묶음 → MTU 세그먼트)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// virtio_net_hdr와 함께 패킷 1개 읽기
+ssize_t tun_read_offload(int tun_fd, struct virtio_net_hdr *vh,
+                         uint8_t *buf, size_t buf_len, uint8_t *stage,
+                         uint8_t **packet) {
+    if (buf_len > TUN_GSO_BUF_SIZE) {
+        buf_len = TUN_GSO_BUF_SIZE;
+    }
+    
+    // 작은 패킷은 buf로 바로, 넘치는 부분은 stage 뒤쪽으로
+    struct iovec iov[3] = {
+        { .iov_base = vh,               .iov_len = TUN_VNET_HDR_LEN },
+        { .iov_base = buf,              .iov_len = buf_len },
+        { .iov_base = stage + buf_len,  .iov_len = TUN_GSO_BUF_SIZE - buf_len },
+    };
+    
+    ssize_t n = readv(tun_fd, iov, 3);
+    if (n < 0) {
+        return -1;
+    }
+    if (n < (ssize_t)TUN_VNET_HDR_LEN) {
+        errno = EINVAL;
+        return -1;
+    }
+    n -= TUN_VNET_HDR_LEN;
+    
+    // 넘쳤거나 GSO 묶음이면 stage 한 곳에 이어 붙임 (세그먼트가 buf를 덮어쓰므로)
+    if ((size_t)n > buf_len || vh->gso_type != VIRTIO_NET_HDR_GSO_NONE) {
+        memcpy(stage, buf, (size_t)n < buf_len ? (size_t)n : buf_len);
+        *packet = stage;
+    } else {
+        *packet = buf;
+    }
+    
+    return n;
+}
+
+// 부분 체크섬 완성 (csum_start부터 끝까지 더해 csum_offset 위치에 기록)
+int tun_finish_checksum(const struct virtio_net_hdr *vh, uint8_t *pkt, size_t len) {
+    if (!(vh->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM)) {
+        return 0;
+    }
+    
+    size_t start = vh->csum_start;
+    size_t field = start + vh->csum_offset;
+    if (field + 2 > len) {
+        return -1;
+    }
+    
+    // 필드에는 의사 헤더 합이 들어 있음
+    uint16_t check = ~csum_fold(csum_partial(pkt + start, len - start, 0));
+    memcpy(pkt + field, &check, 2);
+    return 0;
+}
+
+// TCP 세그먼트 분할 시작
+int tun_gso_begin(tun_gso_iter_t *it, const struct virtio_net_hdr *vh,
+                  const uint8_t *pkt, size_t len) {
+    uint8_t type = vh->gso_type & ~VIRTIO_NET_HDR_GSO_ECN;
+    
+    memset(it, 0, sizeof(*it));
+    it->pkt = pkt;
+    it->len = len;
+    it->mss = vh->gso_size;
+    
+    if (type == VIRTIO_NET_HDR_GSO_TCPV4) {
+        const struct iphdr *ip = (const struct iphdr*)pkt;
+        if (len < sizeof(*ip) || ip->version != 4 || ip->protocol != IPPROTO_TCP) {
+            return -1;
+        }
+        it->l4_off = ip->ihl * 4;
+    } else if (type == VIRTIO_NET_HDR_GSO_TCPV6) {
+        const struct ip6_hdr *ip6 = (const struct ip6_hdr*)pkt;
+        if (len < sizeof(*ip6) || ip6->ip6_nxt != IPPROTO_TCP) {
+            return -1;   // 확장 헤더는 지원 안 함
+        }
+        it->l4_off = sizeof(*ip6);
+        it->ipv6 = 1;
+    } else {
+        return -1;
+    }
+    
+    if (it->l4_off + sizeof(struct tcphdr) > len) {
+        return -1;
+    }
+    
+    const struct tcphdr *tcp = (const struct tcphdr*)(pkt + it->l4_off);
+    it->hdr_len = it->l4_off + tcp->th_off * 4;
+    
+    if (it->hdr_len > len || it->mss == 0) {
+        return -1;
+    }
+    
+    return 0;
+}
+
+// 다음 세그먼트 만들기 (헤더 복사 + 페이로드 조각 + 헤더/체크섬 수정)
+ssize_t tun_gso_next(tun_gso_iter_t *it, uint8_t *out, size_t out_size) {
+    size_t payload_total = it->len - it->hdr_len;
+    
+    if (it->off >= payload_total) {
+        return 0;
+    }
+    
+    size_t chunk = payload_total - it->off;
+    if (chunk > it->mss) {
+        chunk = it->mss;
+    }
+    
+    size_t seg_len = it->hdr_len + chunk;
+    if (seg_len > out_size) {
+        return -1;
+    }
+    
+    int last = (it->off + chunk == payload_total);
+    
+    memcpy(out, it->pkt, it->hdr_len);
+    memcpy(out + it->hdr_len, it->pkt + it->hdr_len + it->off, chunk);
+    
+    // IP 헤더: 길이, ID, 체크섬
+    if (it->ipv6) {
+        struct ip6_hdr *ip6 = (struct ip6_hdr*)out;
+        ip6->ip6_plen = htons((uint16_t)(seg_len - sizeof(*ip6)));
+    } else {
+        struct iphdr *ip = (struct iphdr*)out;
+        ip->tot_len = htons((uint16_t)seg_len);
+        ip->id = htons((uint16_t)(ntohs(ip->id) + it->index));
+        ip_fix_checksum(ip);
+    }
+    
+    // TCP 헤더: 시퀀스, 플래그 (FIN/PSH는 마지막만, CWR은 첫 번째만), 체크섬
+    struct tcphdr *tcp = (struct tcphdr*)(out + it->l4_off);
+    uint8_t *flags = out + it->l4_off + TCP_FLAGS_OFF;
+    
+    tcp->th_seq = htonl(ntohl(tcp->th_seq) + (uint32_t)it->off);
+    if (!last) {
+        *flags &= ~(TCP_FLAG_FIN | TCP_FLAG_PSH);
+    }
+    if (it->index > 0) {
+        *flags &= ~TCP_FLAG_CWR;
+    }
+    
+    size_t l4_len = seg_len - it->l4_off;
+    tcp->th_sum = 0;
+    tcp->th_sum = ~csum_fold(csum_partial(out + it->l4_off, l4_len,
+                                          tcp_pseudo_sum(out, it->ipv6, l4_len)));
+    
+    it->off += chunk;
+    it->index++;
+    
+    return seg_len;
+}
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 오프로드 모드: 쓰기 (연속 TCP 세그먼트 → GSO write 1회)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+void tun_gro_init(tun_gro_t *gro) {
+    memset(gro, 0, sizeof(*gro));
+    gro->iov[0].iov_base = &gro->vh;
+    gro->iov[0].iov_len = TUN_VNET_HDR_LEN;
+}
+
+// 묶을 수 있는 TCP 패킷이면 L4 오프셋, 아니면 0
+// (옵션 없는 IP, 단편 아님, 페이로드 있음, 플래그는 ACK / ACK+PSH 만)
+static size_t gro_tcp_offset(const uint8_t *pkt, size_t len, int *ipv6) {
+    size_t l4_off;
+    
+    if (len < sizeof(struct iphdr)) {
+        return 0;
+    }
+    
+    if ((pkt[0] >> 4) == 4) {
+        const struct iphdr *ip = (const struct iphdr*)pkt;
+        if (ip->ihl != 5 || ip->protocol != IPPROTO_TCP ||
+            (ntohs(ip->frag_off) & (IP_MF | IP_OFFMASK)) ||
+            ntohs(ip->tot_len) != len) {
+            return 0;
+        }
+        l4_off = sizeof(*ip);
+        *ipv6 = 0;
+    } else if ((pkt[0] >> 4) == 6) {
+        const struct ip6_hdr *ip6 = (const struct ip6_hdr*)pkt;
+        if (len < sizeof(*ip6) || ip6->ip6_nxt != IPPROTO_TCP ||
+            ntohs(ip6->ip6_plen) + sizeof(*ip6) != len) {
+            return 0;
+        }
+        l4_off = sizeof(*ip6);
+        *ipv6 = 1;
+    } else {
+        return 0;
+    }
+    
+    if (l4_off + sizeof(struct tcphdr) > len) {
+        return 0;
+    }
+    
+    const struct tcphdr *tcp = (const struct tcphdr*)(pkt + l4_off);
+    uint8_t flags = pkt[l4_off + TCP_FLAGS_OFF];
+    
+    if ((flags & ~TCP_FLAG_PSH) != TCP_FLAG_ACK ||
+        l4_off + tcp->th_off * 4 >= len) {
+        return 0;
+    }
+    
+    return l4_off;
+}
+
+// 헤더 비교: 같은 흐름 + 같은 ACK/윈도우/옵션이어야 이어 붙일 수 있음
+static int gro_same_flow(const tun_gro_t *gro, const uint8_t *pkt) {
+    const uint8_t *first = gro->first;
+    
+    if (gro->ipv6) {
+        // 버전/트래픽 클래스/흐름 레이블, 다음 헤더, 홉 제한, 주소
+        if (memcmp(first, pkt, 4) != 0 || memcmp(first + 6, pkt + 6, 34) != 0) {
+            return 0;
+        }
+    } else {
+        const struct iphdr *a = (const struct iphdr*)first;
+        const struct iphdr *b = (const struct iphdr*)pkt;
+        if (a->tos != b->tos || a->ttl != b->ttl ||
+            a->saddr != b->saddr || a->daddr != b->daddr ||
+            (a->frag_off & htons(IP_DF)) != (b->frag_off & htons(IP_DF))) {
+            return 0;
+        }
+    }
+    
+    const struct tcphdr *ta = (const struct tcphdr*)(first + gro->l4_off);
+    const struct tcphdr *tb = (const struct tcphdr*)(pkt + gro->l4_off);
+    
+    return ta->th_sport == tb->th_sport && ta->th_dport == tb->th_dport &&
+           ta->th_off == tb->th_off && ta->th_ack == tb->th_ack &&
+           ta->th_win == tb->th_win &&
+           memcmp(ta + 1, tb + 1, ta->th_off * 4 - sizeof(*ta)) == 0;
+}
+
+// 패킷 1개를 그대로 쓰기 (GSO 없음)
+static int gro_write_single(int tun_fd, uint8_t *pkt, size_t len) {
+    struct virtio_net_hdr vh;
+    memset(&vh, 0, sizeof(vh));
+    
+    struct iovec iov[2] = {
+        { .iov_base = &vh, .iov_len = TUN_VNET_HDR_LEN },
+        { .iov_base = pkt, .iov_len = len },
+    };
+    
+    if (writev(tun_fd, iov, 2) < 0) {
+        perror("❌ TUN write failed");
+        return -1;
+    }
+    return 0;
+}
+
+// 모인 세그먼트 쓰기
+int tun_gro_flush(tun_gro_t *gro, int tun_fd) {
+    if (gro->segments == 0) {
+        return 0;
+    }
+    
+    int segments = gro->segments;
+    gro->segments = 0;
+    
+    if (segments == 1) {
+        return gro_write_single(tun_fd, gro->first, gro->total);
+    }
+    
+    // 첫 패킷 헤더를 묶음 전체 기준으로 수정
+    uint8_t *first = gro->first;
+    size_t l4_len = gro->total - gro->l4_off;
+    
+    if (gro->ipv6) {
+        ((struct ip6_hdr*)first)->ip6_plen = htons((uint16_t)l4_len);
+    } else {
+        struct iphdr *ip = (struct iphdr*)first;
+        ip->tot_len = htons((uint16_t)gro->total);
+        ip_fix_checksum(ip);
+    }
+    
+    first[gro->l4_off + TCP_FLAGS_OFF] |= gro->push;
+    
+    // 부분 체크섬: 필드에는 의사 헤더 합만 (나머지는 커널이 계산)
+    uint16_t pseudo = csum_fold(tcp_pseudo_sum(first, gro->ipv6, l4_len));
+    memcpy(first + gro->l4_off + TCP_CHECK_OFF, &pseudo, 2);
+    
+    memset(&gro->vh, 0, sizeof(gro->vh));
+    gro->vh.flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+    gro->vh.gso_type = gro->ipv6 ? VIRTIO_NET_HDR_GSO_TCPV6 : VIRTIO_NET_HDR_GSO_TCPV4;
+    gro->vh.gso_size = gro->mss;
+    gro->vh.hdr_len = gro->hdr_len;
+    gro->vh.csum_start = gro->l4_off;
+    gro->vh.csum_offset = TCP_CHECK_OFF;
+    
+    if (writev(tun_fd, gro->iov, segments + 1) < 0) {
+        perror("❌ TUN write failed");
+        return -1;
+    }
+    return 0;
+}
+
+// 복호화된 패킷 1개 추가 (이어 붙이거나, 앞의 묶음을 쓰고 새로 시작)
+int tun_gro_add(tun_gro_t *gro, int tun_fd, uint8_t *pkt, size_t len) {
+    int ipv6 = 0;
+    size_t l4_off = gro_tcp_offset(pkt, len, &ipv6);
+    
+    if (l4_off && gro->segments > 0 && !gro->closed &&
+        ipv6 == gro->ipv6 && gro->segments < TUN_GRO_MAX_SEGMENTS) {
+        const struct tcphdr *tcp = (const struct tcphdr*)(pkt + l4_off);
+        size_t hdr_len = l4_off + tcp->th_off * 4;
+        size_t payload = len - hdr_len;
+        
+        if (hdr_len == gro->hdr_len && payload <= gro->mss &&
+            ntohl(tcp->th_seq) == gro->next_seq &&
+            gro->total + payload <= 0xFFFF &&
+            gro_same_flow(gro, pkt)) {
+            gro->iov[gro->segments + 1].iov_base = pkt + hdr_len;
+            gro->iov[gro->segments + 1].iov_len = payload;
+            gro->segments++;
+            gro->total += payload;
+            gro->next_seq += (uint32_t)payload;
+            gro->push = pkt[l4_off + TCP_FLAGS_OFF] & TCP_FLAG_PSH;
+            gro->closed = (payload < gro->mss) || gro->push;
+            return 0;
+        }
+    }
+    
+    if (tun_gro_flush(gro, tun_fd) != 0) {
+        return -1;
+    }
+    
+    if (!l4_off) {
+        return gro_write_single(tun_fd, pkt, len);
+    }
+    
+    // 새 묶음 시작
+    const struct tcphdr *tcp = (const struct tcphdr*)(pkt + l4_off);
+    
+    gro->first = pkt;
+    gro->ipv6 = ipv6;
+    gro->l4_off = l4_off;
+    gro->hdr_len = l4_off + tcp->th_off * 4;
+    gro->mss = len - gro->hdr_len;
+    gro->total = len;
+    gro->next_seq = ntohl(tcp->th_seq) + (uint32_t)gro->mss;
+    gro->push = pkt[l4_off + TCP_FLAGS_OFF] & TCP_FLAG_PSH;
+    gro->closed = gro->push;
+    gro->iov[1].iov_base = pkt;
+    gro->iov[1].iov_len = len;
+    gro->segments = 1;
+    
+    return 0;
+}
@@ -1,12 +1,26 @@
 // src/server/udp_server.c
 
+#define _GNU_SOURCE
 #include "udp_server.h"
 #include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <netinet/udp.h>
+
+// 오래된 libc 헤더 대비 (값은 커널 ABI)
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
 
 // UDP 서버 생성
 int create_udp_server(uint16_t port) {
@@ -42,9 +56,49 @@ int create_udp_server(uint16_t port) {
     
     printf("✅ UDP server created and bound to port %u (fd=%d)\n", port, udp_fd);
     
+    // 5. GSO/GRO (지원하지 않는 커널이면 일반 배치 송수신만 사용)
+    int offload = udp_enable_offload(udp_fd);
+    printf("   Offload: GSO %s, GRO %s\n",
+           (offload & UDP_OFFLOAD_GSO) ? "on" : "off",
+           (offload & UDP_OFFLOAD_GRO) ? "on" : "off");
+    
     return udp_fd;
 }
 
+// UDP_GRO 켜기 + UDP_SEGMENT 지원 확인
+int udp_enable_offload(int udp_fd) {
+    int one = 1;
+    
+    if (setsockopt(udp_fd, SOL_UDP, UDP_GRO, &one, sizeof(one)) < 0) {
+        // 지원 안 하는 커널은 조용히 넘어감
+        if (errno != ENOPROTOOPT && errno != EINVAL) {
+            perror("⚠️  Warning: setsockopt UDP_GRO failed");
+        }
+    }
+    
+    return udp_offload_flags(udp_fd);
+}
+
+// 현재 켜진 오프로드 조회
+int udp_offload_flags(int udp_fd) {
+    int flags = 0;
+    int value = 0;
+    socklen_t len = sizeof(value);
+    
+    // UDP_SEGMENT 는 메시지마다 cmsg로 지정하므로 옵션 조회 성공 = 지원
+    if (getsockopt(udp_fd, SOL_UDP, UDP_SEGMENT, &value, &len) == 0) {
+        flags |= UDP_OFFLOAD_GSO;
+    }
+    
+    value = 0;
+    len = sizeof(value);
+    if (getsockopt(udp_fd, SOL_UDP, UDP_GRO, &value, &len) == 0 && value) {
+        flags |= UDP_OFFLOAD_GRO;
+    }
+    
+    return flags;
+}
+
 // UDP 패킷 수신
 ssize_t udp_recv(int udp_fd, uint8_t *buffer, size_t buffer_size,
                  struct sockaddr_in *client_addr) {
@@ -54,7 +108,10 @@ ssize_t udp_recv(int udp_fd, uint8_t *buffer, size_t buffer_size,
                          (struct sockaddr*)client_addr, &addr_len);
     
     if (n < 0) {
-        perror("❌ UDP recvfrom failed");
+        // 논블로킹 소켓: 더 읽을 패킷이 없는 경우는 오류 아님
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            perror("❌ UDP recvfrom failed");
+        }
         return -1;
     }
     
@@ -75,3 +132,162 @@ ssize_t udp_send(int udp_fd, const uint8_t *buffer, size_t length,
     
     return n;
 }
+
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+// 배치 송수신 (recvmmsg / sendmmsg)
+// ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+
+// 배치 메시지 1개 준비
+void udp_batch_prepare(struct mmsghdr *msg, struct iovec *iov,
+                       struct sockaddr_in *addr, uint8_t *buffer, size_t length) {
+    iov->iov_base = buffer;
+    iov->iov_len = length;
+    
+    memset(msg, 0, sizeof(*msg));
+    msg->msg_hdr.msg_name = addr;
+    msg->msg_hdr.msg_namelen = sizeof(*addr);
+    msg->msg_hdr.msg_iov = iov;
+    msg->msg_hdr.msg_iovlen = 1;
+}
+
+// GSO 메시지 준비
+void udp_batch_prepare_gso(struct mmsghdr *msg, struct iovec *iov, size_t iov_count,
+                           struct sockaddr_in *addr, udp_cmsg_t *ctrl,
+                           uint16_t segment_size) {
+    memset(msg, 0, sizeof(*msg));
+    msg->msg_hdr.msg_name = addr;
+    msg->msg_hdr.msg_namelen = sizeof(*addr);
+    msg->msg_hdr.msg_iov = iov;
+    msg->msg_hdr.msg_iovlen = iov_count;
+    
+    // 세그먼트 1개면 일반 데이터그램
+    if (iov_count < 2) {
+        return;
+    }
+    
+    memset(ctrl, 0, sizeof(*ctrl));
+    msg->msg_hdr.msg_control = ctrl->buf;
+    msg->msg_hdr.msg_controllen = sizeof(ctrl->buf);
+    
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&msg->msg_hdr);
+    cm->cmsg_level = SOL_UDP;
+    cm->cmsg_type = UDP_SEGMENT;
+    cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    memcpy(CMSG_DATA(cm), &segment_size, sizeof(segment_size));
+}
+
+// GRO 수신 메시지 준비
+void udp_batch_prepare_gro(struct mmsghdr *msg, struct iovec *iov,
+                           struct sockaddr_in *addr, uint8_t *buffer, size_t length,
+                           udp_cmsg_t *ctrl) {
+    udp_batch_prepare(msg, iov, addr, buffer, length);
+    msg->msg_hdr.msg_control = ctrl->buf;
+    msg->msg_hdr.msg_controllen = sizeof(ctrl->buf);
+}
+
+// 수신한 메시지의 GRO 세그먼트 크기
+size_t udp_gro_segment_size(const struct mmsghdr *msg) {
+    if (!msg->msg_hdr.msg_control) {
+        return 0;
+    }
+    
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg->msg_hdr); cm;
+         cm = CMSG_NXTHDR((struct msghdr*)&msg->msg_hdr, cm)) {
+        if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+            int segment_size;
+            memcpy(&segment_size, CMSG_DATA(cm), sizeof(segment_size));
+            // 세그먼트 크기 이하면 묶인 게 아님
+            return (size_t)segment_size < msg->msg_len ? (size_t)segment_size : 0;
+        }
+    }
+    
+    return 0;
+}
+
+// 여러 패킷 한 번에 수신
+int udp_recv_batch(int udp_fd, struct mmsghdr *msgs, unsigned int count) {
+    // recvmmsg가 msg_namelen / msg_controllen을 덮어쓰므로 매번 초기화
+    for (unsigned int i = 0; i < count; i++) {
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        msgs[i].msg_hdr.msg_flags = 0;
+        if (msgs[i].msg_hdr.msg_control) {
+            msgs[i].msg_hdr.msg_controllen = sizeof(udp_cmsg_t);
+        }
+    }
+    
+    int n = recvmmsg(udp_fd, msgs, count, MSG_DONTWAIT, NULL);
+    
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        perror("❌ UDP recvmmsg failed");
+        return -1;
+    }
+    
+    return n;
+}
+
+// GSO 메시지를 세그먼트(iov)별 데이터그램으로 나눠 전송
+// 반환값: 보낸 바이트 수 (하나라도 전송), 0 (전부 실패)
+static unsigned int send_segments(int udp_fd, const struct msghdr *hdr) {
+    unsigned int bytes = 0;
+    
+    for (size_t i = 0; i < hdr->msg_iovlen; i++) {
+        ssize_t n = sendto(udp_fd, hdr->msg_iov[i].iov_base, hdr->msg_iov[i].iov_len, 0,
+                           (const struct sockaddr*)hdr->msg_name, hdr->msg_namelen);
+        if (n >= 0) {
+            bytes += (unsigned int)n;
+        }
+    }
+    
+    return bytes;
+}
+
+// 여러 패킷 한 번에 전송
+int udp_send_batch(int udp_fd, struct mmsghdr *msgs, unsigned int count) {
+    unsigned int next = 0;
+    int sent = 0;
+    
+    // 메시지별 결과는 msg_len으로 알림 (sendmmsg가 보낸 메시지만 채우므로 먼저 0으로)
+    for (unsigned int i = 0; i < count; i++) {
+        msgs[i].msg_len = 0;
+    }
+    
+    // sendmmsg는 일부만 보내고 반환할 수 있으므로 남은 것을 이어서 전송
+    while (next < count) {
+        int n = sendmmsg(udp_fd, msgs + next, count - next, 0);
+        
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;  // 송신 버퍼 가득: 나머지는 드롭 (UDP)
+            }
+            // GSO 거부 시 나눠서 전송
+            //   EIO:      출력 장치가 체크섬 오프로드를 못 함
+            //   EMSGSIZE: 세그먼트가 경로 MTU보다 큼 (일반 전송은 IP 단편화로 나감)
+            if ((errno == EIO || errno == EMSGSIZE) && msgs[next].msg_hdr.msg_control) {
+                msgs[next].msg_len = send_segments(udp_fd, &msgs[next].msg_hdr);
+                if (msgs[next].msg_len > 0) {
+                    next++;
+                    sent++;
+                    continue;
+                }
+            }
+            perror("❌ UDP sendmmsg failed");
+            next++;     // 첫 메시지가 실패한 것이므로 건너뛰고 계속
+            continue;
+        }
+        
+        next += n;
+        sent += n;
+    }
+    
+    if (sent == 0 && count > 0 && next == count) {
+        return -1;
+    }
+    
+    return sent;
+}
@@ -1,59 +1,278 @@
 // src/server/vpn_server.c
 
+#define _GNU_SOURCE
 #include "tun_manager.h"
 #include "udp_server.h"
 #include "protocol.h"
 #include "client_manager.h"
 #include "enclave.h"
 #include "enclave_client.h"
+#include "ipc_protocol.h"
+#include "logger.h"
+#include "event_loop.h"
+#include "packet_io.h"
+#include "server_stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <signal.h>
+#include <errno.h>
+#include <pthread.h>
+#include <endian.h>
 #include <arpa/inet.h>
-#include <sys/select.h>
+#include <netinet/ip.h>
 
 #define TUN_DEVICE "tun0"
-#define TUN_IP "10.8.0.1"
-#define TUN_NETMASK 24
 #define UDP_PORT 51820
 
+#define BATCH_SIZE IPC_MAX_BATCH   // 배치 1회당 최대 처리 패킷 수
+#define DRAIN_BUDGET 16            // epoll 깨어남 1회당 최대 배치 수 (타이머 굶주림 방지)
+
+#define MAX_TUN_QUEUES IPC_MAX_RINGS   // TUN 큐(워커)마다 Enclave 링 1개
+#define WORKER_WAIT_MS 500              // 워커가 종료 플래그를 확인하는 주기
+
+#define HOUSEKEEPING_INTERVAL_MS 1000   // 하우스키핑 타이머 주기
+#define ENCLAVE_CTL_WINDOW 32           // 동시에 진행할 수 있는 핸드셰이크 수 (기본값)
+
+// epoll 이벤트 태그
+enum {
+    EV_UDP = 1,
+    EV_TUN,
+    EV_ENCLAVE,
+    EV_ENCLAVE_CTL,
+    EV_TIMER
+};
+
 volatile sig_atomic_t running = 1;
+static volatile sig_atomic_t latency_sampling = 0;   // 단계별 지연 측정 (SIGUSR1 켜기 / SIGUSR2 끄기)
 static pid_t enclave_pid = -1;
 static int enclave_fd = -1;
+static enclave_ring_t *enclave_ring = NULL;   // ENCRYPT/DECRYPT 데이터 경로
+static enclave_async_t *enclave_ctl = NULL;   // HANDSHAKE/REMOVE_KEY 제어 경로 (전용 연결, 비동기)
 
 void signal_handler(int sig) {
     if (sig == SIGINT || sig == SIGTERM) {
         printf("\n🛑 Shutting down...\n");
         running = 0;
+    } else if (sig == SIGUSR1 || sig == SIGUSR2) {
+        latency_sampling = (sig == SIGUSR1);
+    }
+}
+
+// 배치 버퍼 (이벤트 루프 1회 분량)
+// 패킷 데이터는 Enclave 링 슬롯에 직접 들어가므로 여기에는 메타데이터만 둔다.
+typedef struct {
+    enclave_ring_packet_t pkts[BATCH_SIZE];         // 예약한 링 슬롯 (패킷 버퍼)
+    client_route_t routes[BATCH_SIZE];              // 패킷별 목적지 (값 복사, 워커가 슬롯 재사용과 경쟁하지 않도록)
+    int count;
+    
+    // recvmmsg / sendmmsg 용 (메시지 i ↔ addrs[i] ↔ ctrls[i])
+    // GSO 묶음 전송 시 메시지 하나가 연속된 iovs 여러 개를 사용
+    struct mmsghdr msgs[BATCH_SIZE];
+    struct iovec iovs[BATCH_SIZE];
+    struct sockaddr_in addrs[BATCH_SIZE];
+    udp_cmsg_t ctrls[BATCH_SIZE];
+    
+    // TUN 오프로드 모드
+    uint8_t gso_buf[TUN_GSO_BUF_SIZE];              // TSO 묶음 읽기 (TUN → UDP)
+    tun_gro_t gro;                                  // TCP 세그먼트 묶어 쓰기 (UDP → TUN)
+} packet_batch_t;
+
+// UDP 수신 분류 상태 (예약 슬롯 → 분류 → 구간 단위 복호화)
+typedef struct {
+    int udp_fd;
+    int tun_fd;
+    client_table_t *table;
+    stats_worker_t *stats;        // 워커 0 (메인 스레드) 카운터
+    stats_client_t *client_stats;
+    stats_latency_t *latency;
+    int reserved;                 // 예약한 슬롯 수
+    int used;                     // 채운 슬롯 수
+    int start;                    // 아직 제출하지 않은 첫 슬롯
+} rx_context_t;
+
+// TUN 큐 워커 (TUN → UDP 방향)
+// 워커 0은 메인 스레드가 UDP와 함께 처리, 나머지는 전용 스레드.
+// 링과 배치 버퍼는 워커 전용이므로 워커 간 공유 상태는 클라이언트 테이블과 UDP 소켓뿐.
+typedef struct {
+    int queue;                    // TUN 큐 번호
+    int tun_fd;                   // 큐 fd
+    enclave_ring_t *ring;         // 워커 전용 Enclave 링 (SPSC)
+    packet_batch_t *batch;        // 워커 전용 배치 버퍼
+    int udp_fd;
+    client_table_t *table;
+    stats_worker_t *stats;        // 워커 전용 통계 블록 (공유 메모리)
+    stats_client_t *client_stats; // 워커 전용 클라이언트 카운터 (슬롯 번호로 인덱스)
+    stats_latency_t *latency;     // 워커 전용 단계별 지연 히스토그램
+    pthread_t thread;
+    int started;                  // 스레드 생성 여부
+} tun_worker_t;
+
+static packet_batch_t rx_batch;   // UDP → TUN (메인 스레드)
+static packet_batch_t tx_batch;   // TUN → UDP (워커 0)
+
+// GRO 수신 버퍼 (묶음 1개 = 최대 64KB, 실제로 쓰인 페이지만 메모리 차지)
+static uint8_t gro_buffers[BATCH_SIZE][UDP_GRO_BUF_SIZE];
+static int udp_offload = 0;       // UDP_OFFLOAD_* (GSO 묶음 전송 / GRO 분할 수신)
+static int tun_offload = 0;       // 1 = TUN fd에 virtio_net_hdr (TSO 읽기 / GSO 쓰기)
+
+static tun_worker_t workers[MAX_TUN_QUEUES];
+static int worker_count = 0;
+static server_stats_t server_stats;   // 공유 메모리 카운터 (워커 블록 + 클라이언트 메타)
+
+// 단계 시작 시각 (측정이 꺼져 있으면 0, TSC를 읽지 않음)
+static inline uint64_t stage_begin(void) {
+    return latency_sampling ? stats_cycles() : 0;
+}
+
+// 단계 끝 (시작 시각이 있을 때만 워커 히스토그램에 기록)
+static inline void stage_end(stats_latency_t *latency, int stage, uint64_t start) {
+    if (start) {
+        stats_hist_record(&latency->stages[stage], stats_cycles() - start);
     }
 }
 
-// UDP에서 받은 패킷 처리 (암호화 통합!)
-void handle_udp_to_tun(int udp_fd, int tun_fd, client_table_t *table) {
-    uint8_t buffer[2048];
-    uint8_t decrypted_buffer[2048];
+// 진행 중인 핸드셰이크 (Enclave 응답이 오면 CONNECT_RESP 전송)
+typedef struct {
+    int udp_fd;
+    client_table_t *table;
     struct sockaddr_in client_addr;
+    uint32_t vpn_ip;
+    uint32_t session_id;          // 응답 전에 클라이언트가 바뀌었는지 확인용
+    uint8_t offered_suites;
+} handshake_ctx_t;
+
+// 핸드셰이크 완료 콜백 (enclave_async_poll 안에서 메인 스레드가 호출)
+static void on_handshake_done(void *user, uint32_t token, int status,
+                              const uint8_t *data, size_t len) {
+    handshake_ctx_t *hs = (handshake_ctx_t*)user;
+    client_table_t *table = hs->table;
+    struct in_addr addr = { .s_addr = hs->vpn_ip };
+    (void)token;
     
-    // UDP에서 패킷 수신
-    ssize_t n = udp_recv(udp_fd, buffer, sizeof(buffer), &client_addr);
+    // 기다리는 동안 DISCONNECT / 타임아웃으로 빠졌거나 다른 세션으로 바뀌었을 수 있음
+    client_entry_t *client = find_client_by_vpn_ip(table, hs->vpn_ip);
+    int current = client && get_client_info(table, client)->session_id == hs->session_id;
     
-    if (n < 0) return;
+    if (status != 0 || len < sizeof(ipc_handshake_response_t)) {
+        printf("   ❌ Handshake failed for %s\n", inet_ntoa(addr));
+        if (current) {
+            remove_client(table, hs->vpn_ip);
+        }
+        free(hs);
+        return;
+    }
     
-    printf("\n📥 UDP Packet Received:\n");
-    printf("   From: %s:%d\n",
-           inet_ntoa(client_addr.sin_addr),
-           ntohs(client_addr.sin_port));
-    printf("   Size: %zd bytes\n", n);
+    if (!current) {
+        printf("   ⚠️  Handshake for %s finished after the client left\n", inet_ntoa(addr));
+        // 새 세션이 이미 같은 IP를 쓰고 있으면 그 핸드셰이크가 키를 교체함
+        if (!client) {
+            enclave_async_remove_key(enclave_ctl, hs->vpn_ip, NULL, NULL);
+        }
+        free(hs);
+        return;
+    }
     
-    // 프로토콜 헤더 확인
-    if (n < (ssize_t)sizeof(vpn_header_t)) {
-        printf("   ⚠️  Packet too short\n");
+    const ipc_handshake_response_t *hs_resp = (const ipc_handshake_response_t*)data;
+    key_handle_t key_handle = ntohl(hs_resp->key_handle);
+    
+    printf("🤝 Handshake complete for %s\n", inet_ntoa(addr));
+    
+    printf("   📤 Sending server public key: ");
+    for (int i = 0; i < 8; i++) {
+        printf("%02x", hs_resp->server_public_key[i]);
+    }
+    printf("...\n");
+    
+    printf("   🔑 Session key (server): ");
+    for (int i = 0; i < 8; i++) {
+        printf("%02x", hs_resp->session_key[i]);
+    }
+    printf("...\n");
+    
+    // 응답 패킷 생성
+    connect_response_t resp;
+    init_vpn_header(&resp.header, PKT_CONNECT_RESP,
+                   sizeof(resp) - sizeof(vpn_header_t));
+    resp.status = 0;  // 성공
+    resp.vpn_ip = hs->vpn_ip;
+    resp.session_id = htonl(hs->session_id);
+    
+    // 데이터 경로는 핸들로 키 조회 (재핸드셰이크 시 새 핸들로 교체)
+    set_client_key_handle(client, key_handle);
+    
+    // 서버 공개키 추가 (reserved 필드 활용)
+    memcpy(resp.server_public_key, hs_resp->server_public_key, 32);
+    printf("   ✅ Server public key copied to response\n");
+    
+    resp.cipher_suite = hs_resp->cipher_suite;
+    resp.pool_prefix = (uint8_t)table->prefix;
+    printf("   🔐 Cipher suite: 0x%02x (offered 0x%02x)\n",
+           hs_resp->cipher_suite, hs->offered_suites);
+    
+    // 응답 전송
+    udp_send(hs->udp_fd, (uint8_t*)&resp, sizeof(resp), &hs->client_addr);
+    
+    printf("   → CONNECT_RESP sent (with server public key)\n");
+    print_client_table(table);
+    free(hs);
+}
+
+// 키 제거 완료 콜백
+static void on_key_removed(void *user, uint32_t token, int status,
+                           const uint8_t *data, size_t len) {
+    struct in_addr addr = { .s_addr = (uint32_t)(uintptr_t)user };
+    (void)token;
+    (void)data;
+    (void)len;
+    
+    if (status == 0) {
+        printf("🔓 Key removed from Enclave for %s\n", inet_ntoa(addr));
+    } else {
+        printf("⚠️  Enclave key removal failed for %s\n", inet_ntoa(addr));
+    }
+}
+
+// RTT 측정 응답 (서버가 보낸 PING의 타임스탬프를 클라이언트가 PONG에 그대로 돌려줌)
+static void handle_rtt_pong(client_table_t *table, const vpn_header_t *header,
+                            struct sockaddr_in *client_addr) {
+    client_entry_t *client = find_client_by_addr(table, client_addr);
+    if (!client) {
         return;
     }
     
+    update_client_activity(table, client);
+    
+    uint64_t sent_ns = be64toh(header->timestamp);
+    uint64_t now_ns = stats_now_ns();
+    if (sent_ns == 0 || sent_ns > now_ns || now_ns - sent_ns > STATS_RTT_MAX_NS) {
+        return;   // 서버 PING에 대한 응답이 아님
+    }
+    
+    server_stats_client_rtt(&server_stats, client_slot(table, client), now_ns - sent_ns);
+    LOG_DEBUG("🏓 RTT %s: %.1f us", inet_ntoa(client->real_addr.sin_addr),
+              (now_ns - sent_ns) / 1000.0);
+}
+
+// 제어 패킷 처리 (CONNECT_REQ, PING, PONG, DISCONNECT)
+static void handle_control_packet(int udp_fd, client_table_t *table,
+                                  uint8_t *buffer, ssize_t n,
+                                  struct sockaddr_in client_addr) {
     vpn_header_t *header = (vpn_header_t*)buffer;
+    
+    // RTT 측정 응답은 클라이언트마다 주기적으로 오므로 출력 없이 처리
+    if (header->type == PKT_PONG) {
+        handle_rtt_pong(table, header, &client_addr);
+        return;
+    }
+    
+    printf("\n📥 UDP Packet Received:\n");
+    printf("   From: %s:%d\n",
+           inet_ntoa(client_addr.sin_addr),
+           ntohs(client_addr.sin_port));
+    printf("   Size: %zd bytes\n", n);
     print_vpn_packet(header);
     
     // 패킷 타입별 처리
@@ -63,6 +282,13 @@ void handle_udp_to_tun(int udp_fd, int tun_fd, client_table_t *table) {
             
             connect_request_t *req = (connect_request_t*)buffer;
             
+            // cipher_suites 필드가 없는 구버전 요청은 ChaCha20-Poly1305 전용으로 취급
+            if (n < (ssize_t)offsetof(connect_request_t, cipher_suites)) {
+                printf("   ❌ CONNECT_REQ too short (%zd bytes)\n", n);
+                return;
+            }
+            uint8_t offered_suites = n >= (ssize_t)sizeof(connect_request_t) ? req->cipher_suites : 0;
+            
             // VPN IP 할당
             uint32_t vpn_ip = add_client(table, &client_addr);
             
@@ -71,91 +297,35 @@ void handle_udp_to_tun(int udp_fd, int tun_fd, client_table_t *table) {
                 return;
             }
             
-            // 🔐 ECDH 핸드셰이크 (NEW!)
-            uint8_t server_public_key[32];
-            uint8_t session_key[32];
-            uint8_t client_public_key[32];
-            
-            // 클라이언트 공개키는 auth_token 필드에 임시로 저장
-            // (실제로는 별도 필드 추가 필요)
-            memcpy(client_public_key, req->auth_token, 32);
-            
-            printf("   🔐 Performing ECDH handshake...\n");
-            if (enclave_handshake(enclave_fd, vpn_ip,
-                                 client_public_key,
-                                 server_public_key,
-                                 session_key) != 0) {
-                printf("   ❌ Handshake failed\n");
-                remove_client(table, vpn_ip);
-                return;
-            }
-
-	    printf("   📤 Sending server public key: ");
-	    for (int i = 0; i < 8; i++) {
-		    printf("%02x", server_public_key[i]);
-	    }
-	    printf("...\n");
-
-	    printf("   🔑 Session key (server): ");
-	    for (int i = 0; i < 8; i++) {
-		    printf("%02x", session_key[i]);
-	    }
-	    printf("...\n");
-            
-            // 응답 패킷 생성
-            connect_response_t resp;
-            init_vpn_header(&resp.header, PKT_CONNECT_RESP, 
-                           sizeof(resp) - sizeof(vpn_header_t));
-            resp.status = 0;  // 성공
-            resp.vpn_ip = vpn_ip;
-            
-            client_entry_t *client = find_client_by_addr(table, &client_addr);
-            resp.session_id = htonl(client->session_id);
-            
-            // 서버 공개키 추가 (reserved 필드 활용)
-           memcpy(resp.server_public_key, server_public_key, 32);
-	   printf("   ✅ Server public key copied to response\n");
-
-
-            // 응답 전송
-            udp_send(udp_fd, (uint8_t*)&resp, sizeof(resp), &client_addr);
-            
-            printf("   → CONNECT_RESP sent (with server public key)\n");
-            print_client_table(table);
-            break;
-        }
-        
-        case PKT_DATA: {
-            // 클라이언트 찾기
             client_entry_t *client = find_client_by_addr(table, &client_addr);
             if (!client) {
-                printf("   ⚠️  Unknown client\n");
+                printf("   ❌ Client vanished before handshake\n");
                 return;
             }
             
-            update_client_activity(client);
-            
-            // 🔐 암호문 복호화 (NEW!)
-            uint8_t *ciphertext = buffer + sizeof(vpn_header_t);
-            size_t ciphertext_len = n - sizeof(vpn_header_t);
-            
-            printf("   🔓 Decrypting %zu bytes...\n", ciphertext_len);
-            
-            size_t plaintext_len;
-            if (enclave_decrypt(enclave_fd, client->vpn_ip,
-                               ciphertext, ciphertext_len,
-                               decrypted_buffer, &plaintext_len) != 0) {
-                printf("   ❌ Decryption failed (wrong key or corrupted)\n");
+            // 🔐 ECDH 핸드셰이크 (비동기: 응답이 오면 on_handshake_done에서 CONNECT_RESP)
+            handshake_ctx_t *hs = (handshake_ctx_t*)malloc(sizeof(handshake_ctx_t));
+            if (!hs) {
+                perror("malloc");
+                remove_client(table, vpn_ip);
                 return;
             }
+            hs->udp_fd = udp_fd;
+            hs->table = table;
+            hs->client_addr = client_addr;
+            hs->vpn_ip = vpn_ip;
+            hs->session_id = get_client_info(table, client)->session_id;
+            hs->offered_suites = offered_suites;
             
-            printf("   ✅ Decrypted to %zu bytes\n", plaintext_len);
-            
-            // TUN에 쓰기
-            ssize_t written = write(tun_fd, decrypted_buffer, plaintext_len);
-            if (written > 0) {
-                printf("   → TUN: Written %zd bytes\n", written);
-                print_ip_packet(decrypted_buffer, written);
+            // 클라이언트 공개키는 auth_token 필드에 임시로 저장
+            // (실제로는 별도 필드 추가 필요)
+            printf("   🔐 Performing ECDH handshake...\n");
+            if (enclave_async_handshake(enclave_ctl, vpn_ip, req->auth_token, offered_suites,
+                                        on_handshake_done, hs) == 0) {
+                printf("   ❌ Handshake failed\n");
+                free(hs);
+                remove_client(table, vpn_ip);
+                return;
             }
             break;
         }
@@ -165,7 +335,7 @@ void handle_udp_to_tun(int udp_fd, int tun_fd, client_table_t *table) {
             
             client_entry_t *client = find_client_by_addr(table, &client_addr);
             if (client) {
-                update_client_activity(client);
+                update_client_activity(table, client);
             }
             
             vpn_header_t pong;
@@ -178,8 +348,9 @@ void handle_udp_to_tun(int udp_fd, int tun_fd, client_table_t *table) {
             printf("   → DISCONNECT received\n");
             client_entry_t *client = find_client_by_addr(table, &client_addr);
             if (client) {
-                // Enclave에서 키 제거
-                enclave_remove_key(enclave_fd, client->vpn_ip);
+                // Enclave에서 키 제거 (같은 연결이므로 이후 핸드셰이크보다 먼저 처리됨)
+                enclave_async_remove_key(enclave_ctl, client->vpn_ip, on_key_removed,
+                                         (void*)(uintptr_t)client->vpn_ip);
                 remove_client(table, client->vpn_ip);
                 print_client_table(table);
             }
@@ -191,100 +362,843 @@ void handle_udp_to_tun(int udp_fd, int tun_fd, client_table_t *table) {
     }
 }
 
-// TUN에서 받은 패킷 처리 (암호화 통합!)
-void handle_tun_to_udp(int tun_fd, int udp_fd, client_table_t *table) {
-    uint8_t buffer[2048];
-    uint8_t encrypted_buffer[2048];
-    uint8_t packet_buffer[2048];
+// Enclave 링 제출 1회 + IPC 카운터 (지연, 배치 크기 분포)
+// stage: STATS_STAGE_DECRYPT / STATS_STAGE_ENCRYPT
+// 반환값: enclave_ring_process 결과
+static int process_batch(enclave_ring_t *ring, enclave_ring_packet_t *pkts, int count,
+                         stats_worker_t *stats, stats_latency_t *latency, int stage) {
+    uint64_t *batch_hist = (stage == STATS_STAGE_DECRYPT) ? stats->rx_batch_hist
+                                                          : stats->tx_batch_hist;
+    uint64_t t = stage_begin();
+    uint64_t start = stats_now_ns();
+    int ret = enclave_ring_process(ring, pkts, count);
+    uint64_t elapsed = stats_now_ns() - start;
+    stage_end(latency, stage, t);
+    
+    if (ret < 0) {
+        stats_add(&stats->ipc_failures, 1);
+        stats_add(&stats->drops[STATS_DROP_IPC], count);
+        return ret;
+    }
+    
+    stats_add(&stats->ipc_batches, 1);
+    stats_add(&stats->ipc_packets, count);
+    stats_add(&stats->ipc_ns_total, elapsed);
+    stats_max(&stats->ipc_ns_max, elapsed);
+    stats_add(&batch_hist[stats_batch_bucket(count)], 1);
+    return ret;
+}
+
+// 예약 슬롯 [start, start + count)를 한 번에 복호화하여 TUN에 쓰기
+// (복호화는 슬롯 안에서 제자리로, TUN write도 슬롯에서 바로)
+static void flush_decrypt_batch(rx_context_t *rx, int start, int count) {
+    enclave_ring_packet_t *pkts = &rx_batch.pkts[start];
+    const client_route_t *routes = &rx_batch.routes[start];
+    int tun_fd = rx->tun_fd;
     
-    // TUN에서 패킷 읽기
-    ssize_t n = read(tun_fd, buffer, sizeof(buffer));
+    if (count == 0) {
+        return;
+    }
     
-    if (n < 0) {
-        perror("❌ TUN read failed");
+    // 🔐 배치 복호화 (링 제출 1회)
+    if (process_batch(enclave_ring, pkts, count, rx->stats, rx->latency,
+                      STATS_STAGE_DECRYPT) < 0) {
+        fprintf(stderr, "   ❌ Batch decryption failed (%d packets)\n", count);
         return;
     }
     
-    printf("\n📤 TUN Packet Received:\n");
-    printf("   Size: %zd bytes\n", n);
-    print_ip_packet(buffer, n);
+    uint64_t t = stage_begin();
     
-    // IP 헤더에서 목적지 확인
-    if (n < 20) {
-        printf("   ⚠️  Packet too short for IP\n");
+    for (int i = 0; i < count; i++) {
+        packet_buf_t *pkt = &pkts[i].pkt;
+        
+        if (pkts[i].command == 0) {
+            continue;   // 제어 패킷 / 버린 패킷 자리
+        }
+        
+        stats_client_t *cs = &rx->client_stats[routes[i].slot];
+        
+        if (pkts[i].status != 0) {
+            LOG_DEBUG("   ❌ Decryption failed (wrong key or corrupted)");
+            stats_add(&cs->decrypt_failures, 1);
+            continue;
+        }
+        
+        stats_add(&cs->rx_packets, 1);
+        stats_add(&cs->rx_bytes, pkt->len);
+        
+        if (g_log_level >= LOG_DEBUG) {
+            print_ip_packet(pkt->data, pkt->len);
+        }
+        
+        // 오프로드 모드: 같은 TCP 흐름의 연속 세그먼트를 묶어서 한 번에 쓰기
+        if (tun_offload) {
+            tun_gro_add(&rx_batch.gro, tun_fd, pkt->data, pkt->len);
+            stats_add(&rx->stats->tun_tx_packets, 1);
+            continue;
+        }
+        
+        // TUN에 쓰기
+        ssize_t written = write(tun_fd, pkt->data, pkt->len);
+        if (written > 0) {
+            LOG_DEBUG("   → TUN: Written %zd bytes", written);
+            stats_add(&rx->stats->tun_tx_packets, 1);
+        } else {
+            stats_add(&rx->stats->tun_tx_errors, 1);
+            stats_add(&cs->drops[CLIENT_DROP_TUN_WRITE], 1);
+        }
+    }
+    
+    // 슬롯은 다음 예약 전까지만 유효하므로 여기서 모두 쓰기
+    if (tun_offload) {
+        tun_gro_flush(&rx_batch.gro, tun_fd);
+    }
+    stage_end(rx->latency, STATS_STAGE_TUN_WRITE, t);
+}
+
+// 슬롯 i에 채워진 UDP 패킷 분류
+// DATA → 복호화 대기 (command 설정), 제어 → 앞선 DATA를 처리한 뒤 바로 처리
+static void rx_dispatch(rx_context_t *rx, int i, struct sockaddr_in *client_addr) {
+    enclave_ring_packet_t *rp = &rx_batch.pkts[i];
+    ssize_t n = rp->pkt.len;
+    
+    // 프로토콜 헤더 확인
+    if (n < (ssize_t)sizeof(vpn_header_t)) {
+        LOG_DEBUG("   ⚠️  Packet too short (%zd bytes)", n);
+        stats_add(&rx->stats->drops[STATS_DROP_SHORT], 1);
+        return;
+    }
+    
+    vpn_header_t *header = (vpn_header_t*)rp->pkt.data;
+    
+    if (header->type != PKT_DATA) {
+        // 제어 패킷 앞의 DATA는 먼저 처리 (순서 유지)
+        // 제어 패킷 슬롯은 command=0으로 다음 제출에 섞여 그냥 반환된다.
+        flush_decrypt_batch(rx, rx->start, i - rx->start);
+        rx->start = i;
+        handle_control_packet(rx->udp_fd, rx->table, rp->pkt.data, n, *client_addr);
+        return;
+    }
+    
+    // 클라이언트 찾기
+    client_entry_t *client = find_client_by_addr(rx->table, client_addr);
+    if (!client) {
+        LOG_DEBUG("   ⚠️  Unknown client %s:%d",
+                  inet_ntoa(client_addr->sin_addr), ntohs(client_addr->sin_port));
+        stats_add(&rx->stats->drops[STATS_DROP_UNKNOWN_CLIENT], 1);
         return;
     }
     
-    struct iphdr {
-        uint8_t  ihl:4, version:4;
-        uint8_t  tos;
-        uint16_t tot_len;
-        uint16_t id;
-        uint16_t frag_off;
-        uint8_t  ttl;
-        uint8_t  protocol;
-        uint16_t check;
-        uint32_t saddr;
-        uint32_t daddr;
-    } __attribute__((packed));
+    update_client_activity(rx->table, client);
+    
+    LOG_DEBUG("📥 DATA from %s:%d (%zd bytes)",
+              inet_ntoa(client_addr->sin_addr), ntohs(client_addr->sin_port), n);
     
-    struct iphdr *ip = (struct iphdr*)buffer;
+    // VPN 헤더를 벗기고 [카운터][암호문 + MAC]만 Enclave로
+    pkt_pull(&rp->pkt, sizeof(vpn_header_t));
+    client_route_t *route = &rx_batch.routes[i];
+    client_route_fill(rx->table, client, route);
+    rp->command = IPC_DECRYPT;
+    rp->vpn_ip = route->vpn_ip;
+    rp->key_handle = route->key_handle;
+}
+
+// GRO 묶음을 데이터그램 단위로 잘라 슬롯에 복사 후 분류
+// (슬롯이 모자라면 지금까지를 처리하고 다시 예약)
+static int rx_split_gro(rx_context_t *rx, const uint8_t *buffer, size_t len,
+                        size_t segment_size, struct sockaddr_in *client_addr) {
+    if (segment_size == 0) {
+        segment_size = len;   // 묶이지 않은 단일 데이터그램
+    }
+    
+    for (size_t off = 0; off < len; off += segment_size) {
+        size_t seg_len = len - off < segment_size ? len - off : segment_size;
+        
+        if (rx->used == rx->reserved) {
+            flush_decrypt_batch(rx, rx->start, rx->used - rx->start);
+            rx->reserved = enclave_ring_reserve(enclave_ring, rx_batch.pkts, BATCH_SIZE, 0);
+            rx->used = rx->start = 0;
+            if (rx->reserved <= 0) {
+                stats_add(&rx->stats->ipc_failures, 1);
+                return -1;
+            }
+        }
+        
+        packet_buf_t *pkt = &rx_batch.pkts[rx->used].pkt;
+        uint8_t *dst = pkt_put(pkt, seg_len);
+        if (!dst) {
+            LOG_DEBUG("   ⚠️  Datagram too large (%zu bytes)", seg_len);
+            stats_add(&rx->stats->drops[STATS_DROP_OVERSIZE], 1);
+            continue;   // 빈 슬롯은 다음 세그먼트가 재사용
+        }
+        memcpy(dst, buffer + off, seg_len);
+        stats_add(&rx->stats->udp_rx_packets, 1);
+        
+        rx_dispatch(rx, rx->used++, client_addr);
+    }
+    
+    return 0;
+}
+
+// recvmmsg 호출 카운터 (0 = 빈 소켓)
+static void count_udp_recv(stats_worker_t *stats, int received) {
+    stats_add(&stats->udp_rx_calls, 1);
+    if (received == 0) {
+        stats_add(&stats->udp_rx_eagain, 1);
+    }
+}
+
+// UDP에서 받은 패킷 처리 (배치 복호화 후 TUN에 쓰기)
+// GRO가 꺼져 있으면 링 슬롯으로 바로 수신하고, 켜져 있으면 묶음을 받아 슬롯으로 나눈다.
+// 반환값: 수신한 메시지 수 (BATCH_SIZE 미만이면 소켓이 비었음)
+int handle_udp_to_tun(int udp_fd, int tun_fd, client_table_t *table) {
+    packet_batch_t *batch = &rx_batch;
+    rx_context_t rx = {
+        .udp_fd = udp_fd, .tun_fd = tun_fd, .table = table,
+        .stats = workers[0].stats, .client_stats = workers[0].client_stats,
+        .latency = workers[0].latency
+    };
+    uint64_t t_total = stage_begin();
+    uint64_t t;
+    int received;
+    
+    rx.reserved = enclave_ring_reserve(enclave_ring, batch->pkts, BATCH_SIZE, 0);
+    if (rx.reserved <= 0) {
+        stats_add(&rx.stats->ipc_failures, 1);
+        return -1;
+    }
+    
+    if (udp_offload & UDP_OFFLOAD_GRO) {
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            udp_batch_prepare_gro(&batch->msgs[i], &batch->iovs[i], &batch->addrs[i],
+                                  gro_buffers[i], UDP_GRO_BUF_SIZE, &batch->ctrls[i]);
+        }
+        
+        t = stage_begin();
+        received = udp_recv_batch(udp_fd, batch->msgs, BATCH_SIZE);
+        stage_end(rx.latency, STATS_STAGE_UDP_RECV, t);
+        count_udp_recv(rx.stats, received);
+        
+        for (int i = 0; i < received; i++) {
+            if (rx_split_gro(&rx, gro_buffers[i], batch->msgs[i].msg_len,
+                             udp_gro_segment_size(&batch->msgs[i]), &batch->addrs[i]) != 0) {
+                return -1;
+            }
+        }
+    } else {
+        // recvmmsg 한 번으로 최대 reserved개 수신 (슬롯 메모리에 직접)
+        for (int i = 0; i < rx.reserved; i++) {
+            packet_buf_t *pkt = &batch->pkts[i].pkt;
+            udp_batch_prepare(&batch->msgs[i], &batch->iovs[i], &batch->addrs[i],
+                              pkt->data, pkt_tailroom(pkt));
+        }
+        
+        t = stage_begin();
+        received = udp_recv_batch(udp_fd, batch->msgs, rx.reserved);
+        stage_end(rx.latency, STATS_STAGE_UDP_RECV, t);
+        count_udp_recv(rx.stats, received);
+        if (received > 0) {
+            stats_add(&rx.stats->udp_rx_packets, received);
+        }
+        
+        for (int i = 0; i < received; i++) {
+            pkt_put(&batch->pkts[i].pkt, batch->msgs[i].msg_len);
+            rx_dispatch(&rx, rx.used++, &batch->addrs[i]);
+        }
+    }
+    
+    flush_decrypt_batch(&rx, rx.start, rx.used - rx.start);
+    
+    // 빈 소켓에서 돌아온 호출은 전체 시간에 넣지 않음
+    if (received > 0) {
+        stage_end(rx.latency, STATS_STAGE_RX_TOTAL, t_total);
+    }
+    
+    return received;
+}
+
+// 슬롯 pkts[count]에 담긴 IP 패킷(n 바이트)의 목적지를 찾아 암호화 대기열에 추가
+// (버린 패킷의 슬롯은 다음 패킷이 재사용)
+static void tx_enqueue(tun_worker_t *worker, size_t n) {
+    packet_batch_t *batch = worker->batch;
+    enclave_ring_packet_t *rp = &batch->pkts[batch->count];
+    packet_buf_t *pkt = &rp->pkt;
+    
+    LOG_DEBUG("📤 TUN Packet Received: %zu bytes", n);
+    if (g_log_level >= LOG_DEBUG) {
+        print_ip_packet(pkt->data, n);
+    }
+    
+    // IP 헤더에서 목적지 확인
+    if (n < sizeof(struct iphdr)) {
+        LOG_DEBUG("   ⚠️  Packet too short for IP");
+        stats_add(&worker->stats->drops[STATS_DROP_SHORT], 1);
+        return;
+    }
+    
+    struct iphdr *ip = (struct iphdr*)pkt->data;
     
     // IPv6 필터링
     if (ip->version == 6) {
+        stats_add(&worker->stats->drops[STATS_DROP_IPV6], 1);
         return;  // IPv6 무시
     }
     
-    uint32_t dst_ip = ip->daddr;
+    // 목적지 클라이언트 경로 복사 (메인 스레드가 그 사이 슬롯을 재사용해도 안전)
+    client_route_t *route = &batch->routes[batch->count];
+    if (client_table_route(worker->table, ip->daddr, route) != 0) {
+        struct in_addr dst_addr;
+        dst_addr.s_addr = ip->daddr;
+        LOG_DEBUG("   ⚠️  No client found for VPN IP: %s", inet_ntoa(dst_addr));
+        stats_add(&worker->stats->drops[STATS_DROP_NO_ROUTE], 1);
+        return;
+    }
     
-    // 목적지 클라이언트 찾기
-    client_entry_t *client = find_client_by_vpn_ip(table, dst_ip);
+    // 암호화 배치에 추가
+    pkt_put(pkt, n);
+    rp->command = IPC_ENCRYPT;
+    rp->vpn_ip = route->vpn_ip;
+    rp->key_handle = route->key_handle;
+    batch->count++;
+}
+
+// sendmmsg 결과를 클라이언트 카운터에 반영 (메시지별 msg_len으로 판단)
+// 반환값: 전송된 메시지 수
+static int count_udp_send(tun_worker_t *worker, int ready) {
+    packet_batch_t *batch = worker->batch;
+    int sent = 0;
     
-    if (!client) {
-        struct in_addr dst_addr;
-        dst_addr.s_addr = dst_ip;
-        printf("   ⚠️  No client found for VPN IP: %s\n", inet_ntoa(dst_addr));
+    for (int i = 0; i < ready; i++) {
+        struct msghdr *hdr = &batch->msgs[i].msg_hdr;
+        stats_client_t *cs = &worker->client_stats[batch->routes[i].slot];
+        
+        if (batch->msgs[i].msg_len == 0) {
+            stats_add(&cs->drops[CLIENT_DROP_UDP_SEND], hdr->msg_iovlen);
+            continue;
+        }
+        
+        size_t bytes = 0;
+        for (size_t j = 0; j < hdr->msg_iovlen; j++) {
+            bytes += hdr->msg_iov[j].iov_len;
+        }
+        stats_add(&cs->tx_packets, hdr->msg_iovlen);
+        stats_add(&cs->tx_bytes, bytes);
+        sent++;
+    }
+    
+    stats_add(&worker->stats->udp_tx_calls, 1);
+    stats_add(&worker->stats->udp_tx_messages, sent);
+    stats_add(&worker->stats->udp_tx_eagain, ready - sent);
+    return sent;
+}
+
+// 모인 패킷 배치 암호화 후 UDP 전송 (batch->count = 0으로 비움)
+static void tx_flush(tun_worker_t *worker) {
+    packet_batch_t *batch = worker->batch;
+    
+    if (batch->count == 0) {
+        return;
+    }
+    
+    // 🔐 배치 암호화 (링 제출 1회, 슬롯 안에서 제자리로)
+    if (process_batch(worker->ring, batch->pkts, batch->count,
+                      worker->stats, worker->latency, STATS_STAGE_ENCRYPT) < 0) {
+        fprintf(stderr, "   ❌ Batch encryption failed (%d packets)\n", batch->count);
+        batch->count = 0;
         return;
     }
     
-    // 🔐 평문 암호화 (NEW!)
-    printf("   🔒 Encrypting %zd bytes...\n", n);
+    // 성공한 암호문을 클라이언트와 무관하게 모아 sendmmsg 한 번으로 전송
+    // GSO가 켜져 있으면 같은 클라이언트로 가는 연속된 같은 크기 패킷을 메시지 하나로 묶는다.
+    // (마지막 세그먼트만 짧을 수 있으므로 짧은 패킷이 오면 묶음을 닫음)
+    int ready = 0;
+    int iov_used = 0;
+    int run_first = 0;            // 현재 메시지의 첫 iov
+    size_t run_seg = 0;           // 현재 메시지의 세그먼트 크기
+    size_t run_bytes = 0;
+    int run_open = 0;             // 같은 크기 세그먼트를 더 붙일 수 있는지
     
-    size_t ciphertext_len;
-    if (enclave_encrypt(enclave_fd, client->vpn_ip,
-                       buffer, n,
-                       encrypted_buffer, &ciphertext_len) != 0) {
-        printf("   ❌ Encryption failed\n");
+    for (int i = 0; i < batch->count; i++) {
+        packet_buf_t *pkt = &batch->pkts[i].pkt;
+        const client_route_t *route = &batch->routes[i];
+        
+        if (batch->pkts[i].status != 0) {
+            LOG_DEBUG("   ❌ Encryption failed");
+            stats_add(&worker->client_stats[route->slot].drops[CLIENT_DROP_ENCRYPT], 1);
+            continue;
+        }
+        
+        // [카운터][암호문 + MAC] 앞에 VPN 헤더 붙이기 (headroom 사용)
+        size_t payload_len = pkt->len;
+        vpn_header_t *header = (vpn_header_t*)pkt_push(pkt, sizeof(vpn_header_t));
+        init_vpn_header(header, PKT_DATA, payload_len);
+        
+        batch->iovs[iov_used].iov_base = pkt->data;
+        batch->iovs[iov_used].iov_len = pkt->len;
+        
+        int segments = iov_used - run_first;
+        if ((udp_offload & UDP_OFFLOAD_GSO) && run_open &&
+            batch->addrs[ready - 1].sin_addr.s_addr == route->real_addr.sin_addr.s_addr &&
+            batch->addrs[ready - 1].sin_port == route->real_addr.sin_port &&
+            pkt->len <= run_seg &&
+            segments < UDP_GSO_MAX_SEGMENTS &&
+            run_bytes + pkt->len <= UDP_GSO_MAX_BYTES) {
+            // 현재 묶음에 세그먼트 추가
+            run_bytes += pkt->len;
+            run_open = (pkt->len == run_seg);
+            udp_batch_prepare_gso(&batch->msgs[ready - 1], &batch->iovs[run_first],
+                                  segments + 1, &batch->addrs[ready - 1],
+                                  &batch->ctrls[ready - 1], run_seg);
+        } else {
+            // 새 메시지 시작
+            run_first = iov_used;
+            run_seg = pkt->len;
+            run_bytes = pkt->len;
+            run_open = 1;
+            
+            // 메시지 i ↔ routes[i] (ready ≤ i 이므로 앞으로 당겨 담아도 안전)
+            batch->routes[ready] = *route;
+            batch->addrs[ready] = route->real_addr;
+            udp_batch_prepare_gso(&batch->msgs[ready], &batch->iovs[run_first], 1,
+                                  &batch->addrs[ready], &batch->ctrls[ready], run_seg);
+            ready++;
+        }
+        iov_used++;
+    }
+    
+    batch->count = 0;
+    
+    if (ready == 0) {
         return;
     }
     
-    printf("   ✅ Encrypted to %zu bytes\n", ciphertext_len);
+    // UDP로 전송 (슬롯 메모리에서 바로)
+    uint64_t t = stage_begin();
+    udp_send_batch(worker->udp_fd, batch->msgs, ready);
+    stage_end(worker->latency, STATS_STAGE_UDP_SEND, t);
+    
+    // 실패한 메시지는 건너뛰고 계속 보내므로 결과는 메시지마다 확인
+    int sent = count_udp_send(worker, ready);
+    LOG_DEBUG("   → UDP: Sent %d/%d messages (%d packets)", sent, ready, iov_used);
+}
+
+
+// TUN에서 받은 패킷 처리 (링 슬롯으로 바로 읽기 → 배치 암호화)
+// 오프로드 모드에서는 TSO 묶음(최대 64KB)을 받아 MTU 세그먼트로 나눠 슬롯에 담는다.
+// 반환값: 읽은 패킷 수 (BATCH_SIZE 미만이면 TUN 큐가 비었음), -1 (링 실패)
+int handle_tun_to_udp(tun_worker_t *worker) {
+    packet_batch_t *batch = worker->batch;
+    uint64_t t_total = stage_begin();
+    int reads = 0;
+    
+    // 슬롯 앞에 VPN 헤더 + 카운터 자리를 남겨두고 예약
+    int reserved = enclave_ring_reserve(worker->ring, batch->pkts, BATCH_SIZE, PKT_HEADROOM);
+    if (reserved <= 0) {
+        stats_add(&worker->stats->ipc_failures, 1);
+        return -1;
+    }
+    
+    batch->count = 0;
+    
+    while (reads < BATCH_SIZE) {
+        // 슬롯을 다 쓰면 지금까지를 보내고 다시 예약
+        if (batch->count == reserved) {
+            tx_flush(worker);
+            reserved = enclave_ring_reserve(worker->ring, batch->pkts, BATCH_SIZE, PKT_HEADROOM);
+            if (reserved <= 0) {
+                stats_add(&worker->stats->ipc_failures, 1);
+                return -1;
+            }
+        }
+        
+        packet_buf_t *pkt = &batch->pkts[batch->count].pkt;
+        size_t max_len = pkt_tailroom(pkt) - PKT_TAILROOM;   // MAC 자리는 남김
+        struct virtio_net_hdr vh;
+        uint8_t *data = pkt->data;
+        ssize_t n;
+        uint64_t t = stage_begin();
+        
+        // TUN에서 패킷 읽기 (논블로킹: 더 없으면 종료)
+        if (tun_offload) {
+            n = tun_read_offload(worker->tun_fd, &vh, pkt->data, max_len,
+                                 batch->gso_buf, &data);
+        } else {
+            n = read(worker->tun_fd, pkt->data, max_len);
+        }
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("❌ TUN read failed");
+            } else {
+                stats_add(&worker->stats->tun_rx_eagain, 1);
+            }
+            break;
+        }
+        reads++;
+        stats_add(&worker->stats->tun_rx_packets, 1);
+        stage_end(worker->latency, STATS_STAGE_TUN_READ, t);
+        
+        // 일반 패킷: 슬롯에 그대로 (부분 체크섬만 완성)
+        if (data == pkt->data) {
+            if (tun_offload && tun_finish_checksum(&vh, data, n) != 0) {
+                LOG_DEBUG("   ⚠️  Bad checksum offsets");
+                stats_add(&worker->stats->drops[STATS_DROP_BAD_OFFLOAD], 1);
+                continue;
+            }
+            tx_enqueue(worker, n);
+            continue;
+        }
+        
+        // TSO 묶음: 세그먼트마다 헤더/체크섬을 만들어 슬롯에 하나씩
+        tun_gso_iter_t it;
+        if (tun_gso_begin(&it, &vh, data, n) != 0) {
+            LOG_DEBUG("   ⚠️  Unsupported GSO packet (type=%u, %zd bytes)", vh.gso_type, n);
+            stats_add(&worker->stats->drops[STATS_DROP_BAD_OFFLOAD], 1);
+            continue;
+        }
+        
+        for (;;) {
+            if (batch->count == reserved) {
+                tx_flush(worker);
+                reserved = enclave_ring_reserve(worker->ring, batch->pkts, BATCH_SIZE,
+                                                PKT_HEADROOM);
+                if (reserved <= 0) {
+                    stats_add(&worker->stats->ipc_failures, 1);
+                    return -1;
+                }
+            }
+            
+            pkt = &batch->pkts[batch->count].pkt;
+            ssize_t seg_len = tun_gso_next(&it, pkt->data, pkt_tailroom(pkt) - PKT_TAILROOM);
+            if (seg_len <= 0) {
+                break;
+            }
+            tx_enqueue(worker, seg_len);
+        }
+    }
+    
+    tx_flush(worker);
+    
+    if (reads > 0) {
+        stage_end(worker->latency, STATS_STAGE_TX_TOTAL, t_total);
+    }
+    
+    return reads;
+}
+
+// 이하 서버 프로세스 전용 (워커 스레드 / 하우스키핑 / main)
+// bench_dataplane 은 이 파일을 포함해서 위의 데이터 경로만 구동한다.
+#ifndef VPN_SERVER_NO_MAIN
+
+// TUN 워커 스레드 (큐 1..N-1)
+static void* tun_worker_main(void *arg) {
+    tun_worker_t *worker = (tun_worker_t*)arg;
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+    
+    int epoll_fd = event_loop_create();
+    if (epoll_fd < 0 || event_loop_add(epoll_fd, worker->tun_fd, EPOLLIN | EPOLLET, EV_TUN) < 0) {
+        fprintf(stderr, "❌ TUN worker %d: event loop setup failed\n", worker->queue);
+        if (epoll_fd >= 0) close(epoll_fd);
+        running = 0;
+        return NULL;
+    }
+    
+    while (running) {
+        int nfds = epoll_wait(epoll_fd, events, EVENT_LOOP_MAX_EVENTS, WORKER_WAIT_MS);
+        uint64_t woke = stage_begin();
+        if (nfds < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("❌ epoll_wait failed (TUN worker)");
+            break;
+        }
+        if (nfds == 0) {
+            continue;
+        }
+        
+        stage_end(worker->latency, STATS_STAGE_SCHED, woke);
+        
+        // edge-triggered: EAGAIN까지 비우기
+        while (running && handle_tun_to_udp(worker) == BATCH_SIZE) {
+        }
+    }
+    
+    close(epoll_fd);
+    return NULL;
+}
+
+static packet_io_t packet_io;   // TUN 또는 pcap replay/record
+
+// TUN 큐 + 워커 준비
+// 워커 0은 메인 스레드용 (enclave_ring, tx_batch 사용), 나머지는 링/버퍼를 새로 만든다.
+// 반환값: 0 (성공), -1 (실패, 열린 큐는 stop_tun_workers로 정리)
+static int setup_tun_workers(const packet_io_config_t *io_config, int queues) {
+    int fds[MAX_TUN_QUEUES];
+    
+    if (packet_io_open(&packet_io, io_config, fds, queues) < 0) {
+        return -1;
+    }
+    
+    tun_offload = tun_offload_enabled(fds[0]);
+    tun_gro_init(&rx_batch.gro);
+    
+    for (int i = 0; i < queues; i++) {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].queue = i;
+        workers[i].tun_fd = fds[i];
+    }
+    worker_count = queues;
+    
+    for (int i = 0; i < queues; i++) {
+        tun_worker_t *worker = &workers[i];
+        
+        if (i == 0) {
+            worker->ring = enclave_ring;
+            worker->batch = &tx_batch;
+        } else {
+            worker->ring = enclave_ring_attach(enclave_fd);
+            worker->batch = (packet_batch_t*)malloc(sizeof(packet_batch_t));
+            if (!worker->ring || !worker->batch) {
+                fprintf(stderr, "❌ TUN worker %d setup failed\n", i);
+                return -1;
+            }
+        }
+        
+        if (set_nonblocking(worker->tun_fd) < 0) {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+// 워커 스레드 시작 (시그널은 메인 스레드만 받도록 막아둔 상태로 생성)
+static int start_tun_workers(int udp_fd, client_table_t *table) {
+    sigset_t block, old;
+    int ret = 0;
+    
+    for (int i = 0; i < worker_count; i++) {
+        workers[i].udp_fd = udp_fd;
+        workers[i].table = table;
+        workers[i].stats = server_stats_worker(&server_stats, i);
+        workers[i].client_stats = server_stats_clients(&server_stats, i);
+        workers[i].latency = server_stats_latency(&server_stats, i);
+    }
     
-    // VPN 헤더 추가
-    data_packet_t *pkt = (data_packet_t*)packet_buffer;
-    init_vpn_header(&pkt->header, PKT_DATA, ciphertext_len);
-    memcpy(pkt->data, encrypted_buffer, ciphertext_len);
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    sigaddset(&block, SIGUSR1);
+    sigaddset(&block, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
     
-    size_t total_len = sizeof(vpn_header_t) + ciphertext_len;
+    for (int i = 1; i < worker_count; i++) {
+        if (pthread_create(&workers[i].thread, NULL, tun_worker_main, &workers[i]) != 0) {
+            fprintf(stderr, "❌ Failed to start TUN worker %d\n", i);
+            ret = -1;
+            break;
+        }
+        workers[i].started = 1;
+    }
     
-    // UDP로 전송
-    ssize_t sent = udp_send(udp_fd, packet_buffer, total_len, &client->real_addr);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    return ret;
+}
+
+// 워커 종료 + 정리 (워커 0의 링은 메인이 별도로 해제)
+static void stop_tun_workers(void) {
+    running = 0;
     
-    if (sent > 0) {
-        printf("   → UDP: Sent %zd bytes to %s:%d\n",
-               sent,
-               inet_ntoa(client->real_addr.sin_addr),
-               ntohs(client->real_addr.sin_port));
+    for (int i = 0; i < worker_count; i++) {
+        tun_worker_t *worker = &workers[i];
         
-        update_client_activity(client);
+        if (i > 0) {
+            if (worker->started) {
+                pthread_join(worker->thread, NULL);
+            }
+            enclave_ring_detach(worker->ring);
+            free(worker->batch);
+        }
+        close(worker->tun_fd);
+    }
+    worker_count = 0;
+    
+    // pcap 백엔드 스레드는 데이터 경로 fd가 닫힌 뒤 정리
+    packet_io_close(&packet_io);
+}
+
+// RTT 측정 PING (타임스탬프 자리에 서버 단조 시계를 넣어 보냄)
+static void send_rtt_probe(client_entry_t *client, void *arg) {
+    int udp_fd = *(int*)arg;
+    vpn_header_t ping;
+    
+    if (__atomic_load_n(&client->key_handle, __ATOMIC_ACQUIRE) == KEY_HANDLE_INVALID) {
+        return;   // 핸드셰이크 진행 중
+    }
+    
+    init_vpn_header(&ping, PKT_PING, 0);
+    ping.timestamp = htobe64(stats_now_ns());
+    udp_send(udp_fd, (uint8_t*)&ping, sizeof(ping), &client->real_addr);
+}
+
+// 타임아웃된 세션 키 (REMOVE_KEYS 한 번으로 모아 보냄)
+static uint32_t expired_keys[IPC_MAX_REMOVE_KEYS];
+static int expired_key_count = 0;
+
+// 만료 세션 키 제거 완료 콜백
+static void on_expired_keys_removed(void *user, uint32_t token, int status,
+                                    const uint8_t *data, size_t len) {
+    int requested = (int)(uintptr_t)user;
+    (void)token;
+    
+    if (status == 0 && len >= sizeof(ipc_batch_header_t)) {
+        printf("🔓 Expired keys removed from Enclave: %u / %d\n",
+               ntohs(((const ipc_batch_header_t*)data)->count), requested);
+    } else {
+        printf("⚠️  Enclave key removal failed for %d expired sessions\n", requested);
+    }
+}
+
+// 모아둔 만료 세션 키를 REMOVE_KEYS 한 번으로 제거
+// (핸드셰이크와 같은 연결이라 이후 같은 IP의 새 핸드셰이크보다 먼저 처리됨)
+static void flush_expired_keys(void) {
+    if (expired_key_count == 0) {
+        return;
+    }
+    
+    if (enclave_async_remove_keys(enclave_ctl, expired_keys, expired_key_count,
+                                  on_expired_keys_removed,
+                                  (void*)(uintptr_t)expired_key_count) == 0) {
+        fprintf(stderr, "⚠️  Failed to queue key removal for %d expired sessions\n",
+                expired_key_count);
+    }
+    expired_key_count = 0;
+}
+
+// 타임아웃으로 제거된 클라이언트 (키는 모아서 제거)
+static void on_client_expired(uint32_t vpn_ip, void *arg) {
+    (void)arg;
+    
+    expired_keys[expired_key_count++] = vpn_ip;
+    if (expired_key_count == IPC_MAX_REMOVE_KEYS) {
+        flush_expired_keys();
+    }
+}
+
+// 하우스키핑 (timerfd 만료 시 실행, 트래픽과 무관하게 주기적으로 돌아감)
+// 반환값: 0 (계속), -1 (Enclave 종료로 서버 중단)
+static int run_housekeeping(int udp_fd, client_table_t *table) {
+    // 테이블 시계 갱신 후 세션 만료 / RTT 측정 타이머 처리
+    // (RTT PONG은 handle_rtt_pong에서 통계에 기록)
+    client_table_tick(table);
+    if (run_client_timers(table, send_rtt_probe, on_client_expired, &udp_fd) > 0) {
+        flush_expired_keys();
+    }
+    
+    // 지연 측정을 시그널로 켜고 끈 경우 알리고 세그먼트에 표시
+    if ((uint32_t)latency_sampling != server_stats.header->latency_enabled) {
+        server_stats_set_latency(&server_stats, latency_sampling);
+        printf("⏱️  Latency sampling %s\n", latency_sampling ? "on" : "off");
+    }
+    
+    // Enclave 상태 확인
+    if (!is_enclave_running(enclave_pid)) {
+        fprintf(stderr, "❌ Enclave process died!\n");
+        return -1;
     }
+    
+    return 0;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
     int tun_fd, udp_fd;
-    fd_set read_fds;
-    int max_fd;
+    int epoll_fd, timer_fd;
     client_table_t *client_table;
+    int tun_queues = 1;
+    packet_io_config_t io_config = {
+        .type = PACKET_IO_TUN,
+        .dev_name = TUN_DEVICE,
+        .tun_flags = TUN_OFFLOAD,
+    };
+    int ctl_window = ENCLAVE_CTL_WINDOW;
+    const char *stats_name = STATS_SHM_NAME;
+    const char *pool = CLIENT_POOL_DEFAULT;
+    
+    // 인자 처리
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--queues") == 0 && i + 1 < argc) {
+            tun_queues = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-tun-offload") == 0) {
+            io_config.tun_flags &= ~TUN_OFFLOAD;
+        } else if (strcmp(argv[i], "--pcap-replay") == 0 && i + 1 < argc) {
+            io_config.type = PACKET_IO_PCAP;
+            io_config.replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--pcap-record") == 0 && i + 1 < argc) {
+            io_config.type = PACKET_IO_PCAP;
+            io_config.record_path = argv[++i];
+        } else if (strcmp(argv[i], "--pcap-rate") == 0 && i + 1 < argc &&
+                   (strcmp(argv[i + 1], "original") == 0 || strcmp(argv[i + 1], "max") == 0)) {
+            io_config.replay_max_rate = (strcmp(argv[++i], "max") == 0);
+        } else if (strcmp(argv[i], "--ipc-window") == 0 && i + 1 < argc) {
+            ctl_window = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            stats_name = argv[++i];
+        } else if (strcmp(argv[i], "--no-stats") == 0) {
+            stats_name = NULL;
+        } else if (strcmp(argv[i], "--latency") == 0) {
+            latency_sampling = 1;
+        } else if (strcmp(argv[i], "--pool") == 0 && i + 1 < argc) {
+            pool = argv[++i];
+        } else {
+            printf("Usage:\n");
+            printf("  %s                    (single-queue TUN)\n", argv[0]);
+            printf("  %s --queues <N>       (multi-queue TUN, 1..%d workers)\n",
+                   argv[0], MAX_TUN_QUEUES);
+            printf("  %s --no-tun-offload   (plain TUN reads/writes, no TSO/GRO)\n", argv[0]);
+            printf("  %s --pcap-replay <file> [--pcap-rate original|max]\n", argv[0]);
+            printf("                        (inject a capture instead of reading TUN, no root needed)\n");
+            printf("  %s --pcap-record <file>  (write what would go to TUN into a pcap)\n", argv[0]);
+            printf("  %s --ipc-window <N>   (in-flight Enclave control requests, 1..%d)\n",
+                   argv[0], ENCLAVE_ASYNC_MAX_WINDOW);
+            printf("  %s --stats <name>     (shared memory stats segment, default %s)\n",
+                   argv[0], STATS_SHM_NAME);
+            printf("  %s --no-stats         (keep counters in-process only)\n", argv[0]);
+            printf("  %s --latency          (start with per-stage latency sampling on)\n", argv[0]);
+            printf("  %s --pool <cidr>      (client VPN IP pool, default %s, /%d../%d)\n",
+                   argv[0], CLIENT_POOL_DEFAULT, CLIENT_POOL_MIN_PREFIX, CLIENT_POOL_MAX_PREFIX);
+            return 1;
+        }
+    }
+    
+    if (tun_queues < 1 || tun_queues > MAX_TUN_QUEUES) {
+        fprintf(stderr, "❌ Invalid queue count: %d (1..%d)\n", tun_queues, MAX_TUN_QUEUES);
+        return 1;
+    }
+    
+    if (io_config.type == PACKET_IO_PCAP && tun_queues != 1) {
+        fprintf(stderr, "❌ --queues is only supported with the TUN backend\n");
+        return 1;
+    }
+    
+    if (ctl_window < 1 || ctl_window > ENCLAVE_ASYNC_MAX_WINDOW) {
+        fprintf(stderr, "❌ Invalid IPC window: %d (1..%d)\n", ctl_window, ENCLAVE_ASYNC_MAX_WINDOW);
+        return 1;
+    }
+    
+    if (stats_name && stats_name[0] != '/') {
+        fprintf(stderr, "❌ Stats segment name must start with '/': %s\n", stats_name);
+        return 1;
+    }
+    
+    // 서버 TUN 주소 = 풀의 첫 주소 (클라이언트는 그 다음부터)
+    uint32_t pool_network;
+    int pool_prefix;
+    if (parse_client_pool(pool, &pool_network, &pool_prefix) < 0) {
+        return 1;
+    }
+    struct in_addr tun_addr = { .s_addr = htonl(ntohl(pool_network) + 1) };
+    char tun_ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &tun_addr, tun_ip, sizeof(tun_ip));
     
     printf("🚀 VPN Server Starting...\n");
     printf("═══════════════════════════════════════\n\n");
@@ -292,6 +1206,8 @@ int main() {
     // 시그널 핸들러
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGUSR1, signal_handler);
+    signal(SIGUSR2, signal_handler);
     
     // 랜덤 시드 초기화
     srand(time(NULL));
@@ -319,26 +1235,40 @@ int main() {
         stop_enclave_process(enclave_pid);
         return 1;
     }
+    
+    // 데이터 경로용 공유 메모리 링 등록
+    enclave_ring = enclave_ring_attach(enclave_fd);
+    if (!enclave_ring) {
+        fprintf(stderr, "❌ Enclave ring setup failed\n");
+        enclave_disconnect(enclave_fd);
+        stop_enclave_process(enclave_pid);
+        return 1;
+    }
     printf("\n");
     
-    // 2. TUN 인터페이스 생성
-    printf("━━━ TUN Interface ━━━\n");
-    tun_fd = create_tun_interface(TUN_DEVICE);
-    if (tun_fd < 0) {
+    // 2. TUN 인터페이스 생성 (pcap 백엔드면 장치 없이 소켓쌍)
+    printf(io_config.type == PACKET_IO_TUN ? "━━━ TUN Interface ━━━\n" : "━━━ Packet I/O (pcap) ━━━\n");
+    if (setup_tun_workers(&io_config, tun_queues) < 0) {
+        stop_tun_workers();
+        enclave_ring_detach(enclave_ring);
         enclave_disconnect(enclave_fd);
         stop_enclave_process(enclave_pid);
         return 1;
     }
+    tun_fd = workers[0].tun_fd;   // UDP → TUN 쓰기용 (어느 큐에 써도 됨)
     
-    if (configure_tun_ip(TUN_DEVICE, TUN_IP, TUN_NETMASK) < 0) {
-        close(tun_fd);
+    if (io_config.type == PACKET_IO_TUN &&
+        configure_tun_ip(TUN_DEVICE, tun_ip, pool_prefix) < 0) {
+        stop_tun_workers();
+        enclave_ring_detach(enclave_ring);
         enclave_disconnect(enclave_fd);
         stop_enclave_process(enclave_pid);
         return 1;
     }
     
-    if (bring_tun_up(TUN_DEVICE) < 0) {
-        close(tun_fd);
+    if (io_config.type == PACKET_IO_TUN && bring_tun_up(TUN_DEVICE) < 0) {
+        stop_tun_workers();
+        enclave_ring_detach(enclave_ring);
         enclave_disconnect(enclave_fd);
         stop_enclave_process(enclave_pid);
         return 1;
@@ -349,104 +1279,217 @@ int main() {
     printf("━━━ UDP Server ━━━\n");
     udp_fd = create_udp_server(UDP_PORT);
     if (udp_fd < 0) {
-        close(tun_fd);
+        stop_tun_workers();
+        enclave_ring_detach(enclave_ring);
         enclave_disconnect(enclave_fd);
         stop_enclave_process(enclave_pid);
         return 1;
     }
+    udp_offload = udp_offload_flags(udp_fd);
     printf("\n");
     
     // 4. 클라이언트 테이블 초기화
     printf("━━━ Client Table ━━━\n");
-    client_table = init_client_table();
+    client_table = init_client_table(pool_network, pool_prefix);
     if (!client_table) {
         close(udp_fd);
-        close(tun_fd);
+        stop_tun_workers();
+        enclave_ring_detach(enclave_ring);
+        enclave_disconnect(enclave_fd);
+        stop_enclave_process(enclave_pid);
+        return 1;
+    }
+    
+    // 통계 세그먼트 (vpn_stat 이 읽기 전용으로 매핑, 만들 수 없으면 프로세스 안에서만 집계)
+    if (stats_name &&
+        server_stats_create(&server_stats, stats_name, worker_count, client_table->capacity,
+                            BATCH_SIZE) < 0) {
+        fprintf(stderr, "⚠️  Stats segment %s unavailable, counting in-process only\n", stats_name);
+        stats_name = NULL;
+    }
+    if (!stats_name &&
+        server_stats_create(&server_stats, NULL, worker_count, client_table->capacity,
+                            BATCH_SIZE) < 0) {
+        destroy_client_table(client_table);
+        close(udp_fd);
+        stop_tun_workers();
+        enclave_ring_detach(enclave_ring);
         enclave_disconnect(enclave_fd);
         stop_enclave_process(enclave_pid);
         return 1;
     }
+    client_table->stats = &server_stats;
+    if (stats_name) {
+        printf("📊 Stats published at /dev/shm%s (read with vpn_stat)\n", stats_name);
+    }
     printf("\n");
     
+    // 제어 명령(핸드셰이크 등)용 전용 Enclave 연결 (응답을 기다리지 않고 파이프라인)
+    int ctl_fd = enclave_connect();
+    if (ctl_fd >= 0) {
+        enclave_ctl = enclave_async_create(ctl_fd, ctl_window);
+        if (!enclave_ctl) {
+            enclave_disconnect(ctl_fd);
+        }
+    }
+    printf("\n");
+    
+    // 이벤트 루프 준비: 논블로킹 TUN/UDP + timerfd 를 edge-triggered epoll에 등록
+    // (주 Enclave 소켓은 동기 IPC에 쓰이므로 블로킹 유지, 연결 끊김만 감시.
+    //  제어 연결은 응답이 남아 있는 동안 계속 알리도록 level-triggered)
+    // 큐 1..N-1 은 각자 스레드에서 처리
+    epoll_fd = -1;
+    timer_fd = -1;
+    if (!enclave_ctl ||
+        set_nonblocking(udp_fd) < 0 ||
+        (epoll_fd = event_loop_create()) < 0 ||
+        (timer_fd = timer_fd_create(HOUSEKEEPING_INTERVAL_MS)) < 0 ||
+        event_loop_add(epoll_fd, udp_fd, EPOLLIN | EPOLLET, EV_UDP) < 0 ||
+        event_loop_add(epoll_fd, tun_fd, EPOLLIN | EPOLLET, EV_TUN) < 0 ||
+        event_loop_add(epoll_fd, timer_fd, EPOLLIN | EPOLLET, EV_TIMER) < 0 ||
+        event_loop_add(epoll_fd, enclave_fd, EPOLLRDHUP, EV_ENCLAVE) < 0 ||
+        event_loop_add(epoll_fd, enclave_async_fd(enclave_ctl), EPOLLIN, EV_ENCLAVE_CTL) < 0 ||
+        start_tun_workers(udp_fd, client_table) < 0) {
+        stop_tun_workers();
+        enclave_async_destroy(enclave_ctl);
+        if (timer_fd >= 0) close(timer_fd);
+        if (epoll_fd >= 0) close(epoll_fd);
+        destroy_client_table(client_table);
+        server_stats_close(&server_stats);
+        close(udp_fd);
+        enclave_ring_detach(enclave_ring);
+        enclave_disconnect(enclave_fd);
+        stop_enclave_process(enclave_pid);
+        return 1;
+    }
+    
     // 5. 파일 디스크립터 정보
     printf("━━━ File Descriptors ━━━\n");
-    printf("  Enclave IPC:   fd=%d\n", enclave_fd);
-    printf("  TUN Interface: fd=%d\n", tun_fd);
+    printf("  Enclave IPC:   fd=%d (+ shared memory ring), control fd=%d (window %d)\n",
+           enclave_fd, enclave_async_fd(enclave_ctl), ctl_window);
+    printf("  TUN Interface: fd=%d (%s, %d queue%s, %d worker thread%s)\n",
+           tun_fd, packet_io_name(io_config.type), worker_count, worker_count > 1 ? "s" : "",
+           worker_count - 1, worker_count - 1 == 1 ? "" : "s");
     printf("  UDP Socket:    fd=%d\n", udp_fd);
+    printf("  epoll:         fd=%d (timer fd=%d, %d ms)\n",
+           epoll_fd, timer_fd, HOUSEKEEPING_INTERVAL_MS);
     printf("\n");
     
     printf("✅ VPN Server is running!\n");
     printf("═══════════════════════════════════════\n");
-    printf("🔐 Encryption: ChaCha20-Poly1305 via Enclave\n");
+    printf("🔐 Encryption: ChaCha20-Poly1305 / AES-256-GCM (negotiated) via Enclave\n");
     printf("📡 Listening on:\n");
-    printf("   - TUN: %s/%d\n", TUN_IP, TUN_NETMASK);
+    if (io_config.type == PACKET_IO_TUN) {
+        printf("   - TUN: %s/%d\n", tun_ip, pool_prefix);
+    } else {
+        printf("   - pcap: %s → server → %s\n",
+               io_config.replay_path ? io_config.replay_path : "(none)",
+               io_config.record_path ? io_config.record_path : "(discard)");
+    }
     printf("   - UDP: 0.0.0.0:%d\n", UDP_PORT);
     printf("═══════════════════════════════════════\n");
     printf("⏳ Waiting for packets... (Ctrl+C to stop)\n\n");
     
-    // 6. 이벤트 루프
-    max_fd = (tun_fd > udp_fd) ? tun_fd : udp_fd;
-    
-    time_t last_timeout_check = time(NULL);
+    // 6. 이벤트 루프 (edge-triggered epoll)
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+    int udp_pending = 0;    // 아직 EAGAIN까지 비우지 못한 fd
+    int tun_pending = 0;
     
     while (running) {
-        FD_ZERO(&read_fds);
-        FD_SET(tun_fd, &read_fds);
-        FD_SET(udp_fd, &read_fds);
+        // 덜 비운 fd가 있으면 기다리지 않고 타이머 등만 확인
+        int timeout_ms = (udp_pending || tun_pending) ? 0 : -1;
         
-        struct timeval timeout = {1, 0};  // 1초 타임아웃
+        int nfds = epoll_wait(epoll_fd, events, EVENT_LOOP_MAX_EVENTS, timeout_ms);
+        uint64_t woke = stage_begin();
         
-        int activity = select(max_fd + 1, &read_fds, NULL, NULL, &timeout);
-        
-        if (activity < 0) {
-            if (running) {
-                perror("❌ select failed");
+        if (nfds < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            perror("❌ epoll_wait failed");
             break;
         }
         
-        if (activity == 0) {
-            // 타임아웃: 클라이언트 타임아웃 체크
-            time_t now = time(NULL);
-            if (now - last_timeout_check >= 30) {
-                check_client_timeouts(client_table);
-                last_timeout_check = now;
+        for (int i = 0; i < nfds; i++) {
+            switch (events[i].data.u32) {
+                case EV_UDP:
+                    udp_pending = 1;
+                    break;
+                    
+                case EV_TUN:
+                    tun_pending = 1;
+                    break;
+                    
+                case EV_TIMER:
+                    if (timer_fd_ack(timer_fd) > 0 &&
+                        run_housekeeping(udp_fd, client_table) < 0) {
+                        running = 0;
+                    }
+                    break;
+                    
+                case EV_ENCLAVE:
+                    fprintf(stderr, "❌ Enclave connection closed!\n");
+                    running = 0;
+                    break;
+                    
+                case EV_ENCLAVE_CTL:
+                    // 핸드셰이크 / 키 제거 응답 → 콜백
+                    if (enclave_async_poll(enclave_ctl, 0) < 0) {
+                        running = 0;
+                    }
+                    break;
             }
-            
-            // Enclave 상태 확인
-            if (!is_enclave_running(enclave_pid)) {
-                fprintf(stderr, "❌ Enclave process died!\n");
+        }
+        
+        // 준비된 fd를 번갈아 비움 (한쪽 방향이 다른 쪽을 굶기지 않도록)
+        // 예산을 다 쓰면 pending으로 남겨 다음 반복에서 이어서 처리
+        for (int round = 0; round < DRAIN_BUDGET && running; round++) {
+            if (!udp_pending && !tun_pending) {
                 break;
             }
             
-            continue;
-        }
-        
-        // UDP 소켓에서 패킷 수신
-        if (FD_ISSET(udp_fd, &read_fds)) {
-            handle_udp_to_tun(udp_fd, tun_fd, client_table);
-        }
-        
-        // TUN 인터페이스에서 패킷 수신
-        if (FD_ISSET(tun_fd, &read_fds)) {
-            handle_tun_to_udp(tun_fd, udp_fd, client_table);
+            // 깨어난 뒤 첫 처리까지의 지연 (다른 방향 / 제어 이벤트 처리 대기 포함)
+            if (udp_pending) {
+                if (round == 0) {
+                    stage_end(workers[0].latency, STATS_STAGE_SCHED, woke);
+                }
+                udp_pending = (handle_udp_to_tun(udp_fd, tun_fd, client_table) == BATCH_SIZE);
+            }
+            
+            if (tun_pending) {
+                if (round == 0) {
+                    stage_end(workers[0].latency, STATS_STAGE_SCHED, woke);
+                }
+                tun_pending = (handle_tun_to_udp(&workers[0]) == BATCH_SIZE);
+            }
         }
     }
     
     // 7. 정리
     printf("\n🧹 Cleaning up...\n");
     
-    // Enclave 종료
+    // TUN 워커 종료 (워커 링 해제 + 큐 닫기)
+    stop_tun_workers();
+    
+    // 데이터 경로가 멈췄으므로 통계 세그먼트 제거 (Enclave 종료 대기 전에)
+    client_table->stats = NULL;
+    server_stats_close(&server_stats);
+    
+    // Enclave 종료 (진행 중인 제어 요청은 콜백에서 실패 처리)
+    enclave_async_destroy(enclave_ctl);
     enclave_shutdown(enclave_fd);
+    enclave_ring_detach(enclave_ring);
     enclave_disconnect(enclave_fd);
     stop_enclave_process(enclave_pid);
     
     // 기타 정리
+    close(timer_fd);
+    close(epoll_fd);
     destroy_client_table(client_table);
     close(udp_fd);
-    close(tun_fd);
     
     printf("✅ VPN Server stopped.\n");
     
     return 0;
 }
+#endif // VPN_SERVER_NO_MAIN
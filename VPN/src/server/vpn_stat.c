@@ -0,0 +1,510 @@
+// src/server/vpn_stat.c
+//
+// vpn_server 통계 조회 도구
+//
+// 서버가 공유 메모리에 올려 둔 카운터(server_stats.h)를 읽기 전용으로 매핑해서 출력한다.
+// 서버에는 아무 요청도 보내지 않으므로 (소켓/시그널 없음) 자주 긁어도 패킷 처리에 영향이 없다.
+// 단, --latency on/off 는 서버에 SIGUSR1/SIGUSR2를 보내서 단계별 지연 측정을 켜고 끈다.
+//
+//   vpn_stat                 현재 누적값 1회
+//   vpn_stat -i 1            1초마다 누적값 + 초당 변화량 (지연 백분위도 구간 기준)
+//   vpn_stat --json          스크레이퍼용 JSON (1줄 = 1회)
+//   vpn_stat --latency on    단계별 지연 측정 켜기 (off = 끄기)
+
+#define _GNU_SOURCE
+#include "server_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <arpa/inet.h>
+
+// 한 번에 읽은 값 (워커 블록 합산)
+typedef struct {
+    double at;                    // 읽은 시각 (초, 단조 시계)
+    stats_worker_t total;
+    stats_client_t *clients;      // [client_capacity]
+    stats_client_meta_t *meta;    // [client_capacity]
+    stats_worker_t *workers;      // [worker_count]
+    stats_hist_t *latency;        // [STATS_STAGE_MAX] (워커 합산)
+} stat_snapshot_t;
+
+static const char *drop_names[STATS_DROP_MAX] = {
+    "short", "unknown_client", "no_route", "ipv6", "oversize", "bad_offload", "ipc"
+};
+
+static volatile sig_atomic_t running = 1;
+
+static void signal_handler(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+static int snapshot_alloc(stat_snapshot_t *snap, const stats_header_t *h) {
+    snap->clients = (stats_client_t*)calloc(h->client_capacity, sizeof(stats_client_t));
+    snap->meta = (stats_client_meta_t*)calloc(h->client_capacity, sizeof(stats_client_meta_t));
+    snap->workers = (stats_worker_t*)calloc(h->worker_count, sizeof(stats_worker_t));
+    snap->latency = (stats_hist_t*)calloc(STATS_STAGE_MAX, sizeof(stats_hist_t));
+    if (!snap->clients || !snap->meta || !snap->workers || !snap->latency) {
+        perror("calloc");
+        return -1;
+    }
+    return 0;
+}
+
+static void snapshot_free(stat_snapshot_t *snap) {
+    free(snap->clients);
+    free(snap->meta);
+    free(snap->workers);
+    free(snap->latency);
+}
+
+// 세그먼트 읽기 (메모리 load만, 시스템 콜 없음)
+static void snapshot_take(const server_stats_t *stats, stat_snapshot_t *snap) {
+    const stats_header_t *h = stats->header;
+    
+    snap->at = stats_now_ns() / 1e9;
+    server_stats_sum_workers(stats, &snap->total);
+    
+    for (uint32_t w = 0; w < h->worker_count; w++) {
+        const uint64_t *src = (const uint64_t*)server_stats_worker(stats, w);
+        uint64_t *dst = (uint64_t*)&snap->workers[w];
+        for (size_t i = 0; i < sizeof(stats_worker_t) / sizeof(uint64_t); i++) {
+            dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+        }
+    }
+    
+    for (uint32_t slot = 0; slot < h->client_capacity; slot++) {
+        server_stats_read_meta(stats, slot, &snap->meta[slot]);
+        if (snap->meta[slot].active) {
+            server_stats_sum_client(stats, slot, &snap->clients[slot]);
+        }
+    }
+    
+    for (int st = 0; st < STATS_STAGE_MAX; st++) {
+        server_stats_merge_latency(stats, st, &snap->latency[st]);
+    }
+}
+
+// 서버 프로세스가 살아 있는지 (세그먼트는 서버가 죽어도 남을 수 있음)
+static int server_alive(const stats_header_t *h) {
+    return kill(h->pid, 0) == 0 || errno == EPERM;
+}
+
+// 바이트 → 사람이 읽기 쉬운 단위
+static const char* human_bytes(double bytes, char *buf, size_t len) {
+    const char *units[] = { "B", "KB", "MB", "GB", "TB" };
+    int u = 0;
+    
+    while (bytes >= 1024 && u < 4) {
+        bytes /= 1024;
+        u++;
+    }
+    snprintf(buf, len, u == 0 ? "%.0f%s" : "%.1f%s", bytes, units[u]);
+    return buf;
+}
+
+// 비트율 → 사람이 읽기 쉬운 단위 (10진)
+static const char* human_bits(double bits, char *buf, size_t len) {
+    const char *units[] = { "", "K", "M", "G", "T" };
+    int u = 0;
+    
+    while (bits >= 1000 && u < 4) {
+        bits /= 1000;
+        u++;
+    }
+    snprintf(buf, len, "%.1f%s", bits, units[u]);
+    return buf;
+}
+
+static double ipc_avg_us(const stats_worker_t *w) {
+    return w->ipc_batches ? (double)w->ipc_ns_total / w->ipc_batches / 1000.0 : 0.0;
+}
+
+static void print_hist(const char *label, const uint64_t *hist) {
+    printf("  %s", label);
+    for (int b = 0; b < STATS_BATCH_BUCKETS; b++) {
+        if (b == STATS_BATCH_BUCKETS - 1) {
+            printf(" %d+:%llu", 1 << b, (unsigned long long)hist[b]);
+        } else if (b == 0) {
+            printf(" 1:%llu", (unsigned long long)hist[b]);
+        } else {
+            printf(" %d-%d:%llu", 1 << b, (2 << b) - 1, (unsigned long long)hist[b]);
+        }
+    }
+    printf("\n");
+}
+
+// 구간 히스토그램 (cur - prev, 최댓값은 누적값 그대로)
+static void hist_delta(const stats_hist_t *cur, const stats_hist_t *prev, stats_hist_t *out) {
+    out->count = cur->count - prev->count;
+    out->total = cur->total - prev->total;
+    out->max = cur->max;
+    for (int b = 0; b < STATS_HIST_BUCKETS; b++) {
+        out->buckets[b] = cur->buckets[b] - prev->buckets[b];
+    }
+}
+
+// 단계별 지연 표 (prev가 있으면 그 사이 구간만)
+static void print_latency(const server_stats_t *stats, const stat_snapshot_t *cur,
+                          const stat_snapshot_t *prev) {
+    const stats_header_t *h = stats->header;
+    int shown = 0;
+    
+    for (int st = 0; st < STATS_STAGE_MAX && !shown; st++) {
+        shown = cur->latency[st].count > 0;
+    }
+    if (!h->latency_enabled && !shown) {
+        printf("Latency  off (vpn_stat --latency on)\n");
+        return;
+    }
+    
+    printf("Latency%s%s\n", h->latency_enabled ? "" : " (sampling off, last values)",
+           prev ? " · this interval" : " · since start");
+    printf("  %-10s %10s %9s %9s %9s %9s %9s\n",
+           "stage", "samples", "avg(us)", "p50(us)", "p99(us)", "p999(us)", "max(us)");
+    
+    for (int st = 0; st < STATS_STAGE_MAX; st++) {
+        stats_hist_t delta;
+        const stats_hist_t *hist = &cur->latency[st];
+        
+        if (prev) {
+            hist_delta(hist, &prev->latency[st], &delta);
+            hist = &delta;
+        }
+        if (hist->count == 0) {
+            continue;
+        }
+        
+        printf("  %-10s %10llu %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+               stats_stage_name(st), (unsigned long long)hist->count,
+               server_stats_cycles_to_us(stats, hist->total / hist->count),
+               server_stats_cycles_to_us(stats, stats_hist_percentile(hist, 0.50)),
+               server_stats_cycles_to_us(stats, stats_hist_percentile(hist, 0.99)),
+               server_stats_cycles_to_us(stats, stats_hist_percentile(hist, 0.999)),
+               server_stats_cycles_to_us(stats, hist->max));
+    }
+}
+
+// 텍스트 출력 (prev가 있으면 초당 변화량도)
+static void print_text(const server_stats_t *stats, const stat_snapshot_t *cur,
+                       const stat_snapshot_t *prev) {
+    const stats_header_t *h = stats->header;
+    const stats_worker_t *t = &cur->total;
+    double dt = prev ? cur->at - prev->at : 0;
+    long up = (long)(time(NULL) - h->started_at);
+    int active = 0;
+    char b1[32], b2[32];
+    
+    for (uint32_t slot = 0; slot < h->client_capacity; slot++) {
+        active += cur->meta[slot].active ? 1 : 0;
+    }
+    
+    printf("━━━ vpn_server pid %d%s · up %ldh%02ldm%02lds · %u worker%s · %d/%u clients ━━━\n",
+           h->pid, server_alive(h) ? "" : " (exited)", up / 3600, up / 60 % 60, up % 60,
+           h->worker_count, h->worker_count == 1 ? "" : "s", active, h->client_capacity);
+    
+    printf("UDP   rx %llu pkts (recvmmsg %llu, empty %llu)   tx %llu msgs (sendmmsg %llu, unsent %llu)\n",
+           (unsigned long long)t->udp_rx_packets, (unsigned long long)t->udp_rx_calls,
+           (unsigned long long)t->udp_rx_eagain, (unsigned long long)t->udp_tx_messages,
+           (unsigned long long)t->udp_tx_calls, (unsigned long long)t->udp_tx_eagain);
+    printf("TUN   rx %llu (EAGAIN %llu)   tx %llu (errors %llu)\n",
+           (unsigned long long)t->tun_rx_packets, (unsigned long long)t->tun_rx_eagain,
+           (unsigned long long)t->tun_tx_packets, (unsigned long long)t->tun_tx_errors);
+    printf("IPC   %llu batches, %llu pkts (%.1f/batch), avg %.1f us, max %.1f us, failures %llu\n",
+           (unsigned long long)t->ipc_batches, (unsigned long long)t->ipc_packets,
+           t->ipc_batches ? (double)t->ipc_packets / t->ipc_batches : 0.0,
+           ipc_avg_us(t), t->ipc_ns_max / 1000.0, (unsigned long long)t->ipc_failures);
+    
+    if (prev && dt > 0) {
+        const stats_worker_t *p = &prev->total;
+        uint64_t batches = t->ipc_batches - p->ipc_batches;
+        printf("Rate  udp rx %.0f/s, udp tx %.0f/s, tun rx %.0f/s, tun tx %.0f/s, ipc avg %.1f us\n",
+               (t->udp_rx_packets - p->udp_rx_packets) / dt,
+               (t->udp_tx_messages - p->udp_tx_messages) / dt,
+               (t->tun_rx_packets - p->tun_rx_packets) / dt,
+               (t->tun_tx_packets - p->tun_tx_packets) / dt,
+               batches ? (double)(t->ipc_ns_total - p->ipc_ns_total) / batches / 1000.0 : 0.0);
+    }
+    
+    printf("Batch sizes\n");
+    print_hist("decrypt:", t->rx_batch_hist);
+    print_hist("encrypt:", t->tx_batch_hist);
+    
+    printf("Drops");
+    for (int d = 0; d < STATS_DROP_MAX; d++) {
+        printf(" %s=%llu", drop_names[d], (unsigned long long)t->drops[d]);
+    }
+    printf("\n");
+    
+    print_latency(stats, cur, prev);
+    
+    if (h->worker_count > 1) {
+        for (uint32_t w = 0; w < h->worker_count; w++) {
+            const stats_worker_t *ws = &cur->workers[w];
+            printf("  worker %u: tun rx %llu, udp tx %llu, ipc %llu batches (avg %.1f us)\n",
+                   w, (unsigned long long)ws->tun_rx_packets,
+                   (unsigned long long)ws->udp_tx_messages,
+                   (unsigned long long)ws->ipc_batches, ipc_avg_us(ws));
+        }
+    }
+    
+    if (active == 0) {
+        printf("\n(No active clients)\n\n");
+        return;
+    }
+    
+    if (prev && dt > 0) {
+        printf("\n%-4s %-15s %-21s %10s %10s %10s %10s %8s %14s %9s\n",
+               "SLOT", "VPN IP", "REAL ADDRESS", "RX pkt/s", "RX bit/s", "TX pkt/s",
+               "TX bit/s", "DEC FAIL", "DROP E/T/U", "RTT");
+    } else {
+        printf("\n%-4s %-15s %-21s %10s %10s %10s %10s %8s %14s %9s\n",
+               "SLOT", "VPN IP", "REAL ADDRESS", "RX PKTS", "RX BYTES", "TX PKTS",
+               "TX BYTES", "DEC FAIL", "DROP E/T/U", "RTT");
+    }
+    
+    for (uint32_t slot = 0; slot < h->client_capacity; slot++) {
+        const stats_client_meta_t *m = &cur->meta[slot];
+        const stats_client_t *c = &cur->clients[slot];
+        struct in_addr vpn_addr = { .s_addr = m->vpn_ip };
+        struct in_addr real_addr = { .s_addr = m->real_ip };
+        char vpn_str[INET_ADDRSTRLEN], real_str[32], rtt_str[16], drop_str[32];
+        
+        if (!m->active) {
+            continue;
+        }
+        
+        inet_ntop(AF_INET, &vpn_addr, vpn_str, sizeof(vpn_str));
+        inet_ntop(AF_INET, &real_addr, real_str, sizeof(real_str));
+        snprintf(real_str + strlen(real_str), sizeof(real_str) - strlen(real_str),
+                 ":%u", ntohs(m->real_port));
+        snprintf(drop_str, sizeof(drop_str), "%llu/%llu/%llu",
+                 (unsigned long long)c->drops[CLIENT_DROP_ENCRYPT],
+                 (unsigned long long)c->drops[CLIENT_DROP_TUN_WRITE],
+                 (unsigned long long)c->drops[CLIENT_DROP_UDP_SEND]);
+        if (m->last_rtt_ns) {
+            snprintf(rtt_str, sizeof(rtt_str), "%.2fms", m->last_rtt_ns / 1e6);
+        } else {
+            snprintf(rtt_str, sizeof(rtt_str), "-");
+        }
+        
+        // 같은 슬롯이라도 세션이 바뀌었으면 (카운터 초기화) 변화량 대신 누적값
+        const stats_client_meta_t *pm = prev ? &prev->meta[slot] : NULL;
+        if (prev && dt > 0 && pm->active && pm->session_id == m->session_id) {
+            const stats_client_t *pc = &prev->clients[slot];
+            printf("%-4u %-15s %-21s %10.0f %10s %10.0f %10s %8llu %14s %9s\n",
+                   slot, vpn_str, real_str,
+                   (c->rx_packets - pc->rx_packets) / dt,
+                   human_bits((c->rx_bytes - pc->rx_bytes) * 8 / dt, b1, sizeof(b1)),
+                   (c->tx_packets - pc->tx_packets) / dt,
+                   human_bits((c->tx_bytes - pc->tx_bytes) * 8 / dt, b2, sizeof(b2)),
+                   (unsigned long long)c->decrypt_failures, drop_str, rtt_str);
+        } else {
+            printf("%-4u %-15s %-21s %10llu %10s %10llu %10s %8llu %14s %9s\n",
+                   slot, vpn_str, real_str,
+                   (unsigned long long)c->rx_packets,
+                   human_bytes(c->rx_bytes, b1, sizeof(b1)),
+                   (unsigned long long)c->tx_packets,
+                   human_bytes(c->tx_bytes, b2, sizeof(b2)),
+                   (unsigned long long)c->decrypt_failures, drop_str, rtt_str);
+        }
+    }
+    printf("\n");
+}
+
+static void print_json_hist(const char *name, const uint64_t *hist) {
+    printf("\"%s\":[", name);
+    for (int b = 0; b < STATS_BATCH_BUCKETS; b++) {
+        printf("%s%llu", b ? "," : "", (unsigned long long)hist[b]);
+    }
+    printf("]");
+}
+
+// JSON 출력 (누적값, 1줄)
+static void print_json(const server_stats_t *stats, const stat_snapshot_t *cur) {
+    const stats_header_t *h = stats->header;
+    const stats_worker_t *t = &cur->total;
+    int first = 1;
+    
+    printf("{\"pid\":%d,\"alive\":%s,\"started_at\":%lld,\"time\":%lld,\"workers\":%u,",
+           h->pid, server_alive(h) ? "true" : "false", (long long)h->started_at,
+           (long long)time(NULL), h->worker_count);
+    printf("\"global\":{\"udp_rx_calls\":%llu,\"udp_rx_packets\":%llu,\"udp_rx_eagain\":%llu,"
+           "\"udp_tx_calls\":%llu,\"udp_tx_messages\":%llu,\"udp_tx_eagain\":%llu,"
+           "\"tun_rx_packets\":%llu,\"tun_rx_eagain\":%llu,\"tun_tx_packets\":%llu,"
+           "\"tun_tx_errors\":%llu,\"ipc_batches\":%llu,\"ipc_packets\":%llu,"
+           "\"ipc_ns_total\":%llu,\"ipc_ns_max\":%llu,\"ipc_failures\":%llu,",
+           (unsigned long long)t->udp_rx_calls, (unsigned long long)t->udp_rx_packets,
+           (unsigned long long)t->udp_rx_eagain, (unsigned long long)t->udp_tx_calls,
+           (unsigned long long)t->udp_tx_messages, (unsigned long long)t->udp_tx_eagain,
+           (unsigned long long)t->tun_rx_packets, (unsigned long long)t->tun_rx_eagain,
+           (unsigned long long)t->tun_tx_packets, (unsigned long long)t->tun_tx_errors,
+           (unsigned long long)t->ipc_batches, (unsigned long long)t->ipc_packets,
+           (unsigned long long)t->ipc_ns_total, (unsigned long long)t->ipc_ns_max,
+           (unsigned long long)t->ipc_failures);
+    print_json_hist("rx_batch_hist", t->rx_batch_hist);
+    printf(",");
+    print_json_hist("tx_batch_hist", t->tx_batch_hist);
+    printf(",\"drops\":{");
+    for (int d = 0; d < STATS_DROP_MAX; d++) {
+        printf("%s\"%s\":%llu", d ? "," : "", drop_names[d], (unsigned long long)t->drops[d]);
+    }
+    printf("}},\"latency_enabled\":%s,\"latency\":{", h->latency_enabled ? "true" : "false");
+    for (int st = 0; st < STATS_STAGE_MAX; st++) {
+        const stats_hist_t *hist = &cur->latency[st];
+        printf("%s\"%s\":{\"count\":%llu,\"avg_us\":%.3f,\"p50_us\":%.3f,\"p99_us\":%.3f,"
+               "\"p999_us\":%.3f,\"max_us\":%.3f}",
+               st ? "," : "", stats_stage_name(st), (unsigned long long)hist->count,
+               hist->count ? server_stats_cycles_to_us(stats, hist->total / hist->count) : 0.0,
+               server_stats_cycles_to_us(stats, stats_hist_percentile(hist, 0.50)),
+               server_stats_cycles_to_us(stats, stats_hist_percentile(hist, 0.99)),
+               server_stats_cycles_to_us(stats, stats_hist_percentile(hist, 0.999)),
+               server_stats_cycles_to_us(stats, hist->max));
+    }
+    printf("},\"clients\":[");
+    
+    for (uint32_t slot = 0; slot < h->client_capacity; slot++) {
+        const stats_client_meta_t *m = &cur->meta[slot];
+        const stats_client_t *c = &cur->clients[slot];
+        struct in_addr vpn_addr = { .s_addr = m->vpn_ip };
+        struct in_addr real_addr = { .s_addr = m->real_ip };
+        char vpn_str[INET_ADDRSTRLEN], real_str[INET_ADDRSTRLEN];
+        
+        if (!m->active) {
+            continue;
+        }
+        
+        inet_ntop(AF_INET, &vpn_addr, vpn_str, sizeof(vpn_str));
+        inet_ntop(AF_INET, &real_addr, real_str, sizeof(real_str));
+        printf("%s{\"slot\":%u,\"vpn_ip\":\"%s\",\"addr\":\"%s:%u\",\"session_id\":%u,"
+               "\"connected_at\":%lld,\"rx_packets\":%llu,\"rx_bytes\":%llu,"
+               "\"tx_packets\":%llu,\"tx_bytes\":%llu,\"decrypt_failures\":%llu,"
+               "\"drops\":{\"encrypt\":%llu,\"tun_write\":%llu,\"udp_send\":%llu},"
+               "\"rtt_ns\":%llu}",
+               first ? "" : ",", slot, vpn_str, real_str, ntohs(m->real_port), m->session_id,
+               (long long)m->connected_at, (unsigned long long)c->rx_packets,
+               (unsigned long long)c->rx_bytes, (unsigned long long)c->tx_packets,
+               (unsigned long long)c->tx_bytes, (unsigned long long)c->decrypt_failures,
+               (unsigned long long)c->drops[CLIENT_DROP_ENCRYPT],
+               (unsigned long long)c->drops[CLIENT_DROP_TUN_WRITE],
+               (unsigned long long)c->drops[CLIENT_DROP_UDP_SEND],
+               (unsigned long long)m->last_rtt_ns);
+        first = 0;
+    }
+    printf("]}\n");
+    fflush(stdout);
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --name <shm>         stats segment (default %s)\n", STATS_SHM_NAME);
+    printf("  -i, --interval <s>   repeat every s seconds and show per-second rates\n");
+    printf("  -c, --count <N>      stop after N samples (default 1, or forever with -i)\n");
+    printf("  --json               one JSON object per sample (cumulative counters)\n");
+    printf("  --latency on|off     switch per-stage latency sampling in the server\n");
+}
+
+// 서버에 지연 측정 켜기/끄기 시그널 보내기
+static int switch_latency(const stats_header_t *h, int enabled) {
+    if (!server_alive(h)) {
+        fprintf(stderr, "❌ vpn_server (pid %d) is not running\n", h->pid);
+        return -1;
+    }
+    if (kill(h->pid, enabled ? SIGUSR1 : SIGUSR2) < 0) {
+        perror("kill");
+        return -1;
+    }
+    printf("⏱️  Latency sampling %s (pid %d)\n", enabled ? "on" : "off", h->pid);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *name = STATS_SHM_NAME;
+    double interval = 0;
+    long count = -1;
+    int json = 0;
+    int latency = -1;   // -1 = 그대로, 0 = 끄기, 1 = 켜기
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+            name = argv[++i];
+        } else if ((strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "--interval") == 0) &&
+                   i + 1 < argc) {
+            interval = atof(argv[++i]);
+        } else if ((strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--count") == 0) &&
+                   i + 1 < argc) {
+            count = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc &&
+                   (strcmp(argv[i + 1], "on") == 0 || strcmp(argv[i + 1], "off") == 0)) {
+            latency = (strcmp(argv[++i], "on") == 0);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (interval < 0 || (interval == 0 && count > 1)) {
+        fprintf(stderr, "❌ --count > 1 needs a positive --interval\n");
+        return 1;
+    }
+    if (count < 0) {
+        count = interval > 0 ? 0 : 1;   // 0 = 무한
+    }
+    
+    server_stats_t stats;
+    if (server_stats_attach(&stats, name) < 0) {
+        fprintf(stderr, "❌ Is vpn_server running? (segment %s)\n", name);
+        return 1;
+    }
+    
+    if (latency >= 0) {
+        int ret = switch_latency(stats.header, latency);
+        server_stats_close(&stats);
+        return ret < 0 ? 1 : 0;
+    }
+    
+    stat_snapshot_t snaps[2];
+    memset(snaps, 0, sizeof(snaps));
+    if (snapshot_alloc(&snaps[0], stats.header) < 0 || snapshot_alloc(&snaps[1], stats.header) < 0) {
+        snapshot_free(&snaps[0]);
+        snapshot_free(&snaps[1]);
+        server_stats_close(&stats);
+        return 1;
+    }
+    
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    
+    int cur = 0;
+    for (long n = 0; running && (count == 0 || n < count); n++) {
+        if (n > 0) {
+            usleep((useconds_t)(interval * 1e6));
+            if (!running) {
+                break;
+            }
+        }
+        
+        snapshot_take(&stats, &snaps[cur]);
+        if (json) {
+            print_json(&stats, &snaps[cur]);
+        } else {
+            print_text(&stats, &snaps[cur], n > 0 ? &snaps[cur ^ 1] : NULL);
+        }
+        cur ^= 1;
+        
+        // 서버가 끝났으면 마지막 값을 보여주고 종료 (재시작하면 새 세그먼트)
+        if (!server_alive(stats.header)) {
+            break;
+        }
+    }
+    
+    snapshot_free(&snaps[0]);
+    snapshot_free(&snaps[1]);
+    server_stats_close(&stats);
+    return 0;
+}